@@ -892,6 +892,36 @@ namespace nd {
   array operator/(const array &op0, const array &op1);
   array operator*(const array &op0, const array &op1);
 
+  /**
+   * While an object of this class is alive, the arithmetic operators above
+   * return unevaluated expressions on the calling thread, instead of
+   * evaluating each operation into a temporary. A chain of builtin
+   * arithmetic like ``a * b + c * d - e`` then becomes a single expression
+   * whose eval() computes every operation in one pass, a small block of
+   * elements at a time.
+   *
+   *   nd::array r;
+   *   {
+   *     nd::deferred_arithmetic deferred;
+   *     r = a * b + c * d - e;
+   *   }
+   *   r = r.eval();
+   *
+   * Operators applied outside the scope to such an expression also fuse
+   * with it before evaluating.
+   */
+  class deferred_arithmetic {
+    bool m_previous;
+
+    // Non-copyable
+    deferred_arithmetic(const deferred_arithmetic &);
+    deferred_arithmetic &operator=(const deferred_arithmetic &);
+
+  public:
+    deferred_arithmetic();
+    ~deferred_arithmetic();
+  };
+
   nd::array array_rw(dynd_bool value);
   nd::array array_rw(bool value);
   nd::array array_rw(signed char value);
@@ -1820,10 +1850,13 @@ namespace nd {
    * \param end  If provided, the end of where to memory map. Uses
    *             Python semantics for out of bounds and negative values.
    * \param access  The access permissions with which to open the file.
+   * \param hints  A combination of memmap_hint_flags, from
+   *               <dynd/memblock/memmap_memory_block.hpp>, describing how
+   *               the data will be accessed.
    */
   array memmap(const std::string &filename, intptr_t begin = 0,
                intptr_t end = std::numeric_limits<intptr_t>::max(),
-               uint32_t access = default_access_flags);
+               uint32_t access = default_access_flags, uint32_t hints = 0);
 
   /**
    * Performs a binary search of the first dimension of the array, which
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <string>
+
+#include <dynd/array.hpp>
+
+namespace dynd {
+
+namespace nd {
+
+  /**
+   * Writes ``a`` to the file ``filename`` in a self-describing binary
+   * container which open_columnar can map back into memory.
+   *
+   * The file starts with a header holding the datashape of ``a`` and a
+   * table of sections. The first section holds the top level data of
+   * ``a``, and each string, bytes and var_dim in the type gets one more
+   * section holding all of its strings or elements, one after another.
+   * All data is written in the default layout of the type, so the arrmeta
+   * follows from the datashape, and pointers are written as offsets in
+   * the file. Sections start on 64 byte boundaries.
+   *
+   * Supported types are fixed_dim, var_dim, struct, tuple, option, string
+   * and bytes, over any POD type without arrmeta.
+   *
+   * The file is specific to the pointer size and byte order of the
+   * machine which writes it.
+   */
+  void save_columnar(const std::string &filename, const nd::array &a);
+
+  /**
+   * Opens a file written by save_columnar as an immutable nd::array.
+   *
+   * The file is memory mapped. Sections without pointers, which includes
+   * all the characters of strings and all POD data, are used in place, so
+   * their pages are only read from disk when they are first touched.
+   * Sections which contain string or var_dim pointers are copied into
+   * memory at open, and their pointers are relocated to the mapping.
+   */
+  nd::array open_columnar(const std::string &filename);
+
+} // namespace nd
+
+} // namespace dynd
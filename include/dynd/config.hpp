@@ -14,6 +14,12 @@
 /** The number of elements to process at once when doing chunking/buffering */
 #define DYND_BUFFER_CHUNK_SIZE 128
 
+/**
+ * The approximate number of bytes each thread processes at once when
+ * evaluating a lifted arrfunc in parallel
+ */
+#define DYND_PARALLEL_CHUNK_BYTES (64 * 1024)
+
 #ifdef __clang__
 // It appears that on OSX, one can have a configuration with
 // clang that supports rvalue references but no implementation
@@ -29,6 +29,9 @@ struct eval_context {
     std::atomic<date_parse_order_t> date_parse_order;
     // Century selection for 2 digit years in date strings
     std::atomic<int> century_window;
+    // Number of threads for parallel evaluation of lifted elementwise
+    // arrfuncs, 1 means evaluate on the calling thread only
+    std::atomic<intptr_t> nthreads;
 #else
     // Default error mode for computations
     assign_error_mode errmode;
@@ -38,12 +41,16 @@ struct eval_context {
     date_parse_order_t date_parse_order;
     // Century selection for 2 digit years in date strings
     int century_window;
+    // Number of threads for parallel evaluation of lifted elementwise
+    // arrfuncs, 1 means evaluate on the calling thread only
+    intptr_t nthreads;
 #endif
 
     DYND_CONSTEXPR eval_context()
         : errmode(assign_error_fractional),
           cuda_device_errmode(assign_error_nocheck),
-          date_parse_order(date_parse_no_ambig), century_window(70)
+          date_parse_order(date_parse_no_ambig), century_window(70),
+          nthreads(1)
     {
     }
 
@@ -53,7 +60,8 @@ struct eval_context {
         : errmode(rhs.errmode.load()),
           cuda_device_errmode(rhs.cuda_device_errmode.load()),
           date_parse_order(rhs.date_parse_order.load()),
-          century_window(rhs.century_window.load())
+          century_window(rhs.century_window.load()),
+          nthreads(rhs.nthreads.load())
     {
     }
 
@@ -62,6 +70,7 @@ struct eval_context {
         cuda_device_errmode.store(rhs.cuda_device_errmode.load());
         date_parse_order.store(rhs.date_parse_order.load());
         century_window.store(rhs.century_window.load());
+        nthreads.store(rhs.nthreads.load());
         return *this;
     }
 #endif
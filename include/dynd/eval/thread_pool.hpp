@@ -0,0 +1,47 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/config.hpp>
+
+namespace dynd { namespace eval {
+
+/**
+ * Function called by ``parallel_for`` once for each chunk.
+ *
+ * \param thread_index  The index, in [0, nthreads), of the thread running
+ *                      the chunk. The calling thread is always index 0.
+ * \param chunk_index  The index, in [0, nchunks), of the chunk to process.
+ * \param data  The user data pointer passed to ``parallel_for``.
+ */
+typedef void (*parallel_chunk_t)(intptr_t thread_index, intptr_t chunk_index,
+                                 void *data);
+
+/**
+ * Calls ``chunk_fn`` for every chunk index in [0, nchunks), using up to
+ * ``nthreads`` threads from a process-wide pool. The calling thread
+ * participates as thread index 0, and idle threads claim the next
+ * unprocessed chunk, so uneven chunks balance out across the threads.
+ *
+ * A chunk function is never run concurrently with another chunk function
+ * that has the same thread index, which lets callers keep per-thread state
+ * such as a private ckernel in an array indexed by ``thread_index``.
+ *
+ * If the pool is already busy, or this is called from inside a chunk
+ * function, all the chunks are run serially on the calling thread.
+ *
+ * If a chunk function throws, the remaining chunks are skipped and the
+ * first exception is rethrown on the calling thread.
+ */
+void parallel_for(intptr_t nthreads, intptr_t nchunks,
+                  parallel_chunk_t chunk_fn, void *data);
+
+/**
+ * Returns the number of hardware threads available, at least 1.
+ */
+intptr_t get_hardware_concurrency();
+
+}} // namespace dynd::eval
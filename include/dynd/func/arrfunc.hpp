@@ -11,6 +11,7 @@
 #include <dynd/types/arrfunc_type.hpp>
 #include <dynd/types/arrfunc_old_type.hpp>
 #include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/ckernel_cache.hpp>
 #include <dynd/types/struct_type.hpp>
 #include <dynd/types/type_pattern_match.hpp>
 #include <dynd/types/substitute_typevars.hpp>
@@ -243,7 +244,7 @@ namespace nd {
 
       std::vector<intptr_t> resolve_available_types(
           const arrfunc_type *DYND_UNUSED(self_tp), ndt::type *DYND_UNUSED(tp),
-          std::map<nd::string, ndt::type> &DYND_UNUSED(typevars)) const
+          ndt::typevar_table &DYND_UNUSED(typevars)) const
       {
         return std::vector<intptr_t>();
       }
@@ -308,7 +309,7 @@ namespace nd {
       std::vector<intptr_t>
       resolve_available_types(const arrfunc_type *self_tp,
                               ndt::type *kwd_tp_data,
-                              std::map<nd::string, ndt::type> &typevars) const
+                              ndt::typevar_table &typevars) const
       {
         std::vector<intptr_t> available;
 
@@ -473,7 +474,7 @@ namespace nd {
 
     std::vector<intptr_t> resolve_missing_types(
         ndt::type *kwd_tp,
-        std::map<nd::string, ndt::type> &DYND_UNUSED(typevars)) const
+        ndt::typevar_table &DYND_UNUSED(typevars)) const
     {
       std::vector<intptr_t> missing;
 
@@ -512,23 +513,21 @@ namespace nd {
         return dst_tp;
       }
 
-      if (nsrc != self_tp->get_npos()) {
+      const ndt::pattern_signature &sig = self_tp->get_pos_signature();
+      if (nsrc != sig.get_nparam()) {
         std::stringstream ss;
-        ss << "arrfunc expected " << self_tp->get_npos()
+        ss << "arrfunc expected " << sig.get_nparam()
            << " parameters, but received " << nsrc;
         throw std::invalid_argument(ss.str());
       }
-      const ndt::type *param_types = self_tp->get_arg_types_raw();
-      std::map<nd::string, ndt::type> typevars;
-      for (intptr_t i = 0; i != nsrc; ++i) {
-        ndt::type expected_tp = param_types[i];
-        if (!ndt::pattern_match(src_tp[i].value_type(), expected_tp,
-                                typevars)) {
-          std::stringstream ss;
-          ss << "parameter " << (i + 1) << " to arrfunc does not match, ";
-          ss << "expected " << expected_tp << ", received " << src_tp[i];
-          throw std::invalid_argument(ss.str());
-        }
+      ndt::typevar_table typevars;
+      intptr_t i = sig.match(src_tp, typevars);
+      if (i != -1) {
+        std::stringstream ss;
+        ss << "parameter " << (i + 1) << " to arrfunc does not match, ";
+        ss << "expected " << self_tp->get_arg_type(i) << ", received "
+           << src_tp[i];
+        throw std::invalid_argument(ss.str());
       }
 
       if (self_tp->get_nkwd() > 0) {
@@ -554,6 +553,9 @@ namespace nd {
         }
       }
 
+      if (!sig.has_symbolic_return()) {
+        return self_tp->get_return_type();
+      }
       return ndt::substitute(self_tp->get_return_type(), typevars, true);
     }
 
@@ -563,7 +565,6 @@ namespace nd {
                const detail::kwds<K...> &kwds,
                const eval::eval_context *ectx) const
     {
-      const arrfunc_type_data *af = get();
       const arrfunc_type *af_tp = m_value.get_type().extended<arrfunc_type>();
 
       std::vector<ndt::type> arg_tp(narg);
@@ -590,14 +591,14 @@ namespace nd {
       // Construct the destination array
       nd::array res = nd::empty(dst_tp);
 
-      // Generate and evaluate the ckernel
-      ckernel_builder<kernel_request_host> ckb;
-      af->instantiate(af, af_tp, &ckb, 0, dst_tp, res.get_arrmeta(), &arg_tp[0],
-                      &src_arrmeta[0], kernel_request_single, ectx,
-                      kwds_as_array);
-      expr_single_t fn = ckb.get()->get_function<expr_single_t>();
+      // Generate, or reuse from the cache, and evaluate the ckernel
+      kernels::cached_ckernel ck(m_value, dst_tp, res.get_arrmeta(),
+                                 af_tp->get_npos(), &arg_tp[0],
+                                 &src_arrmeta[0], kernel_request_single, ectx,
+                                 kwds_as_array);
+      expr_single_t fn = ck.get()->get_function<expr_single_t>();
       fn(res.get_readwrite_originptr(), src_data.empty() ? NULL : &src_data[0],
-         ckb.get());
+         ck.get());
       return res;
     }
 
@@ -641,7 +642,6 @@ namespace nd {
                   const detail::kwds<K...> &DYND_UNUSED(kwds),
                   const nd::array &out, const eval::eval_context *ectx) const
     {
-      const arrfunc_type_data *af = get();
       const arrfunc_type *af_tp = m_value.get_type().extended<arrfunc_type>();
 
       std::vector<ndt::type> arg_tp(narg);
@@ -658,14 +658,14 @@ namespace nd {
         src_data[i] = const_cast<char *>(args[i].get_readonly_originptr());
       }
 
-      // Generate and evaluate the ckernel
-      ckernel_builder<kernel_request_host> ckb;
-      af->instantiate(af, af_tp, &ckb, 0, out.get_type(), out.get_arrmeta(),
-                      &arg_tp[0], &src_arrmeta[0], kernel_request_single, ectx,
-                      array());
-      expr_single_t fn = ckb.get()->get_function<expr_single_t>();
+      // Generate, or reuse from the cache, and evaluate the ckernel
+      kernels::cached_ckernel ck(m_value, out.get_type(), out.get_arrmeta(),
+                                 af_tp->get_npos(), &arg_tp[0],
+                                 &src_arrmeta[0], kernel_request_single, ectx,
+                                 array());
+      expr_single_t fn = ck.get()->get_function<expr_single_t>();
       fn(out.get_readwrite_originptr(), src_data.empty() ? NULL : &src_data[0],
-         ckb.get());
+         ck.get());
     }
     void call_out(intptr_t arg_count, const nd::array *args,
                   const nd::array &out, const eval::eval_context *ectx) const
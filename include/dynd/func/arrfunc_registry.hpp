@@ -10,18 +10,23 @@
 namespace dynd { namespace func {
 
 /**
- * Returns a reference to the map of registered arrfuncs.
+ * Returns a snapshot of the registered arrfuncs.
  * NOTE: The internal representation will change, this
  *       function will change.
  */
-const std::map<nd::string, nd::arrfunc>& get_regfunctions();
+std::map<nd::string, nd::arrfunc> get_regfunctions();
 
 /**
-  * Looks up a named arrfunc from the registry.
+  * Looks up a named arrfunc from the registry. Lookups take no
+  * lock, and may run concurrently with each other and with
+  * ``set_regfunction``.
   */
 nd::arrfunc get_regfunction(const nd::string &name);
+nd::arrfunc get_regfunction(const char *name);
 /**
-  * Sets a named arrfunc in the registry.
+  * Sets a named arrfunc in the registry. This is safe to call
+  * at runtime from any thread, but is much slower than a lookup,
+  * as it copies the registry.
   */
 void set_regfunction(const nd::string &name, const nd::arrfunc &af);
 
@@ -0,0 +1,32 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/config.hpp>
+#include <dynd/array.hpp>
+#include <dynd/func/arrfunc.hpp>
+
+namespace dynd { namespace kernels {
+
+/**
+ * Create an arrfunc which transposes an array of structs into a struct
+ * of arrays, (N * {a: A, b: B, ...}) -> {a: N * A, b: N * B, ...}. Tuples
+ * work the same way.
+ *
+ * Each field is copied into its own contiguous column with one strided
+ * assignment over the whole dimension.
+ */
+nd::arrfunc make_struct_of_arrays_arrfunc();
+
+/**
+ * Create an arrfunc which transposes a struct of arrays into an array of
+ * structs, ({a: N * A, b: N * B, ...}) -> N * {a: A, b: B, ...}, the
+ * inverse of make_struct_of_arrays_arrfunc. All the fields must have
+ * the same size.
+ */
+nd::arrfunc make_array_of_structs_arrfunc();
+
+}} // namespace dynd::kernels
@@ -0,0 +1,51 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/array.hpp>
+
+namespace dynd {
+
+enum groupby_aggregate_t {
+  /** The number of values which are not NaN, as int64 */
+  groupby_aggregate_count,
+  /** The sum as int64, uint64 or float64, by the kind of the values */
+  groupby_aggregate_sum,
+  /** The mean as float64 */
+  groupby_aggregate_mean,
+  /** The smallest and largest values, in the type of the values */
+  groupby_aggregate_min,
+  groupby_aggregate_max
+};
+
+namespace nd {
+
+  /**
+   * Groups the rows of the one-dimensional arrays ``keys`` and ``values``
+   * by the key, and reduces the values of each group with ``agg``.
+   *
+   * The keys can have any type make_hash_kernel supports, so multiple key
+   * columns can be passed as a struct. The values must be bool, integers
+   * or float32/64, or a struct of those, in which case each field is
+   * reduced separately. NaN values are skipped, and a group of only NaNs
+   * has a NaN mean, min and max.
+   *
+   * The result is a "N * {key: K, ...}" array with one element per
+   * distinct key, in the order the keys first appear. The reduced values
+   * follow the key in a field named "value", or in fields with the names
+   * of the value struct's fields.
+   *
+   * This is a single streaming pass which never materializes the groups.
+   * Large inputs are split into one chunk per thread of the default eval
+   * context, each with its own hash table and partial reductions, which
+   * are merged at the end.
+   */
+  nd::array groupby_aggregate(const nd::array &keys, const nd::array &values,
+                              groupby_aggregate_t agg);
+
+} // namespace nd
+
+} // namespace dynd
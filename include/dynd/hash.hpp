@@ -0,0 +1,109 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <vector>
+
+#include <dynd/array.hpp>
+#include <dynd/func/arrfunc.hpp>
+#include <dynd/kernels/hash_kernels.hpp>
+
+namespace dynd {
+
+namespace nd {
+
+  /**
+   * Returns the uint64 hash of every element of ``a``, with the same
+   * shape as ``a``. See make_hash_kernel for the supported types.
+   */
+  nd::array hash(const nd::array &a);
+
+  /**
+   * Returns the distinct values of the one-dimensional array ``a``, in
+   * the order they first appear. -0.0 and 0.0 count as the same value,
+   * as do all NaNs.
+   */
+  nd::array unique(const nd::array &a);
+
+  /**
+   * Returns a "N * {value: T, count: int64}" array with each distinct
+   * value of the one-dimensional array ``a`` and how many times it
+   * appears, in the order the values first appear.
+   */
+  nd::array value_counts(const nd::array &a);
+
+} // namespace nd
+
+/**
+ * An arrfunc with the signature "(T) -> uint64", which hashes a value
+ * with make_hash_kernel.
+ */
+nd::arrfunc make_hash_arrfunc();
+
+/**
+ * An open addressing hash table which numbers the distinct values of a
+ * type in the order they are inserted, using linear probing on hashes
+ * from make_hash_kernel. The table stores pointers to the first
+ * occurrence of each value rather than copies, so the inserted data
+ * must outlive it.
+ */
+class value_hash_index {
+  ndt::type m_tp;
+  const char *m_arrmeta;
+  // How two values whose hashes match are checked for equality. For
+  // option types this applies to the value type, once both are available.
+  enum { equal_bytes, equal_blockref_bytes, equal_sorting_less } m_equal_kind;
+  size_t m_data_size;
+  // The hashes of integers are a bijection of their values, so matching
+  // hashes need no further check
+  bool m_hash_is_exact;
+  bool m_option;
+  ckernel_builder<kernel_request_host> m_hash_ck, m_less_ck, m_is_avail_ck;
+  // A slot holds the hash and id of a value, or an id of -1 if empty.
+  // Keeping them together makes a probe touch a single cache line.
+  struct slot {
+    uint64_t hash;
+    intptr_t id;
+  };
+  std::vector<slot> m_slots;
+  std::vector<const char *> m_values;
+  std::vector<uint64_t> m_hash_buffer;
+
+  // Non-copyable
+  value_hash_index(const value_hash_index &);
+  value_hash_index &operator=(const value_hash_index &);
+
+  bool equal(const char *a, const char *b) const;
+  void grow();
+
+public:
+  value_hash_index(const ndt::type &tp, const char *arrmeta,
+                   const eval::eval_context *ectx);
+
+  /**
+   * Writes the id of each of the ``count`` values at ``data``, spaced
+   * by ``stride``, to ``out_ids``, giving each value not yet in the
+   * table the next id.
+   */
+  void insert(const char *data, intptr_t stride, intptr_t count,
+              intptr_t *out_ids);
+
+  /**
+   * Like insert, but writes -1 for values not in the table instead of
+   * adding them. This does not modify the table, so several threads
+   * may call it at once.
+   */
+  void find(const char *data, intptr_t stride, intptr_t count,
+            intptr_t *out_ids) const;
+
+  /** The number of distinct values in the table */
+  intptr_t size() const { return (intptr_t)m_values.size(); }
+
+  /** A pointer to the first occurrence of the value with id ``id`` */
+  const char *get_value(intptr_t id) const { return m_values[id]; }
+};
+
+} // namespace dynd
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <iosfwd>
+
 #include <dynd/array.hpp>
 
 namespace dynd {
@@ -18,4 +20,35 @@ namespace dynd {
  */
 nd::array format_json(const nd::array &a, bool struct_as_list = false);
 
+/**
+ * A destination for JSON output which is streamed out in pieces.
+ */
+class json_output_sink {
+public:
+  virtual ~json_output_sink();
+
+  /** Receives the next piece of output, [begin, end) */
+  virtual void write(const char *begin, const char *end) = 0;
+};
+
+/**
+ * Formats the nd::array as JSON into ``sink``. The output is produced in a
+ * buffer of ``buffer_size`` bytes, which is passed to the sink each time
+ * it fills up, so the whole output is never held in memory at once.
+ *
+ * \param sink  The sink which receives the output.
+ * \param a  The array to format as JSON.
+ * \param struct_as_list  If true, formats struct objects as lists, otherwise
+ *                        formats them as objects/dicts.
+ * \param buffer_size  The size of the output buffer.
+ */
+void format_json(json_output_sink &sink, const nd::array &a,
+                 bool struct_as_list = false, intptr_t buffer_size = 65536);
+
+/**
+ * Formats the nd::array as JSON, writing it to the stream ``o``.
+ */
+void format_json(std::ostream &o, const nd::array &a,
+                 bool struct_as_list = false);
+
 } // namespace dynd
@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <deque>
+#include <string>
+
 #include <dynd/array.hpp>
 
 namespace dynd {
@@ -91,4 +94,75 @@ parse_json(const char(&dt)[M], const char(&json)[N],
   return parse_json(ndt::type(dt, dt + M - 1), json, json + N - 1, ectx);
 }
 
+/**
+ * An incremental parser for newline-delimited JSON, where every line holds
+ * one value of the row type. The input is fed in chunks of any size, for
+ * example blocks read from a file descriptor or successive windows of a
+ * memory mapped file, and the rows come out in batches of type
+ * ``var * row_tp``. Lines may be split across chunks, and blank lines are
+ * skipped.
+ *
+ * The parser holds at most one partial line and the batches which have not
+ * been popped yet, so if the batches are popped after every ``feed``, its
+ * memory use is bounded by the batch size and chunk size, not the input size.
+ *
+ * Like parse_json into a var dimension, the row type may not contain types
+ * which require destruction.
+ */
+class json_stream_parser {
+  ndt::type m_row_tp, m_batch_tp;
+  intptr_t m_batch_size;
+  const eval::eval_context *m_ectx;
+  // The number of lines consumed so far, for error messages
+  intptr_t m_line_count;
+  // The start of a line which did not end within the last chunk
+  std::string m_partial_line;
+  // The batch being filled, and the end of its allocated rows
+  nd::array m_batch;
+  char *m_batch_end;
+  std::deque<nd::array> m_ready_batches;
+
+  // Non-copyable
+  json_stream_parser(const json_stream_parser &);
+  json_stream_parser &operator=(const json_stream_parser &);
+
+  void parse_line(const char *begin, const char *end);
+  void flush_batch();
+
+public:
+  /**
+   * Creates a parser for rows of type ``row_tp``.
+   *
+   * \param row_tp  The type of the value on each line.
+   * \param batch_size  The maximum number of rows in one batch.
+   * \param ectx  An evaluation context, which must outlive the parser.
+   */
+  json_stream_parser(const ndt::type &row_tp, intptr_t batch_size = 4096,
+                     const eval::eval_context *ectx =
+                         &eval::default_eval_context);
+
+  /**
+   * Parses the complete lines in the next chunk of input, keeping any
+   * trailing partial line until the next call.
+   */
+  void feed(const char *chunk_begin, const char *chunk_end);
+
+  inline void feed(const std::string &chunk)
+  {
+    feed(chunk.data(), chunk.data() + chunk.size());
+  }
+
+  /**
+   * Signals the end of the input, parsing a last line which has no
+   * terminating newline and emitting the final partial batch.
+   */
+  void finish();
+
+  /** Returns true if a batch of rows is ready to be popped */
+  inline bool has_batch() const { return !m_ready_batches.empty(); }
+
+  /** Removes and returns the oldest ready batch, of type ``var * row_tp`` */
+  nd::array pop_batch();
+};
+
 } // namespace dynd
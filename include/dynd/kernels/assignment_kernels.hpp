@@ -146,6 +146,30 @@ namespace kernels {
           reinterpret_cast<dst_type *>(dst),
           reinterpret_cast<src_type *>(*src));
     }
+
+    void strided(char *dst, intptr_t dst_stride, char *const *src,
+                 const intptr_t *src_stride, size_t count)
+    {
+      typedef single_assigner_builtin_block<dst_type, src_type, errmode>
+          block_assigner;
+      char *src0 = src[0];
+      intptr_t src0_stride = src_stride[0];
+      // Contiguous data is range checked a block at a time
+      if (block_assigner::enabled && dst_stride == sizeof(dst_type) &&
+          src0_stride == sizeof(src_type)) {
+        block_assigner::assign_contiguous(
+            reinterpret_cast<dst_type *>(dst),
+            reinterpret_cast<const src_type *>(src0), count);
+        return;
+      }
+      for (size_t i = 0; i != count; ++i) {
+        single_assigner_builtin<dst_type, src_type, errmode>::assign(
+            reinterpret_cast<dst_type *>(dst),
+            reinterpret_cast<src_type *>(src0));
+        dst += dst_stride;
+        src0 += src0_stride;
+      }
+    }
   };
 
   template <class dst_type, class src_type>
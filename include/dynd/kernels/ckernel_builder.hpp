@@ -14,6 +14,30 @@
 
 namespace dynd {
 
+namespace detail {
+  /**
+   * Allocates the heap memory of a host ckernel_builder. Small blocks
+   * come from the per-thread chunk pool the memory blocks use, so building
+   * and destroying ckernels repeatedly does not go through malloc each
+   * time. Returns NULL on allocation failure.
+   */
+  void *ckernel_builder_pool_alloc(size_t size);
+
+  /**
+   * Grows a block allocated by ``ckernel_builder_pool_alloc``, copying the
+   * first ``old_size`` bytes. Returns NULL on allocation failure, in which
+   * case the old block is still valid.
+   */
+  void *ckernel_builder_pool_realloc(void *ptr, size_t old_size,
+                                     size_t new_size);
+
+  /**
+   * Frees a block allocated by ``ckernel_builder_pool_alloc``, where
+   * ``size`` is the size it was allocated or last reallocated with.
+   */
+  void ckernel_builder_pool_free(void *ptr, size_t size);
+} // namespace detail
+
 namespace kernels {
   /**
    * Increments a ``ckb_offset`` variable (offset into a ckernel_builder)
@@ -218,12 +242,12 @@ public:
 
   void destroy(ckernel_prefix *self) { self->destroy(); }
 
-  void *alloc(size_t size) { return std::malloc(size); }
+  void *alloc(size_t size) { return detail::ckernel_builder_pool_alloc(size); }
 
   void *realloc(void *ptr, size_t old_size, size_t new_size)
   {
     if (using_static_data()) {
-      // If we were previously using the static data, do a malloc
+      // If we were previously using the static data, do an alloc
       void *new_data = alloc(new_size);
       // If the allocation succeeded, copy the old data as the realloc would
       if (new_data != NULL) {
@@ -231,14 +255,14 @@ public:
       }
       return new_data;
     } else {
-      return std::realloc(ptr, new_size);
+      return detail::ckernel_builder_pool_realloc(ptr, old_size, new_size);
     }
   }
 
   void free(void *ptr)
   {
     if (!using_static_data()) {
-      std::free(ptr);
+      detail::ckernel_builder_pool_free(ptr, m_capacity);
     }
   }
 
@@ -439,19 +463,8 @@ inline int ckernel_builder_ensure_capacity_leaf(void *ckb,
     if (requested_capacity < grown_capacity) {
       requested_capacity = grown_capacity;
     }
-    char *new_data;
-    if (ckb_ptr->using_static_data()) {
-      // If we were previously using the static data, do a malloc
-      new_data = reinterpret_cast<char *>(malloc(requested_capacity));
-      // If the allocation succeeded, copy the old data as the realloc would
-      if (new_data != NULL) {
-        memcpy(new_data, ckb_ptr->m_data, ckb_ptr->m_capacity);
-      }
-    } else {
-      // Otherwise do a realloc
-      new_data = reinterpret_cast<char *>(
-          realloc(ckb_ptr->m_data, requested_capacity));
-    }
+    char *new_data = reinterpret_cast<char *>(ckb_ptr->realloc(
+        ckb_ptr->m_data, ckb_ptr->m_capacity, requested_capacity));
     if (new_data == NULL) {
       ckb_ptr->destroy();
       ckb_ptr->m_data = NULL;
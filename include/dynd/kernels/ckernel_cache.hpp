@@ -0,0 +1,79 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/config.hpp>
+#include <dynd/array.hpp>
+#include <dynd/eval/eval_context.hpp>
+#include <dynd/kernels/ckernel_builder.hpp>
+
+namespace dynd { namespace kernels {
+
+struct ckernel_cache_entry;
+
+/**
+ * An instantiated ckernel for one call of an arrfunc. The ckernel is taken
+ * from a process-wide cache when an identical one was instantiated before,
+ * and is handed back to the cache for reuse when this object is destroyed.
+ *
+ * Only calls whose types are builtin scalars or fixed dimensions of them,
+ * and which pass no keyword arguments, are cached. Their arrmeta is just
+ * sizes and strides, so the key (arrfunc, types, arrmeta bytes, kernreq,
+ * eval_context settings) determines the ckernel completely. Any other call
+ * is instantiated into a fresh ckernel_builder as usual.
+ *
+ * A ckernel is only ever used by one cached_ckernel at a time.
+ */
+class cached_ckernel {
+  ckernel_cache_entry *m_entry;
+
+  // Non-copyable
+  cached_ckernel(const cached_ckernel &);
+  cached_ckernel &operator=(const cached_ckernel &);
+
+public:
+  /**
+   * Gets a ckernel for ``af``, which must be an immutable array of
+   * arrfunc type, instantiating it if the cache has no match.
+   */
+  cached_ckernel(const nd::array &af, const ndt::type &dst_tp,
+                 const char *dst_arrmeta, intptr_t nsrc,
+                 const ndt::type *src_tp, const char *const *src_arrmeta,
+                 kernel_request_t kernreq, const eval::eval_context *ectx,
+                 const nd::array &kwds);
+
+  ~cached_ckernel();
+
+  ckernel_prefix *get() const;
+};
+
+struct ckernel_cache_stats {
+  // Number of lookups which reused a cached ckernel
+  intptr_t hits;
+  // Number of cacheable lookups which had to instantiate a ckernel
+  intptr_t misses;
+  // Number of ckernels currently held by the cache
+  intptr_t size;
+};
+
+/**
+ * Returns the hit/miss counters and the current size of the ckernel cache.
+ */
+ckernel_cache_stats get_ckernel_cache_stats();
+
+/**
+ * Destroys all the ckernels held by the cache and resets its counters.
+ */
+void clear_ckernel_cache();
+
+} // namespace kernels
+
+namespace init {
+void ckernel_cache_init();
+void ckernel_cache_cleanup();
+} // namespace init
+
+} // namespace dynd
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/eval/thread_pool.hpp>
 
 namespace dynd {
 namespace kernels {
@@ -61,5 +62,63 @@ namespace kernels {
       self->destroy_child_ckernel(sizeof(self_type));
     }
   };
+
+  /**
+   * Expr kernel for a strided dimension which splits the dimension into
+   * chunks and evaluates them with eval::parallel_for. Instead of a single
+   * child ckernel following it in the ckernel_builder, this kernel owns
+   * one separately instantiated kernel_request_strided child per thread,
+   * so child kernels with internal state (e.g. buffers) are never shared.
+   */
+  template <int N>
+  struct parallel_elwise_ck
+      : expr_ck<parallel_elwise_ck<N>, kernel_request_host, N> {
+    typedef parallel_elwise_ck<N> self_type;
+
+    intptr_t size, chunk_size, nthreads;
+    intptr_t dst_stride, src_stride[N];
+    ckernel_builder<kernel_request_host> *children;
+
+    struct chunk_args {
+      self_type *self;
+      char *dst;
+      char *const *src;
+    };
+
+    parallel_elwise_ck(intptr_t size, intptr_t chunk_size, intptr_t nthreads,
+                       intptr_t dst_stride, const intptr_t *src_stride)
+        : size(size), chunk_size(chunk_size), nthreads(nthreads),
+          dst_stride(dst_stride),
+          children(new ckernel_builder<kernel_request_host>[nthreads])
+    {
+      memcpy(this->src_stride, src_stride, sizeof(this->src_stride));
+    }
+
+    ~parallel_elwise_ck() { delete[] children; }
+
+    static void run_chunk(intptr_t thread_index, intptr_t chunk_index,
+                          void *data)
+    {
+      const chunk_args *args = reinterpret_cast<const chunk_args *>(data);
+      self_type *self = args->self;
+      intptr_t begin = chunk_index * self->chunk_size;
+      intptr_t count = std::min(self->chunk_size, self->size - begin);
+      char *src_chunk[N];
+      for (int j = 0; j != N; ++j) {
+        src_chunk[j] = args->src[j] + begin * self->src_stride[j];
+      }
+      ckernel_prefix *child = self->children[thread_index].get();
+      expr_strided_t opchild = child->get_function<expr_strided_t>();
+      opchild(args->dst + begin * self->dst_stride, self->dst_stride,
+              src_chunk, self->src_stride, count, child);
+    }
+
+    void single(char *dst, char *const *src)
+    {
+      chunk_args args = {this, dst, src};
+      eval::parallel_for(nthreads, (size + chunk_size - 1) / chunk_size,
+                         &self_type::run_chunk, &args);
+    }
+  };
 } // namespace dynd
 } // namespace kernels
\ No newline at end of file
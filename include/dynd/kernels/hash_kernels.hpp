@@ -0,0 +1,75 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/eval/eval_context.hpp>
+
+namespace dynd {
+
+namespace ndt {
+    class type;
+} // namespace ndt
+
+/**
+ * The 64-bit finalizer of MurmurHash3, which spreads every bit of
+ * ``k`` across the whole result.
+ */
+inline uint64_t hash_mix(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/**
+ * Folds the hash ``h`` into the running hash ``seed``. The result
+ * depends on the order in which hashes are combined.
+ */
+inline uint64_t hash_combine(uint64_t seed, uint64_t h)
+{
+  return hash_mix(seed ^
+                  (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+/**
+ * Hashes ``size`` bytes of memory, eight bytes at a time.
+ */
+uint64_t hash_bytes(const char *data, size_t size);
+
+/**
+ * Creates a kernel which hashes a value of type ``src_tp`` into a
+ * uint64 destination. It is an expr_single_t or expr_strided_t
+ * with one source, depending on ``kernreq``.
+ *
+ * Values which compare equal hash equal, so for floating point types
+ * -0.0 hashes like 0.0 and every NaN hashes the same. Hashes are
+ * stable within a process, but are not meant to be persisted.
+ *
+ * Supported types are the builtin types, string, bytes, fixedstring,
+ * fixedbytes, categorical, date, time and datetime, structs and tuples
+ * (combining the hashes of their fields), and option types (hashing
+ * NA to a fixed value).
+ *
+ * \param ckb  The ckernel_builder being constructed.
+ * \param ckb_offset  The offset within 'ckb'.
+ * \param src_tp  The type to hash.
+ * \param src_arrmeta  Arrmeta for the values.
+ * \param kernreq  Either kernel_request_single or kernel_request_strided.
+ * \param ectx  DyND evaluation context.
+ *
+ * \returns  The offset within 'ckb' immediately after the
+ *           created kernel.
+ */
+intptr_t make_hash_kernel(void *ckb, intptr_t ckb_offset,
+                          const ndt::type &src_tp, const char *src_arrmeta,
+                          kernel_request_t kernreq,
+                          const eval::eval_context *ectx);
+
+} // namespace dynd
@@ -44,7 +44,12 @@ namespace dynd {
  * \param kernreq  Either dynd::kernel_request_single or
  *                 dynd::kernel_request_strided,
  *                 as required by the caller.
- * \param ectx  The evaluation context to use.
+ * \param ectx  The evaluation context to use. If ``ectx->nthreads`` is
+ *              greater than one, the request is single, and the reduction
+ *              is associative, the outermost reduced dimension is split
+ *              into chunks reduced on separate threads, and the partial
+ *              results are combined pairwise. In that mode every chunk
+ *              starts from ``reduction_identity``.
  */
 size_t make_lifted_reduction_ckernel(
     const arrfunc_type_data *elwise_reduction,
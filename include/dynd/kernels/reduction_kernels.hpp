@@ -33,11 +33,52 @@ nd::arrfunc make_builtin_sum_reduction_arrfunc(type_id_t tid);
 nd::arrfunc make_builtin_sum1d_arrfunc(type_id_t tid);
 
 /**
- * Makes a 1D mean arrfunc.
+ * Makes a 1D mean arrfunc, which skips NaN values and produces
+ * NaN when fewer than ``minp`` values remain. A ``minp`` <= 0
+ * is relative to the dimension size.
  * (fixed * <tid>) -> <tid>
  */
 nd::arrfunc make_builtin_mean1d_arrfunc(type_id_t tid, intptr_t minp);
 
+/**
+ * Makes a 1D sample variance (ddof = 1) arrfunc, which treats
+ * NaN values and ``minp`` like the mean arrfunc.
+ * (fixed * <tid>) -> <tid>
+ */
+nd::arrfunc make_builtin_var1d_arrfunc(type_id_t tid, intptr_t minp);
+
+/**
+ * Makes 1D min and max arrfuncs, which treat NaN values
+ * and ``minp`` like the mean arrfunc.
+ * (fixed * <tid>) -> <tid>
+ */
+nd::arrfunc make_builtin_min1d_arrfunc(type_id_t tid, intptr_t minp);
+nd::arrfunc make_builtin_max1d_arrfunc(type_id_t tid, intptr_t minp);
+
+enum builtin_reduction1d_t {
+  builtin_reduction1d_sum,
+  builtin_reduction1d_mean,
+  builtin_reduction1d_var,
+  builtin_reduction1d_min,
+  builtin_reduction1d_max
+};
+
+struct builtin_reduction1d_info {
+  builtin_reduction1d_t kind;
+  type_id_t tid;
+  // Not used by sum
+  intptr_t minp;
+};
+
+/**
+ * If ``af`` was created by one of the make_builtin_*1d_arrfunc
+ * functions, fills in ``out_info`` and returns true. This lets
+ * other arrfuncs, like the rolling window one, substitute a
+ * specialized kernel for the reduction.
+ */
+bool get_builtin_reduction1d_info(const nd::arrfunc &af,
+                                  builtin_reduction1d_info &out_info);
+
 intptr_t make_strided_reduction_ckernel(void *ckb, intptr_t ckb_offset);
 
 nd::arrfunc make_strided_reduction_arrfunc();
@@ -9,7 +9,9 @@
 #include <dynd/fpstatus.hpp>
 #include <cmath>
 #include <complex>
+#include <cstring>
 #include <limits>
+#include <type_traits>
 
 #include <dynd/config.hpp>
 #include <dynd/type.hpp>
@@ -1201,4 +1203,194 @@ struct single_assigner_builtin<same_type, same_type, errmode>
     }
 };
 
+
+// Checks for converting a whole block of values at once. The check of
+// each value is a few integer operations on the value or its bits, which
+// the compiler can vectorize, and any nonzero result means the value may
+// not convert cleanly. The checks may flag values which are fine, like NaN,
+// because a flagged block goes through the single assigners above, which
+// do the exact check and report the bad value.
+template<class T>
+struct single_assigner_builtin_float_bits;
+template<>
+struct single_assigner_builtin_float_bits<float> {
+    typedef uint32_t type;
+    static inline type get(float s) {
+        type b;
+        memcpy(&b, &s, sizeof(b));
+        return b;
+    }
+};
+template<>
+struct single_assigner_builtin_float_bits<double> {
+    typedef uint64_t type;
+    static inline type get(double s) {
+        type b;
+        memcpy(&b, &s, sizeof(b));
+        return b;
+    }
+};
+
+/** Returns 1 if x > limit, for unsigned values below the top bit */
+template<class U>
+inline U single_assigner_builtin_bits_greater(U x, U limit) {
+    return (limit - x) >> (sizeof(U) * 8 - 1);
+}
+
+template<class dst_type, class src_type, type_kind_t dst_kind, type_kind_t src_kind,
+         assign_error_mode errmode, bool native>
+struct single_assigner_builtin_block_base
+{
+    static const bool enabled = false;
+    typedef unsigned char mask_type;
+    static inline mask_type check(src_type DYND_UNUSED(s)) {
+        return 0;
+    }
+};
+
+// Signed int -> signed int, checked when sizeof(dst) < sizeof(src)
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, int_kind, int_kind, errmode, true>
+{
+    static const bool enabled = sizeof(dst_type) < sizeof(src_type);
+    typedef typename std::make_unsigned<src_type>::type mask_type;
+    static inline mask_type check(src_type s) {
+        // Shifts the dst range to start at zero, then looks for high bits
+        mask_type dst_min = static_cast<mask_type>(std::numeric_limits<dst_type>::min());
+        mask_type dst_max = static_cast<mask_type>(std::numeric_limits<dst_type>::max());
+        return (static_cast<mask_type>(s) - dst_min) & ~(dst_max - dst_min);
+    }
+};
+
+// Unsigned int -> signed int, checked when sizeof(dst) <= sizeof(src)
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, int_kind, uint_kind, errmode, true>
+{
+    static const bool enabled = sizeof(dst_type) <= sizeof(src_type);
+    typedef src_type mask_type;
+    static inline mask_type check(src_type s) {
+        return s & ~static_cast<mask_type>(std::numeric_limits<dst_type>::max());
+    }
+};
+
+// Signed int -> unsigned int
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, uint_kind, int_kind, errmode, true>
+{
+    static const bool enabled = true;
+    typedef typename std::make_unsigned<src_type>::type mask_type;
+    static inline mask_type check(src_type s) {
+        // Negative values have the top bit set
+        mask_type max = sizeof(dst_type) < sizeof(src_type)
+                ? static_cast<mask_type>(std::numeric_limits<dst_type>::max())
+                : static_cast<mask_type>(std::numeric_limits<src_type>::max());
+        return static_cast<mask_type>(s) & ~max;
+    }
+};
+
+// Unsigned int -> unsigned int, checked when sizeof(dst) < sizeof(src)
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, uint_kind, uint_kind, errmode, true>
+{
+    static const bool enabled = sizeof(dst_type) < sizeof(src_type);
+    typedef src_type mask_type;
+    static inline mask_type check(src_type s) {
+        return s & ~static_cast<mask_type>(std::numeric_limits<dst_type>::max());
+    }
+};
+
+// Floating point -> signed int
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, int_kind, real_kind, errmode, true>
+{
+    static const bool enabled = true;
+    typedef typename single_assigner_builtin_float_bits<src_type>::type mask_type;
+    static inline mask_type check(src_type s) {
+        // Flags |s| > max, which covers s < min as well
+        typedef single_assigner_builtin_float_bits<src_type> bits;
+        mask_type abs_bits = bits::get(s) & (~mask_type(0) >> 1);
+        mask_type limit = bits::get(static_cast<src_type>(std::numeric_limits<dst_type>::max()));
+        // A fractional part leaves nonzero bits, other than the sign, in floor(s) - s
+        return single_assigner_builtin_bits_greater(abs_bits, limit) |
+               (errmode != assign_error_overflow ? bits::get(std::floor(s) - s) << 1 : 0);
+    }
+};
+
+// Floating point -> unsigned int
+template<class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block_base<dst_type, src_type, uint_kind, real_kind, errmode, true>
+{
+    static const bool enabled = true;
+    typedef typename single_assigner_builtin_float_bits<src_type>::type mask_type;
+    static inline mask_type check(src_type s) {
+        // Flags |s| > max, and anything with the sign bit set
+        typedef single_assigner_builtin_float_bits<src_type> bits;
+        mask_type s_bits = bits::get(s);
+        mask_type abs_bits = s_bits & (~mask_type(0) >> 1);
+        mask_type limit = bits::get(static_cast<src_type>(std::numeric_limits<dst_type>::max()));
+        return single_assigner_builtin_bits_greater(abs_bits, limit) |
+               (s_bits >> (sizeof(mask_type) * 8 - 1)) |
+               (errmode != assign_error_overflow ? bits::get(std::floor(s) - s) << 1 : 0);
+    }
+};
+
+// double -> float
+template<assign_error_mode errmode>
+struct single_assigner_builtin_block_base<float, double, real_kind, real_kind, errmode, true>
+{
+    static const bool enabled = true;
+    typedef uint64_t mask_type;
+    static inline mask_type check(double s) {
+        // Flags |s| > the float max, which includes inf and NaN
+        typedef single_assigner_builtin_float_bits<double> bits;
+        mask_type abs_bits = bits::get(s) & (~mask_type(0) >> 1);
+        mask_type limit = bits::get(static_cast<double>(std::numeric_limits<float>::max()));
+        // Lost precision leaves nonzero bits, other than the sign, in the difference
+        return single_assigner_builtin_bits_greater(abs_bits, limit) |
+               (errmode == assign_error_inexact
+                    ? bits::get(static_cast<double>(static_cast<float>(s)) - s) << 1 : 0);
+    }
+};
+
+/**
+ * Assigns contiguous values with error checking, checking a block at a
+ * time with single_assigner_builtin_block_base::check before converting
+ * it. Only used when ``enabled`` is true.
+ */
+template <class dst_type, class src_type, assign_error_mode errmode>
+struct single_assigner_builtin_block
+    : public single_assigner_builtin_block_base<dst_type, src_type,
+                        dynd_kind_of<dst_type>::value, dynd_kind_of<src_type>::value, errmode,
+                        std::is_arithmetic<dst_type>::value && std::is_arithmetic<src_type>::value>
+{
+    typedef single_assigner_builtin_block_base<dst_type, src_type,
+                        dynd_kind_of<dst_type>::value, dynd_kind_of<src_type>::value, errmode,
+                        std::is_arithmetic<dst_type>::value && std::is_arithmetic<src_type>::value> base_type;
+
+    enum { block_size = 256 };
+
+    static void assign_contiguous(dst_type *dst, const src_type *src, size_t count) {
+        while (count > 0) {
+            size_t n = count < (size_t)block_size ? count : (size_t)block_size;
+            typename base_type::mask_type flagged = 0;
+            for (size_t i = 0; i != n; ++i) {
+                flagged |= base_type::check(src[i]);
+            }
+            if (flagged == 0) {
+                for (size_t i = 0; i != n; ++i) {
+                    single_assigner_builtin<dst_type, src_type, assign_error_nocheck>::assign(dst + i, src + i);
+                }
+            } else {
+                // Reports the first bad value, assigning the ones before it
+                for (size_t i = 0; i != n; ++i) {
+                    single_assigner_builtin<dst_type, src_type, errmode>::assign(dst + i, src + i);
+                }
+            }
+            dst += n;
+            src += n;
+            count -= n;
+        }
+    }
+};
+
 } // namespace dynd
@@ -12,6 +12,27 @@
 
 namespace dynd {
 
+/**
+ * Hints about how a memory-mapped file will be accessed. These are passed
+ * on to the operating system as advice, so they only affect performance,
+ * never the contents of the mapping. Hints the platform does not support
+ * are ignored.
+ */
+enum memmap_hint_flags {
+    /** No special treatment, the default readahead of the platform */
+    memmap_hint_normal = 0x00,
+    /** The data will be scanned in order, so read ahead aggressively */
+    memmap_hint_sequential = 0x01,
+    /** The data will be accessed in random order, so don't read ahead */
+    memmap_hint_random = 0x02,
+    /** The data will be needed soon, so start reading it in now */
+    memmap_hint_willneed = 0x04,
+    /** Read in the whole mapping before returning (MAP_POPULATE) */
+    memmap_hint_populate = 0x08,
+    /** Back the mapping with huge pages where the platform allows it */
+    memmap_hint_hugepages = 0x10
+};
+
 /**
  * Creates a memory block of a memory-mapped file.
  *
@@ -29,10 +50,76 @@ namespace dynd {
  *             (default end of the file). This value may be
  *             negative, in which case it is interpreted as an offset from the
  *             end of the file.
+ * \param hints  A combination of memmap_hint_flags describing how the
+ *               mapping will be accessed.
  */
 memory_block_ptr make_memmap_memory_block(const std::string& filename,
     uint32_t access, char **out_pointer, intptr_t *out_size,
-    intptr_t begin = 0, intptr_t end = std::numeric_limits<intptr_t>::max());
+    intptr_t begin = 0, intptr_t end = std::numeric_limits<intptr_t>::max(),
+    uint32_t hints = memmap_hint_normal);
+
+/**
+ * Gives the operating system advice about how the range [begin, end) of
+ * a memory-mapped file will be accessed, for example to switch a part of
+ * a mapping to random access, or to start reading in a range which will
+ * be needed soon. The range is widened to page boundaries.
+ *
+ * \param begin  The start of the range, inside a mapping.
+ * \param end  The end of the range, inside the same mapping.
+ * \param hints  A combination of memmap_hint_flags.
+ */
+void memmap_advise(const char *begin, const char *end, uint32_t hints);
+
+/**
+ * Warms the pages of a strided scan over memory-mapped data on a
+ * background thread, staying up to ``lookahead`` elements ahead of the
+ * position reported by the scan. The page faults, and any reads from
+ * disk, happen on the background thread instead of in the scan.
+ *
+ * Example:
+ *     memmap_prefetcher pf(data, stride, count, sizeof(double), 65536);
+ *     for (intptr_t i = 0; i < count; ++i) {
+ *         pf.advance(i);
+ *         sum += *(const double *)(data + i * stride);
+ *     }
+ */
+class memmap_prefetcher {
+    struct state;
+    state *m_state;
+    // The position at which advance next wakes up the thread
+    intptr_t m_next_notify;
+
+    void notify(intptr_t i);
+
+    // Non-copyable
+    memmap_prefetcher(const memmap_prefetcher&);
+    memmap_prefetcher& operator=(const memmap_prefetcher&);
+public:
+    /**
+     * Starts prefetching the elements [0, lookahead) of the scan.
+     *
+     * \param origin  Pointer to element 0 of the scan.
+     * \param stride  The stride between elements, which may be negative.
+     * \param count  The number of elements in the scan.
+     * \param element_size  The number of bytes read at each element.
+     * \param lookahead  How many elements to keep warm ahead of the scan.
+     */
+    memmap_prefetcher(const char *origin, intptr_t stride, intptr_t count,
+                      intptr_t element_size, intptr_t lookahead);
+
+    /** Stops the background thread */
+    ~memmap_prefetcher();
+
+    /**
+     * Reports that the scan has reached element ``i``. This is cheap
+     * enough to call for every element.
+     */
+    inline void advance(intptr_t i) {
+        if (i >= m_next_notify) {
+            notify(i);
+        }
+    }
+};
 
 void memmap_memory_block_debug_print(const memory_block_data *memblock, std::ostream& o, const std::string& indent);
 
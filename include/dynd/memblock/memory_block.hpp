@@ -140,6 +140,46 @@ memory_block_pod_allocator_api *get_memory_block_pod_allocator_api(memory_block_
  */
 memory_block_objectarray_allocator_api *get_memory_block_objectarray_allocator_api(memory_block_data *memblock);
 
+namespace detail {
+    /**
+     * Allocates a chunk of at least ``size_bytes`` bytes for a growable
+     * memory block. Chunks are taken from a thread-local pool of power of
+     * two size classes when possible, and ``*out_capacity_bytes`` receives
+     * the real size of the chunk, which the memory block may use in full.
+     *
+     * Throws std::bad_alloc if the memory cannot be allocated.
+     */
+    char *memory_chunk_alloc(intptr_t size_bytes, intptr_t *out_capacity_bytes);
+
+    /**
+     * Returns the capacity memory_chunk_alloc gives a chunk of
+     * ``size_bytes`` bytes.
+     */
+    intptr_t memory_chunk_capacity(intptr_t size_bytes);
+
+    /**
+     * Returns a chunk from memory_chunk_alloc to the pool of the calling
+     * thread, or to the system if the pool is full. The capacity must be
+     * the one memory_chunk_alloc returned.
+     */
+    void memory_chunk_free(char *chunk, intptr_t capacity_bytes);
+} // namespace detail
+
+struct memory_chunk_pool_stats {
+    /** Number of bytes in chunks currently allocated */
+    intptr_t bytes_in_flight;
+    /** Number of chunk allocations satisfied from a pool */
+    intptr_t hits;
+    /** Number of chunk allocations which had to go to the system */
+    intptr_t misses;
+};
+
+/**
+ * Returns process-wide counters for the chunks used by the pod,
+ * zeroinit and objectarray memory blocks and by ckernel_builders.
+ */
+memory_chunk_pool_stats get_memory_chunk_pool_stats();
+
 
 
 namespace detail {
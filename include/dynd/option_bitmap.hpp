@@ -0,0 +1,79 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+/**
+ * Validity bitmaps hold the availability of the elements of a
+ * one-dimensional option array as one bit per element, beside the values.
+ * Bit ``i % 64`` of word ``i / 64`` is set when element ``i`` is available,
+ * and the bits past the last element are zero. On little endian machines
+ * this is the byte layout of an Arrow validity buffer.
+ */
+
+#pragma once
+
+#include <dynd/array.hpp>
+
+namespace dynd {
+
+/** The number of 64-bit words in the validity bitmap of ``size`` elements */
+inline intptr_t validity_bitmap_word_count(intptr_t size)
+{
+  return (size + 63) / 64;
+}
+
+inline bool validity_bitmap_get(const uint64_t *bits, intptr_t i)
+{
+  return ((bits[i / 64] >> (i % 64)) & 1) != 0;
+}
+
+inline void validity_bitmap_set(uint64_t *bits, intptr_t i, bool avail)
+{
+  uint64_t bit = (uint64_t)1 << (i % 64);
+  if (avail) {
+    bits[i / 64] |= bit;
+  } else {
+    bits[i / 64] &= ~bit;
+  }
+}
+
+/**
+ * Returns the number of set bits among the first ``size`` bits of
+ * ``bits``, counting a word at a time.
+ */
+intptr_t validity_bitmap_count(const uint64_t *bits, intptr_t size);
+
+namespace nd {
+
+  /**
+   * Returns the validity bitmap of the one-dimensional strided option
+   * array ``a``, as a "W * uint64" array with
+   * W = validity_bitmap_word_count(N).
+   */
+  nd::array validity_bitmap(const nd::array &a);
+
+  /**
+   * Returns a new "N * ?T" array holding the elements of the
+   * one-dimensional strided "N * T" array ``values`` where ``bitmap`` has
+   * a bit set, and NA elsewhere. If ``values`` is itself an option array,
+   * T is its value type.
+   *
+   * The values are copied in blocks with one strided value assignment
+   * each, and only the runs of clear bits are then overwritten with NA,
+   * so columns with few missing values don't branch per element.
+   */
+  nd::array option_from_bitmap(const nd::array &values,
+                               const nd::array &bitmap);
+
+  /**
+   * Returns the sum of the elements of the one-dimensional strided array
+   * ``values`` where ``bitmap`` has a bit set, as an int64, uint64 or
+   * float64 scalar by the kind of the values. The values may be bool,
+   * integers or float32/64, or options of those.
+   */
+  nd::array masked_sum(const nd::array &values, const nd::array &bitmap);
+
+} // namespace nd
+
+} // namespace dynd
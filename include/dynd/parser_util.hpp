@@ -94,6 +94,21 @@ inline void skip_whitespace(const char *&rbegin, const char *end)
     rbegin = begin;
 }
 
+/**
+ * Returns a pointer to the first byte in the range which is not whitespace,
+ * as classified by ``isspace`` in the C locale, or ``end`` if there is none.
+ * Where SSE2 is available, long runs like the indentation of pretty-printed
+ * JSON are scanned 16 bytes at a time.
+ */
+const char *skip_whitespace_run(const char *begin, const char *end);
+
+/**
+ * Returns a pointer to the first double quote or backslash in the range,
+ * or ``end`` if there is none. This is how the body of a double-quoted
+ * string is scanned, 16 bytes at a time where SSE2 is available.
+ */
+const char *find_quote_or_backslash(const char *begin, const char *end);
+
 /**
  * Modifies `begin` to skip past any whitespace and comments starting with #.
  *
@@ -479,7 +494,9 @@ dynd_uint128 unchecked_string_to_uint128(const char *begin, const char *end);
 
 /**
  * Converts a string containing only a floating point number into
- * a float64/C double.
+ * a float64/C double. Plain decimal numbers with at most 19 significant
+ * digits, the usual case, are converted exactly without going through
+ * strtod, using the Clinger fast path or the Eisel-Lemire algorithm.
  */
 double checked_string_to_float64(const char *begin, const char *end,
                                 assign_error_mode errmode);
@@ -6,17 +6,29 @@
 #pragma once
 
 #include <dynd/array.hpp>
+#include <dynd/func/arrfunc.hpp>
 #include <dynd/types/dynd_complex.hpp>
 
-namespace dynd { namespace nd {
+namespace dynd {
+
+namespace nd {
 
   /**
-   * Primitive function to construct an nd::array with each element initialized
-   * to a random value. This is used only for testing right now, and it should
-   * be completely redone at some point.
+   * Constructs an nd::array with each element set to a uniform random
+   * value in [0, 1), or to a complex value with both parts drawn that way.
+   * Supports float32, float64, complex[float32] and complex[float64].
+   *
+   * The values come from the Philox4x32-10 counter-based generator, where
+   * each element is a pure function of (seed, stream, element index). Large
+   * arrays are filled in parallel according to the nthreads setting of the
+   * default eval context, and the result does not depend on it.
+   *
+   * The version without a seed draws a fresh seed on every call.
    */
   nd::array rand(const ndt::type &tp);
 
+  nd::array rand(const ndt::type &tp, uint64_t seed, uint64_t stream = 0);
+
   inline nd::array rand(intptr_t dim0, const ndt::type &tp)
   {
     return rand(ndt::make_fixed_dim(dim0, tp));
@@ -34,4 +46,40 @@ namespace dynd { namespace nd {
         dim0, ndt::make_fixed_dim(dim1, ndt::make_fixed_dim(dim2, tp))));
   }
 
-}} // namespace dynd::nd
+} // namespace nd
+
+/**
+ * Arrfuncs which create arrays of random values, taking all their
+ * parameters as keywords. Each call produces an array of the type id
+ * the arrfunc was made for, with the dimensions in the "shape" keyword
+ * (an integer or a 1D array of integers, a scalar if absent).
+ *
+ * All of them accept the "seed" and "stream" keywords, both defaulting
+ * to 0, and produce the same values for the same seed, stream and
+ * shape, no matter how many threads the eval context allows. Distinct
+ * streams with the same seed are statistically independent.
+ *
+ *   make_uniform_arrfunc  Uniform in ["low", "high"), defaults 0 and 1.
+ *                         float32, float64, complex[float32] and
+ *                         complex[float64], drawing both parts of a
+ *                         complex value independently.
+ *   make_normal_arrfunc   Normal with "mean" and "stddev", defaults 0
+ *                         and 1. float32 and float64.
+ *   make_randint_arrfunc  Uniform integers in ["low", "high"] inclusive,
+ *                         defaulting to 0 and the largest value of the
+ *                         type. Any builtin integer type up to 64 bits.
+ */
+nd::arrfunc make_uniform_arrfunc(type_id_t tid);
+nd::arrfunc make_normal_arrfunc(type_id_t tid);
+nd::arrfunc make_randint_arrfunc(type_id_t tid);
+
+namespace detail {
+  /**
+   * The Philox4x32-10 block function, turning a four word counter and a
+   * two word key into four random words.
+   */
+  void philox4x32_10(const uint32_t *counter, const uint32_t *key,
+                     uint32_t *out);
+} // namespace detail
+
+} // namespace dynd
@@ -0,0 +1,53 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/array.hpp>
+#include <dynd/func/arrfunc.hpp>
+
+namespace dynd {
+
+namespace nd {
+
+  /**
+   * Returns a copy of ``a`` with the values sorted along its last
+   * dimension, which must be strided. The sort is stable, orders NaN
+   * after all the other floating point values, and uses the nthreads
+   * setting of the default eval context for large dimensions.
+   */
+  nd::array sort(const nd::array &a);
+
+  /**
+   * Returns the intptr indices which stably sort ``a`` along its last
+   * dimension, which must be strided.
+   */
+  nd::array argsort(const nd::array &a);
+
+} // namespace nd
+
+/**
+ * Arrfuncs with the signatures "(N * T) -> N * T" and
+ * "(N * T) -> N * intptr", which sort a strided dimension or produce the
+ * indices which sort it. Both are stable, and lift_arrfunc applies them
+ * along the last dimension of a bigger array.
+ *
+ * The element type determines the algorithm:
+ *
+ *   bool, ints, float32/64  LSD radix sort on the bits of the values,
+ *                           with NaN ordered last. Dimensions of at least
+ *                           a million elements are split across the
+ *                           threads of the eval context, and the sorted
+ *                           runs merged.
+ *   ascii/utf8 string       Radix sort on an 8 byte prefix of each string,
+ *                           then a comparison sort of the strings which
+ *                           share a prefix.
+ *   anything else           A comparison merge sort using the type's
+ *                           sorting_less comparison kernel.
+ */
+nd::arrfunc make_sort_arrfunc();
+nd::arrfunc make_argsort_arrfunc();
+
+} // namespace dynd
@@ -35,6 +35,12 @@ public:
     {
     }
     inline string(const std::string& rhs) : m_value(rhs) {}
+
+    inline string& operator=(const nd::string& rhs) {
+        m_value = rhs.m_value;
+        return *this;
+    }
+
     /**
      * Constructor from an nd::array. Validates the input, and evaluates
      * to "string" type if it has the "string" kind.
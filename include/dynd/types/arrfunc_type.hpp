@@ -13,6 +13,7 @@
 #include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/fixed_dimsym_type.hpp>
 #include <dynd/types/string_type.hpp>
+#include <dynd/types/type_pattern_match.hpp>
 
 namespace dynd {
 
@@ -22,6 +23,7 @@ class arrfunc_type : public base_type {
   nd::array m_arg_names;
 
   std::vector<intptr_t> m_opt_indices;
+  ndt::pattern_signature m_pos_signature;
 
 public:
   arrfunc_type(const ndt::type &ret_type, const nd::array &arg_types,
@@ -53,7 +55,7 @@ public:
   intptr_t get_arg_index(const char *arg_name_begin,
                          const char *arg_name_end) const;
 
-  std::vector<intptr_t> get_option_arg_indices() const
+  const std::vector<intptr_t> &get_option_arg_indices() const
   {
     return m_opt_indices;
   }
@@ -88,6 +90,15 @@ public:
 
   const ndt::type &get_return_type() const { return m_return_type; }
 
+  /**
+   * The positional parameters and return type, precompiled for matching
+   * the argument types of calls.
+   */
+  const ndt::pattern_signature &get_pos_signature() const
+  {
+    return m_pos_signature;
+  }
+
   void print_data(std::ostream &o, const char *arrmeta, const char *data) const;
 
   void print_type(std::ostream &o) const;
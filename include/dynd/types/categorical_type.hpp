@@ -19,23 +19,27 @@ struct assign_to_same_category_type;
 
 namespace dynd {
 
+class value_hash_index;
+
 class categorical_type : public base_type {
     // The data type of the category
     ndt::type m_category_tp;
     // The integer type used for storage
     ndt::type m_storage_type;
-    // list of categories, in sorted order
+    // list of categories, in the order of their values
+    nd::array m_categories_by_value;
+    // hash table from categories to values, or NULL if the category
+    // type can't be hashed independently of its arrmeta
+    value_hash_index *m_value_index;
+    // when there is no hash table, the list of categories in sorted
+    // order, and the mapping from their indices to values
     nd::array m_categories;
-    // mapping from category indices to values
     nd::array m_category_index_to_value;
-    // mapping from values to category indices
-    nd::array m_value_to_category_index;
 
 public:
     categorical_type(const nd::array &categories, bool presorted = false);
 
-    virtual ~categorical_type() {
-    }
+    virtual ~categorical_type();
 
     void print_data(std::ostream &o, const char *arrmeta,
                     const char *data) const;
@@ -47,7 +51,7 @@ public:
 
     size_t get_category_count() const {
         return (size_t) reinterpret_cast<const fixed_dim_type_arrmeta *>(
-                   m_categories.get_arrmeta())->dim_size;
+                   m_categories_by_value.get_arrmeta())->dim_size;
     }
 
     /**
@@ -68,16 +72,21 @@ public:
     uint32_t get_value_from_category(const char *category_arrmeta,
                                      const char *category_data) const;
     uint32_t get_value_from_category(const nd::array &category) const;
+    /**
+     * Writes the values of the ``count`` categories at ``category_data``,
+     * spaced by ``stride``, to ``out_values``.
+     */
+    void get_values_from_categories(const char *category_arrmeta,
+                                    const char *category_data, intptr_t stride,
+                                    intptr_t count, intptr_t *out_values) const;
 
     const char *get_category_data_from_value(uint32_t value) const {
       if (value >= get_category_count()) {
         throw std::runtime_error("category value is out of bounds");
       }
-      return m_categories.get_readonly_originptr() +
-             unchecked_fixed_dim_get<intptr_t>(m_value_to_category_index,
-                                               value) *
-                 reinterpret_cast<const fixed_dim_type_arrmeta *>(
-                     m_categories.get_arrmeta())->stride;
+      return m_categories_by_value.get_readonly_originptr() +
+             value * reinterpret_cast<const fixed_dim_type_arrmeta *>(
+                         m_categories_by_value.get_arrmeta())->stride;
     }
     /** Returns the arrmeta corresponding to data from get_category_data_from_value */
     const char *get_category_arrmeta() const;
@@ -37,6 +37,24 @@ inline ndt::type type_from_datashape(const char (&datashape)[N])
     return type_from_datashape(datashape, datashape + N - 1);
 }
 
+struct datashape_cache_stats {
+  // Number of parses answered from the cache
+  intptr_t hits;
+  // Number of parses which had to run the parser
+  intptr_t misses;
+  // Number of datashapes currently held by the cache
+  intptr_t size;
+};
+
+/**
+ * type_from_datashape keeps the most recently parsed datashapes in a
+ * thread-safe LRU cache, with the types interned by ndt::intern, so
+ * parsing the same text again is a hash lookup and gives the identical
+ * type object. These return its hit/miss counters and size, and empty it.
+ */
+datashape_cache_stats get_datashape_cache_stats();
+void clear_datashape_cache();
+
 namespace init {
 void datashape_parser_init();
 void datashape_parser_cleanup();
@@ -0,0 +1,130 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <string>
+
+#include <dynd/config.hpp>
+#include <dynd/type.hpp>
+#include <dynd/typed_data_assign.hpp>
+#include <dynd/types/date_util.hpp>
+#include <dynd/types/time_util.hpp>
+#include <dynd/types/datetime_util.hpp>
+
+namespace dynd {
+
+/**
+ * A fixed-width ISO 8601 layout of date, time or datetime strings, like
+ * "YYYY-MM-DD", "HH:MM:SS.ffff" or "YYYY-MM-DDTHH:MM:SSZ". The string
+ * columns a date, time or datetime array is parsed from nearly always
+ * share one such layout, so the string assignment kernels detect it from
+ * the first values and then check each string against it with a single
+ * compare of all its chars, instead of trying the general parser's formats
+ * one after another. Strings which don't match use the general parser.
+ */
+struct datetime_layout {
+  enum {
+    // The longest string with a fixed layout
+    max_length = 32,
+    // How many values the kernels try to detect a layout from
+    max_detect_count = 8
+  };
+
+  // The char expected at each position which isn't a digit, and zero
+  // past the end
+  char literal[max_length];
+  // 0xff at the positions of digits, 0 elsewhere
+  unsigned char digit[max_length];
+  // The length of the strings, 0 if there is no layout
+  int length;
+  // Where the time begins, -1 for a date without a time
+  int time_offset;
+  // Where the seconds begin, -1 for an "HH:MM" time
+  int second_offset;
+  // Where the fractional seconds begin and how many digits there are,
+  // 0 digits if there is no fraction
+  int fraction_offset, fraction_digits;
+
+  datetime_layout() : length(0) {}
+
+  inline bool empty() const { return length == 0; }
+
+  /**
+   * Detects the layout of the date string [begin, end), which must be
+   * "YYYY-MM-DD". Returns false, leaving the layout empty, if it doesn't
+   * have a fixed layout.
+   */
+  bool detect_date(const char *begin, const char *end);
+
+  /**
+   * Detects the layout of the time string [begin, end), one of "HH:MM",
+   * "HH:MM:SS" or "HH:MM:SS.f...", optionally followed by "Z".
+   */
+  bool detect_time(const char *begin, const char *end);
+
+  /**
+   * Detects the layout of the datetime string [begin, end), a date as for
+   * detect_date, optionally followed by "T" or " " and a time as for
+   * detect_time.
+   */
+  bool detect_datetime(const char *begin, const char *end);
+
+  /**
+   * Parses the string [begin, end) if it matches the layout and holds
+   * a valid value, returning false otherwise. The parse functions give
+   * the same values as string_to_date, string_to_time and
+   * string_to_datetime, ignoring any "Z" time zone as those do.
+   */
+  bool parse_date(const char *begin, const char *end, date_ymd &out_ymd) const;
+  bool parse_time(const char *begin, const char *end,
+                  time_hmst &out_hmst) const;
+  bool parse_datetime(const char *begin, const char *end,
+                      datetime_struct &out_dt) const;
+
+private:
+  bool detect(const char *begin, const char *end, bool date, bool time);
+  bool matches(const char *begin, const char *end, char *buf) const;
+  bool parse_hmst(const char *buf, time_hmst &out_hmst) const;
+};
+
+/**
+ * The source side of the string to date, time and datetime assignment
+ * kernels. It reads the strings as UTF-8 and holds the layout detected
+ * from the first of them.
+ */
+struct datetime_string_source {
+  enum kind_t { date_kind, time_kind, datetime_kind };
+
+  ndt::type string_tp;
+  const char *arrmeta;
+  assign_error_mode errmode;
+  kind_t kind;
+  // True if the strings are UTF-8 or ASCII, and can be parsed in place
+  bool utf8;
+  // The layout of the strings, detected from the first values
+  datetime_layout layout;
+  int detect_count;
+
+  void init(const ndt::type &src_string_tp, const char *src_arrmeta,
+            assign_error_mode src_errmode, kind_t src_kind);
+
+  /**
+   * Gets the UTF-8 string at ``src`` as [out_begin, out_end), using
+   * ``buf`` to hold it if it has to be converted. Returns true if the
+   * string is "NA".
+   */
+  bool get_range(const char *src, const char *&out_begin,
+                 const char *&out_end, std::string &buf) const;
+
+  /**
+   * Called with a string which didn't match the layout. If there is no
+   * layout yet, tries to detect one from it, giving up after
+   * datetime_layout::max_detect_count strings.
+   */
+  void detect(const char *begin, const char *end);
+};
+
+} // namespace dynd
@@ -9,6 +9,7 @@
 
 #include <dynd/type.hpp>
 #include <dynd/string.hpp>
+#include <dynd/types/type_pattern_match.hpp>
 
 namespace dynd { namespace ndt {
 
@@ -16,13 +17,15 @@ namespace detail {
   ndt::type internal_substitute(const ndt::type &pattern,
                                 const std::map<nd::string, ndt::type> &typevars,
                                 bool concrete);
+  ndt::type internal_substitute(const ndt::type &pattern,
+                                const typevar_table &typevars, bool concrete);
 }
 
 /**
  * Substitutes type variables in a pattern type.
  *
  * \param pattern  A symbolic type within which to substitute typevars.
- * \param typevars  A map of names to type var values.
+ * \param typevars  A map or table of names to type var values.
  * \param concrete  If true, requires that the result be concrete.
  */
 inline ndt::type substitute(const ndt::type &pattern,
@@ -38,4 +41,14 @@ inline ndt::type substitute(const ndt::type &pattern,
   }
 }
 
+inline ndt::type substitute(const ndt::type &pattern,
+                            const typevar_table &typevars, bool concrete)
+{
+  if (!pattern.is_symbolic() && pattern.get_type_id() != arrfunc_type_id) {
+    return pattern;
+  } else {
+    return detail::internal_substitute(pattern, typevars, concrete);
+  }
+}
+
 }} // namespace dynd::ndt
@@ -0,0 +1,45 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#pragma once
+
+#include <dynd/type.hpp>
+
+namespace dynd { namespace ndt {
+
+/**
+ * Returns the instance of ``tp`` held by the process-wide intern table,
+ * adding ``tp`` to the table if no type equal to it is there yet. All
+ * interned types which are equal share one base_type object, so comparing
+ * them with operator== is a pointer compare. Builtin types are returned
+ * as is.
+ *
+ * The table is thread-safe. Types which nothing but the table refers to
+ * any more are swept out of it as it grows.
+ */
+ndt::type intern(const ndt::type &tp);
+
+} // namespace ndt
+
+struct type_intern_stats {
+  // Number of intern calls which found an equal type in the table
+  intptr_t hits;
+  // Number of intern calls which added the type to the table
+  intptr_t misses;
+  // Number of types currently held by the table
+  intptr_t size;
+};
+
+/**
+ * Returns the hit/miss counters and the current size of the intern table.
+ */
+type_intern_stats get_type_intern_stats();
+
+namespace init {
+void type_intern_init();
+void type_intern_cleanup();
+} // namespace init
+
+} // namespace dynd
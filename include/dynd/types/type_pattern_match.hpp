@@ -6,12 +6,101 @@
 #pragma once
 
 #include <map>
+#include <new>
 
 #include <dynd/type.hpp>
 #include <dynd/string.hpp>
 
 namespace dynd { namespace ndt {
 
+/**
+ * A flat table of typevar bindings with a fixed inline capacity, for use
+ * in place of a std::map when matching call signatures. It lives on the
+ * stack and never allocates, so matching the types of a call against a
+ * signature does no heap allocations. Lookups are a linear scan, which
+ * beats a tree for the handful of typevars a signature has.
+ *
+ * It supports the subset of the std::map interface used by the pattern
+ * matching and typevar substitution code.
+ */
+class typevar_table {
+public:
+  typedef std::pair<nd::string, ndt::type> value_type;
+  typedef value_type *iterator;
+  typedef const value_type *const_iterator;
+
+  /** The maximum number of distinct typevars the table can bind */
+  enum { capacity = 16 };
+
+private:
+  // Entries are only constructed as they are bound, so that an empty
+  // table costs nothing to set up and tear down
+  union {
+    char m_storage[capacity * sizeof(value_type)];
+    intptr_t m_align;
+  };
+  intptr_t m_size;
+
+  value_type *entries()
+  {
+    return reinterpret_cast<value_type *>(m_storage);
+  }
+  const value_type *entries() const
+  {
+    return reinterpret_cast<const value_type *>(m_storage);
+  }
+
+  // Bindings are referenced while matching continues, so the table can't
+  // be copied out from under them
+  typevar_table(const typevar_table &);
+  typevar_table &operator=(const typevar_table &);
+
+public:
+  typevar_table() : m_size(0) {}
+
+  ~typevar_table() { clear(); }
+
+  intptr_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  iterator begin() { return entries(); }
+  iterator end() { return entries() + m_size; }
+  const_iterator begin() const { return entries(); }
+  const_iterator end() const { return entries() + m_size; }
+
+  const_iterator find(const nd::string &name) const
+  {
+    const value_type *e = entries();
+    for (intptr_t i = 0; i < m_size; ++i) {
+      if (e[i].first == name) {
+        return e + i;
+      }
+    }
+    return end();
+  }
+
+  iterator find(const nd::string &name)
+  {
+    return const_cast<iterator>(
+        static_cast<const typevar_table *>(this)->find(name));
+  }
+
+  /**
+   * Returns the binding for the typevar, adding a null one if it isn't in
+   * the table yet. Throws a type_error if the table is full.
+   */
+  ndt::type &operator[](const nd::string &name);
+
+  void clear()
+  {
+    value_type *e = entries();
+    for (intptr_t i = 0; i < m_size; ++i) {
+      e[i].~value_type();
+    }
+    m_size = 0;
+  }
+};
+
 /**
  * Matches the provided concrete type against the pattern type, which may
  * include type vars. Returns true if it matches, false otherwise.
@@ -30,6 +119,8 @@ namespace dynd { namespace ndt {
  */
 bool pattern_match(const ndt::type &concrete, const ndt::type &pattern,
                    std::map<nd::string, ndt::type> &typevars);
+bool pattern_match(const ndt::type &concrete, const ndt::type &pattern,
+                   typevar_table &typevars);
 
 /**
  * Matches the dimensions of the provided concrete type against the
@@ -55,6 +146,9 @@ bool pattern_match_dims(const ndt::type &concrete, const ndt::type &pattern,
                         std::map<nd::string, ndt::type> &typevars,
                         ndt::type &out_concrete_dtype,
                         ndt::type &out_pattern_dtype);
+bool pattern_match_dims(const ndt::type &concrete, const ndt::type &pattern,
+                        typevar_table &typevars, ndt::type &out_concrete_dtype,
+                        ndt::type &out_pattern_dtype);
 
 /**
  * Matches the provided concrete type against the pattern type, which may
@@ -65,8 +159,52 @@ inline bool pattern_match(const ndt::type &concrete, const ndt::type &pattern)
   if (concrete.extended() == pattern.extended()) {
     return true;
   } else {
-    std::map<nd::string, ndt::type> typevars;
+    typevar_table typevars;
     return pattern_match(concrete, pattern, typevars);
   }
 }
+
+/**
+ * A list of parameter types precompiled for matching the argument types
+ * of many calls against it. Parameters whose type is concrete are
+ * compared for equality first, only going through the general pattern
+ * matcher if that fails, and whether the return type needs typevar
+ * substitution is determined once up front.
+ */
+class pattern_signature {
+  intptr_t m_nparam;
+  const ndt::type *m_param_tp;
+  // Bit i is set if parameter i is symbolic, for the first 64 parameters
+  uint64_t m_symbolic_mask;
+  bool m_symbolic_return;
+
+public:
+  pattern_signature()
+      : m_nparam(0), m_param_tp(NULL), m_symbolic_mask(0),
+        m_symbolic_return(false)
+  {
+  }
+
+  /**
+   * Precompiles the signature. The parameter types must outlive it.
+   */
+  pattern_signature(intptr_t nparam, const ndt::type *param_tp,
+                    const ndt::type &return_tp);
+
+  intptr_t get_nparam() const { return m_nparam; }
+
+  /**
+   * Whether the return type has typevars which must be substituted
+   * from the bindings of a match.
+   */
+  bool has_symbolic_return() const { return m_symbolic_return; }
+
+  /**
+   * Matches the value types of the ``nsrc`` argument types against the
+   * parameters, binding typevars in the table. Returns -1 if all of them
+   * match, otherwise the index of the first argument which doesn't.
+   * The caller checks that ``nsrc`` equals the number of parameters.
+   */
+  intptr_t match(const ndt::type *src_tp, typevar_table &typevars) const;
+};
 }} // namespace dynd::ndt
@@ -4,6 +4,7 @@
 //
 
 #include <sstream>
+#include <vector>
 
 #include <dynd/array.hpp>
 #include <dynd/type_promotion.hpp>
@@ -14,6 +15,10 @@
 #include <dynd/types/expr_type.hpp>
 #include <dynd/types/string_type.hpp>
 #include <dynd/kernels/string_algorithm_kernels.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/ctuple_type.hpp>
+#include <dynd/types/pointer_type.hpp>
+#include <dynd/memblock/array_memory_block.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -266,32 +271,373 @@ nd::array apply_binary_operator(const nd::array *ops,
 }
 
 namespace {
-    struct ckernel_prefix_with_init : public ckernel_prefix {
-        template<class R, class S, class T>
-        inline void init(R, S, T) {}
+    // The most operands make_elwise_dimension_expr_kernel supports,
+    // which limits how many operations get fused together
+    const size_t max_fused_operands = 6;
+
+    thread_local bool tls_deferred_arithmetic = false;
+
+    /**
+     * A chain of builtin arithmetic operations which all have the
+     * same type, evaluated as one kernel. The operations are stored in
+     * evaluation order, the last one producing the result. The leaf
+     * kernel runs them over DYND_BUFFER_CHUNK_SIZE elements at a time,
+     * keeping intermediate values in stack buffers which stay in cache.
+     */
+    class fused_arithmetic_kernel_generator : public expr_kernel_generator {
+    public:
+        struct operation {
+            expr_strided_t strided;
+            const char *name;
+            // An argument >= 0 is an operand index, and an argument
+            // < 0 is the result of the operation at index ~arg
+            intptr_t arg[2];
+        };
+
+    private:
+        ndt::type m_rdt;
+        size_t m_operand_count;
+        vector<operation> m_ops;
+
+        void print_arg(std::ostream& o, intptr_t arg) const {
+            if (arg >= 0) {
+                o << "op" << arg;
+            } else {
+                const operation& op = m_ops[~arg];
+                o << op.name << "(";
+                print_arg(o, op.arg[0]);
+                o << ", ";
+                print_arg(o, op.arg[1]);
+                o << ")";
+            }
+        }
+
+    public:
+        fused_arithmetic_kernel_generator(const ndt::type& rdt, size_t operand_count,
+                        const vector<operation>& ops)
+            : expr_kernel_generator(true), m_rdt(rdt),
+                            m_operand_count(operand_count), m_ops(ops)
+        {
+        }
+
+        virtual ~fused_arithmetic_kernel_generator() {
+        }
+
+        inline const ndt::type& get_type() const {
+            return m_rdt;
+        }
+
+        inline size_t get_operand_count() const {
+            return m_operand_count;
+        }
+
+        inline const vector<operation>& get_operations() const {
+            return m_ops;
+        }
+
+        void evaluate(char *dst, intptr_t dst_stride,
+                        char *const *src, const intptr_t *src_stride,
+                        size_t count) const
+        {
+            // Sixteen bytes per element covers every builtin type
+            double buffers[max_fused_operands - 2][2 * DYND_BUFFER_CHUNK_SIZE];
+            intptr_t data_size = m_rdt.get_data_size();
+            size_t op_count = m_ops.size();
+            // A single operation needs no buffers, so it does everything at once
+            size_t chunk_size = op_count == 1 ? count : DYND_BUFFER_CHUNK_SIZE;
+            for (size_t i = 0; i < count; i += chunk_size) {
+                size_t chunk_count = min(chunk_size, count - i);
+                for (size_t j = 0; j != op_count; ++j) {
+                    const operation& op = m_ops[j];
+                    char *args[2];
+                    intptr_t arg_stride[2];
+                    for (int k = 0; k != 2; ++k) {
+                        intptr_t arg = op.arg[k];
+                        if (arg >= 0) {
+                            args[k] = src[arg] + i * src_stride[arg];
+                            arg_stride[k] = src_stride[arg];
+                        } else {
+                            args[k] = reinterpret_cast<char *>(buffers[~arg]);
+                            arg_stride[k] = data_size;
+                        }
+                    }
+                    if (j == op_count - 1) {
+                        op.strided(dst + i * dst_stride, dst_stride,
+                                        args, arg_stride, chunk_count, NULL);
+                    } else {
+                        op.strided(reinterpret_cast<char *>(buffers[j]), data_size,
+                                        args, arg_stride, chunk_count, NULL);
+                    }
+                }
+            }
+        }
+
+        size_t make_expr_kernel(void *ckb, intptr_t ckb_offset,
+                                const ndt::type &dst_tp,
+                                const char *dst_arrmeta, size_t src_count,
+                                const ndt::type *src_tp,
+                                const char *const *src_arrmeta,
+                                kernel_request_t kernreq,
+                                const eval::eval_context *ectx) const;
+
+        void print_type(std::ostream& o) const
+        {
+            print_arg(o, ~(intptr_t)(m_ops.size() - 1));
+        }
     };
-} // anonymous namespace
 
-nd::array nd::operator+(const nd::array& op1, const nd::array& op2)
-{
-    nd::array ops[2] = {op1, op2};
-    expr_operation_pair func_ptr;
-    ndt::type op1dt = op1.get_dtype().value_type();
-    ndt::type op2dt = op2.get_dtype().value_type();
-    if (op1dt.is_builtin() && op1dt.is_builtin()) {
-        ndt::type rdt = promote_types_arithmetic(op1dt, op2dt);
-        int table_index = compress_builtin_type_id[rdt.get_type_id()];
-        if (table_index >= 0) {
-            func_ptr = addition_table[table_index];
+    struct fused_arithmetic_ck
+        : public kernels::expr_ck<fused_arithmetic_ck, kernel_request_host, 1> {
+        const fused_arithmetic_kernel_generator *m_kgen;
+
+        fused_arithmetic_ck(const fused_arithmetic_kernel_generator *kgen)
+            : m_kgen(kgen)
+        {
+            expr_kernel_generator_incref(m_kgen);
+        }
+
+        ~fused_arithmetic_ck() {
+            expr_kernel_generator_decref(m_kgen);
+        }
+
+        inline void single(char *dst, char *const *src)
+        {
+            static const intptr_t src_stride[max_fused_operands] = {0};
+            m_kgen->evaluate(dst, 0, src, src_stride, 1);
+        }
+
+        inline void strided(char *dst, intptr_t dst_stride,
+                        char *const *src, const intptr_t *src_stride,
+                        size_t count)
+        {
+            m_kgen->evaluate(dst, dst_stride, src, src_stride, count);
+        }
+    };
+
+    size_t fused_arithmetic_kernel_generator::make_expr_kernel(
+                    void *ckb, intptr_t ckb_offset,
+                    const ndt::type &dst_tp, const char *dst_arrmeta,
+                    size_t src_count, const ndt::type *src_tp,
+                    const char *const *src_arrmeta,
+                    kernel_request_t kernreq,
+                    const eval::eval_context *ectx) const
+    {
+        if (src_count != m_operand_count) {
+            stringstream ss;
+            ss << "The fused arithmetic kernel requires " << m_operand_count;
+            ss << " src operands, received " << src_count;
+            throw runtime_error(ss.str());
+        }
+        bool is_leaf = (dst_tp == m_rdt);
+        for (size_t i = 0; i != src_count && is_leaf; ++i) {
+            is_leaf = (src_tp[i] == m_rdt);
+        }
+        if (!is_leaf) {
+            return make_elwise_dimension_expr_kernel(ckb, ckb_offset,
+                            dst_tp, dst_arrmeta,
+                            src_count, src_tp, src_arrmeta,
+                            kernreq, ectx,
+                            this);
+        }
+        fused_arithmetic_ck::create_leaf(ckb, kernreq, ckb_offset, this);
+        return ckb_offset;
+    }
+
+    typedef fused_arithmetic_kernel_generator::operation fused_operation;
+
+    /**
+     * Returns the fused arithmetic generator of an unevaluated
+     * expression of type ``rdt``, or NULL if ``op`` isn't one.
+     */
+    const fused_arithmetic_kernel_generator *get_fused_kgen(const nd::array& op,
+                    const ndt::type& rdt)
+    {
+        const ndt::type& tp = op.get_type();
+        if (tp.get_type_id() == expr_type_id) {
+            const fused_arithmetic_kernel_generator *kgen =
+                dynamic_cast<const fused_arithmetic_kernel_generator *>(
+                                &tp.extended<expr_type>()->get_kgen());
+            if (kgen != NULL && kgen->get_type() == rdt) {
+                return kgen;
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * Returns operand ``i`` of the unevaluated expression ``op``,
+     * following the pointer to it in the expression's data.
+     */
+    nd::array get_expr_operand(const nd::array& op, size_t i)
+    {
+        const ctuple_type *operand_tp = op.get_type().extended<expr_type>()
+                        ->get_operand_type().extended<ctuple_type>();
+        const pointer_type_arrmeta *md = reinterpret_cast<const pointer_type_arrmeta *>(
+                        op.get_arrmeta() + operand_tp->get_arrmeta_offsets_raw()[i]);
+        const char *data = op.get_readonly_originptr() +
+                        operand_tp->get_data_offsets_raw()[i];
+        ndt::type tp = operand_tp->get_field_type(i).extended<pointer_type>()
+                        ->get_target_type();
+
+        nd::array result(make_array_memory_block(tp.get_arrmeta_size()));
+        if (!tp.is_builtin()) {
+            tp.extended()->arrmeta_copy_construct(result.get_arrmeta(),
+                            reinterpret_cast<const char *>(md + 1),
+                            &op.get_ndo()->m_memblockdata);
+        }
+        result.get_ndo()->m_type = tp.release();
+        result.get_ndo()->m_data_pointer =
+                        *reinterpret_cast<char *const *>(data) + md->offset;
+        result.get_ndo()->m_data_reference = md->blockref;
+        memory_block_incref(md->blockref);
+        result.get_ndo()->m_flags = op.get_flags();
+        return result;
+    }
+
+    /**
+     * Appends the operations of ``kgen`` to ``ops``, with its operands
+     * numbered from ``operand_offset``. Returns the argument
+     * referring to its result.
+     */
+    intptr_t append_operations(const fused_arithmetic_kernel_generator& kgen,
+                    intptr_t operand_offset, vector<fused_operation>& ops)
+    {
+        intptr_t op_offset = ops.size();
+        const vector<fused_operation>& kgen_ops = kgen.get_operations();
+        for (size_t i = 0; i != kgen_ops.size(); ++i) {
+            fused_operation op = kgen_ops[i];
+            for (int k = 0; k != 2; ++k) {
+                op.arg[k] = op.arg[k] >= 0 ? op.arg[k] + operand_offset
+                                           : ~(~op.arg[k] + op_offset);
+            }
+            ops.push_back(op);
+        }
+        return ~(intptr_t)(ops.size() - 1);
+    }
+
+    nd::array apply_builtin_arithmetic(const nd::array& op1, const nd::array& op2,
+                    const expr_operation_pair *table, const char *name)
+    {
+        ndt::type op1dt = op1.get_type().value_type().get_dtype();
+        ndt::type op2dt = op2.get_type().value_type().get_dtype();
+        ndt::type rdt;
+        expr_strided_t strided = NULL;
+        if (op1dt.is_builtin() && op2dt.is_builtin()) {
+            rdt = promote_types_arithmetic(op1dt, op2dt);
+            int table_index = compress_builtin_type_id[rdt.get_type_id()];
+            if (table_index >= 0) {
+                strided = table[table_index].strided;
+            }
+        }
+        if (strided == NULL) {
+            stringstream ss;
+            ss << "Operator " << name << " is not supported for dynd types ";
+            ss << op1dt << " and " << op2dt;
+            throw runtime_error(ss.str());
+        }
+
+        // Unevaluated operands of the same type get fused into this
+        // operation, as long as the operand count stays in range
+        const nd::array *ops[2] = {&op1, &op2};
+        const fused_arithmetic_kernel_generator *op_kgen[2];
+        size_t side_count[2], operand_count = 0;
+        for (int i = 0; i != 2; ++i) {
+            op_kgen[i] = get_fused_kgen(*ops[i], rdt);
+            side_count[i] = op_kgen[i] ? op_kgen[i]->get_operand_count() : 1;
+            operand_count += side_count[i];
+        }
+        // When there are too many, the side with fewer operands is
+        // evaluated first, so as much as possible stays fused
+        int order[2] = {1, 0};
+        if (side_count[0] < side_count[1]) {
+            swap(order[0], order[1]);
+        }
+        for (int k = 0; k != 2 && operand_count > max_fused_operands; ++k) {
+            int i = order[k];
+            if (op_kgen[i] != NULL) {
+                operand_count -= side_count[i] - 1;
+                op_kgen[i] = NULL;
+            }
+        }
+
+        vector<nd::array> operands;
+        vector<fused_operation> fused_ops;
+        fused_operation result_op;
+        result_op.strided = strided;
+        result_op.name = name;
+        for (int i = 0; i != 2; ++i) {
+            if (op_kgen[i] != NULL) {
+                result_op.arg[i] = append_operations(*op_kgen[i],
+                                operands.size(), fused_ops);
+                size_t count = op_kgen[i]->get_operand_count();
+                for (size_t j = 0; j != count; ++j) {
+                    operands.push_back(get_expr_operand(*ops[i], j));
+                }
+            } else {
+                result_op.arg[i] = operands.size();
+                if (ops[i]->get_type().get_type_id() == expr_type_id) {
+                    operands.push_back(ops[i]->eval().ucast(rdt));
+                } else {
+                    operands.push_back(ops[i]->ucast(rdt));
+                }
+            }
+        }
+        fused_ops.push_back(result_op);
+
+        // Get the broadcasted shape
+        size_t ndim = 0;
+        for (size_t i = 0; i != operands.size(); ++i) {
+            ndim = max(ndim, (size_t)operands[i].get_ndim());
+        }
+        dimvector result_shape(ndim), tmp_shape(ndim);
+        for (size_t j = 0; j != ndim; ++j) {
+            result_shape[j] = 1;
+        }
+        for (size_t i = 0; i != operands.size(); ++i) {
+            size_t ndim_i = operands[i].get_ndim();
+            if (ndim_i > 0) {
+                operands[i].get_shape(tmp_shape.get());
+                incremental_broadcast(ndim, result_shape.get(), ndim_i, tmp_shape.get());
+            }
+        }
+
+        // Assemble the destination value type
+        ndt::type result_vdt = ndt::make_type(ndim, result_shape.get(), rdt);
+
+        nd::array result = combine_into_tuple(operands.size(), &operands[0]);
+        // Because the expr type's operand is the result's type,
+        // we can swap it in as the type
+        ndt::type edt = ndt::make_expr(result_vdt,
+                        result.get_type(),
+                        new fused_arithmetic_kernel_generator(rdt,
+                                        operands.size(), fused_ops));
+        edt.swap(result.get_ndo()->m_type);
+        if (tls_deferred_arithmetic) {
+            return result;
         } else {
-            func_ptr.single = NULL;
-            func_ptr.strided = NULL;
+            return result.eval();
         }
+    }
+} // anonymous namespace
 
-        // The signature is (T, T) -> T, so we don't use the original types
-        return apply_binary_operator<ckernel_prefix_with_init>(
-            ops, rdt, rdt, rdt, func_ptr, "addition").eval();
-    } else if (op1dt.get_kind() == string_kind && op2dt.get_kind() == string_kind) {
+nd::deferred_arithmetic::deferred_arithmetic()
+    : m_previous(tls_deferred_arithmetic)
+{
+    tls_deferred_arithmetic = true;
+}
+
+nd::deferred_arithmetic::~deferred_arithmetic()
+{
+    tls_deferred_arithmetic = m_previous;
+}
+
+nd::array nd::operator+(const nd::array& op1, const nd::array& op2)
+{
+    ndt::type op1dt = op1.get_type().value_type().get_dtype();
+    ndt::type op2dt = op2.get_type().value_type().get_dtype();
+    if (op1dt.get_kind() == string_kind && op2dt.get_kind() == string_kind) {
+        nd::array ops[2] = {op1, op2};
+        expr_operation_pair func_ptr;
         ndt::type rdt = ndt::make_string();
         func_ptr.single = &kernels::string_concatenation_kernel::single;
         func_ptr.strided = &kernels::string_concatenation_kernel::strided;
@@ -301,67 +647,21 @@ nd::array nd::operator+(const nd::array& op1, const nd::array& op2)
             ops, rdt, rdt, rdt, func_ptr, "string_concat");
 
         return tmp.eval();
-    } else {
-        stringstream ss;
-        ss << "Addition is not supported for dynd types ";
-        ss << op1dt << " and " << op2dt;
-        throw runtime_error(ss.str());
     }
+    return apply_builtin_arithmetic(op1, op2, addition_table, "addition");
 }
 
 nd::array nd::operator-(const nd::array& op1, const nd::array& op2)
 {
-    ndt::type rdt;
-    expr_operation_pair func_ptr;
-    ndt::type op1dt = op1.get_dtype().value_type();
-    ndt::type op2dt = op2.get_dtype().value_type();
-    if (op1dt.is_builtin() && op1dt.is_builtin()) {
-        rdt = promote_types_arithmetic(op1dt, op2dt);
-        int table_index = compress_builtin_type_id[rdt.get_type_id()];
-        if (table_index >= 0) {
-            func_ptr = subtraction_table[table_index];
-        }
-    }
-
-    nd::array ops[2] = {op1, op2};
-    return apply_binary_operator<ckernel_prefix_with_init>(
-        ops, rdt, rdt, rdt, func_ptr, "subtraction").eval();
+    return apply_builtin_arithmetic(op1, op2, subtraction_table, "subtraction");
 }
 
 nd::array nd::operator*(const nd::array& op1, const nd::array& op2)
 {
-    ndt::type rdt;
-    expr_operation_pair func_ptr;
-    ndt::type op1dt = op1.get_dtype().value_type();
-    ndt::type op2dt = op2.get_dtype().value_type();
-    if (op1dt.is_builtin() && op1dt.is_builtin()) {
-        rdt = promote_types_arithmetic(op1dt, op2dt);
-        int table_index = compress_builtin_type_id[rdt.get_type_id()];
-        if (table_index >= 0) {
-            func_ptr = multiplication_table[table_index];
-        }
-    }
-
-    nd::array ops[2] = {op1, op2};
-    return apply_binary_operator<ckernel_prefix_with_init>(
-        ops, rdt, rdt, rdt, func_ptr, "multiplication").eval();
+    return apply_builtin_arithmetic(op1, op2, multiplication_table, "multiplication");
 }
 
 nd::array nd::operator/(const nd::array& op1, const nd::array& op2)
 {
-    ndt::type rdt;
-    expr_operation_pair func_ptr;
-    ndt::type op1dt = op1.get_dtype().value_type();
-    ndt::type op2dt = op2.get_dtype().value_type();
-    if (op1dt.is_builtin() && op1dt.is_builtin()) {
-        rdt = promote_types_arithmetic(op1dt, op2dt);
-        int table_index = compress_builtin_type_id[rdt.get_type_id()];
-        if (table_index >= 0) {
-            func_ptr = division_table[table_index];
-        }
-    }
-
-    nd::array ops[2] = {op1, op2};
-    return apply_binary_operator<ckernel_prefix_with_init>(
-        ops, rdt, rdt, rdt, func_ptr, "division").eval();
+    return apply_builtin_arithmetic(op1, op2, division_table, "division");
 }
@@ -1947,7 +1947,8 @@ nd::array nd::reshape(const nd::array &a, const nd::array &shape)
 nd::array nd::memmap(const std::string& filename,
     intptr_t begin,
     intptr_t end,
-    uint32_t access)
+    uint32_t access,
+    uint32_t hints)
 {
     if (access == 0) {
         access = nd::default_access_flags;
@@ -1957,7 +1958,7 @@ nd::array nd::memmap(const std::string& filename,
     intptr_t mm_size = 0;
     // Create a memory mapped memblock of the file
     memory_block_ptr mm = make_memmap_memory_block(
-        filename, access, &mm_ptr, &mm_size, begin, end);
+        filename, access, &mm_ptr, &mm_size, begin, end, hints);
     // Create a bytes array referring to the data.
     ndt::type dt = ndt::make_bytes(1);
     char *data_ptr = 0;
@@ -0,0 +1,631 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <dynd/columnar_file.hpp>
+#include <dynd/arrmeta_holder.hpp>
+#include <dynd/memblock/fixed_size_pod_memory_block.hpp>
+#include <dynd/memblock/memmap_memory_block.hpp>
+#include <dynd/types/base_tuple_type.hpp>
+#include <dynd/types/bytes_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// The file header, followed by the section table and the datashape
+struct columnar_header {
+  char magic[8];
+  uint64_t version;
+  // Identifies the byte order and pointer size of the writer
+  uint64_t byte_order_mark;
+  uint64_t pointer_size;
+  uint64_t datashape_size;
+  uint64_t section_count;
+};
+
+struct columnar_section {
+  uint64_t offset;
+  uint64_t size;
+};
+
+const char columnar_magic[8] = {'D', 'Y', 'N', 'D', 'C', 'O', 'L', '\0'};
+const uint64_t columnar_version = 1;
+const uint64_t columnar_byte_order_mark = 0x0102030405060708ULL;
+const uint64_t columnar_section_alignment = 64;
+
+inline uint64_t align_up(uint64_t offset, uint64_t alignment)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+enum column_kind {
+  column_pod,
+  column_fixed_dim,
+  column_var_dim,
+  column_tuple,
+  column_option,
+  column_bytes
+};
+
+/**
+ * One node of the type tree of the saved array. String, bytes and
+ * var_dim nodes each own a section for the data they point to.
+ */
+struct column_node {
+  column_kind kind;
+  ndt::type tp;
+  // The section holding the pointed-to data of a bytes or var_dim node
+  intptr_t section;
+  // Whether the data of the node contains pointers
+  bool has_pointers;
+  // The element, value or field nodes
+  vector<intptr_t> children;
+};
+
+struct column_layout {
+  vector<column_node> nodes;
+  // Whether each section contains pointers
+  vector<bool> section_has_pointers;
+
+  explicit column_layout(const ndt::type &tp)
+  {
+    section_has_pointers.push_back(false);
+    // add() may grow section_has_pointers, so it has to be done before
+    // taking a reference to its first element
+    intptr_t root = add(tp);
+    section_has_pointers[0] = nodes[root].has_pointers;
+  }
+
+  // Adds the nodes of ``tp`` in pre-order, returning the index of its node
+  intptr_t add(const ndt::type &tp)
+  {
+    intptr_t i = nodes.size();
+    nodes.push_back(column_node());
+    nodes[i].tp = tp;
+    nodes[i].section = -1;
+    nodes[i].has_pointers = false;
+    if (tp.get_arrmeta_size() == 0 && tp.is_pod()) {
+      nodes[i].kind = column_pod;
+      return i;
+    }
+
+    switch (tp.get_type_id()) {
+    case fixed_dim_type_id:
+      nodes[i].kind = column_fixed_dim;
+      add_child(i, tp.extended<fixed_dim_type>()->get_element_type());
+      break;
+    case option_type_id:
+      nodes[i].kind = column_option;
+      add_child(i, tp.extended<option_type>()->get_value_type());
+      break;
+    case struct_type_id:
+    case cstruct_type_id:
+    case tuple_type_id:
+    case ctuple_type_id: {
+      nodes[i].kind = column_tuple;
+      const base_tuple_type *bt = tp.extended<base_tuple_type>();
+      for (intptr_t j = 0; j < bt->get_field_count(); ++j) {
+        add_child(i, bt->get_field_type(j));
+      }
+      break;
+    }
+    case string_type_id:
+    case bytes_type_id:
+      nodes[i].kind = column_bytes;
+      nodes[i].has_pointers = true;
+      nodes[i].section = section_has_pointers.size();
+      section_has_pointers.push_back(false);
+      break;
+    case var_dim_type_id: {
+      nodes[i].kind = column_var_dim;
+      nodes[i].has_pointers = true;
+      intptr_t section = section_has_pointers.size();
+      nodes[i].section = section;
+      section_has_pointers.push_back(false);
+      intptr_t child = add_child(i, tp.extended<var_dim_type>()->get_element_type());
+      section_has_pointers[section] = nodes[child].has_pointers;
+      break;
+    }
+    default: {
+      stringstream ss;
+      ss << "dynd columnar files do not support type " << tp;
+      throw type_error(ss.str());
+    }
+    }
+    return i;
+  }
+
+  intptr_t add_child(intptr_t parent, const ndt::type &tp)
+  {
+    intptr_t child = add(tp);
+    nodes[parent].children.push_back(child);
+    if (nodes[child].has_pointers) {
+      nodes[parent].has_pointers = true;
+    }
+    return child;
+  }
+};
+
+#ifdef _WIN32
+inline int seek_file(FILE *f, uint64_t offset)
+{
+  return _fseeki64(f, (__int64)offset, SEEK_SET);
+}
+#else
+inline int seek_file(FILE *f, uint64_t offset)
+{
+  return fseeko(f, (off_t)offset, SEEK_SET);
+}
+#endif
+
+/**
+ * Appends to one section of the file, buffering the writes. Without a
+ * file, this only counts the size of the section.
+ */
+class section_writer {
+  FILE *m_file;
+  const string *m_filename;
+  uint64_t m_offset, m_size, m_flushed;
+  vector<char> m_buffer;
+
+public:
+  section_writer() : m_file(NULL), m_filename(NULL), m_offset(0), m_size(0), m_flushed(0) {}
+
+  void open(FILE *file, const string &filename, uint64_t offset)
+  {
+    m_file = file;
+    m_filename = &filename;
+    m_offset = offset;
+    m_size = 0;
+    m_flushed = 0;
+  }
+
+  /** The offset in the file of the next byte written */
+  uint64_t tell() const { return m_offset + m_size; }
+
+  uint64_t size() const { return m_size; }
+
+  void write(const char *data, size_t size)
+  {
+    if (m_file != NULL) {
+      m_buffer.insert(m_buffer.end(), data, data + size);
+      if (m_buffer.size() >= (1 << 20)) {
+        flush();
+      }
+    }
+    m_size += size;
+  }
+
+  /** Writes zeros up to ``size`` bytes from the start of the section */
+  void pad_to(uint64_t size)
+  {
+    if (m_file != NULL) {
+      m_buffer.resize(m_buffer.size() + (size_t)(size - m_size));
+    }
+    m_size = size;
+  }
+
+  void flush()
+  {
+    if (m_file != NULL && !m_buffer.empty()) {
+      if (seek_file(m_file, m_offset + m_flushed) != 0 ||
+          fwrite(&m_buffer[0], 1, m_buffer.size(), m_file) != m_buffer.size()) {
+        stringstream ss;
+        ss << "failed to write to file \"" << *m_filename << "\"";
+        throw runtime_error(ss.str());
+      }
+      m_flushed += m_buffer.size();
+      m_buffer.clear();
+    }
+  }
+};
+
+/**
+ * Writes the value of node ``i`` at ``src_data`` into ``out`` in the
+ * layout given by ``dst_arrmeta``, and the data it points to into the
+ * sections of its nodes.
+ */
+void write_value(const column_layout &layout, vector<section_writer> &sections,
+                 intptr_t i, const char *src_arrmeta, const char *src_data,
+                 const char *dst_arrmeta, section_writer &out)
+{
+  const column_node &node = layout.nodes[i];
+  switch (node.kind) {
+  case column_pod:
+    out.write(src_data, node.tp.get_data_size());
+    break;
+  case column_fixed_dim: {
+    const fixed_dim_type_arrmeta *src_md =
+        reinterpret_cast<const fixed_dim_type_arrmeta *>(src_arrmeta);
+    const fixed_dim_type_arrmeta *dst_md =
+        reinterpret_cast<const fixed_dim_type_arrmeta *>(dst_arrmeta);
+    intptr_t child = node.children[0];
+    if (layout.nodes[child].kind == column_pod &&
+        src_md->stride == dst_md->stride) {
+      // Contiguous POD elements are written all at once
+      out.write(src_data, src_md->dim_size * src_md->stride);
+    } else {
+      uint64_t start = out.size();
+      for (intptr_t j = 0; j < src_md->dim_size; ++j) {
+        out.pad_to(start + j * dst_md->stride);
+        write_value(layout, sections, child,
+                    src_arrmeta + sizeof(fixed_dim_type_arrmeta),
+                    src_data + j * src_md->stride,
+                    dst_arrmeta + sizeof(fixed_dim_type_arrmeta), out);
+      }
+    }
+    break;
+  }
+  case column_tuple: {
+    const base_tuple_type *bt = node.tp.extended<base_tuple_type>();
+    const uintptr_t *src_offsets = bt->get_data_offsets(src_arrmeta);
+    const uintptr_t *dst_offsets = bt->get_data_offsets(dst_arrmeta);
+    const uintptr_t *arrmeta_offsets = bt->get_arrmeta_offsets_raw();
+    uint64_t start = out.size();
+    for (size_t j = 0; j < node.children.size(); ++j) {
+      out.pad_to(start + dst_offsets[j]);
+      write_value(layout, sections, node.children[j],
+                  src_arrmeta + arrmeta_offsets[j], src_data + src_offsets[j],
+                  dst_arrmeta + arrmeta_offsets[j], out);
+    }
+    out.pad_to(start + node.tp.get_default_data_size());
+    break;
+  }
+  case column_option:
+    // An option has the arrmeta and data layout of its value
+    write_value(layout, sections, node.children[0], src_arrmeta, src_data,
+                dst_arrmeta, out);
+    break;
+  case column_bytes: {
+    const bytes_type_data *d = reinterpret_cast<const bytes_type_data *>(src_data);
+    // A NULL pointer, for example of an NA string, is written as zero,
+    // which is never the offset of a section
+    uintptr_t offsets[2] = {0, 0};
+    if (d->begin != NULL) {
+      section_writer &sec = sections[node.section];
+      offsets[0] = (uintptr_t)sec.tell();
+      sec.write(d->begin, d->end - d->begin);
+      offsets[1] = (uintptr_t)sec.tell();
+    }
+    out.write(reinterpret_cast<const char *>(offsets), sizeof(offsets));
+    break;
+  }
+  case column_var_dim: {
+    const var_dim_type_arrmeta *src_md =
+        reinterpret_cast<const var_dim_type_arrmeta *>(src_arrmeta);
+    const var_dim_type_arrmeta *dst_md =
+        reinterpret_cast<const var_dim_type_arrmeta *>(dst_arrmeta);
+    const var_dim_type_data *d = reinterpret_cast<const var_dim_type_data *>(src_data);
+    uintptr_t values[2] = {0, d->size};
+    if (d->begin != NULL) {
+      section_writer &sec = sections[node.section];
+      const ndt::type &el_tp = layout.nodes[node.children[0]].tp;
+      sec.pad_to(align_up(sec.size(), el_tp.get_data_alignment()));
+      values[0] = (uintptr_t)sec.tell();
+      uint64_t start = sec.size();
+      for (size_t j = 0; j < d->size; ++j) {
+        sec.pad_to(start + j * dst_md->stride);
+        write_value(layout, sections, node.children[0],
+                    src_arrmeta + sizeof(var_dim_type_arrmeta),
+                    d->begin + src_md->offset + j * src_md->stride,
+                    dst_arrmeta + sizeof(var_dim_type_arrmeta), sec);
+      }
+    }
+    out.write(reinterpret_cast<const char *>(values), sizeof(values));
+    break;
+  }
+  }
+}
+
+/**
+ * Turns the file offsets in the value of node ``i`` at ``data`` back
+ * into pointers, using the addresses where the sections were loaded.
+ */
+void relocate_value(const column_layout &layout,
+                    const vector<char *> &section_data,
+                    const vector<columnar_section> &sections, intptr_t i,
+                    const char *arrmeta, char *data)
+{
+  const column_node &node = layout.nodes[i];
+  if (!node.has_pointers) {
+    return;
+  }
+  switch (node.kind) {
+  case column_fixed_dim: {
+    const fixed_dim_type_arrmeta *md =
+        reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    for (intptr_t j = 0; j < md->dim_size; ++j) {
+      relocate_value(layout, section_data, sections, node.children[0],
+                     arrmeta + sizeof(fixed_dim_type_arrmeta),
+                     data + j * md->stride);
+    }
+    break;
+  }
+  case column_tuple: {
+    const base_tuple_type *bt = node.tp.extended<base_tuple_type>();
+    const uintptr_t *offsets = bt->get_data_offsets(arrmeta);
+    const uintptr_t *arrmeta_offsets = bt->get_arrmeta_offsets_raw();
+    for (size_t j = 0; j < node.children.size(); ++j) {
+      relocate_value(layout, section_data, sections, node.children[j],
+                     arrmeta + arrmeta_offsets[j], data + offsets[j]);
+    }
+    break;
+  }
+  case column_option:
+    relocate_value(layout, section_data, sections, node.children[0], arrmeta,
+                   data);
+    break;
+  case column_bytes: {
+    uintptr_t *values = reinterpret_cast<uintptr_t *>(data);
+    if (values[0] == 0) {
+      break;
+    }
+    const columnar_section &sec = sections[node.section];
+    if (values[0] < sec.offset || values[1] < values[0] ||
+        values[1] > sec.offset + sec.size) {
+      throw runtime_error("dynd columnar file is corrupt, it has a string "
+                          "outside of its section");
+    }
+    char *sec_data = section_data[node.section];
+    values[0] = reinterpret_cast<uintptr_t>(sec_data + (values[0] - sec.offset));
+    values[1] = reinterpret_cast<uintptr_t>(sec_data + (values[1] - sec.offset));
+    break;
+  }
+  case column_var_dim: {
+    const var_dim_type_arrmeta *md =
+        reinterpret_cast<const var_dim_type_arrmeta *>(arrmeta);
+    var_dim_type_data *d = reinterpret_cast<var_dim_type_data *>(data);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(d->begin);
+    if (begin == 0) {
+      break;
+    }
+    const columnar_section &sec = sections[node.section];
+    if (begin < sec.offset || begin - sec.offset > sec.size ||
+        (md->stride > 0 &&
+         d->size > (sec.size - (begin - sec.offset)) / md->stride)) {
+      throw runtime_error("dynd columnar file is corrupt, it has a var dim "
+                          "outside of its section");
+    }
+    d->begin = section_data[node.section] + (begin - sec.offset);
+    for (size_t j = 0; j < d->size; ++j) {
+      relocate_value(layout, section_data, sections, node.children[0],
+                     arrmeta + sizeof(var_dim_type_arrmeta),
+                     d->begin + j * md->stride);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+/**
+ * Points the blockrefs in the arrmeta of node ``i`` at the memory
+ * blocks holding their sections.
+ */
+void set_blockrefs(const column_layout &layout,
+                   const vector<memory_block_ptr> &section_blocks, intptr_t i,
+                   char *arrmeta)
+{
+  const column_node &node = layout.nodes[i];
+  switch (node.kind) {
+  case column_fixed_dim:
+    set_blockrefs(layout, section_blocks, node.children[0],
+                  arrmeta + sizeof(fixed_dim_type_arrmeta));
+    break;
+  case column_tuple: {
+    const uintptr_t *arrmeta_offsets =
+        node.tp.extended<base_tuple_type>()->get_arrmeta_offsets_raw();
+    for (size_t j = 0; j < node.children.size(); ++j) {
+      set_blockrefs(layout, section_blocks, node.children[j],
+                    arrmeta + arrmeta_offsets[j]);
+    }
+    break;
+  }
+  case column_option:
+    set_blockrefs(layout, section_blocks, node.children[0], arrmeta);
+    break;
+  case column_bytes: {
+    bytes_type_arrmeta *md = reinterpret_cast<bytes_type_arrmeta *>(arrmeta);
+    md->blockref = section_blocks[node.section].get();
+    memory_block_incref(md->blockref);
+    break;
+  }
+  case column_var_dim: {
+    var_dim_type_arrmeta *md = reinterpret_cast<var_dim_type_arrmeta *>(arrmeta);
+    md->blockref = section_blocks[node.section].get();
+    memory_block_incref(md->blockref);
+    set_blockrefs(layout, section_blocks, node.children[0],
+                  arrmeta + sizeof(var_dim_type_arrmeta));
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+} // anonymous namespace
+
+void nd::save_columnar(const std::string &filename, const nd::array &a)
+{
+  const ndt::type &tp = a.get_type();
+  // The datashape is the only description of the data in the file
+  stringstream datashape_ss;
+  datashape_ss << tp;
+  std::string datashape = datashape_ss.str();
+  if (ndt::type(datashape) != tp) {
+    stringstream ss;
+    ss << "cannot save type " << tp
+       << " to a dynd columnar file, its datashape does not round trip";
+    throw type_error(ss.str());
+  }
+  column_layout layout(tp);
+
+  // The layout the data is written in
+  arrmeta_holder dst_arrmeta(tp);
+  dst_arrmeta.arrmeta_default_construct(false);
+
+  // Count the sizes of the sections first, then write them in place
+  intptr_t section_count = layout.section_has_pointers.size();
+  vector<section_writer> writers(section_count);
+  write_value(layout, writers, 0, a.get_arrmeta(), a.get_readonly_originptr(),
+              dst_arrmeta.get(), writers[0]);
+
+  columnar_header header;
+  memcpy(header.magic, columnar_magic, sizeof(header.magic));
+  header.version = columnar_version;
+  header.byte_order_mark = columnar_byte_order_mark;
+  header.pointer_size = sizeof(void *);
+  header.datashape_size = datashape.size();
+  header.section_count = section_count;
+  vector<columnar_section> sections(section_count);
+  uint64_t offset = sizeof(columnar_header) +
+                    section_count * sizeof(columnar_section) + datashape.size();
+  for (intptr_t i = 0; i < section_count; ++i) {
+    offset = align_up(offset, columnar_section_alignment);
+    sections[i].offset = offset;
+    sections[i].size = writers[i].size();
+    offset += sections[i].size;
+  }
+
+  FILE *f = fopen(filename.c_str(), "wb");
+  if (f == NULL) {
+    stringstream ss;
+    ss << "failed to open file \"" << filename << "\" for writing";
+    throw runtime_error(ss.str());
+  }
+  try {
+    if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+        fwrite(&sections[0], sizeof(columnar_section), section_count, f) !=
+            (size_t)section_count ||
+        fwrite(datashape.data(), 1, datashape.size(), f) != datashape.size()) {
+      stringstream ss;
+      ss << "failed to write to file \"" << filename << "\"";
+      throw runtime_error(ss.str());
+    }
+    for (intptr_t i = 0; i < section_count; ++i) {
+      writers[i].open(f, filename, sections[i].offset);
+    }
+    write_value(layout, writers, 0, a.get_arrmeta(),
+                a.get_readonly_originptr(), dst_arrmeta.get(), writers[0]);
+    for (intptr_t i = 0; i < section_count; ++i) {
+      writers[i].pad_to(sections[i].size);
+      writers[i].flush();
+    }
+  } catch (...) {
+    fclose(f);
+    throw;
+  }
+  if (fclose(f) != 0) {
+    stringstream ss;
+    ss << "failed to write to file \"" << filename << "\"";
+    throw runtime_error(ss.str());
+  }
+}
+
+nd::array nd::open_columnar(const std::string &filename)
+{
+  char *file_data = NULL;
+  intptr_t file_size = 0;
+  memory_block_ptr mm = make_memmap_memory_block(
+      filename, nd::read_access_flag | nd::immutable_access_flag, &file_data,
+      &file_size);
+
+  columnar_header header;
+  if (file_size < (intptr_t)sizeof(header)) {
+    stringstream ss;
+    ss << "file \"" << filename << "\" is not a dynd columnar file";
+    throw runtime_error(ss.str());
+  }
+  memcpy(&header, file_data, sizeof(header));
+  if (memcmp(header.magic, columnar_magic, sizeof(header.magic)) != 0) {
+    stringstream ss;
+    ss << "file \"" << filename << "\" is not a dynd columnar file";
+    throw runtime_error(ss.str());
+  }
+  if (header.version != columnar_version ||
+      header.byte_order_mark != columnar_byte_order_mark ||
+      header.pointer_size != sizeof(void *)) {
+    stringstream ss;
+    ss << "dynd columnar file \"" << filename
+       << "\" was written by an incompatible version or platform";
+    throw runtime_error(ss.str());
+  }
+  // Compare each part of the table against what is left of the file, so
+  // a corrupt count or size can't wrap around
+  uint64_t table_space = (uint64_t)file_size - sizeof(header);
+  if (header.section_count == 0 ||
+      header.section_count > table_space / sizeof(columnar_section) ||
+      header.datashape_size >
+          table_space - header.section_count * sizeof(columnar_section)) {
+    throw runtime_error("dynd columnar file is corrupt, its header is truncated");
+  }
+  uint64_t table_end = sizeof(header) +
+                       header.section_count * sizeof(columnar_section) +
+                       header.datashape_size;
+  vector<columnar_section> sections(header.section_count);
+  memcpy(&sections[0], file_data + sizeof(header),
+         sections.size() * sizeof(columnar_section));
+  ndt::type tp(std::string(file_data + table_end - header.datashape_size,
+                      header.datashape_size));
+
+  column_layout layout(tp);
+  if (layout.section_has_pointers.size() != sections.size()) {
+    throw runtime_error("dynd columnar file is corrupt, its section count "
+                        "does not match its datashape");
+  }
+  for (size_t i = 0; i < sections.size(); ++i) {
+    if (sections[i].offset < table_end ||
+        sections[i].offset % columnar_section_alignment != 0 ||
+        sections[i].size > (uint64_t)file_size - sections[i].offset) {
+      throw runtime_error(
+          "dynd columnar file is corrupt, a section is out of bounds");
+    }
+  }
+  if (sections[0].size != tp.get_default_data_size()) {
+    throw runtime_error("dynd columnar file is corrupt, its data size does "
+                        "not match its datashape");
+  }
+
+  // Sections without pointers are used in place, the others are copied
+  // so their pointers can be relocated
+  vector<char *> section_data(sections.size());
+  vector<memory_block_ptr> section_blocks(sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    if (layout.section_has_pointers[i]) {
+      section_blocks[i] = make_fixed_size_pod_memory_block(
+          max(sections[i].size, (uint64_t)1), columnar_section_alignment,
+          &section_data[i]);
+      memcpy(section_data[i], file_data + sections[i].offset, sections[i].size);
+    } else {
+      section_blocks[i] = mm;
+      section_data[i] = file_data + sections[i].offset;
+    }
+  }
+
+  nd::array result(make_array_memory_block(tp.get_arrmeta_size()));
+  array_preamble *ndo = result.get_ndo();
+  ndo->m_type = ndt::type(tp).release();
+  ndo->m_flags = nd::read_access_flag | nd::immutable_access_flag;
+  if (!tp.is_builtin()) {
+    tp.extended()->arrmeta_default_construct(result.get_arrmeta(), false);
+  }
+  set_blockrefs(layout, section_blocks, 0, result.get_arrmeta());
+  relocate_value(layout, section_data, sections, 0, result.get_arrmeta(),
+                 section_data[0]);
+  ndo->m_data_pointer = section_data[0];
+  ndo->m_data_reference = section_blocks[0].release();
+  return result;
+}
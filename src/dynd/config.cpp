@@ -12,7 +12,9 @@
 // TODO: Move elsewhere
 #include <dynd/func/apply_arrfunc.hpp>
 #include <dynd/types/datashape_parser.hpp>
+#include <dynd/types/type_intern.hpp>
 #include <dynd/func/arrfunc_registry.hpp>
+#include <dynd/kernels/ckernel_cache.hpp>
 
 using namespace std;
 
@@ -28,8 +30,10 @@ bool dynd::built_with_cuda()
 int dynd::libdynd_init()
 {
   dynd::init::static_types_init();
+  dynd::init::type_intern_init();
   dynd::init::datashape_parser_init();
   dynd::init::arrfunc_registry_init();
+  dynd::init::ckernel_cache_init();
 #ifdef DYND_FFTW
 //  dynd::init::fft_init();
 #endif
@@ -42,7 +46,9 @@ void dynd::libdynd_cleanup()
 #ifdef DYND_FFTW
 //  dynd::init::fft_cleanup();
 #endif
+  dynd::init::ckernel_cache_cleanup();
   dynd::init::arrfunc_registry_cleanup();
   dynd::init::datashape_parser_cleanup();
+  dynd::init::type_intern_cleanup();
   dynd::init::static_types_cleanup();
 }
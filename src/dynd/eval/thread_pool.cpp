@@ -0,0 +1,184 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <dynd/eval/thread_pool.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// Set while the current thread is running chunks, so nested
+// parallel_for calls fall back to serial execution
+thread_local bool tls_in_parallel_for = false;
+
+class thread_pool {
+  // Held by the thread which is currently submitting a job
+  mutex m_submit_mutex;
+
+  // Protects the job description and the counters below
+  mutex m_mutex;
+  condition_variable m_job_cv, m_done_cv;
+  vector<thread> m_threads;
+  bool m_shutdown;
+
+  // The current job. Worker i (1-based) participates if i < m_job_nthreads.
+  uint64_t m_generation;
+  intptr_t m_job_nthreads, m_nchunks;
+  eval::parallel_chunk_t m_chunk_fn;
+  void *m_data;
+  atomic<intptr_t> m_next_chunk;
+  intptr_t m_pending_workers;
+  exception_ptr m_error;
+
+  void run_chunks(intptr_t thread_index)
+  {
+    for (;;) {
+      intptr_t chunk_index = m_next_chunk.fetch_add(1);
+      if (chunk_index >= m_nchunks) {
+        return;
+      }
+      try {
+        m_chunk_fn(thread_index, chunk_index, m_data);
+      }
+      catch (...) {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_error) {
+          m_error = current_exception();
+        }
+        // Make all the threads stop claiming chunks
+        m_next_chunk.store(m_nchunks);
+        return;
+      }
+    }
+  }
+
+  void worker_main(intptr_t thread_index)
+  {
+    tls_in_parallel_for = true;
+    uint64_t seen_generation = 0;
+    for (;;) {
+      {
+        unique_lock<mutex> lock(m_mutex);
+        m_job_cv.wait(lock, [&] {
+          return m_shutdown || (m_generation != seen_generation &&
+                                thread_index < m_job_nthreads);
+        });
+        if (m_shutdown) {
+          return;
+        }
+        seen_generation = m_generation;
+      }
+      run_chunks(thread_index);
+      {
+        lock_guard<mutex> lock(m_mutex);
+        if (--m_pending_workers == 0) {
+          m_done_cv.notify_one();
+        }
+      }
+    }
+  }
+
+public:
+  thread_pool()
+      : m_shutdown(false), m_generation(0), m_job_nthreads(0), m_nchunks(0),
+        m_chunk_fn(NULL), m_data(NULL), m_next_chunk(0), m_pending_workers(0)
+  {
+  }
+
+  ~thread_pool()
+  {
+    {
+      lock_guard<mutex> lock(m_mutex);
+      m_shutdown = true;
+    }
+    m_job_cv.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+      m_threads[i].join();
+    }
+  }
+
+  bool try_run(intptr_t nthreads, intptr_t nchunks,
+               eval::parallel_chunk_t chunk_fn, void *data)
+  {
+    unique_lock<mutex> submit_lock(m_submit_mutex, try_to_lock);
+    if (!submit_lock.owns_lock()) {
+      return false;
+    }
+
+    // Grow the pool so there are nthreads - 1 workers besides the caller
+    while ((intptr_t)m_threads.size() < nthreads - 1) {
+      m_threads.push_back(thread(&thread_pool::worker_main, this,
+                                 (intptr_t)m_threads.size() + 1));
+    }
+
+    {
+      lock_guard<mutex> lock(m_mutex);
+      m_job_nthreads = nthreads;
+      m_nchunks = nchunks;
+      m_chunk_fn = chunk_fn;
+      m_data = data;
+      m_next_chunk.store(0);
+      m_pending_workers = nthreads - 1;
+      m_error = exception_ptr();
+      ++m_generation;
+    }
+    m_job_cv.notify_all();
+
+    tls_in_parallel_for = true;
+    run_chunks(0);
+    tls_in_parallel_for = false;
+
+    exception_ptr error;
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_done_cv.wait(lock, [&] { return m_pending_workers == 0; });
+      m_job_nthreads = 0;
+      error = m_error;
+      m_error = exception_ptr();
+    }
+    if (error) {
+      rethrow_exception(error);
+    }
+    return true;
+  }
+};
+
+thread_pool &get_thread_pool()
+{
+  static thread_pool pool;
+  return pool;
+}
+
+} // anonymous namespace
+
+void eval::parallel_for(intptr_t nthreads, intptr_t nchunks,
+                        parallel_chunk_t chunk_fn, void *data)
+{
+  if (nthreads > nchunks) {
+    nthreads = nchunks;
+  }
+  if (nthreads > 1 && !tls_in_parallel_for &&
+      get_thread_pool().try_run(nthreads, nchunks, chunk_fn, data)) {
+    return;
+  }
+
+  for (intptr_t i = 0; i < nchunks; ++i) {
+    chunk_fn(0, i, data);
+  }
+}
+
+intptr_t eval::get_hardware_concurrency()
+{
+  intptr_t n = thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
@@ -3,7 +3,11 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <cmath>
 
 #include <dynd/func/arrfunc.hpp>
@@ -15,9 +19,250 @@
 using namespace std;
 using namespace dynd;
 
-// Probably want to use a concurrent_hash_map, like
-// http://www.threadingbuildingblocks.org/docs/help/reference/containers_overview/concurrent_hash_map_cls.htm
-static map<nd::string, nd::arrfunc> *registry;
+namespace {
+
+inline size_t hash_name(const char *begin, const char *end)
+{
+  // 64-bit FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (; begin != end; ++begin) {
+    hash = (hash ^ static_cast<unsigned char>(*begin)) * 1099511628211ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+/**
+ * An open addressing hash table of registered arrfuncs. Once a table is
+ * published in ``registry`` it is never modified, so lookups don't need
+ * the registration mutex. Registering a function copies the current table,
+ * inserts into the copy, publishes the copy, and retires the old table
+ * until no lookup can still be reading it.
+ */
+class registry_table {
+  struct slot {
+    // The precomputed hash of the name, valid when name is not null
+    size_t hash;
+    nd::string name;
+    nd::arrfunc af;
+  };
+  // The number of slots is a power of two, at most half of them in use
+  vector<slot> m_slots;
+  size_t m_count;
+
+  size_t find_slot(const char *begin, const char *end, size_t hash) const
+  {
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      const slot &s = m_slots[i];
+      if (s.name.is_null() ||
+          (s.hash == hash && (size_t)(s.name.end() - s.name.begin()) ==
+                                 (size_t)(end - begin) &&
+           memcmp(s.name.begin(), begin, end - begin) == 0)) {
+        return i;
+      }
+    }
+  }
+
+public:
+  explicit registry_table(size_t capacity = 64) : m_slots(capacity), m_count(0)
+  {
+  }
+
+  size_t get_capacity() const { return m_slots.size(); }
+
+  const nd::arrfunc *find(const char *begin, const char *end) const
+  {
+    const slot &s = m_slots[find_slot(begin, end, hash_name(begin, end))];
+    return s.name.is_null() ? NULL : &s.af;
+  }
+
+  void insert(const nd::string &name, const nd::arrfunc &af)
+  {
+    if (2 * (m_count + 1) > m_slots.size()) {
+      registry_table grown(2 * m_slots.size());
+      grown.insert_all(*this);
+      m_slots.swap(grown.m_slots);
+    }
+    size_t hash = hash_name(name.begin(), name.end());
+    slot &s = m_slots[find_slot(name.begin(), name.end(), hash)];
+    if (s.name.is_null()) {
+      s.hash = hash;
+      s.name = name;
+      ++m_count;
+    }
+    s.af = af;
+  }
+
+  void insert_all(const registry_table &other)
+  {
+    for (size_t i = 0; i < other.m_slots.size(); ++i) {
+      if (!other.m_slots[i].name.is_null()) {
+        insert(other.m_slots[i].name, other.m_slots[i].af);
+      }
+    }
+  }
+
+  void get_all(map<nd::string, nd::arrfunc> &out) const
+  {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+      if (!m_slots[i].name.is_null()) {
+        out[m_slots[i].name] = m_slots[i].af;
+      }
+    }
+  }
+};
+
+// The currently published table
+atomic<const registry_table *> registry(NULL);
+// Serializes registrations, and guards registry_retired
+mutex registry_write_mutex;
+// Replaced tables which a lookup may still have been reading when they
+// were replaced. Each registration frees the ones no hazard points at,
+// so at most one table per thread is ever kept here.
+vector<const registry_table *> registry_retired;
+
+/**
+ * A hazard pointer, through which a lookup announces the table it is
+ * reading so that a concurrent registration doesn't free it. Each hazard
+ * is owned by one thread at a time, and is padded to its own cache line
+ * so lookups on different threads don't share writes.
+ */
+struct registry_hazard {
+  atomic<const registry_table *> table;
+  atomic<bool> in_use;
+  registry_hazard *next;
+  char padding[64 - 2 * sizeof(void *) - sizeof(atomic<bool>)];
+};
+
+// Every hazard ever created. Hazards are never freed, a hazard released
+// by an exiting thread is reused by the next thread which needs one.
+atomic<registry_hazard *> registry_hazards(NULL);
+
+registry_hazard *acquire_hazard()
+{
+  registry_hazard *h = registry_hazards.load(memory_order_acquire);
+  for (; h != NULL; h = h->next) {
+    bool expected = false;
+    if (h->in_use.compare_exchange_strong(expected, true,
+                                          memory_order_acquire)) {
+      return h;
+    }
+  }
+  h = new registry_hazard;
+  h->table.store(NULL, memory_order_relaxed);
+  h->in_use.store(true, memory_order_relaxed);
+  h->next = registry_hazards.load(memory_order_relaxed);
+  while (!registry_hazards.compare_exchange_weak(
+      h->next, h, memory_order_release, memory_order_relaxed)) {
+  }
+  return h;
+}
+
+thread_local registry_hazard *tls_hazard = NULL;
+thread_local bool tls_hazard_released = false;
+
+/**
+ * Hands the thread's hazard back for reuse when the thread exits.
+ */
+struct registry_hazard_owner {
+  ~registry_hazard_owner()
+  {
+    if (tls_hazard != NULL) {
+      tls_hazard->table.store(NULL, memory_order_release);
+      tls_hazard->in_use.store(false, memory_order_release);
+      tls_hazard = NULL;
+    }
+    tls_hazard_released = true;
+  }
+};
+thread_local registry_hazard_owner tls_hazard_owner;
+
+/**
+ * Returns this thread's hazard, or NULL if the thread has already
+ * released it during its exit.
+ */
+registry_hazard *get_hazard()
+{
+  if (tls_hazard == NULL && !tls_hazard_released) {
+    // Touch the owner so its destructor is registered for this thread
+    (void)&tls_hazard_owner;
+    tls_hazard = acquire_hazard();
+  }
+  return tls_hazard;
+}
+
+/**
+ * Protects the published table for the lifetime of the object. This is
+ * lock-free, except during thread exit where it falls back to taking
+ * the registration mutex. Readers must not nest on one thread.
+ */
+class registry_reader {
+  registry_hazard *m_hazard;
+  unique_lock<mutex> m_lock;
+  const registry_table *m_table;
+
+  registry_reader(const registry_reader &);
+  registry_reader &operator=(const registry_reader &);
+
+public:
+  registry_reader() : m_hazard(get_hazard())
+  {
+    if (m_hazard == NULL) {
+      m_lock = unique_lock<mutex>(registry_write_mutex);
+      m_table = registry.load(memory_order_acquire);
+      return;
+    }
+    // Announce the table, then check it is still the published one. A
+    // registration publishes before scanning the hazards, so if the table
+    // is still published here, the scan will see the announcement.
+    m_table = registry.load(memory_order_acquire);
+    for (;;) {
+      m_hazard->table.store(m_table, memory_order_seq_cst);
+      const registry_table *current = registry.load(memory_order_seq_cst);
+      if (current == m_table) {
+        break;
+      }
+      m_table = current;
+    }
+  }
+
+  ~registry_reader()
+  {
+    if (m_hazard != NULL) {
+      m_hazard->table.store(NULL, memory_order_release);
+    }
+  }
+
+  const registry_table *get() const { return m_table; }
+};
+
+/**
+ * Frees the retired tables which no hazard points at. Must be called
+ * with registry_write_mutex held.
+ */
+void free_retired_tables()
+{
+  vector<const registry_table *> in_use;
+  for (registry_hazard *h = registry_hazards.load(memory_order_acquire);
+       h != NULL; h = h->next) {
+    const registry_table *t = h->table.load(memory_order_seq_cst);
+    if (t != NULL) {
+      in_use.push_back(t);
+    }
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < registry_retired.size(); ++i) {
+    if (find(in_use.begin(), in_use.end(), registry_retired[i]) !=
+        in_use.end()) {
+      registry_retired[kept++] = registry_retired[i];
+    } else {
+      delete registry_retired[i];
+    }
+  }
+  registry_retired.resize(kept);
+}
+
+} // anonymous namespace
 
 template<typename T0, typename T1>
 static nd::arrfunc make_ufunc(T0 f0, T1 f1)
@@ -173,120 +418,162 @@ struct logaddexp2 {
 
 void init::arrfunc_registry_init()
 {
-  registry = new map<nd::string, nd::arrfunc>;
+  registry_table *table = new registry_table;
 
   // Arithmetic
-  func::set_regfunction(
+  table->insert(
       "add", make_ufunc(add<int32_t>(), add<int64_t>(), add<dynd_int128>(),
                         add<uint32_t>(), add<uint64_t>(), add<dynd_uint128>(),
                         add<float>(), add<double>(), add<complex<float> >(),
                         add<complex<double> >()));
-  func::set_regfunction(
+  table->insert(
       "subtract",
       make_ufunc(subtract<int32_t>(), subtract<int64_t>(),
                  subtract<dynd_int128>(), subtract<float>(), subtract<double>(),
                  subtract<complex<float> >(), subtract<complex<double> >()));
-  func::set_regfunction(
+  table->insert(
       "multiply",
       make_ufunc(multiply<int32_t>(), multiply<int64_t>(),
                  /*multiply<dynd_int128>(),*/ multiply<uint32_t>(),
                  multiply<uint64_t>(), /*multiply<dynd_uint128>(),*/
                  multiply<float>(), multiply<double>(),
                  multiply<complex<float> >(), multiply<complex<double> >()));
-  func::set_regfunction(
+  table->insert(
       "divide",
       make_ufunc(
           divide<int32_t>(), divide<int64_t>(),   /*divide<dynd_int128>(),*/
           divide<uint32_t>(), divide<uint64_t>(), /*divide<dynd_uint128>(),*/
           divide<float>(), divide<double>(), divide<complex<float> >(),
           divide<complex<double> >()));
-  func::set_regfunction(
+  table->insert(
       "negative",
       make_ufunc(negative<int32_t>(), negative<int64_t>(),
                  negative<dynd_int128>(), negative<float>(), negative<double>(),
                  negative<complex<float> >(), negative<complex<double> >()));
-  func::set_regfunction("sign", make_ufunc(sign<int32_t>(), sign<int64_t>(),
-                                           sign<dynd_int128>(), sign<float>(),
-                                           sign<double>()));
-  func::set_regfunction("conj", make_ufunc(conj_fn<complex<float> >(), conj_fn<complex<double> >()));
+  table->insert("sign", make_ufunc(sign<int32_t>(), sign<int64_t>(),
+                                   sign<dynd_int128>(), sign<float>(),
+                                   sign<double>()));
+  table->insert("conj", make_ufunc(conj_fn<complex<float> >(), conj_fn<complex<double> >()));
 
 #if !(defined(_MSC_VER) && _MSC_VER < 1700)
-  func::set_regfunction("logaddexp",
-                        make_ufunc(logaddexp<float>(), logaddexp<double>()));
-  func::set_regfunction("logaddexp2",
-                        make_ufunc(logaddexp2<float>(), logaddexp2<double>()));
+  table->insert("logaddexp",
+                make_ufunc(logaddexp<float>(), logaddexp<double>()));
+  table->insert("logaddexp2",
+                make_ufunc(logaddexp2<float>(), logaddexp2<double>()));
 #endif
 
   // Trig functions
-  func::set_regfunction(
+  table->insert(
       "sin", make_ufunc(&::sinf, static_cast<double (*)(double)>(&::sin)));
-  func::set_regfunction(
+  table->insert(
       "cos", make_ufunc(&::cosf, static_cast<double (*)(double)>(&::cos)));
-  func::set_regfunction(
+  table->insert(
       "tan", make_ufunc(&::tanf, static_cast<double (*)(double)>(&::tan)));
-  func::set_regfunction(
+  table->insert(
       "exp", make_ufunc(&::expf, static_cast<double (*)(double)>(&::exp)));
-  func::set_regfunction(
+  table->insert(
       "arcsin", make_ufunc(&::asinf, static_cast<double (*)(double)>(&::asin)));
-  func::set_regfunction(
+  table->insert(
       "arccos", make_ufunc(&::acosf, static_cast<double (*)(double)>(&::acos)));
-  func::set_regfunction(
+  table->insert(
       "arctan", make_ufunc(&::atanf, static_cast<double (*)(double)>(&::atan)));
-  func::set_regfunction(
+  table->insert(
       "arctan2",
       make_ufunc(&::atan2f, static_cast<double (*)(double, double)>(&::atan2)));
-  func::set_regfunction(
+  table->insert(
       "hypot",
       make_ufunc(&::hypotf, static_cast<double (*)(double, double)>(&::hypot)));
-  func::set_regfunction(
+  table->insert(
       "sinh", make_ufunc(&::sinhf, static_cast<double (*)(double)>(&::sinh)));
-  func::set_regfunction(
+  table->insert(
       "cosh", make_ufunc(&::coshf, static_cast<double (*)(double)>(&::cosh)));
-  func::set_regfunction(
+  table->insert(
       "tanh", make_ufunc(&::tanhf, static_cast<double (*)(double)>(&::tanh)));
 #if !(defined(_MSC_VER) && _MSC_VER < 1700)
-  func::set_regfunction(
+  table->insert(
       "asinh",
       make_ufunc(&::asinhf, static_cast<double (*)(double)>(&::asinh)));
-  func::set_regfunction(
+  table->insert(
       "acosh",
       make_ufunc(&::acoshf, static_cast<double (*)(double)>(&::acosh)));
-  func::set_regfunction(
+  table->insert(
       "atanh",
       make_ufunc(&::atanhf, static_cast<double (*)(double)>(&::atanh)));
 #endif
 
-  func::set_regfunction(
+  table->insert(
       "power",
       make_ufunc(&powf, static_cast<double (*)(double, double)>(&::pow)));
+
+  registry.store(table, memory_order_release);
 }
 
 void init::arrfunc_registry_cleanup()
 {
-  delete registry;
-  registry = NULL;
+  lock_guard<mutex> lock(registry_write_mutex);
+  const registry_table *table = registry.exchange(NULL, memory_order_seq_cst);
+  if (table != NULL) {
+    registry_retired.push_back(table);
+  }
+  free_retired_tables();
 }
 
-const std::map<nd::string, nd::arrfunc> &func::get_regfunctions()
+std::map<nd::string, nd::arrfunc> func::get_regfunctions()
 {
-  return *registry;
+  std::map<nd::string, nd::arrfunc> result;
+  registry_reader reader;
+  if (reader.get() != NULL) {
+    reader.get()->get_all(result);
+  }
+  return result;
 }
 
-nd::arrfunc func::get_regfunction(const nd::string &name)
+static nd::arrfunc get_regfunction(const char *begin, const char *end)
 {
-  map<nd::string, nd::arrfunc>::const_iterator it = registry->find(name);
-  if (it != registry->end()) {
-    return it->second;
-  } else {
+  nd::arrfunc result;
+  bool found = false;
+  {
+    registry_reader reader;
+    const nd::arrfunc *af =
+        reader.get() != NULL ? reader.get()->find(begin, end) : NULL;
+    if (af != NULL) {
+      result = *af;
+      found = true;
+    }
+  }
+  if (!found) {
     stringstream ss;
     ss << "No dynd function ";
-    print_escaped_utf8_string(ss, name);
+    print_escaped_utf8_string(ss, begin, end);
     ss << " has been registered";
     throw invalid_argument(ss.str());
   }
+  return result;
+}
+
+nd::arrfunc func::get_regfunction(const nd::string &name)
+{
+  return ::get_regfunction(name.begin(), name.end());
+}
+
+nd::arrfunc func::get_regfunction(const char *name)
+{
+  return ::get_regfunction(name, name + strlen(name));
 }
 
 void func::set_regfunction(const nd::string &name, const nd::arrfunc &af)
 {
-  (*registry)[name] = af;
+  lock_guard<mutex> lock(registry_write_mutex);
+  const registry_table *old_table = registry.load(memory_order_relaxed);
+  registry_table *table =
+      new registry_table(old_table ? old_table->get_capacity() : 64);
+  if (old_table != NULL) {
+    table->insert_all(*old_table);
+  }
+  table->insert(name, af);
+  registry.store(table, memory_order_seq_cst);
+  if (old_table != NULL) {
+    registry_retired.push_back(old_table);
+  }
+  free_retired_tables();
 }
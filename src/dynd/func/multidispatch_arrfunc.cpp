@@ -3,6 +3,7 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <mutex>
 #include <set>
 
 #include <dynd/func/multidispatch_arrfunc.hpp>
@@ -26,7 +27,7 @@ using namespace dynd;
  *
  */
 static bool can_implicitly_convert(const ndt::type &src, const ndt::type &dst,
-                                   std::map<nd::string, ndt::type> &typevars)
+                                   ndt::typevar_table &typevars)
 {
   if (src == dst) {
     return true;
@@ -72,7 +73,7 @@ static bool supercedes(const nd::arrfunc &lhs, const nd::arrfunc &rhs)
     for (intptr_t i = 0; i < nargs; ++i) {
       const ndt::type &lpt = lhs.get_type()->get_arg_type(i);
       const ndt::type &rpt = rhs.get_type()->get_arg_type(i);
-      std::map<nd::string, ndt::type> typevars;
+      ndt::typevar_table typevars;
       if (!can_implicitly_convert(lpt, rpt, typevars)) {
         return false;
       }
@@ -96,7 +97,7 @@ static bool toposort_edge(const nd::arrfunc &lhs, const nd::arrfunc &rhs)
     for (intptr_t i = 0; i < nargs; ++i) {
       const ndt::type &lpt = lhs.get_type()->get_arg_type(i);
       const ndt::type &rpt = rhs.get_type()->get_arg_type(i);
-      std::map<nd::string, ndt::type> typevars;
+      ndt::typevar_table typevars;
       if (lpt.get_kind() >= rpt.get_kind() &&
           !can_implicitly_convert(lpt, rpt, typevars)) {
         return false;
@@ -122,7 +123,7 @@ static bool ambiguous(const nd::arrfunc &lhs, const nd::arrfunc &rhs)
       const ndt::type &lpt = lhs.get_type()->get_arg_type(i);
       const ndt::type &rpt = rhs.get_type()->get_arg_type(i);
       bool either = false;
-      std::map<nd::string, ndt::type> typevars;
+      ndt::typevar_table typevars;
       if (can_implicitly_convert(lpt, rpt, typevars)) {
         lsupercount++;
         either = true;
@@ -256,47 +257,156 @@ get_ambiguous_pairs(intptr_t naf, const nd::arrfunc *af,
   }
 }
 
+namespace {
+// The number of slots in the dispatch cache of each multidispatch arrfunc
+const size_t multidispatch_cache_size = 64;
+
+/**
+ * The overload chosen for a tuple of source types.
+ */
+struct multidispatch_choice {
+  // Index of the chosen arrfunc, or -1 if none matches
+  intptr_t index;
+  // Whether the source types are exactly the arrfunc's, so no
+  // buffering is needed
+  bool exact;
+  ndt::type dst_tp;
+};
+
+struct multidispatch_cache_entry {
+  size_t hash;
+  // Empty if the slot hasn't been filled, calls without
+  // source types are never cached
+  vector<ndt::type> src_tp;
+  multidispatch_choice choice;
+};
+
+/**
+ * The data of a multidispatch arrfunc, its topologically sorted
+ * arrfuncs and a direct-mapped cache from the exact source types
+ * of a call to the arrfunc chosen for them. A cache slot is
+ * overwritten when another source type tuple hashes to it.
+ */
+struct multidispatch_data {
+  vector<nd::arrfunc> af;
+  mutex cache_mutex;
+  multidispatch_cache_entry cache[multidispatch_cache_size];
+};
+
+inline void hash_combine(size_t &hash, size_t value)
+{
+  hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+size_t hash_src_types(intptr_t nsrc, const ndt::type *src_tp)
+{
+  size_t hash = nsrc;
+  for (intptr_t i = 0; i < nsrc; ++i) {
+    hash_combine(hash, src_tp[i].get_type_id());
+    if (!src_tp[i].is_builtin()) {
+      hash_combine(hash, src_tp[i].get_ndim());
+      hash_combine(hash, src_tp[i].get_dtype().get_type_id());
+      hash_combine(hash, src_tp[i].get_data_size());
+    }
+  }
+  return hash;
+}
+
+/**
+ * Scans the arrfuncs in order for the first one the source types
+ * implicitly convert to.
+ */
+multidispatch_choice choose_arrfunc(const vector<nd::arrfunc> &icd,
+                                    intptr_t nsrc, const ndt::type *src_tp)
+{
+  multidispatch_choice choice;
+  for (intptr_t i = 0; i < (intptr_t)icd.size(); ++i) {
+    const nd::arrfunc &af = icd[i];
+    if (nsrc == af.get_type()->get_npos()) {
+      intptr_t isrc;
+      ndt::typevar_table typevars;
+      for (isrc = 0; isrc < nsrc; ++isrc) {
+        if (!can_implicitly_convert(
+                src_tp[isrc], af.get_type()->get_arg_type(isrc), typevars)) {
+          break;
+        }
+      }
+      if (isrc == nsrc) {
+        choice.index = i;
+        choice.exact = true;
+        for (isrc = 0; isrc < nsrc; ++isrc) {
+          const ndt::type &arg_tp = af.get_type()->get_arg_type(isrc);
+          if (!arg_tp.is_symbolic() && src_tp[isrc] != arg_tp) {
+            choice.exact = false;
+            break;
+          }
+        }
+        choice.dst_tp =
+            ndt::substitute(af.get_type()->get_return_type(), typevars, true);
+        return choice;
+      }
+    }
+  }
+  choice.index = -1;
+  choice.exact = false;
+  return choice;
+}
+
+/**
+ * Returns the arrfunc choice for the source types, from the
+ * dispatch cache when possible.
+ */
+multidispatch_choice get_choice(multidispatch_data *md, intptr_t nsrc,
+                                const ndt::type *src_tp)
+{
+  size_t hash = hash_src_types(nsrc, src_tp);
+  multidispatch_cache_entry &e = md->cache[hash % multidispatch_cache_size];
+  {
+    lock_guard<mutex> lock(md->cache_mutex);
+    if (e.hash == hash && (intptr_t)e.src_tp.size() == nsrc && nsrc > 0 &&
+        equal(e.src_tp.begin(), e.src_tp.end(), src_tp)) {
+      return e.choice;
+    }
+  }
+
+  // Choose outside the lock, pattern matching can be slow
+  multidispatch_choice choice = choose_arrfunc(md->af, nsrc, src_tp);
+  {
+    lock_guard<mutex> lock(md->cache_mutex);
+    e.hash = hash;
+    e.src_tp.assign(src_tp, src_tp + nsrc);
+    e.choice = choice;
+  }
+  return choice;
+}
+} // anonymous namespace
+
 static void free_multidispatch_af_data(arrfunc_type_data *self_af) {
-  self_af->get_data_as<vector<nd::arrfunc> >()->~vector();
+  delete *self_af->get_data_as<multidispatch_data *>();
 }
 
 static intptr_t instantiate_multidispatch_af(
-    const arrfunc_type_data *af_self, const arrfunc_type *DYND_UNUSED(af_tp),
+    const arrfunc_type_data *af_self, const arrfunc_type *af_tp,
     void *ckb, intptr_t ckb_offset, const ndt::type &dst_tp,
     const char *dst_arrmeta, const ndt::type *src_tp,
     const char *const *src_arrmeta, kernel_request_t kernreq,
     const eval::eval_context *ectx,
     const nd::array &kwds)
 {
-  const vector<nd::arrfunc> *icd = af_self->get_data_as<vector<nd::arrfunc> >();
-  for (intptr_t i = 0; i < (intptr_t)icd->size(); ++i) {
-    const nd::arrfunc &af = (*icd)[i];
-    intptr_t isrc, nsrc = af.get_type()->get_npos();
-    std::map<nd::string, ndt::type> typevars;
-    for (isrc = 0; isrc < nsrc; ++isrc) {
-      if (!can_implicitly_convert(src_tp[isrc], af.get_type()->get_arg_type(isrc),
-                                  typevars)) {
-        break;
-      }
-    }
-    if (isrc == nsrc) {
-      intptr_t j;
-      for (j = 0; j < nsrc; ++j) {
-        const ndt::type &arg_tp = af.get_type()->get_arg_type(j);
-        if (!arg_tp.is_symbolic() && src_tp[j] != arg_tp) {
-          break;
-        }
-      }
-      if (j == nsrc) {
-        return af.get()->instantiate(af.get(), af.get_type(), ckb, ckb_offset,
-                                     dst_tp, dst_arrmeta, src_tp, src_arrmeta,
-                                     kernreq, ectx, kwds);
-      } else {
-        return make_buffered_ckernel(af.get(), af.get_type(), ckb, ckb_offset,
-                                     dst_tp, dst_arrmeta, nsrc, src_tp,
-                                     af.get_type()->get_arg_types_raw(),
-                                     src_arrmeta, kernreq, ectx);
-      }
+  multidispatch_data *md = *af_self->get_data_as<multidispatch_data *>();
+  intptr_t nsrc = af_tp->get_npos();
+  multidispatch_choice choice = get_choice(md, nsrc, src_tp);
+  if (choice.index >= 0) {
+    const nd::arrfunc &af = md->af[choice.index];
+    if (choice.exact) {
+      return af.get()->instantiate(af.get(), af.get_type(), ckb, ckb_offset,
+                                   dst_tp, dst_arrmeta, src_tp, src_arrmeta,
+                                   kernreq, ectx, kwds);
+    } else {
+      return make_buffered_ckernel(af.get(), af.get_type(), ckb, ckb_offset,
+                                   dst_tp, dst_arrmeta, nsrc, src_tp,
+                                   af.get_type()->get_arg_types_raw(),
+                                   src_arrmeta, kernreq, ectx);
     }
   }
   // TODO: Good message here
@@ -311,24 +421,11 @@ static int resolve_multidispatch_dst_type(
     ndt::type &out_dst_tp,
     const nd::array &DYND_UNUSED(kwds))
 {
-  const vector<nd::arrfunc> *icd = af_self->get_data_as<vector<nd::arrfunc> >();
-  for (intptr_t i = 0; i < (intptr_t)icd->size(); ++i) {
-    const nd::arrfunc &af = (*icd)[i];
-    if (nsrc == af.get_type()->get_npos()) {
-      intptr_t isrc;
-      std::map<nd::string, ndt::type> typevars;
-      for (isrc = 0; isrc < nsrc; ++isrc) {
-        if (!can_implicitly_convert(
-                src_tp[isrc], af.get_type()->get_arg_type(isrc), typevars)) {
-          break;
-        }
-      }
-      if (isrc == nsrc) {
-        out_dst_tp =
-            ndt::substitute(af.get_type()->get_return_type(), typevars, true);
-        return 1;
-      }
-    }
+  multidispatch_data *md = *af_self->get_data_as<multidispatch_data *>();
+  multidispatch_choice choice = get_choice(md, nsrc, src_tp);
+  if (choice.index >= 0) {
+    out_dst_tp = choice.dst_tp;
+    return 1;
   }
 
   if (throw_on_error) {
@@ -403,10 +500,10 @@ nd::arrfunc dynd::make_multidispatch_arrfunc(intptr_t naf,
   nd::array af = nd::empty(ndt::make_generic_funcproto(nargs));
   arrfunc_type_data *out_af =
       reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
-  vector<nd::arrfunc> *af_data =
-      new (out_af->get_data_as<char>()) vector<nd::arrfunc>();
+  multidispatch_data *af_data = new multidispatch_data();
+  *out_af->get_data_as<multidispatch_data *>() = af_data;
   out_af->free = &free_multidispatch_af_data;
-  af_data->swap(sorted_af);
+  af_data->af.swap(sorted_af);
   out_af->instantiate = &instantiate_multidispatch_af;
   out_af->resolve_dst_type = &resolve_multidispatch_dst_type;
   af.flag_as_immutable();
@@ -188,23 +188,26 @@ static int resolve_neighborhood_dst_type(
   // TODO: Should be able to express the match/subsitution without special code
 
   // This is basically resolve() from arrfunc.hpp
-  if (nsrc != af_tp->get_npos()) {
+  const ndt::pattern_signature &sig = af_tp->get_pos_signature();
+  if (nsrc != sig.get_nparam()) {
     std::stringstream ss;
-    ss << "arrfunc expected " << af_tp->get_npos()
+    ss << "arrfunc expected " << sig.get_nparam()
        << " parameters, but received " << nsrc;
     throw std::invalid_argument(ss.str());
   }
-  const ndt::type *param_types = af_tp->get_arg_types_raw();
-  std::map<nd::string, ndt::type> typevars;
-  for (intptr_t i = 0; i != nsrc; ++i) {
-    if (!ndt::pattern_match(src_tp[i].value_type(), param_types[i], typevars)) {
-      std::stringstream ss;
-      ss << "parameter " << (i + 1) << " to arrfunc does not match, ";
-      ss << "expected " << param_types[i] << ", received " << src_tp[i];
-      throw std::invalid_argument(ss.str());
-    }
+  ndt::typevar_table typevars;
+  intptr_t i = sig.match(src_tp, typevars);
+  if (i != -1) {
+    std::stringstream ss;
+    ss << "parameter " << (i + 1) << " to arrfunc does not match, ";
+    ss << "expected " << af_tp->get_arg_type(i) << ", received " << src_tp[i];
+    throw std::invalid_argument(ss.str());
+  }
+  if (sig.has_symbolic_return()) {
+    out_dst_tp = ndt::substitute(af_tp->get_return_type(), typevars, false);
+  } else {
+    out_dst_tp = af_tp->get_return_type();
   }
-  out_dst_tp = ndt::substitute(af_tp->get_return_type(), typevars, false);
 
   // swap in the input dimension values for the fixed**N
   intptr_t ndim = src_tp[0].get_ndim();
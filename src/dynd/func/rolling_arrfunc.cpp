@@ -3,9 +3,13 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <cmath>
+#include <vector>
+
 #include <dynd/kernels/assignment_kernels.hpp>
 #include <dynd/func/rolling_arrfunc.hpp>
 #include <dynd/kernels/ckernel_common_functions.hpp>
+#include <dynd/kernels/reduction_kernels.hpp>
 #include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/var_dim_type.hpp>
 #include <dynd/types/typevar_dim_type.hpp>
@@ -101,6 +105,310 @@ struct var_rolling_ck : public kernels::unary_ck<var_rolling_ck> {
     }
 };
 
+/**
+ * Running state for an incremental rolling window. Each step of the
+ * rolling kernel pushes the entering element and pops the leaving one,
+ * so a window of any size costs O(1) per output.
+ */
+template <class T>
+struct rolling_sum_state {
+  typedef T value_type;
+  T m_sum;
+
+  rolling_sum_state(intptr_t DYND_UNUSED(window_size),
+                    intptr_t DYND_UNUSED(minp))
+  {
+  }
+
+  inline void reset() { m_sum = 0; }
+  inline void push(intptr_t DYND_UNUSED(i), T v) { m_sum = m_sum + v; }
+  inline void pop(intptr_t DYND_UNUSED(i), T v) { m_sum = m_sum - v; }
+  inline T value() const { return m_sum; }
+};
+
+/**
+ * A compensated (Neumaier) running sum of the finite values in the
+ * window, with counts of the NaN and infinite values kept on the side
+ * so that they can leave the window again without poisoning the sum.
+ */
+struct rolling_double_sum_base {
+  double m_sum, m_compensation;
+  intptr_t m_count, m_nan_count, m_posinf_count, m_neginf_count;
+
+  inline void reset()
+  {
+    m_sum = m_compensation = 0;
+    m_count = m_nan_count = m_posinf_count = m_neginf_count = 0;
+  }
+
+  inline void add(double v)
+  {
+    double t = m_sum + v;
+    if (fabs(m_sum) >= fabs(v)) {
+      m_compensation += (m_sum - t) + v;
+    }
+    else {
+      m_compensation += (v - t) + m_sum;
+    }
+    m_sum = t;
+  }
+
+  inline void update(double v, intptr_t sign)
+  {
+    if (DYND_ISNAN(v)) {
+      m_nan_count += sign;
+    }
+    else if (v == numeric_limits<double>::infinity()) {
+      m_posinf_count += sign;
+    }
+    else if (v == -numeric_limits<double>::infinity()) {
+      m_neginf_count += sign;
+    }
+    else {
+      m_count += sign;
+      add(sign > 0 ? v : -v);
+      if (m_count == 0) {
+        // Drop any rounding residue once the window holds no values
+        m_sum = m_compensation = 0;
+      }
+    }
+  }
+
+  /** The sum of the non-NaN values, with IEEE infinity semantics */
+  inline double nonnan_sum() const
+  {
+    if (m_posinf_count > 0) {
+      return m_neginf_count > 0 ? numeric_limits<double>::quiet_NaN()
+                                : numeric_limits<double>::infinity();
+    }
+    else if (m_neginf_count > 0) {
+      return -numeric_limits<double>::infinity();
+    }
+    return m_sum + m_compensation;
+  }
+};
+
+template <>
+struct rolling_sum_state<double> : rolling_double_sum_base {
+  typedef double value_type;
+
+  rolling_sum_state(intptr_t DYND_UNUSED(window_size),
+                    intptr_t DYND_UNUSED(minp))
+  {
+  }
+
+  inline void push(intptr_t DYND_UNUSED(i), double v) { update(v, 1); }
+  inline void pop(intptr_t DYND_UNUSED(i), double v) { update(v, -1); }
+  inline double value() const
+  {
+    return m_nan_count > 0 ? numeric_limits<double>::quiet_NaN()
+                           : nonnan_sum();
+  }
+};
+
+struct rolling_mean_state : rolling_double_sum_base {
+  typedef double value_type;
+  intptr_t m_minp;
+
+  rolling_mean_state(intptr_t DYND_UNUSED(window_size), intptr_t minp)
+      : m_minp(minp)
+  {
+  }
+
+  inline void push(intptr_t DYND_UNUSED(i), double v) { update(v, 1); }
+  inline void pop(intptr_t DYND_UNUSED(i), double v) { update(v, -1); }
+  inline double value() const
+  {
+    intptr_t countp = m_count + m_posinf_count + m_neginf_count;
+    if (countp < m_minp || countp == 0) {
+      return numeric_limits<double>::quiet_NaN();
+    }
+    return nonnan_sum() / countp;
+  }
+};
+
+/**
+ * Welford's running mean and sum of squared deviations, updated in
+ * both directions as values enter and leave the window.
+ */
+struct rolling_var_state {
+  typedef double value_type;
+  intptr_t m_minp;
+  intptr_t m_count, m_inf_count;
+  double m_mean, m_m2;
+
+  rolling_var_state(intptr_t DYND_UNUSED(window_size), intptr_t minp)
+      : m_minp(minp)
+  {
+  }
+
+  inline void reset()
+  {
+    m_count = m_inf_count = 0;
+    m_mean = m_m2 = 0;
+  }
+
+  inline void push(intptr_t DYND_UNUSED(i), double v)
+  {
+    if (DYND_ISNAN(v)) {
+      return;
+    }
+    else if (fabs(v) == numeric_limits<double>::infinity()) {
+      ++m_inf_count;
+      return;
+    }
+    ++m_count;
+    double delta = v - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (v - m_mean);
+  }
+
+  inline void pop(intptr_t DYND_UNUSED(i), double v)
+  {
+    if (DYND_ISNAN(v)) {
+      return;
+    }
+    else if (fabs(v) == numeric_limits<double>::infinity()) {
+      --m_inf_count;
+      return;
+    }
+    if (--m_count == 0) {
+      m_mean = m_m2 = 0;
+      return;
+    }
+    double delta = v - m_mean;
+    m_mean -= delta / m_count;
+    m_m2 -= delta * (v - m_mean);
+    if (m_m2 < 0) {
+      m_m2 = 0;
+    }
+  }
+
+  inline double value() const
+  {
+    intptr_t countp = m_count + m_inf_count;
+    if (countp < m_minp || countp < 2 || m_inf_count > 0) {
+      return numeric_limits<double>::quiet_NaN();
+    }
+    return m_m2 / (m_count - 1);
+  }
+};
+
+/**
+ * A monotonic deque of the window positions which can still become the
+ * min (or max), kept in a ring buffer of the window size. Every position
+ * enters and leaves the deque at most once, so each step is amortized
+ * O(1).
+ */
+template <bool Max>
+struct rolling_minmax_state {
+  typedef double value_type;
+  intptr_t m_minp;
+  intptr_t m_count;
+  // Ring buffer of (position, value) pairs
+  std::vector<std::pair<intptr_t, double> > m_deque;
+  intptr_t m_head, m_size;
+
+  rolling_minmax_state(intptr_t window_size, intptr_t minp)
+      : m_minp(minp), m_deque(window_size)
+  {
+  }
+
+  inline void reset() { m_count = m_head = m_size = 0; }
+
+  inline std::pair<intptr_t, double> &at(intptr_t k)
+  {
+    intptr_t idx = m_head + k;
+    intptr_t capacity = (intptr_t)m_deque.size();
+    return m_deque[idx < capacity ? idx : idx - capacity];
+  }
+
+  inline void push(intptr_t i, double v)
+  {
+    if (DYND_ISNAN(v)) {
+      return;
+    }
+    ++m_count;
+    // Drop the values which can no longer be the result
+    while (m_size > 0 &&
+           (Max ? (at(m_size - 1).second <= v) : (at(m_size - 1).second >= v))) {
+      --m_size;
+    }
+    at(m_size++) = std::make_pair(i, v);
+  }
+
+  inline void pop(intptr_t i, double v)
+  {
+    if (DYND_ISNAN(v)) {
+      return;
+    }
+    --m_count;
+    if (m_size > 0 && at(0).first == i) {
+      if (++m_head == (intptr_t)m_deque.size()) {
+        m_head = 0;
+      }
+      --m_size;
+    }
+  }
+
+  inline double value()
+  {
+    if (m_count < m_minp || m_count == 0) {
+      return numeric_limits<double>::quiet_NaN();
+    }
+    return at(0).second;
+  }
+};
+
+template <class State>
+struct strided_incremental_rolling_ck
+    : public kernels::unary_ck<strided_incremental_rolling_ck<State> > {
+  typedef typename State::value_type T;
+  intptr_t m_window_size;
+  intptr_t m_dim_size, m_dst_stride, m_src_stride;
+  State m_state;
+
+  strided_incremental_rolling_ck(intptr_t window_size, intptr_t minp)
+      : m_window_size(window_size), m_state(window_size, minp)
+  {
+  }
+
+  inline void single(char *dst, char *src)
+  {
+    ckernel_prefix *nachild = this->get_child_ckernel();
+    expr_strided_t nachild_fn = nachild->template get_function<expr_strided_t>();
+    intptr_t window_size = m_window_size, dim_size = m_dim_size;
+    intptr_t dst_stride = m_dst_stride, src_stride = m_src_stride;
+    // Fill in NA/NaN at the beginning
+    if (dim_size > 0) {
+      nachild_fn(dst, dst_stride, NULL, NULL,
+                 std::min(window_size - 1, dim_size), nachild);
+    }
+    m_state.reset();
+    const char *src_leaving = src;
+    dst += dst_stride * (window_size - 1);
+    for (intptr_t i = 0; i < dim_size; ++i) {
+      if (i >= window_size) {
+        m_state.pop(i - window_size,
+                    *reinterpret_cast<const T *>(src_leaving));
+        src_leaving += src_stride;
+      }
+      m_state.push(i, *reinterpret_cast<const T *>(src));
+      src += src_stride;
+      if (i >= window_size - 1) {
+        *reinterpret_cast<T *>(dst) = m_state.value();
+        dst += dst_stride;
+      }
+    }
+  }
+
+  inline void destruct_children()
+  {
+    // The NA filler
+    this->get_child_ckernel()->destroy();
+  }
+};
+
 struct rolling_arrfunc_data {
     intptr_t window_size;
     // The window op
@@ -158,6 +466,92 @@ static int resolve_rolling_dst_type(const arrfunc_type_data *af_self,
   return 1;
 }
 
+template <class State>
+static intptr_t instantiate_incremental(
+    intptr_t window_size, intptr_t minp, void *ckb, intptr_t ckb_offset,
+    const ndt::type &dst_el_tp, const char *dst_el_arrmeta, intptr_t dim_size,
+    intptr_t dst_stride, intptr_t src_stride, kernel_request_t kernreq,
+    const eval::eval_context *ectx)
+{
+    typedef strided_incremental_rolling_ck<State> self_type;
+    self_type *self =
+        self_type::create(ckb, kernreq, ckb_offset, window_size, minp);
+    self->m_dim_size = dim_size;
+    self->m_dst_stride = dst_stride;
+    self->m_src_stride = src_stride;
+    // Create the NA-filling child ckernel
+    return kernels::make_constant_value_assignment_ckernel(
+        ckb, ckb_offset, dst_el_tp, dst_el_arrmeta,
+        numeric_limits<double>::quiet_NaN(), kernel_request_strided, ectx);
+}
+
+/**
+ * Creates an incremental rolling ckernel for the builtin reduction,
+ * returning false if there is none for its kind and type.
+ */
+static bool instantiate_incremental(
+    const kernels::builtin_reduction1d_info &info, intptr_t window_size,
+    void *ckb, intptr_t &inout_ckb_offset, const ndt::type &dst_el_tp,
+    const char *dst_el_arrmeta, intptr_t dim_size, intptr_t dst_stride,
+    intptr_t src_stride, kernel_request_t kernreq,
+    const eval::eval_context *ectx)
+{
+    intptr_t (*instantiate)(intptr_t, intptr_t, void *, intptr_t,
+                            const ndt::type &, const char *, intptr_t, intptr_t,
+                            intptr_t, kernel_request_t,
+                            const eval::eval_context *) = NULL;
+    intptr_t minp = info.minp;
+    if (info.kind == kernels::builtin_reduction1d_sum) {
+        switch (info.tid) {
+        case int32_type_id:
+            instantiate = &instantiate_incremental<rolling_sum_state<int32_t> >;
+            break;
+        case int64_type_id:
+            instantiate = &instantiate_incremental<rolling_sum_state<int64_t> >;
+            break;
+        case float64_type_id:
+            instantiate = &instantiate_incremental<rolling_sum_state<double> >;
+            break;
+        default:
+            return false;
+        }
+    }
+    else if (info.tid == float64_type_id) {
+        if (minp <= 0) {
+            if (minp <= -window_size) {
+                throw invalid_argument(
+                    "minp parameter is too large of a negative number");
+            }
+            minp += window_size;
+        }
+        switch (info.kind) {
+        case kernels::builtin_reduction1d_mean:
+            instantiate = &instantiate_incremental<rolling_mean_state>;
+            break;
+        case kernels::builtin_reduction1d_var:
+            instantiate = &instantiate_incremental<rolling_var_state>;
+            break;
+        case kernels::builtin_reduction1d_min:
+            instantiate = &instantiate_incremental<rolling_minmax_state<false> >;
+            break;
+        case kernels::builtin_reduction1d_max:
+            instantiate = &instantiate_incremental<rolling_minmax_state<true> >;
+            break;
+        default:
+            return false;
+        }
+    }
+    else {
+        return false;
+    }
+
+    inout_ckb_offset =
+        instantiate(window_size, minp, ckb, inout_ckb_offset, dst_el_tp,
+                    dst_el_arrmeta, dim_size, dst_stride, src_stride, kernreq,
+                    ectx);
+    return true;
+}
+
 // TODO This should handle both strided and var cases
 static intptr_t
 instantiate_strided(const arrfunc_type_data *af_self,
@@ -171,37 +565,55 @@ instantiate_strided(const arrfunc_type_data *af_self,
     typedef strided_rolling_ck self_type;
     rolling_arrfunc_data *data = *af_self->get_data_as<rolling_arrfunc_data *>();
 
-    intptr_t root_ckb_offset = ckb_offset;
-    self_type *self = self_type::create(ckb, kernreq, ckb_offset);
     const arrfunc_type_data *window_af = data->window_op.get();
     const arrfunc_type *window_af_tp = data->window_op.get_type();
+    intptr_t dim_size, dst_stride, src_stride;
     ndt::type dst_el_tp, src_el_tp;
     const char *dst_el_arrmeta, *src_el_arrmeta;
-    if (!dst_tp.get_as_strided(dst_arrmeta, &self->m_dim_size,
-                               &self->m_dst_stride, &dst_el_tp,
-                               &dst_el_arrmeta)) {
+    if (!dst_tp.get_as_strided(dst_arrmeta, &dim_size, &dst_stride,
+                               &dst_el_tp, &dst_el_arrmeta)) {
         stringstream ss;
         ss << "rolling window ckernel: could not process type " << dst_tp;
         ss << " as a strided dimension";
         throw type_error(ss.str());
     }
     intptr_t src_dim_size;
-    if (!src_tp[0].get_as_strided(src_arrmeta[0], &src_dim_size,
-                                  &self->m_src_stride, &src_el_tp,
-                                  &src_el_arrmeta)) {
+    if (!src_tp[0].get_as_strided(src_arrmeta[0], &src_dim_size, &src_stride,
+                                  &src_el_tp, &src_el_arrmeta)) {
         stringstream ss;
         ss << "rolling window ckernel: could not process type " << src_tp[0];
         ss << " as a strided dimension";
         throw type_error(ss.str());
     }
-    if (src_dim_size != self->m_dim_size) {
+    if (src_dim_size != dim_size) {
         stringstream ss;
         ss << "rolling window ckernel: source dimension size " << src_dim_size
            << " for type " << src_tp[0]
-           << " does not match dest dimension size " << self->m_dim_size
+           << " does not match dest dimension size " << dim_size
            << " for type " << dst_tp;
         throw type_error(ss.str());
     }
+
+    // Builtin reductions get an incremental ckernel in place of
+    // one which calls the window op on every window
+    kernels::builtin_reduction1d_info info;
+    if (dst_el_tp.is_builtin() && dst_el_tp == src_el_tp &&
+        kernels::get_builtin_reduction1d_info(data->window_op, info) &&
+        info.tid == dst_el_tp.get_type_id()) {
+        intptr_t incremental_ckb_offset = ckb_offset;
+        if (instantiate_incremental(info, data->window_size, ckb,
+                                    incremental_ckb_offset, dst_el_tp,
+                                    dst_el_arrmeta, dim_size, dst_stride,
+                                    src_stride, kernreq, ectx)) {
+            return incremental_ckb_offset;
+        }
+    }
+
+    intptr_t root_ckb_offset = ckb_offset;
+    self_type *self = self_type::create(ckb, kernreq, ckb_offset);
+    self->m_dim_size = dim_size;
+    self->m_dst_stride = dst_stride;
+    self->m_src_stride = src_stride;
     self->m_window_size = data->window_size;
     // Create the NA-filling child ckernel
     ckb_offset = kernels::make_constant_value_assignment_ckernel(
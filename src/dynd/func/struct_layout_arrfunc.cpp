@@ -0,0 +1,334 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <dynd/func/struct_layout_arrfunc.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/types/arrfunc_type.hpp>
+#include <dynd/types/base_struct_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/tuple_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+struct struct_layout_item {
+  size_t child_kernel_offset;
+  intptr_t dst_data_offset, dst_stride;
+  intptr_t src_data_offset, src_stride;
+};
+
+/**
+ * CKernel which copies between an array of structs and a struct of
+ * arrays. Each field has a strided child ckernel which copies the
+ * whole dimension of that field.
+ */
+struct struct_layout_ck : public kernels::unary_ck<struct_layout_ck> {
+  intptr_t m_field_count, m_dim_size;
+  // After this are m_field_count struct_layout_item, one per field
+
+  struct_layout_ck(intptr_t field_count, intptr_t dim_size)
+      : m_field_count(field_count), m_dim_size(dim_size)
+  {
+  }
+
+  inline struct_layout_item *get_fields()
+  {
+    return reinterpret_cast<struct_layout_item *>(this + 1);
+  }
+
+  inline void single(char *dst, char *src)
+  {
+    const struct_layout_item *fi = get_fields();
+    for (intptr_t i = 0; i < m_field_count; ++i) {
+      const struct_layout_item &item = fi[i];
+      ckernel_prefix *child = get_child_ckernel(item.child_kernel_offset);
+      expr_strided_t child_fn = child->get_function<expr_strided_t>();
+      char *child_src = src + item.src_data_offset;
+      child_fn(dst + item.dst_data_offset, item.dst_stride, &child_src,
+               &item.src_stride, m_dim_size, child);
+    }
+  }
+
+  inline void destruct_children()
+  {
+    const struct_layout_item *fi = get_fields();
+    for (intptr_t i = 0; i < m_field_count; ++i) {
+      base.destroy_child_ckernel(fi[i].child_kernel_offset);
+    }
+  }
+};
+
+/**
+ * Returns the tuple or struct type with the same field names as
+ * ``tup_tp``, and the given field types.
+ */
+ndt::type make_like_tuple(const ndt::type &tup_tp, const nd::array &field_types)
+{
+  if (tup_tp.get_kind() == struct_kind) {
+    return ndt::make_struct(
+        tup_tp.extended<base_struct_type>()->get_field_names(), field_types);
+  } else {
+    return ndt::make_tuple(field_types);
+  }
+}
+
+bool is_tuple_or_struct(const ndt::type &tp)
+{
+  return tp.get_kind() == tuple_kind || tp.get_kind() == struct_kind;
+}
+
+/**
+ * Makes the struct_layout_ck for an array of structs with the type
+ * ``aos_tp``, and a struct of arrays with the type ``soa_tp``, in either
+ * direction.
+ */
+intptr_t instantiate_struct_layout(
+    const char *funcname, void *ckb, intptr_t ckb_offset, bool dst_is_soa,
+    const ndt::type &aos_tp, const char *aos_arrmeta, const ndt::type &soa_tp,
+    const char *soa_arrmeta, kernel_request_t kernreq,
+    const eval::eval_context *ectx)
+{
+  intptr_t dim_size, aos_stride;
+  ndt::type aos_el_tp;
+  const char *aos_el_arrmeta;
+  if (!aos_tp.get_as_strided(aos_arrmeta, &dim_size, &aos_stride, &aos_el_tp,
+                             &aos_el_arrmeta) ||
+      !is_tuple_or_struct(aos_el_tp)) {
+    stringstream ss;
+    ss << funcname << " arrfunc: could not process type " << aos_tp;
+    ss << " as a strided dimension of structs";
+    throw type_error(ss.str());
+  }
+  if (!is_tuple_or_struct(soa_tp)) {
+    stringstream ss;
+    ss << funcname << " arrfunc: type " << soa_tp
+       << " is not of tuple or struct kind";
+    throw type_error(ss.str());
+  }
+  const base_tuple_type *aos_bsd = aos_el_tp.extended<base_tuple_type>();
+  const base_tuple_type *soa_bsd = soa_tp.extended<base_tuple_type>();
+  intptr_t field_count = aos_bsd->get_field_count();
+  if (field_count != soa_bsd->get_field_count()) {
+    stringstream ss;
+    ss << funcname << " arrfunc: types " << aos_tp << " and " << soa_tp
+       << " have different numbers of fields";
+    throw type_error(ss.str());
+  }
+  const uintptr_t *aos_data_offsets = aos_bsd->get_data_offsets(aos_el_arrmeta);
+  const uintptr_t *aos_arrmeta_offsets = aos_bsd->get_arrmeta_offsets_raw();
+  const uintptr_t *soa_data_offsets = soa_bsd->get_data_offsets(soa_arrmeta);
+  const uintptr_t *soa_arrmeta_offsets = soa_bsd->get_arrmeta_offsets_raw();
+
+  intptr_t root_ckb_offset = ckb_offset;
+  struct_layout_ck::create(ckb, kernreq, ckb_offset, field_count, dim_size);
+  kernels::inc_ckb_offset(ckb_offset, field_count * sizeof(struct_layout_item));
+  for (intptr_t i = 0; i < field_count; ++i) {
+    intptr_t column_size, column_stride;
+    ndt::type column_el_tp;
+    const char *column_el_arrmeta;
+    const ndt::type &column_tp = soa_bsd->get_field_type(i);
+    if (!column_tp.get_as_strided(soa_arrmeta + soa_arrmeta_offsets[i],
+                                  &column_size, &column_stride, &column_el_tp,
+                                  &column_el_arrmeta) ||
+        column_size != dim_size) {
+      stringstream ss;
+      ss << funcname << " arrfunc: field " << i << " of " << soa_tp
+         << " is not a strided dimension of size " << dim_size;
+      throw type_error(ss.str());
+    }
+    reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+        ->ensure_capacity(ckb_offset);
+    struct_layout_ck *self =
+        reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+            ->get_at<struct_layout_ck>(root_ckb_offset);
+    struct_layout_item &field = self->get_fields()[i];
+    field.child_kernel_offset = ckb_offset - root_ckb_offset;
+    const ndt::type &aos_field_tp = aos_bsd->get_field_type(i);
+    const char *aos_field_arrmeta = aos_el_arrmeta + aos_arrmeta_offsets[i];
+    if (dst_is_soa) {
+      field.dst_data_offset = soa_data_offsets[i];
+      field.dst_stride = column_stride;
+      field.src_data_offset = aos_data_offsets[i];
+      field.src_stride = aos_stride;
+      ckb_offset = make_assignment_kernel(
+          NULL, NULL, ckb, ckb_offset, column_el_tp, column_el_arrmeta,
+          aos_field_tp, aos_field_arrmeta, kernel_request_strided, ectx,
+          nd::array());
+    } else {
+      field.dst_data_offset = aos_data_offsets[i];
+      field.dst_stride = aos_stride;
+      field.src_data_offset = soa_data_offsets[i];
+      field.src_stride = column_stride;
+      ckb_offset = make_assignment_kernel(
+          NULL, NULL, ckb, ckb_offset, aos_field_tp, aos_field_arrmeta,
+          column_el_tp, column_el_arrmeta, kernel_request_strided, ectx,
+          nd::array());
+    }
+  }
+  return ckb_offset;
+}
+
+int check_nsrc(const char *funcname, const arrfunc_type *af_tp, intptr_t nsrc,
+               int throw_on_error)
+{
+  if (nsrc != 1) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "Wrong number of arguments to " << funcname
+         << " arrfunc with prototype " << af_tp << ", got " << nsrc
+         << " arguments";
+      throw invalid_argument(ss.str());
+    } else {
+      return 0;
+    }
+  }
+  return 1;
+}
+} // anonymous namespace
+
+static int resolve_struct_of_arrays_dst_type(
+    const arrfunc_type_data *DYND_UNUSED(af_self), const arrfunc_type *af_tp,
+    intptr_t nsrc, const ndt::type *src_tp, int throw_on_error,
+    ndt::type &out_dst_tp, const nd::array &DYND_UNUSED(kwds))
+{
+  if (!check_nsrc("struct_of_arrays", af_tp, nsrc, throw_on_error)) {
+    return 0;
+  }
+  ndt::type el_tp;
+  if (src_tp[0].get_type_id() == fixed_dim_type_id) {
+    el_tp = src_tp[0].get_type_at_dimension(NULL, 1);
+  }
+  if (el_tp.is_null() || !is_tuple_or_struct(el_tp)) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "struct_of_arrays arrfunc: expected a fixed dimension of structs, "
+         << "not " << src_tp[0];
+      throw type_error(ss.str());
+    } else {
+      return 0;
+    }
+  }
+  intptr_t dim_size = src_tp[0].get_dim_size(NULL, NULL);
+  const base_tuple_type *bsd = el_tp.extended<base_tuple_type>();
+  intptr_t field_count = bsd->get_field_count();
+  nd::array field_types = nd::empty(field_count, ndt::make_type());
+  for (intptr_t i = 0; i < field_count; ++i) {
+    unchecked_fixed_dim_get_rw<ndt::type>(field_types, i) =
+        ndt::make_fixed_dim(dim_size,
+                            bsd->get_field_type(i).get_canonical_type());
+  }
+  field_types.flag_as_immutable();
+  out_dst_tp = make_like_tuple(el_tp, field_types);
+  return 1;
+}
+
+static intptr_t instantiate_struct_of_arrays(
+    const arrfunc_type_data *DYND_UNUSED(af_self),
+    const arrfunc_type *DYND_UNUSED(af_tp), void *ckb, intptr_t ckb_offset,
+    const ndt::type &dst_tp, const char *dst_arrmeta, const ndt::type *src_tp,
+    const char *const *src_arrmeta, kernel_request_t kernreq,
+    const eval::eval_context *ectx, const nd::array &DYND_UNUSED(kwds))
+{
+  return instantiate_struct_layout("struct_of_arrays", ckb, ckb_offset, true,
+                                   src_tp[0], src_arrmeta[0], dst_tp,
+                                   dst_arrmeta, kernreq, ectx);
+}
+
+static int resolve_array_of_structs_dst_type(
+    const arrfunc_type_data *DYND_UNUSED(af_self), const arrfunc_type *af_tp,
+    intptr_t nsrc, const ndt::type *src_tp, int throw_on_error,
+    ndt::type &out_dst_tp, const nd::array &DYND_UNUSED(kwds))
+{
+  if (!check_nsrc("array_of_structs", af_tp, nsrc, throw_on_error)) {
+    return 0;
+  }
+  if (!is_tuple_or_struct(src_tp[0])) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "array_of_structs arrfunc: expected a struct of fixed dimensions, "
+         << "not " << src_tp[0];
+      throw type_error(ss.str());
+    } else {
+      return 0;
+    }
+  }
+  const base_tuple_type *bsd = src_tp[0].extended<base_tuple_type>();
+  intptr_t field_count = bsd->get_field_count();
+  intptr_t dim_size = -1;
+  nd::array field_types = nd::empty(field_count, ndt::make_type());
+  for (intptr_t i = 0; i < field_count; ++i) {
+    const ndt::type &ft = bsd->get_field_type(i);
+    if (ft.get_type_id() != fixed_dim_type_id ||
+        (dim_size >= 0 && ft.get_dim_size(NULL, NULL) != dim_size)) {
+      if (throw_on_error) {
+        stringstream ss;
+        ss << "array_of_structs arrfunc: expected a struct of fixed "
+           << "dimensions with the same size, not " << src_tp[0];
+        throw type_error(ss.str());
+      } else {
+        return 0;
+      }
+    }
+    dim_size = ft.get_dim_size(NULL, NULL);
+    unchecked_fixed_dim_get_rw<ndt::type>(field_types, i) =
+        ft.get_type_at_dimension(NULL, 1).get_canonical_type();
+  }
+  if (dim_size < 0) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "array_of_structs arrfunc: cannot find the dimension size of a "
+         << "struct with no fields, " << src_tp[0];
+      throw type_error(ss.str());
+    } else {
+      return 0;
+    }
+  }
+  field_types.flag_as_immutable();
+  out_dst_tp =
+      ndt::make_fixed_dim(dim_size, make_like_tuple(src_tp[0], field_types));
+  return 1;
+}
+
+static intptr_t instantiate_array_of_structs(
+    const arrfunc_type_data *DYND_UNUSED(af_self),
+    const arrfunc_type *DYND_UNUSED(af_tp), void *ckb, intptr_t ckb_offset,
+    const ndt::type &dst_tp, const char *dst_arrmeta, const ndt::type *src_tp,
+    const char *const *src_arrmeta, kernel_request_t kernreq,
+    const eval::eval_context *ectx, const nd::array &DYND_UNUSED(kwds))
+{
+  return instantiate_struct_layout("array_of_structs", ckb, ckb_offset, false,
+                                   dst_tp, dst_arrmeta, src_tp[0],
+                                   src_arrmeta[0], kernreq, ectx);
+}
+
+nd::arrfunc kernels::make_struct_of_arrays_arrfunc()
+{
+  static ndt::type func_proto =
+      ndt::make_funcproto(ndt::type("N * T"), ndt::type("R"));
+  nd::array af = nd::empty(func_proto);
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  out_af->free = NULL;
+  out_af->resolve_dst_type = &resolve_struct_of_arrays_dst_type;
+  out_af->instantiate = &instantiate_struct_of_arrays;
+  af.flag_as_immutable();
+  return af;
+}
+
+nd::arrfunc kernels::make_array_of_structs_arrfunc()
+{
+  static ndt::type func_proto =
+      ndt::make_funcproto(ndt::type("T"), ndt::type("N * R"));
+  nd::array af = nd::empty(func_proto);
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  out_af->free = NULL;
+  out_af->resolve_dst_type = &resolve_array_of_structs_dst_type;
+  out_af->instantiate = &instantiate_array_of_structs;
+  af.flag_as_immutable();
+  return af;
+}
@@ -0,0 +1,476 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <dynd/groupby.hpp>
+#include <dynd/hash.hpp>
+#include <dynd/eval/thread_pool.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/types/base_struct_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// Inputs with at least this many rows are split across the threads
+// of the default eval context
+const intptr_t parallel_groupby_threshold = 1 << 16;
+
+// The number of rows whose group ids are found before the values are
+// accumulated, small enough for the ids to stay in cache
+const intptr_t groupby_block_size = 1024;
+
+/**
+ * The partial reduction of one value column, for every group seen so
+ * far. Only the accumulators of the column's accumulation type A (int64,
+ * uint64 or double, by the kind of the column) are used, through
+ * ``acc<A>()``, and ``n`` counts the non-NaN values.
+ */
+struct agg_partial {
+  std::vector<int64_t> int_acc;
+  std::vector<uint64_t> uint_acc;
+  std::vector<double> real_acc;
+  std::vector<int64_t> n;
+
+  template <typename A>
+  std::vector<A> &acc();
+
+  template <typename A>
+  const std::vector<A> &acc() const
+  {
+    return const_cast<agg_partial *>(this)->acc<A>();
+  }
+
+  template <typename A>
+  void resize(intptr_t ngroups)
+  {
+    acc<A>().resize(ngroups);
+    n.resize(ngroups);
+  }
+};
+
+template <>
+std::vector<int64_t> &agg_partial::acc<int64_t>()
+{
+  return int_acc;
+}
+
+template <>
+std::vector<uint64_t> &agg_partial::acc<uint64_t>()
+{
+  return uint_acc;
+}
+
+template <>
+std::vector<double> &agg_partial::acc<double>()
+{
+  return real_acc;
+}
+
+template <typename A>
+void resize_partial(agg_partial &p, intptr_t ngroups)
+{
+  p.resize<A>(ngroups);
+}
+
+template <typename T>
+inline bool is_nan(T)
+{
+  return false;
+}
+
+inline bool is_nan(float v) { return v != v; }
+
+inline bool is_nan(double v) { return v != v; }
+
+template <typename T, typename A>
+void accumulate(groupby_aggregate_t agg, const char *data, intptr_t stride,
+                const intptr_t *ids, intptr_t count, agg_partial &p)
+{
+  A *acc = p.acc<A>().data();
+  int64_t *n = p.n.data();
+  for (intptr_t i = 0; i < count; ++i, data += stride) {
+    T v = *reinterpret_cast<const T *>(data);
+    if (is_nan(v)) {
+      continue;
+    }
+    intptr_t g = ids[i];
+    switch (agg) {
+    case groupby_aggregate_sum:
+    case groupby_aggregate_mean:
+      acc[g] += static_cast<A>(v);
+      break;
+    case groupby_aggregate_min:
+      if (n[g] == 0 || static_cast<A>(v) < acc[g]) {
+        acc[g] = static_cast<A>(v);
+      }
+      break;
+    case groupby_aggregate_max:
+      if (n[g] == 0 || acc[g] < static_cast<A>(v)) {
+        acc[g] = static_cast<A>(v);
+      }
+      break;
+    default:
+      break;
+    }
+    ++n[g];
+  }
+}
+
+/**
+ * Merges the partial reduction ``src`` into ``dst``, where group ``i``
+ * of ``src`` is group ``id_map[i]`` of ``dst``.
+ */
+template <typename A>
+void merge(groupby_aggregate_t agg, const agg_partial &src,
+           const intptr_t *id_map, agg_partial &dst)
+{
+  const A *src_acc = src.acc<A>().data();
+  A *dst_acc = dst.acc<A>().data();
+  for (size_t i = 0; i != src.n.size(); ++i) {
+    intptr_t g = id_map[i];
+    if (src.n[i] == 0) {
+      continue;
+    }
+    switch (agg) {
+    case groupby_aggregate_sum:
+    case groupby_aggregate_mean:
+      dst_acc[g] += src_acc[i];
+      break;
+    case groupby_aggregate_min:
+      if (dst.n[g] == 0 || src_acc[i] < dst_acc[g]) {
+        dst_acc[g] = src_acc[i];
+      }
+      break;
+    case groupby_aggregate_max:
+      if (dst.n[g] == 0 || dst_acc[g] < src_acc[i]) {
+        dst_acc[g] = src_acc[i];
+      }
+      break;
+    default:
+      break;
+    }
+    dst.n[g] += src.n[i];
+  }
+}
+
+template <typename T, typename A>
+void finalize(groupby_aggregate_t agg, const agg_partial &p, char *dst,
+              intptr_t dst_stride)
+{
+  if (p.n.empty()) {
+    return;
+  }
+  const A *acc = p.acc<A>().data();
+  for (size_t g = 0; g != p.n.size(); ++g, dst += dst_stride) {
+    switch (agg) {
+    case groupby_aggregate_count:
+      *reinterpret_cast<int64_t *>(dst) = p.n[g];
+      break;
+    case groupby_aggregate_sum:
+      *reinterpret_cast<A *>(dst) = acc[g];
+      break;
+    case groupby_aggregate_mean:
+      *reinterpret_cast<double *>(dst) =
+          p.n[g] > 0 ? static_cast<double>(acc[g]) / p.n[g]
+                     : numeric_limits<double>::quiet_NaN();
+      break;
+    default:
+      // Only groups of floating point values can have no values
+      *reinterpret_cast<T *>(dst) = p.n[g] > 0
+                                        ? static_cast<T>(acc[g])
+                                        : numeric_limits<T>::quiet_NaN();
+      break;
+    }
+  }
+}
+
+typedef void (*accumulate_t)(groupby_aggregate_t agg, const char *data,
+                             intptr_t stride, const intptr_t *ids,
+                             intptr_t count, agg_partial &p);
+typedef void (*resize_partial_t)(agg_partial &p, intptr_t ngroups);
+typedef void (*merge_t)(groupby_aggregate_t agg, const agg_partial &src,
+                        const intptr_t *id_map, agg_partial &dst);
+typedef void (*finalize_t)(groupby_aggregate_t agg, const agg_partial &p,
+                           char *dst, intptr_t dst_stride);
+
+struct agg_column {
+  std::string name;
+  uintptr_t data_offset;
+  ndt::type result_tp;
+  resize_partial_t resize_fn;
+  accumulate_t accumulate_fn;
+  merge_t merge_fn;
+  finalize_t finalize_fn;
+};
+
+template <typename T, typename A>
+void init_agg_column(agg_column &col, groupby_aggregate_t agg,
+                     const ndt::type &value_tp)
+{
+  col.resize_fn = &resize_partial<A>;
+  col.accumulate_fn = &accumulate<T, A>;
+  col.merge_fn = &merge<A>;
+  col.finalize_fn = &finalize<T, A>;
+  switch (agg) {
+  case groupby_aggregate_count:
+    col.result_tp = ndt::make_type<int64_t>();
+    break;
+  case groupby_aggregate_sum:
+    col.result_tp = ndt::make_type<A>();
+    break;
+  case groupby_aggregate_mean:
+    col.result_tp = ndt::make_type<double>();
+    break;
+  default:
+    col.result_tp = value_tp;
+    break;
+  }
+}
+
+agg_column make_agg_column(const std::string &name, uintptr_t data_offset,
+                           const ndt::type &value_tp, groupby_aggregate_t agg)
+{
+  agg_column col;
+  col.name = name;
+  col.data_offset = data_offset;
+  switch (value_tp.get_type_id()) {
+  case bool_type_id:
+    // dynd_bool is stored as a uint8 0 or 1
+    init_agg_column<uint8_t, int64_t>(col, agg, value_tp);
+    break;
+  case int8_type_id:
+    init_agg_column<int8_t, int64_t>(col, agg, value_tp);
+    break;
+  case int16_type_id:
+    init_agg_column<int16_t, int64_t>(col, agg, value_tp);
+    break;
+  case int32_type_id:
+    init_agg_column<int32_t, int64_t>(col, agg, value_tp);
+    break;
+  case int64_type_id:
+    init_agg_column<int64_t, int64_t>(col, agg, value_tp);
+    break;
+  case uint8_type_id:
+    init_agg_column<uint8_t, uint64_t>(col, agg, value_tp);
+    break;
+  case uint16_type_id:
+    init_agg_column<uint16_t, uint64_t>(col, agg, value_tp);
+    break;
+  case uint32_type_id:
+    init_agg_column<uint32_t, uint64_t>(col, agg, value_tp);
+    break;
+  case uint64_type_id:
+    init_agg_column<uint64_t, uint64_t>(col, agg, value_tp);
+    break;
+  case float32_type_id:
+    init_agg_column<float, double>(col, agg, value_tp);
+    break;
+  case float64_type_id:
+    init_agg_column<double, double>(col, agg, value_tp);
+    break;
+  default: {
+    stringstream ss;
+    ss << "dynd groupby_aggregate: cannot reduce values of type " << value_tp;
+    throw type_error(ss.str());
+  }
+  }
+  return col;
+}
+
+/**
+ * The hash table and partial reductions for one chunk of the rows.
+ */
+struct groupby_chunk {
+  value_hash_index *index;
+  std::vector<agg_partial> partials;
+
+  groupby_chunk() : index(NULL) {}
+  ~groupby_chunk() { delete index; }
+
+private:
+  // Non-copyable, since it owns the index
+  groupby_chunk(const groupby_chunk &);
+  groupby_chunk &operator=(const groupby_chunk &);
+};
+
+struct groupby_job {
+  groupby_aggregate_t agg;
+  intptr_t size, nchunks;
+  const char *keys_data, *values_data;
+  intptr_t keys_stride, values_stride;
+  const std::vector<agg_column> *columns;
+  std::vector<groupby_chunk> *chunks;
+};
+
+void groupby_chunk_fn(intptr_t DYND_UNUSED(thread_index), intptr_t chunk_index,
+                      void *data)
+{
+  groupby_job *job = reinterpret_cast<groupby_job *>(data);
+  groupby_chunk &chunk = (*job->chunks)[chunk_index];
+  const std::vector<agg_column> &columns = *job->columns;
+  intptr_t begin = job->size / job->nchunks * chunk_index;
+  intptr_t end = chunk_index == job->nchunks - 1
+                     ? job->size
+                     : job->size / job->nchunks * (chunk_index + 1);
+
+  intptr_t ids[groupby_block_size];
+  for (intptr_t i = begin; i < end; i += groupby_block_size) {
+    intptr_t count = min(groupby_block_size, end - i);
+    chunk.index->insert(job->keys_data + i * job->keys_stride,
+                        job->keys_stride, count, ids);
+    for (size_t c = 0; c != columns.size(); ++c) {
+      columns[c].resize_fn(chunk.partials[c], chunk.index->size());
+      columns[c].accumulate_fn(
+          job->agg,
+          job->values_data + i * job->values_stride + columns[c].data_offset,
+          job->values_stride, ids, count, chunk.partials[c]);
+    }
+  }
+}
+
+nd::array get_strided_column(const nd::array &a, const char *name,
+                             intptr_t &out_size, intptr_t &out_stride,
+                             ndt::type &out_el_tp,
+                             const char *&out_el_arrmeta)
+{
+  nd::array values = a.get_dtype().is_expression() ? a.eval() : a;
+  if (values.get_ndim() != 1 ||
+      !values.get_type().get_as_strided(values.get_arrmeta(), &out_size,
+                                        &out_stride, &out_el_tp,
+                                        &out_el_arrmeta)) {
+    stringstream ss;
+    ss << "dynd groupby_aggregate: expected one-dimensional strided '" << name
+       << "', but received " << a.get_type();
+    throw type_error(ss.str());
+  }
+  return values;
+}
+
+} // anonymous namespace
+
+nd::array nd::groupby_aggregate(const nd::array &keys, const nd::array &values,
+                                groupby_aggregate_t agg)
+{
+  intptr_t size, keys_stride, values_size, values_stride;
+  ndt::type key_tp, value_tp;
+  const char *key_arrmeta, *value_arrmeta;
+  nd::array k =
+      get_strided_column(keys, "keys", size, keys_stride, key_tp, key_arrmeta);
+  nd::array v = get_strided_column(values, "values", values_size,
+                                   values_stride, value_tp, value_arrmeta);
+  if (size != values_size) {
+    stringstream ss;
+    ss << "dynd groupby_aggregate: 'keys' and 'values' have different sizes, ";
+    ss << size << " and " << values_size;
+    throw runtime_error(ss.str());
+  }
+
+  // One column for a scalar value, or one per field of a struct
+  std::vector<agg_column> columns;
+  if (value_tp.get_kind() == struct_kind) {
+    const base_struct_type *bsd = value_tp.extended<base_struct_type>();
+    const uintptr_t *data_offsets = bsd->get_data_offsets(value_arrmeta);
+    for (intptr_t i = 0; i < bsd->get_field_count(); ++i) {
+      columns.push_back(make_agg_column(bsd->get_field_name(i),
+                                        data_offsets[i],
+                                        bsd->get_field_type(i), agg));
+    }
+  } else {
+    columns.push_back(make_agg_column("value", 0, value_tp, agg));
+  }
+
+  const eval::eval_context *ectx = &eval::default_eval_context;
+  intptr_t nchunks =
+      (size >= parallel_groupby_threshold && ectx->nthreads > 1) ? ectx->nthreads
+                                                                 : 1;
+  std::vector<groupby_chunk> chunks(nchunks);
+  for (intptr_t c = 0; c < nchunks; ++c) {
+    chunks[c].index = new value_hash_index(key_tp, key_arrmeta, ectx);
+    chunks[c].partials.resize(columns.size());
+  }
+
+  groupby_job job;
+  job.agg = agg;
+  job.size = size;
+  job.nchunks = nchunks;
+  job.keys_data = k.get_readonly_originptr();
+  job.keys_stride = keys_stride;
+  job.values_data = v.get_readonly_originptr();
+  job.values_stride = values_stride;
+  job.columns = &columns;
+  job.chunks = &chunks;
+  eval::parallel_for(ectx->nthreads, nchunks, &groupby_chunk_fn, &job);
+
+  // Merge the chunks into the first one, in order, so the groups stay in
+  // the order their keys first appear
+  groupby_chunk &result_chunk = chunks[0];
+  std::vector<intptr_t> id_map;
+  for (intptr_t c = 1; c < nchunks; ++c) {
+    value_hash_index &index = *chunks[c].index;
+    id_map.resize(index.size());
+    for (intptr_t i = 0; i < index.size(); ++i) {
+      result_chunk.index->insert(index.get_value(i), 0, 1, &id_map[i]);
+    }
+    for (size_t col = 0; col != columns.size(); ++col) {
+      columns[col].resize_fn(result_chunk.partials[col],
+                             result_chunk.index->size());
+      if (index.size() > 0) {
+        columns[col].merge_fn(agg, chunks[c].partials[col], &id_map[0],
+                              result_chunk.partials[col]);
+      }
+    }
+  }
+  value_hash_index &index = *result_chunk.index;
+  for (size_t col = 0; col != columns.size(); ++col) {
+    columns[col].resize_fn(result_chunk.partials[col], index.size());
+  }
+
+  // Assemble the "N * {key: K, ...}" result
+  nd::array field_names = nd::empty(columns.size() + 1, ndt::make_string());
+  nd::array field_types = nd::empty(columns.size() + 1, ndt::make_type());
+  field_names(0).vals() = "key";
+  unchecked_fixed_dim_get_rw<ndt::type>(field_types, 0) = key_tp;
+  for (size_t col = 0; col != columns.size(); ++col) {
+    field_names(col + 1).vals() = columns[col].name;
+    unchecked_fixed_dim_get_rw<ndt::type>(field_types, col + 1) =
+        columns[col].result_tp;
+  }
+  field_names.flag_as_immutable();
+  field_types.flag_as_immutable();
+  ndt::type struct_tp = ndt::make_struct(field_names, field_types);
+
+  nd::array result = nd::empty(index.size(), struct_tp);
+  const char *struct_arrmeta =
+      result.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
+  const base_struct_type *bsd = struct_tp.extended<base_struct_type>();
+  const uintptr_t *data_offsets = bsd->get_data_offsets(struct_arrmeta);
+  const uintptr_t *arrmeta_offsets = bsd->get_arrmeta_offsets_raw();
+  intptr_t result_stride =
+      reinterpret_cast<const fixed_dim_type_arrmeta *>(result.get_arrmeta())
+          ->stride;
+  char *dst = result.get_readwrite_originptr();
+
+  unary_ckernel_builder key_assign;
+  make_assignment_kernel(NULL, NULL, &key_assign, 0, key_tp,
+                         struct_arrmeta + arrmeta_offsets[0], key_tp,
+                         key_arrmeta, kernel_request_single, ectx, nd::array());
+  for (intptr_t i = 0; i < index.size(); ++i) {
+    key_assign(dst + i * result_stride + data_offsets[0],
+               const_cast<char *>(index.get_value(i)));
+  }
+  for (size_t col = 0; col != columns.size(); ++col) {
+    columns[col].finalize_fn(agg, result_chunk.partials[col],
+                             dst + data_offsets[col + 1], result_stride);
+  }
+  return result;
+}
@@ -0,0 +1,353 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include <dynd/hash.hpp>
+#include <dynd/func/lift_arrfunc.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/kernels/comparison_kernels.hpp>
+#include <dynd/types/base_tuple_type.hpp>
+#include <dynd/types/bytes_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/struct_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+value_hash_index::value_hash_index(const ndt::type &tp, const char *arrmeta,
+                                   const eval::eval_context *ectx)
+    : m_tp(tp), m_arrmeta(arrmeta), m_hash_is_exact(false), m_option(false)
+{
+  slot empty = {0, -1};
+  m_slots.resize(16, empty);
+  make_hash_kernel(&m_hash_ck, 0, tp, arrmeta, kernel_request_strided, ectx);
+
+  ndt::type value_tp = tp;
+  if (tp.get_type_id() == option_type_id) {
+    m_option = true;
+    value_tp = tp.extended<option_type>()->get_value_type();
+    const arrfunc_type_data *af =
+        tp.extended<option_type>()->get_is_avail_arrfunc();
+    const arrfunc_type *af_tp =
+        tp.extended<option_type>()->get_is_avail_arrfunc_type();
+    af->instantiate(af, af_tp, &m_is_avail_ck, 0, ndt::make_type<dynd_bool>(),
+                    NULL, &tp, &arrmeta, kernel_request_single, ectx,
+                    nd::array());
+  }
+  m_data_size = value_tp.get_data_size();
+  switch (value_tp.get_type_id()) {
+  case bool_type_id:
+  case int8_type_id:
+  case int16_type_id:
+  case int32_type_id:
+  case int64_type_id:
+  case uint8_type_id:
+  case uint16_type_id:
+  case uint32_type_id:
+  case uint64_type_id:
+    m_hash_is_exact = !m_option;
+    m_equal_kind = equal_bytes;
+    break;
+  case int128_type_id:
+  case uint128_type_id:
+  case fixedbytes_type_id:
+  case fixedstring_type_id:
+  case categorical_type_id:
+  case date_type_id:
+  case time_type_id:
+  case datetime_type_id:
+    m_equal_kind = equal_bytes;
+    break;
+  case string_type_id:
+  case bytes_type_id:
+    m_equal_kind = equal_blockref_bytes;
+    break;
+  default:
+    // Two values are equal when neither sorts before the other, which
+    // makes NaN equal to NaN unlike comparison_type_equal
+    m_equal_kind = equal_sorting_less;
+    make_comparison_kernel(&m_less_ck, 0, value_tp, arrmeta, value_tp, arrmeta,
+                           comparison_type_sorting_less, ectx);
+    break;
+  }
+}
+
+bool value_hash_index::equal(const char *a, const char *b) const
+{
+  if (m_option) {
+    ckernel_prefix *is_avail = m_is_avail_ck.get();
+    expr_single_t is_avail_fn = is_avail->get_function<expr_single_t>();
+    dynd_bool a_avail = false, b_avail = false;
+    char *src = const_cast<char *>(a);
+    is_avail_fn(reinterpret_cast<char *>(&a_avail), &src, is_avail);
+    src = const_cast<char *>(b);
+    is_avail_fn(reinterpret_cast<char *>(&b_avail), &src, is_avail);
+    if (!a_avail || !b_avail) {
+      return !a_avail && !b_avail;
+    }
+  }
+
+  switch (m_equal_kind) {
+  case equal_bytes:
+    return memcmp(a, b, m_data_size) == 0;
+  case equal_blockref_bytes: {
+    const bytes_type_data *ad = reinterpret_cast<const bytes_type_data *>(a);
+    const bytes_type_data *bd = reinterpret_cast<const bytes_type_data *>(b);
+    size_t size = ad->end - ad->begin;
+    return size == (size_t)(bd->end - bd->begin) &&
+           memcmp(ad->begin, bd->begin, size) == 0;
+  }
+  default: {
+    ckernel_prefix *less = m_less_ck.get();
+    expr_predicate_t less_fn = less->get_function<expr_predicate_t>();
+    const char *src[2] = {a, b};
+    if (less_fn(src, less)) {
+      return false;
+    }
+    src[0] = b;
+    src[1] = a;
+    return !less_fn(src, less);
+  }
+  }
+}
+
+void value_hash_index::grow()
+{
+  size_t capacity = m_slots.size() * 2;
+  size_t mask = capacity - 1;
+  slot empty = {0, -1};
+  vector<slot> slots(capacity, empty);
+  for (size_t i = 0; i != m_slots.size(); ++i) {
+    if (m_slots[i].id >= 0) {
+      size_t pos = m_slots[i].hash & mask;
+      while (slots[pos].id >= 0) {
+        pos = (pos + 1) & mask;
+      }
+      slots[pos] = m_slots[i];
+    }
+  }
+  m_slots.swap(slots);
+}
+
+void value_hash_index::insert(const char *data, intptr_t stride,
+                              intptr_t count, intptr_t *out_ids)
+{
+  ckernel_prefix *hash = m_hash_ck.get();
+  expr_strided_t hash_fn = hash->get_function<expr_strided_t>();
+  m_hash_buffer.resize(DYND_BUFFER_CHUNK_SIZE);
+  uint64_t *hashes = &m_hash_buffer[0];
+  // Hash a chunk of values in one kernel call, then probe for each
+  while (count > 0) {
+    intptr_t chunk_size = min(count, (intptr_t)DYND_BUFFER_CHUNK_SIZE);
+    char *src = const_cast<char *>(data);
+    hash_fn(reinterpret_cast<char *>(hashes), sizeof(uint64_t), &src, &stride,
+            chunk_size, hash);
+    for (intptr_t i = 0; i < chunk_size; ++i, data += stride) {
+      // Keep the load factor at most 1/2
+      if (2 * (m_values.size() + 1) > m_slots.size()) {
+        grow();
+      }
+      size_t mask = m_slots.size() - 1;
+      uint64_t h = hashes[i];
+      size_t pos = h & mask;
+      intptr_t id;
+      for (;;) {
+        id = m_slots[pos].id;
+        if (id < 0) {
+          id = m_values.size();
+          m_slots[pos].hash = h;
+          m_slots[pos].id = id;
+          m_values.push_back(data);
+          break;
+        } else if (m_slots[pos].hash == h &&
+                   (m_hash_is_exact || equal(m_values[id], data))) {
+          break;
+        }
+        pos = (pos + 1) & mask;
+      }
+      out_ids[i] = id;
+    }
+    out_ids += chunk_size;
+    count -= chunk_size;
+  }
+}
+
+void value_hash_index::find(const char *data, intptr_t stride, intptr_t count,
+                            intptr_t *out_ids) const
+{
+  ckernel_prefix *hash = m_hash_ck.get();
+  expr_strided_t hash_fn = hash->get_function<expr_strided_t>();
+  uint64_t hashes[DYND_BUFFER_CHUNK_SIZE];
+  size_t mask = m_slots.size() - 1;
+  while (count > 0) {
+    intptr_t chunk_size = min(count, (intptr_t)DYND_BUFFER_CHUNK_SIZE);
+    char *src = const_cast<char *>(data);
+    hash_fn(reinterpret_cast<char *>(hashes), sizeof(uint64_t), &src, &stride,
+            chunk_size, hash);
+    for (intptr_t i = 0; i < chunk_size; ++i, data += stride) {
+      uint64_t h = hashes[i];
+      size_t pos = h & mask;
+      intptr_t id;
+      for (;;) {
+        id = m_slots[pos].id;
+        if (id < 0 || (m_slots[pos].hash == h &&
+                       (m_hash_is_exact || equal(m_values[id], data)))) {
+          break;
+        }
+        pos = (pos + 1) & mask;
+      }
+      out_ids[i] = id;
+    }
+    out_ids += chunk_size;
+    count -= chunk_size;
+  }
+}
+
+namespace {
+
+intptr_t instantiate_hash(const arrfunc_type_data *DYND_UNUSED(af_self),
+                          const arrfunc_type *DYND_UNUSED(af_tp), void *ckb,
+                          intptr_t ckb_offset, const ndt::type &dst_tp,
+                          const char *DYND_UNUSED(dst_arrmeta),
+                          const ndt::type *src_tp,
+                          const char *const *src_arrmeta,
+                          kernel_request_t kernreq,
+                          const eval::eval_context *ectx,
+                          const nd::array &DYND_UNUSED(kwds))
+{
+  if (dst_tp.get_type_id() != uint64_type_id) {
+    stringstream ss;
+    ss << "dynd hash: destination type " << dst_tp << " is not uint64";
+    throw type_error(ss.str());
+  }
+  return make_hash_kernel(ckb, ckb_offset, src_tp[0], src_arrmeta[0], kernreq,
+                          ectx);
+}
+
+/**
+ * Gets the one-dimensional strided array to find the distinct values
+ * of, evaluating any expression type.
+ */
+nd::array get_strided_values(const nd::array &a, const char *name,
+                             intptr_t &out_size, intptr_t &out_stride,
+                             ndt::type &out_el_tp,
+                             const char *&out_el_arrmeta)
+{
+  nd::array values = a.get_dtype().is_expression() ? a.eval() : a;
+  if (values.get_ndim() != 1 ||
+      !values.get_type().get_as_strided(values.get_arrmeta(), &out_size,
+                                        &out_stride, &out_el_tp,
+                                        &out_el_arrmeta)) {
+    stringstream ss;
+    ss << "dynd " << name << ": expected a one-dimensional strided array, "
+       << "but received " << a.get_type();
+    throw type_error(ss.str());
+  }
+  return values;
+}
+
+/**
+ * Copies the distinct values in ``index`` to the strided destination.
+ */
+void copy_index_values(const value_hash_index &index, char *dst,
+                       intptr_t dst_stride, const ndt::type &dst_tp,
+                       const char *dst_arrmeta, const ndt::type &src_tp,
+                       const char *src_arrmeta)
+{
+  unary_ckernel_builder k;
+  make_assignment_kernel(NULL, NULL, &k, 0, dst_tp, dst_arrmeta, src_tp,
+                         src_arrmeta, kernel_request_single,
+                         &eval::default_eval_context, nd::array());
+  for (intptr_t i = 0; i < index.size(); ++i, dst += dst_stride) {
+    k(dst, const_cast<char *>(index.get_value(i)));
+  }
+}
+
+} // anonymous namespace
+
+nd::arrfunc dynd::make_hash_arrfunc()
+{
+  nd::array af = nd::empty(ndt::type("(T) -> uint64"));
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  out_af->instantiate = &instantiate_hash;
+  out_af->free = NULL;
+  af.flag_as_immutable();
+  return af;
+}
+
+nd::array nd::hash(const nd::array &a)
+{
+  nd::arrfunc af = make_hash_arrfunc();
+  if (a.get_ndim() == 0) {
+    return af(a);
+  } else {
+    return lift_arrfunc(af)(a);
+  }
+}
+
+nd::array nd::unique(const nd::array &a)
+{
+  intptr_t size, stride;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  nd::array values =
+      get_strided_values(a, "unique", size, stride, el_tp, el_arrmeta);
+
+  value_hash_index index(el_tp, el_arrmeta, &eval::default_eval_context);
+  vector<intptr_t> ids(size);
+  index.insert(values.get_readonly_originptr(), stride, size,
+               ids.empty() ? NULL : &ids[0]);
+
+  nd::array result = nd::empty(index.size(), el_tp);
+  copy_index_values(index, result.get_readwrite_originptr(),
+                    reinterpret_cast<const fixed_dim_type_arrmeta *>(
+                        result.get_arrmeta())->stride,
+                    el_tp,
+                    result.get_arrmeta() + sizeof(fixed_dim_type_arrmeta),
+                    el_tp, el_arrmeta);
+  return result;
+}
+
+nd::array nd::value_counts(const nd::array &a)
+{
+  intptr_t size, stride;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  nd::array values =
+      get_strided_values(a, "value_counts", size, stride, el_tp, el_arrmeta);
+
+  value_hash_index index(el_tp, el_arrmeta, &eval::default_eval_context);
+  vector<intptr_t> ids(size);
+  index.insert(values.get_readonly_originptr(), stride, size,
+               ids.empty() ? NULL : &ids[0]);
+  vector<int64_t> counts(index.size());
+  for (intptr_t i = 0; i < size; ++i) {
+    ++counts[ids[i]];
+  }
+
+  ndt::type struct_tp =
+      ndt::make_struct(el_tp, "value", ndt::make_type<int64_t>(), "count");
+  nd::array result = nd::empty(index.size(), struct_tp);
+  const char *struct_arrmeta =
+      result.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
+  const base_tuple_type *bsd = struct_tp.extended<base_tuple_type>();
+  const uintptr_t *data_offsets = bsd->get_data_offsets(struct_arrmeta);
+  const uintptr_t *arrmeta_offsets = bsd->get_arrmeta_offsets_raw();
+  intptr_t result_stride =
+      reinterpret_cast<const fixed_dim_type_arrmeta *>(result.get_arrmeta())
+          ->stride;
+  char *dst = result.get_readwrite_originptr();
+  copy_index_values(index, dst + data_offsets[0], result_stride, el_tp,
+                    struct_arrmeta + arrmeta_offsets[0], el_tp, el_arrmeta);
+  dst += data_offsets[1];
+  for (intptr_t i = 0; i < index.size(); ++i, dst += result_stride) {
+    *reinterpret_cast<int64_t *>(dst) = counts[i];
+  }
+  return result;
+}
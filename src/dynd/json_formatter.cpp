@@ -3,6 +3,10 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <deque>
+#include <ostream>
+#include <vector>
+
 #include <dynd/json_formatter.hpp>
 #include <dynd/types/string_type.hpp>
 #include <dynd/types/json_type.hpp>
@@ -13,28 +17,85 @@
 #include <dynd/types/cfixed_dim_type.hpp>
 #include <dynd/types/var_dim_type.hpp>
 #include <dynd/types/option_type.hpp>
+#include <dynd/kernels/ckernel_builder.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DYND_JSON_FORMAT_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 using namespace std;
 using namespace dynd;
 
+json_output_sink::~json_output_sink() {}
+
+namespace {
+
+class string_output_sink : public json_output_sink {
+  std::string &m_str;
+
+public:
+  explicit string_output_sink(std::string &str) : m_str(str) {}
+
+  void write(const char *begin, const char *end) { m_str.append(begin, end); }
+};
+
+class ostream_output_sink : public json_output_sink {
+  std::ostream &m_o;
+
+public:
+  explicit ostream_output_sink(std::ostream &o) : m_o(o) {}
+
+  void write(const char *begin, const char *end)
+  {
+    m_o.write(begin, end - begin);
+  }
+};
+
+} // anonymous namespace
+
 struct output_data {
   char *out_begin, *out_end, *out_capacity_end;
+  // When formatting into a string, the memory block which holds the output
   memory_block_pod_allocator_api *api;
   memory_block_data *blockref;
+  // When streaming, the sink which receives each filled buffer
+  json_output_sink *sink;
+  std::vector<char> *sink_buffer;
   bool struct_as_list;
 
+  void init_sink(json_output_sink *s, std::vector<char> *buffer,
+                 intptr_t buffer_size, bool sal)
+  {
+    api = NULL;
+    blockref = NULL;
+    sink = s;
+    sink_buffer = buffer;
+    sink_buffer->resize(buffer_size);
+    out_begin = out_end = &(*sink_buffer)[0];
+    out_capacity_end = out_begin + buffer_size;
+    struct_as_list = sal;
+  }
+
+  /** Passes everything buffered so far to the sink */
+  void flush()
+  {
+    if (out_end != out_begin) {
+      sink->write(out_begin, out_end);
+      out_end = out_begin;
+    }
+  }
+
+  void make_room(intptr_t added_capacity);
+
   void ensure_capacity(intptr_t added_capacity)
   {
-    // If there's not enough space, double the capacity
     if (out_capacity_end - out_end < added_capacity) {
-      intptr_t current_size = out_end - out_begin;
-      intptr_t new_capacity = 2 * (out_capacity_end - out_begin);
-      // Make sure this adds the requested additional capacity
-      if (new_capacity < current_size + added_capacity) {
-        new_capacity = current_size + added_capacity;
-      }
-      api->resize(blockref, new_capacity, &out_begin, &out_capacity_end);
-      out_end = out_begin + current_size;
+      make_room(added_capacity);
     }
   }
 
@@ -56,22 +117,397 @@ struct output_data {
   // Write a std::string
   inline void write(const std::string &s)
   {
-    ensure_capacity(s.size());
-    memcpy(out_end, s.data(), s.size());
-    out_end += s.size();
+    write(s.data(), s.data() + s.size());
   }
 
   // Write a string-range
   inline void write(const char *begin, const char *end)
   {
-    ensure_capacity(end - begin);
-    memcpy(out_end, begin, end - begin);
-    out_end += (end - begin);
+    intptr_t size = end - begin;
+    if (sink != NULL && size > out_capacity_end - out_begin) {
+      // Pass ranges bigger than the whole buffer straight through
+      flush();
+      sink->write(begin, end);
+      return;
+    }
+    ensure_capacity(size);
+    memcpy(out_end, begin, size);
+    out_end += size;
   }
 };
 
-static void format_json(output_data &out, const ndt::type &dt,
-                        const char *arrmeta, const char *data);
+void output_data::make_room(intptr_t added_capacity)
+{
+  if (sink != NULL) {
+    flush();
+    if (out_capacity_end - out_begin < added_capacity) {
+      sink_buffer->resize(added_capacity);
+      out_begin = out_end = &(*sink_buffer)[0];
+      out_capacity_end = out_begin + added_capacity;
+    }
+  } else {
+    // Double the capacity
+    intptr_t current_size = out_end - out_begin;
+    intptr_t new_capacity = 2 * (out_capacity_end - out_begin);
+    // Make sure this adds the requested additional capacity
+    if (new_capacity < current_size + added_capacity) {
+      new_capacity = current_size + added_capacity;
+    }
+    api->resize(blockref, new_capacity, &out_begin, &out_capacity_end);
+    out_end = out_begin + current_size;
+  }
+}
+
+static const char digit_pairs[201] = "00010203040506070809"
+                                     "10111213141516171819"
+                                     "20212223242526272829"
+                                     "30313233343536373839"
+                                     "40414243444546474849"
+                                     "50515253545556575859"
+                                     "60616263646566676869"
+                                     "70717273747576777879"
+                                     "80818283848586878889"
+                                     "90919293949596979899";
+
+// Writes the decimal digits of ``value`` so they end at ``end``, returning
+// where they begin
+static char *print_uint64_backward(char *end, uint64_t value)
+{
+  while (value >= 100) {
+    unsigned i = static_cast<unsigned>(value % 100) * 2;
+    value /= 100;
+    end -= 2;
+    end[0] = digit_pairs[i];
+    end[1] = digit_pairs[i + 1];
+  }
+  if (value >= 10) {
+    unsigned i = static_cast<unsigned>(value) * 2;
+    end -= 2;
+    end[0] = digit_pairs[i];
+    end[1] = digit_pairs[i + 1];
+  } else {
+    *--end = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Round trip floating point printing, with the Grisu2 algorithm from
+// Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers", PLDI 2010. The digits always read back as the same
+// value, and are nearly always the shortest which do, but Grisu2 does not
+// guarantee the shortest.
+
+namespace {
+
+// A floating point value f * 2^e with a 64-bit significand
+struct diy_fp {
+  uint64_t f;
+  int e;
+
+  diy_fp(uint64_t f_, int e_) : f(f_), e(e_) {}
+};
+
+} // anonymous namespace
+
+// The upper 64 bits of the 128-bit product, rounded
+static inline diy_fp diy_fp_multiply(const diy_fp &x, const diy_fp &y)
+{
+  const uint64_t m32 = 0xFFFFFFFFu;
+  uint64_t a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+  tmp += 1U << 31;
+  return diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+}
+
+// The normalized 64-bit significands and binary exponents of 10^k for
+// k = -348, -340, ..., 340
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint32_t pow10_uint32[] = {1,         10,        100,     1000,
+                                        10000,     100000,    1000000,
+                                        10000000,  100000000, 1000000000};
+
+static const uint64_t pow10_uint64[] = {1ULL,
+                                        10ULL,
+                                        100ULL,
+                                        1000ULL,
+                                        10000ULL,
+                                        100000ULL,
+                                        1000000ULL,
+                                        10000000ULL,
+                                        100000000ULL,
+                                        1000000000ULL,
+                                        10000000000ULL,
+                                        100000000000ULL,
+                                        1000000000000ULL,
+                                        10000000000000ULL,
+                                        100000000000000ULL,
+                                        1000000000000000ULL,
+                                        10000000000000000ULL,
+                                        100000000000000000ULL,
+                                        1000000000000000000ULL,
+                                        10000000000000000000ULL};
+
+// Returns the cached power c such that the exponent of c times a value
+// with binary exponent ``e`` is in [-60, -32], and its decimal exponent
+// negated in ``K``
+static inline diy_fp get_cached_power(int e, int *K)
+{
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int k = static_cast<int>(dk);
+  if (dk - k > 0.0) {
+    ++k;
+  }
+  unsigned index = static_cast<unsigned>((k >> 3) + 1);
+  *K = -(-348 + static_cast<int>(index << 3));
+  return diy_fp(cached_powers_f[index], cached_powers_e[index]);
+}
+
+static inline int count_decimal_digits32(uint32_t n)
+{
+  int count = 1;
+  while (count < 10 && n >= pow10_uint32[count]) {
+    ++count;
+  }
+  return count;
+}
+
+static inline void grisu_round(char *buffer, int len, uint64_t delta,
+                               uint64_t rest, uint64_t ten_kappa,
+                               uint64_t wp_w)
+{
+  while (rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+    buffer[len - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+static int grisu_digit_gen(const diy_fp &w, const diy_fp &mp, uint64_t delta,
+                           char *buffer, int *K)
+{
+  const diy_fp one(uint64_t(1) << -mp.e, mp.e);
+  const uint64_t wp_w = mp.f - w.f;
+  uint32_t p1 = static_cast<uint32_t>(mp.f >> -one.e);
+  uint64_t p2 = mp.f & (one.f - 1);
+  int kappa = count_decimal_digits32(p1);
+  int len = 0;
+
+  while (kappa > 0) {
+    uint32_t div = pow10_uint32[kappa - 1];
+    uint32_t d = p1 / div;
+    p1 %= div;
+    if (d != 0 || len != 0) {
+      buffer[len++] = static_cast<char>('0' + d);
+    }
+    --kappa;
+    uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (tmp <= delta) {
+      *K += kappa;
+      grisu_round(buffer, len, delta, tmp,
+                  static_cast<uint64_t>(pow10_uint32[kappa]) << -one.e, wp_w);
+      return len;
+    }
+  }
+
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char d = static_cast<char>(p2 >> -one.e);
+    if (d != 0 || len != 0) {
+      buffer[len++] = static_cast<char>('0' + d);
+    }
+    p2 &= one.f - 1;
+    --kappa;
+    if (p2 < delta) {
+      *K += kappa;
+      int index = -kappa;
+      grisu_round(buffer, len, delta, p2, one.f,
+                  wp_w * (index < 20 ? pow10_uint64[index] : 0));
+      return len;
+    }
+  }
+}
+
+/**
+ * Writes decimal digits which read back as the positive value f * 2^e,
+ * for a binary floating point format with ``p`` explicit significand bits,
+ * returning how many there are. The value is the digits times 10^K.
+ */
+static int grisu2(uint64_t f, int e, int p, char *buffer, int *K)
+{
+  const uint64_t hidden_bit = uint64_t(1) << p;
+
+  // The upper boundary, halfway to the next value
+  diy_fp w_plus((f << 1) + 1, e - 1);
+  while ((w_plus.f & (hidden_bit << 1)) == 0) {
+    w_plus.f <<= 1;
+    w_plus.e--;
+  }
+  w_plus.f <<= 64 - p - 2;
+  w_plus.e -= 64 - p - 2;
+  // The lower boundary is closer when f is a power of two
+  diy_fp w_minus = (f == hidden_bit) ? diy_fp((f << 2) - 1, e - 2)
+                                     : diy_fp((f << 1) - 1, e - 1);
+  w_minus.f <<= w_minus.e - w_plus.e;
+  w_minus.e = w_plus.e;
+
+  diy_fp v(f, e);
+  while ((v.f & (uint64_t(1) << 63)) == 0) {
+    v.f <<= 1;
+    v.e--;
+  }
+
+  const diy_fp c_mk = get_cached_power(w_plus.e, K);
+  const diy_fp w = diy_fp_multiply(v, c_mk);
+  diy_fp wp = diy_fp_multiply(w_plus, c_mk);
+  diy_fp wm = diy_fp_multiply(w_minus, c_mk);
+  wm.f++;
+  wp.f--;
+  return grisu_digit_gen(w, wp, wp.f - wm.f, buffer, K);
+}
+
+// Lays out the digits d1...dn times 10^K as JavaScript's Number.toString
+// does, in fixed notation for decimal exponents in (-7, 21] and in
+// exponential notation otherwise
+static char *print_decimal_digits(char *out, const char *digits, int len,
+                                  int K)
+{
+  int n = len + K;
+  if (len <= n && n <= 21) {
+    memcpy(out, digits, len);
+    out += len;
+    for (int i = len; i < n; ++i) {
+      *out++ = '0';
+    }
+  } else if (0 < n && n <= 21) {
+    memcpy(out, digits, n);
+    out += n;
+    *out++ = '.';
+    memcpy(out, digits + n, len - n);
+    out += len - n;
+  } else if (-6 < n && n <= 0) {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = n; i < 0; ++i) {
+      *out++ = '0';
+    }
+    memcpy(out, digits, len);
+    out += len;
+  } else {
+    *out++ = digits[0];
+    if (len > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, len - 1);
+      out += len - 1;
+    }
+    *out++ = 'e';
+    int exponent = n - 1;
+    if (exponent < 0) {
+      *out++ = '-';
+      exponent = -exponent;
+    } else {
+      *out++ = '+';
+    }
+    char buf[8];
+    char *begin = print_uint64_backward(buf + sizeof(buf), exponent);
+    memcpy(out, begin, buf + sizeof(buf) - begin);
+    out += buf + sizeof(buf) - begin;
+  }
+  return out;
+}
+
+/**
+ * Prints the binary floating point value with the bit pattern ``bits``,
+ * which has ``p`` explicit significand bits and ``exponent_bits`` exponent
+ * bits, as a decimal that reads back as the same value. Returns the end
+ * of the output, which needs up to 32 chars.
+ */
+static char *print_round_trip_real(char *out, uint64_t bits, int p,
+                                   int exponent_bits)
+{
+  const int exponent_mask = (1 << exponent_bits) - 1;
+  const int bias = (exponent_mask >> 1) + p;
+  bool negative = ((bits >> (p + exponent_bits)) & 1) != 0;
+  int biased_exponent = static_cast<int>(bits >> p) & exponent_mask;
+  uint64_t significand = bits & ((uint64_t(1) << p) - 1);
+
+  if (biased_exponent == exponent_mask) {
+    // Match what printing through an ostream gives
+    if (negative) {
+      *out++ = '-';
+    }
+    memcpy(out, significand != 0 ? "nan" : "inf", 3);
+    return out + 3;
+  }
+  if (negative) {
+    *out++ = '-';
+  }
+  if (biased_exponent == 0 && significand == 0) {
+    *out++ = '0';
+    return out;
+  }
+
+  uint64_t f;
+  int e;
+  if (biased_exponent != 0) {
+    f = significand | (uint64_t(1) << p);
+    e = biased_exponent - bias;
+  } else {
+    f = significand;
+    e = 1 - bias;
+  }
+  char digits[24];
+  int K;
+  int len = grisu2(f, e, p, digits, &K);
+  return print_decimal_digits(out, digits, len, K);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Formatting of individual values, given the type
 
 static void format_json_bool(output_data &out, const ndt::type &dt,
                              const char *arrmeta, const char *data)
@@ -130,10 +566,12 @@ print_escaped_unicode_codepoint(output_data &out, uint32_t cp,
                 break;
             default:
                 if (cp < 0x20 || cp == 0x7f) {
-                    stringstream ss;
-                    ss << "\\u";
-                    hexadecimal_print(ss, static_cast<uint16_t>(cp));
-                    out.write(ss.str());
+                    static const char hexdigits[] = "0123456789abcdef";
+                    out.ensure_capacity(6);
+                    memcpy(out.out_end, "\\u00", 4);
+                    out.out_end[4] = hexdigits[cp >> 4];
+                    out.out_end[5] = hexdigits[cp & 0xf];
+                    out.out_end += 6;
                 } else {
                     out.write(static_cast<char>(cp));
                 }
@@ -159,10 +597,82 @@ print_escaped_unicode_codepoint(output_data &out, uint32_t cp,
     */
 }
 
+#ifdef DYND_JSON_FORMAT_USE_SSE2
+// Returns the index of the lowest set bit in a nonzero mask
+static inline int lowest_set_bit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+static inline bool json_needs_escape(unsigned char c)
+{
+  return c < 0x20 || c == '"' || c == '\\' || c == '/' || c == 0x7f;
+}
+
+// Returns the first char in [begin, end) which JSON output escapes, or end
+static const char *find_json_escape(const char *begin, const char *end)
+{
+#ifdef DYND_JSON_FORMAT_USE_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i slash = _mm_set1_epi8('/');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i max_control = _mm_set1_epi8(0x1f);
+  while (end - begin >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    // Bytes up to 0x1f are the ones unchanged by an unsigned max with 0x1f
+    __m128i hits = _mm_cmpeq_epi8(_mm_max_epu8(v, max_control), max_control);
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, quote));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, backslash));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, slash));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, del));
+    unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+    if (mask != 0) {
+      return begin + lowest_set_bit(mask);
+    }
+    begin += 16;
+  }
+#endif
+  while (begin < end && !json_needs_escape(static_cast<unsigned char>(*begin))) {
+    ++begin;
+  }
+  return begin;
+}
+
+// Formats UTF-8 (or ASCII) text as a JSON string, copying the runs which
+// need no escaping directly
+static void format_json_utf8_string(output_data &out, const char *begin,
+                                    const char *end)
+{
+  out.write('\"');
+  while (begin < end) {
+    const char *run_end = find_json_escape(begin, end);
+    out.write(begin, run_end);
+    if (run_end == end) {
+      break;
+    }
+    print_escaped_unicode_codepoint(
+        out, static_cast<unsigned char>(*run_end), NULL);
+    begin = run_end + 1;
+  }
+  out.write('\"');
+}
+
 static void format_json_encoded_string(output_data &out, const char *begin,
                                        const char *end,
                                        string_encoding_t encoding)
 {
+  if (encoding == string_encoding_utf_8 || encoding == string_encoding_ascii) {
+    format_json_utf8_string(out, begin, end);
+    return;
+  }
   uint32_t cp;
   next_unicode_codepoint_t next_fn;
   append_unicode_codepoint_t append_fn;
@@ -187,17 +697,6 @@ static void format_json_string(output_data &out, const ndt::type &dt,
   format_json_encoded_string(out, begin, end, encoding);
 }
 
-static void format_json_option(output_data &out, const ndt::type &dt,
-                               const char *arrmeta, const char *data)
-{
-  const option_type *ot = dt.extended<option_type>();
-  if (ot->is_avail(arrmeta, data, &eval::default_eval_context)) {
-    format_json(out, ot->get_value_type(), arrmeta, data);
-  } else {
-    out.write("null");
-  }
-}
-
 static void format_json_dynamic(output_data &out, const ndt::type &dt,
                                 const char *DYND_UNUSED(arrmeta),
                                 const char *data)
@@ -255,127 +754,383 @@ static void format_json_type(output_data &out, const ndt::type &dt,
   }
 }
 
-static void format_json_struct(output_data &out, const ndt::type &dt,
-                               const char *arrmeta, const char *data)
+static void format_json_unsupported(output_data &DYND_UNUSED(out),
+                                    const ndt::type &dt,
+                                    const char *DYND_UNUSED(arrmeta),
+                                    const char *DYND_UNUSED(data))
 {
-  const base_struct_type *bsd = dt.extended<base_struct_type>();
-  intptr_t field_count = bsd->get_field_count();
-  const size_t *data_offsets = bsd->get_data_offsets(arrmeta);
-  const size_t *arrmeta_offsets = bsd->get_arrmeta_offsets_raw();
+  stringstream ss;
+  ss << "Formatting dynd type " << dt << " as JSON is not implemented yet";
+  throw runtime_error(ss.str());
+}
 
-  if (out.struct_as_list) {
-    out.write('[');
-    for (intptr_t i = 0; i < field_count; ++i) {
-      ::format_json(out, bsd->get_field_type(i), arrmeta + arrmeta_offsets[i],
-                    data + data_offsets[i]);
-      if (i != field_count - 1) {
-        out.write(',');
-      }
-    }
-    out.write(']');
+////////////////////////////////////////////////////////////////////////
+// The formatting plan. The type and arrmeta are walked once up front,
+// producing a tree of nodes which hold everything the per-element work
+// needs, so formatting each element is one indirect call per value.
+
+namespace {
+
+struct format_node;
+
+typedef void (*format_node_fn_t)(output_data &out, const format_node *node,
+                                 const char *data);
+typedef void (*format_type_fn_t)(output_data &out, const ndt::type &dt,
+                                 const char *arrmeta, const char *data);
+
+struct format_node {
+  format_node_fn_t fn;
+  ndt::type tp;
+  const char *arrmeta;
+  // The element of a dimension or the value of an option
+  const format_node *child;
+  // The size and stride of a fixed dimension, or the stride and offset
+  // of a var dimension
+  intptr_t dim_size, stride, offset;
+  // The fields of a struct, with the text preceding each one
+  const uintptr_t *data_offsets;
+  std::vector<const format_node *> fields;
+  std::vector<std::string> field_prefixes;
+  // The is_avail ckernel of an option with a non-builtin value type
+  ckernel_prefix *is_avail_ck;
+  // For values which are formatted by the functions taking their type
+  format_type_fn_t type_fn;
+
+  format_node()
+      : fn(NULL), arrmeta(NULL), child(NULL), dim_size(0), stride(0),
+        offset(0), data_offsets(NULL), is_avail_ck(NULL), type_fn(NULL)
+  {
+  }
+};
+
+class format_plan {
+  // Deques so the nodes and ckernels never move once created
+  std::deque<format_node> m_nodes;
+  std::deque<ckernel_builder<kernel_request_host>> m_ckbs;
+  bool m_struct_as_list;
+
+  format_node *add_node(format_node_fn_t fn, const ndt::type &tp,
+                        const char *arrmeta)
+  {
+    m_nodes.push_back(format_node());
+    format_node *node = &m_nodes.back();
+    node->fn = fn;
+    node->tp = tp;
+    node->arrmeta = arrmeta;
+    return node;
+  }
+
+  format_node *add_type_node(format_type_fn_t type_fn, const ndt::type &tp,
+                             const char *arrmeta);
+
+public:
+  explicit format_plan(bool struct_as_list) : m_struct_as_list(struct_as_list)
+  {
+  }
+
+  const format_node *compile(const ndt::type &tp, const char *arrmeta);
+};
+
+} // anonymous namespace
+
+static void format_node_type_fn(output_data &out, const format_node *node,
+                                const char *data)
+{
+  node->type_fn(out, node->tp, node->arrmeta, data);
+}
+
+static void format_node_bool(output_data &out,
+                             const format_node *DYND_UNUSED(node),
+                             const char *data)
+{
+  if (*data != 0) {
+    out.write("true");
   } else {
-    out.write('{');
-    for (intptr_t i = 0; i < field_count; ++i) {
-      const string_type_data &fname = bsd->get_field_name_raw(i);
-      format_json_encoded_string(out, fname.begin, fname.end,
-                                 string_encoding_utf_8);
-      out.write(':');
-      ::format_json(out, bsd->get_field_type(i), arrmeta + arrmeta_offsets[i],
-                    data + data_offsets[i]);
-      if (i != field_count - 1) {
-        out.write(',');
-      }
-    }
-    out.write('}');
+    out.write("false");
+  }
+}
+
+template <class T>
+static void format_node_int(output_data &out,
+                            const format_node *DYND_UNUSED(node),
+                            const char *data)
+{
+  T value = *reinterpret_cast<const T *>(data);
+  char buf[24];
+  char *begin;
+  if (value < 0) {
+    begin = print_uint64_backward(buf + sizeof(buf),
+                                  0 - static_cast<uint64_t>(value));
+    *--begin = '-';
+  } else {
+    begin = print_uint64_backward(buf + sizeof(buf),
+                                  static_cast<uint64_t>(value));
+  }
+  out.write(begin, buf + sizeof(buf));
+}
+
+template <class T>
+static void format_node_uint(output_data &out,
+                             const format_node *DYND_UNUSED(node),
+                             const char *data)
+{
+  char buf[24];
+  char *begin = print_uint64_backward(
+      buf + sizeof(buf),
+      static_cast<uint64_t>(*reinterpret_cast<const T *>(data)));
+  out.write(begin, buf + sizeof(buf));
+}
+
+static void format_node_float32(output_data &out,
+                                const format_node *DYND_UNUSED(node),
+                                const char *data)
+{
+  uint32_t bits;
+  memcpy(&bits, data, sizeof(bits));
+  out.ensure_capacity(32);
+  out.out_end = print_round_trip_real(out.out_end, bits, 23, 8);
+}
+
+static void format_node_float64(output_data &out,
+                                const format_node *DYND_UNUSED(node),
+                                const char *data)
+{
+  uint64_t bits;
+  memcpy(&bits, data, sizeof(bits));
+  out.ensure_capacity(32);
+  out.out_end = print_round_trip_real(out.out_end, bits, 52, 11);
+}
+
+static void format_node_string(output_data &out,
+                               const format_node *DYND_UNUSED(node),
+                               const char *data)
+{
+  const string_type_data *d = reinterpret_cast<const string_type_data *>(data);
+  format_json_utf8_string(out, d->begin, d->end);
+}
+
+static void format_node_option(output_data &out, const format_node *node,
+                               const char *data)
+{
+  bool avail;
+  if (node->is_avail_ck != NULL) {
+    char result;
+    node->is_avail_ck->get_function<expr_single_t>()(
+        &result, const_cast<char **>(&data), node->is_avail_ck);
+    avail = (result != 0);
+  } else {
+    avail = node->tp.extended<option_type>()->is_avail(
+        node->arrmeta, data, &eval::default_eval_context);
+  }
+  if (avail) {
+    node->child->fn(out, node->child, data);
+  } else {
+    out.write("null");
+  }
+}
+
+static void format_node_struct(output_data &out, const format_node *node,
+                               const char *data)
+{
+  intptr_t field_count = node->fields.size();
+  out.write(out.struct_as_list ? '[' : '{');
+  for (intptr_t i = 0; i < field_count; ++i) {
+    const format_node *field = node->fields[i];
+    out.write(node->field_prefixes[i]);
+    field->fn(out, field, data + node->data_offsets[i]);
   }
+  out.write(out.struct_as_list ? ']' : '}');
 }
 
-static void format_json_dim(output_data& out, const ndt::type& dt, const char *arrmeta, const char *data)
+static void format_node_strided_dim(output_data &out, const format_node *node,
+                                    const char *data)
 {
+  const format_node *child = node->child;
+  format_node_fn_t child_fn = child->fn;
+  intptr_t size = node->dim_size, stride = node->stride;
   out.write('[');
-  switch (dt.get_type_id()) {
-  case cfixed_dim_type_id:
-  case fixed_dim_type_id: {
-    const base_dim_type *sad = dt.extended<base_dim_type>();
-    const fixed_dim_type_arrmeta *md =
-        reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
-    ndt::type element_tp = sad->get_element_type();
-    intptr_t size = md->dim_size, stride = md->stride;
-    arrmeta += sizeof(fixed_dim_type_arrmeta);
-    for (intptr_t i = 0; i < size; ++i) {
-      ::format_json(out, element_tp, arrmeta, data + i * stride);
-      if (i != size - 1) {
-        out.write(',');
-      }
+  for (intptr_t i = 0; i < size; ++i) {
+    if (i != 0) {
+      out.write(',');
     }
-    break;
+    child_fn(out, child, data + i * stride);
   }
-  case var_dim_type_id: {
-    const var_dim_type *vad = dt.extended<var_dim_type>();
-    const var_dim_type_arrmeta *md =
-        reinterpret_cast<const var_dim_type_arrmeta *>(arrmeta);
-    const var_dim_type_data *d =
-        reinterpret_cast<const var_dim_type_data *>(data);
-    ndt::type element_tp = vad->get_element_type();
-    intptr_t size = d->size, stride = md->stride;
-    const char *begin = d->begin + md->offset;
-    arrmeta += sizeof(var_dim_type_arrmeta);
-    for (intptr_t i = 0; i < size; ++i) {
-      ::format_json(out, element_tp, arrmeta, begin + i * stride);
-      if (i != size - 1) {
-        out.write(',');
-      }
+  out.write(']');
+}
+
+static void format_node_var_dim(output_data &out, const format_node *node,
+                                const char *data)
+{
+  const var_dim_type_data *d =
+      reinterpret_cast<const var_dim_type_data *>(data);
+  const format_node *child = node->child;
+  format_node_fn_t child_fn = child->fn;
+  intptr_t size = d->size, stride = node->stride;
+  const char *begin = d->begin + node->offset;
+  out.write('[');
+  for (intptr_t i = 0; i < size; ++i) {
+    if (i != 0) {
+      out.write(',');
     }
-    break;
-  }
-  default: {
-    stringstream ss;
-    ss << "Formatting dynd type " << dt << " as JSON is not implemented yet";
-    throw runtime_error(ss.str());
-  }
+    child_fn(out, child, begin + i * stride);
   }
   out.write(']');
 }
 
-static void format_json(output_data& out, const ndt::type& dt, const char *arrmeta, const char *data)
+// Escapes a struct field name as a JSON string
+static std::string escape_field_name(const string_type_data &fname)
 {
-  switch (dt.get_kind()) {
+  std::string result;
+  string_output_sink sink(result);
+  std::vector<char> buffer;
+  output_data out;
+  out.init_sink(&sink, &buffer, 64, false);
+  format_json_utf8_string(out, fname.begin, fname.end);
+  out.flush();
+  return result;
+}
+
+format_node *format_plan::add_type_node(format_type_fn_t type_fn,
+                                        const ndt::type &tp,
+                                        const char *arrmeta)
+{
+  format_node *node = add_node(&format_node_type_fn, tp, arrmeta);
+  node->type_fn = type_fn;
+  return node;
+}
+
+const format_node *format_plan::compile(const ndt::type &tp,
+                                        const char *arrmeta)
+{
+  switch (tp.get_kind()) {
   case bool_kind:
-    format_json_bool(out, dt, arrmeta, data);
-    break;
+    if (tp.get_type_id() == bool_type_id) {
+      return add_node(&format_node_bool, tp, arrmeta);
+    }
+    return add_type_node(&format_json_bool, tp, arrmeta);
   case int_kind:
   case uint_kind:
   case real_kind:
   case complex_kind:
-    format_json_number(out, dt, arrmeta, data);
-    break;
+    switch (tp.get_type_id()) {
+    case int8_type_id:
+      return add_node(&format_node_int<int8_t>, tp, arrmeta);
+    case int16_type_id:
+      return add_node(&format_node_int<int16_t>, tp, arrmeta);
+    case int32_type_id:
+      return add_node(&format_node_int<int32_t>, tp, arrmeta);
+    case int64_type_id:
+      return add_node(&format_node_int<int64_t>, tp, arrmeta);
+    case uint8_type_id:
+      return add_node(&format_node_uint<uint8_t>, tp, arrmeta);
+    case uint16_type_id:
+      return add_node(&format_node_uint<uint16_t>, tp, arrmeta);
+    case uint32_type_id:
+      return add_node(&format_node_uint<uint32_t>, tp, arrmeta);
+    case uint64_type_id:
+      return add_node(&format_node_uint<uint64_t>, tp, arrmeta);
+    case float32_type_id:
+      return add_node(&format_node_float32, tp, arrmeta);
+    case float64_type_id:
+      return add_node(&format_node_float64, tp, arrmeta);
+    default:
+      return add_type_node(&format_json_number, tp, arrmeta);
+    }
   case string_kind:
-    format_json_string(out, dt, arrmeta, data);
-    break;
+    if (tp.get_type_id() == string_type_id) {
+      string_encoding_t encoding =
+          tp.extended<base_string_type>()->get_encoding();
+      if (encoding == string_encoding_utf_8 ||
+          encoding == string_encoding_ascii) {
+        return add_node(&format_node_string, tp, arrmeta);
+      }
+    }
+    return add_type_node(&format_json_string, tp, arrmeta);
   case datetime_kind:
-    format_json_datetime(out, dt, arrmeta, data);
-    break;
+    return add_type_node(&format_json_datetime, tp, arrmeta);
   case type_kind:
-    format_json_type(out, dt, arrmeta, data);
-    break;
-  case struct_kind:
-    format_json_struct(out, dt, arrmeta, data);
-    break;
-  case option_kind:
-    format_json_option(out, dt, arrmeta, data);
-    break;
+    return add_type_node(&format_json_type, tp, arrmeta);
   case dynamic_kind:
-    format_json_dynamic(out, dt, arrmeta, data);
-    break;
-  case dim_kind:
-    format_json_dim(out, dt, arrmeta, data);
-    break;
-  default: {
-    stringstream ss;
-    ss << "Formatting dynd type " << dt << " as JSON is not implemented yet";
-    throw runtime_error(ss.str());
+    return add_type_node(&format_json_dynamic, tp, arrmeta);
+  case struct_kind: {
+    const base_struct_type *bsd = tp.extended<base_struct_type>();
+    intptr_t field_count = bsd->get_field_count();
+    const uintptr_t *arrmeta_offsets = bsd->get_arrmeta_offsets_raw();
+    format_node *node = add_node(&format_node_struct, tp, arrmeta);
+    node->data_offsets = bsd->get_data_offsets(arrmeta);
+    node->fields.resize(field_count);
+    node->field_prefixes.resize(field_count);
+    for (intptr_t i = 0; i < field_count; ++i) {
+      std::string &prefix = node->field_prefixes[i];
+      if (i != 0) {
+        prefix = ",";
+      }
+      if (!m_struct_as_list) {
+        prefix += escape_field_name(bsd->get_field_name_raw(i));
+        prefix += ":";
+      }
+      node->fields[i] =
+          compile(bsd->get_field_type(i), arrmeta + arrmeta_offsets[i]);
+    }
+    return node;
   }
+  case option_kind: {
+    const option_type *ot = tp.extended<option_type>();
+    format_node *node = add_node(&format_node_option, tp, arrmeta);
+    node->child = compile(ot->get_value_type(), arrmeta);
+    if (!ot->get_value_type().is_builtin() && !ot->get_nafunc().is_null()) {
+      // Instantiate the is_avail ckernel once for all the elements
+      m_ckbs.emplace_back();
+      ckernel_builder<kernel_request_host> &ckb = m_ckbs.back();
+      const arrfunc_type_data *af = ot->get_is_avail_arrfunc();
+      ndt::type src_tp[1] = {tp};
+      af->instantiate(af, ot->get_is_avail_arrfunc_type(), &ckb, 0,
+                      ndt::make_type<dynd_bool>(), NULL, src_tp, &arrmeta,
+                      kernel_request_single, &eval::default_eval_context,
+                      nd::array());
+      node->is_avail_ck = ckb.get();
+    }
+    return node;
   }
+  case dim_kind:
+    switch (tp.get_type_id()) {
+    case cfixed_dim_type_id:
+    case fixed_dim_type_id: {
+      const fixed_dim_type_arrmeta *md =
+          reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+      format_node *node = add_node(&format_node_strided_dim, tp, arrmeta);
+      node->dim_size = md->dim_size;
+      node->stride = md->stride;
+      node->child =
+          compile(tp.extended<base_dim_type>()->get_element_type(),
+                  arrmeta + sizeof(fixed_dim_type_arrmeta));
+      return node;
+    }
+    case var_dim_type_id: {
+      const var_dim_type_arrmeta *md =
+          reinterpret_cast<const var_dim_type_arrmeta *>(arrmeta);
+      format_node *node = add_node(&format_node_var_dim, tp, arrmeta);
+      node->stride = md->stride;
+      node->offset = md->offset;
+      node->child = compile(tp.extended<var_dim_type>()->get_element_type(),
+                            arrmeta + sizeof(var_dim_type_arrmeta));
+      return node;
+    }
+    default:
+      return add_type_node(&format_json_unsupported, tp, arrmeta);
+    }
+  default:
+    // Unsupported types raise an error only if a value is actually formatted
+    return add_type_node(&format_json_unsupported, tp, arrmeta);
+  }
+}
+
+static void format_json(output_data &out, const nd::array &n)
+{
+  nd::array tmp = n.get_type().is_expression() ? n.eval() : n;
+  format_plan plan(out.struct_as_list);
+  const format_node *root = plan.compile(tmp.get_type(), tmp.get_arrmeta());
+  root->fn(out, root, tmp.get_readonly_originptr());
 }
 
 nd::array dynd::format_json(const nd::array& n, bool struct_as_list)
@@ -391,16 +1146,11 @@ nd::array dynd::format_json(const nd::array& n, bool struct_as_list)
   out.api->allocate(out.blockref, 1024, 1, &out.out_begin,
                     &out.out_capacity_end);
   out.out_end = out.out_begin;
+  out.sink = NULL;
+  out.sink_buffer = NULL;
   out.struct_as_list = struct_as_list;
 
-  if (!n.get_type().is_expression()) {
-    ::format_json(out, n.get_type(), n.get_arrmeta(),
-                  n.get_readonly_originptr());
-  } else {
-    nd::array tmp = n.eval();
-    ::format_json(out, tmp.get_type(), tmp.get_arrmeta(),
-                  tmp.get_readonly_originptr());
-  }
+  ::format_json(out, n);
 
   // Shrink the memory to fit, and set the pointers in the output
   string_type_data *d =
@@ -416,3 +1166,23 @@ nd::array dynd::format_json(const nd::array& n, bool struct_as_list)
 
   return result;
 }
+
+void dynd::format_json(json_output_sink &sink, const nd::array &n,
+                       bool struct_as_list, intptr_t buffer_size)
+{
+  if (buffer_size < 64) {
+    buffer_size = 64;
+  }
+  std::vector<char> buffer;
+  output_data out;
+  out.init_sink(&sink, &buffer, buffer_size, struct_as_list);
+  ::format_json(out, n);
+  out.flush();
+}
+
+void dynd::format_json(std::ostream &o, const nd::array &n,
+                       bool struct_as_list)
+{
+  ostream_output_sink sink(o);
+  format_json(sink, n, struct_as_list);
+}
@@ -104,13 +104,13 @@ static void parse_json(const ndt::type &tp, const char *arrmeta, char *out_data,
                        const char *&json_begin, const char *json_end,
                        const eval::eval_context *ectx);
 
-static const char *skip_whitespace(const char *begin, const char *end)
+static inline const char *skip_whitespace(const char *begin, const char *end)
 {
-  while (begin < end && isspace(*begin)) {
-    ++begin;
+  // Most tokens follow no whitespace at all, so check that first
+  if (begin < end && *begin > ' ') {
+    return begin;
   }
-
-  return begin;
+  return parse::skip_whitespace_run(begin, end);
 }
 
 template <int N>
@@ -926,14 +926,19 @@ void dynd::validate_json(const char *json_begin, const char *json_end)
   }
 }
 
-void dynd::parse_json(nd::array &out, const char *json_begin,
-                      const char *json_end, const eval::eval_context *ectx)
+/**
+ * Parses a complete JSON value from the buffer, turning parse errors into
+ * an invalid_argument with the line and column. ``line_offset`` is the
+ * number of input lines which came before ``json_begin``.
+ */
+static void parse_json_value(const ndt::type &tp, const char *arrmeta,
+                             char *out_data, const char *json_begin,
+                             const char *json_end, intptr_t line_offset,
+                             const eval::eval_context *ectx)
 {
   try {
     const char *begin = json_begin, *end = json_end;
-    ndt::type tp = out.get_type();
-    ::parse_json(tp, out.get_arrmeta(), out.get_readwrite_originptr(), begin,
-                 end, ectx);
+    ::parse_json(tp, arrmeta, out_data, begin, end, ectx);
     begin = skip_whitespace(begin, end);
     if (begin != end) {
       throw json_parse_error(begin, "unexpected trailing JSON text", tp);
@@ -945,8 +950,8 @@ void dynd::parse_json(nd::array &out, const char *json_begin,
     int line, column;
     get_error_line_column(json_begin, json_end, e.get_position(), line_prev,
                           line_cur, line, column);
-    ss << "Error parsing JSON at line " << line << ", column " << column
-       << "\n";
+    ss << "Error parsing JSON at line " << line + line_offset << ", column "
+       << column << "\n";
     ss << "DyND Type: " << e.get_type() << "\n";
     ss << "Message: " << e.what() << "\n";
     print_json_parse_error_marker(ss, line_prev, line_cur, line, column);
@@ -958,14 +963,22 @@ void dynd::parse_json(nd::array &out, const char *json_begin,
     int line, column;
     get_error_line_column(json_begin, json_end, e.get_position(), line_prev,
                           line_cur, line, column);
-    ss << "Error parsing JSON at line " << line << ", column " << column
-       << "\n";
+    ss << "Error parsing JSON at line " << line + line_offset << ", column "
+       << column << "\n";
     ss << "Message: " << e.what() << "\n";
     print_json_parse_error_marker(ss, line_prev, line_cur, line, column);
     throw invalid_argument(ss.str());
   }
 }
 
+void dynd::parse_json(nd::array &out, const char *json_begin,
+                      const char *json_end, const eval::eval_context *ectx)
+{
+  parse_json_value(out.get_type(), out.get_arrmeta(),
+                   out.get_readwrite_originptr(), json_begin, json_end, 0,
+                   ectx);
+}
+
 nd::array dynd::parse_json(const ndt::type &tp, const char *json_begin,
                            const char *json_end, const eval::eval_context *ectx)
 {
@@ -977,3 +990,130 @@ nd::array dynd::parse_json(const ndt::type &tp, const char *json_begin,
   }
   return result;
 }
+
+json_stream_parser::json_stream_parser(const ndt::type &row_tp,
+                                       intptr_t batch_size,
+                                       const eval::eval_context *ectx)
+    : m_row_tp(row_tp), m_batch_tp(ndt::make_var_dim(row_tp)),
+      m_batch_size(batch_size), m_ectx(ectx), m_line_count(0),
+      m_batch_end(NULL)
+{
+  if (batch_size <= 0) {
+    stringstream ss;
+    ss << "json_stream_parser: the batch size must be positive, not "
+       << batch_size;
+    throw invalid_argument(ss.str());
+  }
+  if (row_tp.get_flags() & type_flag_destructor) {
+    stringstream ss;
+    ss << "json_stream_parser: cannot parse rows of type " << row_tp
+       << ", because it requires destruction";
+    throw type_error(ss.str());
+  }
+}
+
+void json_stream_parser::parse_line(const char *begin, const char *end)
+{
+  ++m_line_count;
+  if (skip_whitespace(begin, end) == end) {
+    return;
+  }
+
+  if (m_batch.is_null()) {
+    // Start a new batch, with room for a full batch of rows
+    m_batch = nd::empty(m_batch_tp);
+    const var_dim_type_arrmeta *md =
+        reinterpret_cast<const var_dim_type_arrmeta *>(m_batch.get_arrmeta());
+    var_dim_type_data *out =
+        reinterpret_cast<var_dim_type_data *>(m_batch.get_readwrite_originptr());
+    memory_block_pod_allocator_api *allocator =
+        get_memory_block_pod_allocator_api(md->blockref);
+    allocator->allocate(md->blockref, m_batch_size * md->stride,
+                        m_row_tp.get_data_alignment(), &out->begin,
+                        &m_batch_end);
+    out->size = 0;
+  }
+
+  const var_dim_type_arrmeta *md =
+      reinterpret_cast<const var_dim_type_arrmeta *>(m_batch.get_arrmeta());
+  var_dim_type_data *out =
+      reinterpret_cast<var_dim_type_data *>(m_batch.get_readwrite_originptr());
+  parse_json_value(m_row_tp, m_batch.get_arrmeta() + sizeof(var_dim_type_arrmeta),
+                   out->begin + out->size * md->stride, begin, end,
+                   m_line_count - 1, m_ectx);
+  if (++out->size == (size_t)m_batch_size) {
+    flush_batch();
+  }
+}
+
+void json_stream_parser::flush_batch()
+{
+  if (m_batch.is_null()) {
+    return;
+  }
+  const var_dim_type_arrmeta *md =
+      reinterpret_cast<const var_dim_type_arrmeta *>(m_batch.get_arrmeta());
+  var_dim_type_data *out =
+      reinterpret_cast<var_dim_type_data *>(m_batch.get_readwrite_originptr());
+  // Shrink-wrap the memory to just fit the rows
+  memory_block_pod_allocator_api *allocator =
+      get_memory_block_pod_allocator_api(md->blockref);
+  allocator->resize(md->blockref, out->size * md->stride, &out->begin,
+                    &m_batch_end);
+  m_batch_tp.extended()->arrmeta_finalize_buffers(m_batch.get_arrmeta());
+  m_ready_batches.push_back(nd::array());
+  m_ready_batches.back().swap(m_batch);
+  m_batch_end = NULL;
+}
+
+void json_stream_parser::feed(const char *chunk_begin, const char *chunk_end)
+{
+  const char *begin = chunk_begin;
+  if (!m_partial_line.empty()) {
+    // Complete the line left over from the previous chunk
+    const char *line_end =
+        (const char *)memchr(begin, '\n', chunk_end - begin);
+    if (line_end == NULL) {
+      m_partial_line.append(begin, chunk_end);
+      return;
+    }
+    m_partial_line.append(begin, line_end);
+    begin = line_end + 1;
+    string line;
+    line.swap(m_partial_line);
+    parse_line(line.data(), line.data() + line.size());
+  }
+
+  // Parse the complete lines directly from the chunk
+  for (;;) {
+    const char *line_end =
+        (const char *)memchr(begin, '\n', chunk_end - begin);
+    if (line_end == NULL) {
+      break;
+    }
+    parse_line(begin, line_end);
+    begin = line_end + 1;
+  }
+  m_partial_line.assign(begin, chunk_end);
+}
+
+void json_stream_parser::finish()
+{
+  if (!m_partial_line.empty()) {
+    string line;
+    line.swap(m_partial_line);
+    parse_line(line.data(), line.data() + line.size());
+  }
+  flush_batch();
+}
+
+nd::array json_stream_parser::pop_batch()
+{
+  if (m_ready_batches.empty()) {
+    throw runtime_error("json_stream_parser: no batch of rows is ready");
+  }
+  nd::array result;
+  result.swap(m_ready_batches.front());
+  m_ready_batches.pop_front();
+  return result;
+}
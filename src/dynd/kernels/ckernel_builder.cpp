@@ -0,0 +1,47 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/memblock/memory_block.hpp>
+
+using namespace std;
+using namespace dynd;
+
+// The heap memory of ckernel_builders comes from the same per-thread chunk
+// pool as the growable memory blocks. A block's capacity is always the
+// chunk capacity of the size it was allocated with, so only the size needs
+// to be tracked.
+
+void *detail::ckernel_builder_pool_alloc(size_t size)
+{
+  intptr_t capacity;
+  try {
+    return detail::memory_chunk_alloc(size, &capacity);
+  }
+  catch (const std::bad_alloc &) {
+    return NULL;
+  }
+}
+
+void *detail::ckernel_builder_pool_realloc(void *ptr, size_t old_size,
+                                           size_t new_size)
+{
+  if ((size_t)detail::memory_chunk_capacity(old_size) >= new_size) {
+    // The block already has room
+    return ptr;
+  }
+  void *new_ptr = ckernel_builder_pool_alloc(new_size);
+  if (new_ptr != NULL) {
+    memcpy(new_ptr, ptr, old_size);
+    ckernel_builder_pool_free(ptr, old_size);
+  }
+  return new_ptr;
+}
+
+void detail::ckernel_builder_pool_free(void *ptr, size_t size)
+{
+  detail::memory_chunk_free(reinterpret_cast<char *>(ptr),
+                            detail::memory_chunk_capacity(size));
+}
@@ -0,0 +1,297 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <dynd/kernels/ckernel_cache.hpp>
+#include <dynd/func/arrfunc.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/cfixed_dim_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+struct dynd::kernels::ckernel_cache_entry {
+  // Whether the ckernel goes back into the cache when released
+  bool cacheable;
+  size_t hash;
+  // Holds a reference to the arrfunc, so its address stays unique
+  nd::array af;
+  kernel_request_t kernreq;
+  eval::eval_context ectx;
+  // The destination type followed by the source types
+  vector<ndt::type> tp;
+  // The destination arrmeta followed by the source arrmeta
+  vector<char> arrmeta;
+  ckernel_builder<kernel_request_host> ckb;
+};
+
+namespace {
+
+// The maximum number of ckernels held by the cache
+const size_t ckernel_cache_capacity = 64;
+
+/**
+ * Returns true if the arrmeta of the type is only sizes and strides,
+ * so that two calls with equal arrmeta bytes produce the same ckernel.
+ */
+bool is_plain_strided(const ndt::type &tp)
+{
+  const ndt::type *el_tp = &tp;
+  while (!el_tp->is_builtin()) {
+    switch (el_tp->get_type_id()) {
+    case fixed_dim_type_id:
+      el_tp = &el_tp->extended<fixed_dim_type>()->get_element_type();
+      break;
+    case cfixed_dim_type_id:
+      el_tp = &el_tp->extended<cfixed_dim_type>()->get_element_type();
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+inline void hash_combine(size_t &hash, size_t value)
+{
+  hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+void hash_arrmeta(size_t &hash, const ndt::type &tp, const char *arrmeta)
+{
+  hash_combine(hash, tp.get_type_id());
+  // Plain strided arrmeta is made of intptr_t sizes and strides
+  const intptr_t *words = reinterpret_cast<const intptr_t *>(arrmeta);
+  for (size_t i = 0; i < tp.get_arrmeta_size() / sizeof(intptr_t); ++i) {
+    hash_combine(hash, static_cast<size_t>(words[i]));
+  }
+}
+
+inline bool arrmeta_equal(const char *lhs, const char *rhs, size_t size)
+{
+  return size == 0 || memcmp(lhs, rhs, size) == 0;
+}
+
+bool ectx_equal(const eval::eval_context &lhs, const eval::eval_context &rhs)
+{
+  return lhs.errmode == rhs.errmode &&
+         lhs.cuda_device_errmode == rhs.cuda_device_errmode &&
+         lhs.date_parse_order == rhs.date_parse_order &&
+         lhs.century_window == rhs.century_window &&
+         lhs.nthreads == rhs.nthreads;
+}
+
+bool entry_matches(const kernels::ckernel_cache_entry &e, size_t hash,
+                   const arrfunc_type_data *af, const ndt::type &dst_tp,
+                   const char *dst_arrmeta, intptr_t nsrc,
+                   const ndt::type *src_tp, const char *const *src_arrmeta,
+                   kernel_request_t kernreq, const eval::eval_context *ectx)
+{
+  if (e.hash != hash || e.af.get_readonly_originptr() !=
+                            reinterpret_cast<const char *>(af) ||
+      e.kernreq != kernreq || (intptr_t)e.tp.size() != nsrc + 1 ||
+      !ectx_equal(e.ectx, *ectx)) {
+    return false;
+  }
+  const char *arrmeta = e.arrmeta.empty() ? NULL : &e.arrmeta[0];
+  if (e.tp[0] != dst_tp ||
+      !arrmeta_equal(arrmeta, dst_arrmeta, dst_tp.get_arrmeta_size())) {
+    return false;
+  }
+  arrmeta += dst_tp.get_arrmeta_size();
+  for (intptr_t i = 0; i < nsrc; ++i) {
+    if (e.tp[i + 1] != src_tp[i] ||
+        !arrmeta_equal(arrmeta, src_arrmeta[i], src_tp[i].get_arrmeta_size())) {
+      return false;
+    }
+    arrmeta += src_tp[i].get_arrmeta_size();
+  }
+  return true;
+}
+
+class ckernel_cache {
+  mutex m_mutex;
+  // The most recently released ckernels are at the front
+  list<kernels::ckernel_cache_entry *> m_entries;
+  intptr_t m_hits, m_misses;
+
+public:
+  ckernel_cache() : m_hits(0), m_misses(0) {}
+
+  ~ckernel_cache() { clear(); }
+
+  /**
+   * Removes a matching ckernel from the cache and returns it,
+   * or returns NULL if there is none.
+   */
+  kernels::ckernel_cache_entry *
+  checkout(size_t hash, const arrfunc_type_data *af, const ndt::type &dst_tp,
+           const char *dst_arrmeta, intptr_t nsrc, const ndt::type *src_tp,
+           const char *const *src_arrmeta, kernel_request_t kernreq,
+           const eval::eval_context *ectx)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    for (list<kernels::ckernel_cache_entry *>::iterator it = m_entries.begin();
+         it != m_entries.end(); ++it) {
+      if (entry_matches(**it, hash, af, dst_tp, dst_arrmeta, nsrc, src_tp,
+                        src_arrmeta, kernreq, ectx)) {
+        kernels::ckernel_cache_entry *e = *it;
+        m_entries.erase(it);
+        ++m_hits;
+        return e;
+      }
+    }
+    ++m_misses;
+    return NULL;
+  }
+
+  /**
+   * Puts a ckernel back into the cache, evicting the least
+   * recently used one if the cache is full.
+   */
+  void checkin(kernels::ckernel_cache_entry *e)
+  {
+    kernels::ckernel_cache_entry *evicted = NULL;
+    {
+      lock_guard<mutex> lock(m_mutex);
+      m_entries.push_front(e);
+      if (m_entries.size() > ckernel_cache_capacity) {
+        evicted = m_entries.back();
+        m_entries.pop_back();
+      }
+    }
+    // Destroy the ckernel outside the lock
+    delete evicted;
+  }
+
+  kernels::ckernel_cache_stats get_stats()
+  {
+    lock_guard<mutex> lock(m_mutex);
+    kernels::ckernel_cache_stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.size = m_entries.size();
+    return stats;
+  }
+
+  void clear()
+  {
+    list<kernels::ckernel_cache_entry *> entries;
+    {
+      lock_guard<mutex> lock(m_mutex);
+      entries.swap(m_entries);
+      m_hits = 0;
+      m_misses = 0;
+    }
+    for (list<kernels::ckernel_cache_entry *>::iterator it = entries.begin();
+         it != entries.end(); ++it) {
+      delete *it;
+    }
+  }
+};
+
+ckernel_cache *cache = NULL;
+
+} // anonymous namespace
+
+kernels::cached_ckernel::cached_ckernel(
+    const nd::array &af, const ndt::type &dst_tp, const char *dst_arrmeta,
+    intptr_t nsrc, const ndt::type *src_tp, const char *const *src_arrmeta,
+    kernel_request_t kernreq, const eval::eval_context *ectx,
+    const nd::array &kwds)
+    : m_entry(NULL)
+{
+  const arrfunc_type_data *af_data =
+      reinterpret_cast<const arrfunc_type_data *>(af.get_readonly_originptr());
+  const arrfunc_type *af_tp = af.get_type().extended<arrfunc_type>();
+
+  bool cacheable = cache != NULL && kwds.is_null() && is_plain_strided(dst_tp);
+  for (intptr_t i = 0; i < nsrc && cacheable; ++i) {
+    cacheable = is_plain_strided(src_tp[i]);
+  }
+
+  size_t hash = 0;
+  if (cacheable) {
+    hash_combine(hash, reinterpret_cast<size_t>(af_data));
+    hash_combine(hash, kernreq);
+    hash_arrmeta(hash, dst_tp, dst_arrmeta);
+    for (intptr_t i = 0; i < nsrc; ++i) {
+      hash_arrmeta(hash, src_tp[i], src_arrmeta[i]);
+    }
+    m_entry = cache->checkout(hash, af_data, dst_tp, dst_arrmeta, nsrc, src_tp,
+                              src_arrmeta, kernreq, ectx);
+    if (m_entry != NULL) {
+      return;
+    }
+  }
+
+  ckernel_cache_entry *e = new ckernel_cache_entry;
+  try {
+    e->cacheable = cacheable;
+    if (cacheable) {
+      e->hash = hash;
+      e->af = af;
+      e->kernreq = kernreq;
+      e->ectx = *ectx;
+      e->tp.reserve(nsrc + 1);
+      e->tp.push_back(dst_tp);
+      e->arrmeta.insert(e->arrmeta.end(), dst_arrmeta,
+                        dst_arrmeta + dst_tp.get_arrmeta_size());
+      for (intptr_t i = 0; i < nsrc; ++i) {
+        e->tp.push_back(src_tp[i]);
+        e->arrmeta.insert(e->arrmeta.end(), src_arrmeta[i],
+                          src_arrmeta[i] + src_tp[i].get_arrmeta_size());
+      }
+    }
+    af_data->instantiate(af_data, af_tp, &e->ckb, 0, dst_tp, dst_arrmeta,
+                         src_tp, src_arrmeta, kernreq, ectx, kwds);
+  }
+  catch (...) {
+    delete e;
+    throw;
+  }
+  m_entry = e;
+}
+
+kernels::cached_ckernel::~cached_ckernel()
+{
+  if (m_entry->cacheable && cache != NULL) {
+    cache->checkin(m_entry);
+  } else {
+    delete m_entry;
+  }
+}
+
+ckernel_prefix *kernels::cached_ckernel::get() const
+{
+  return m_entry->ckb.get();
+}
+
+kernels::ckernel_cache_stats kernels::get_ckernel_cache_stats()
+{
+  if (cache == NULL) {
+    ckernel_cache_stats stats = {0, 0, 0};
+    return stats;
+  }
+  return cache->get_stats();
+}
+
+void kernels::clear_ckernel_cache()
+{
+  if (cache != NULL) {
+    cache->clear();
+  }
+}
+
+void init::ckernel_cache_init() { cache = new ckernel_cache; }
+
+void init::ckernel_cache_cleanup()
+{
+  delete cache;
+  cache = NULL;
+}
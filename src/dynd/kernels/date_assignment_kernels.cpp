@@ -6,6 +6,7 @@
 #include <dynd/kernels/date_assignment_kernels.hpp>
 #include <dynd/kernels/assignment_kernels.hpp>
 #include <dynd/types/cstruct_type.hpp>
+#include <dynd/types/datetime_layout.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -15,22 +16,22 @@ using namespace dynd;
 
 namespace {
     struct string_to_date_ck : public kernels::unary_ck<string_to_date_ck> {
-        ndt::type m_src_string_tp;
-        const char *m_src_arrmeta;
-        assign_error_mode m_errmode;
+        datetime_string_source m_src;
         date_parse_order_t m_date_parse_order;
         int m_century_window;
 
         inline void single(char *dst, const char *src)
         {
-            const base_string_type *bst = static_cast<const base_string_type *>(m_src_string_tp.extended());
-            const string& s = bst->get_utf8_string(m_src_arrmeta, src, m_errmode);
+            const char *begin, *end;
+            string s;
             date_ymd ymd;
-            // TODO: properly distinguish "date" and "option[date]" with respect to NA support
-            if (s == "NA") {
+            if (m_src.get_range(src, begin, end, s)) {
+                // TODO: properly distinguish "date" and "option[date]" with respect to NA support
                 ymd.set_to_na();
-            } else {
-                ymd.set_from_str(s, m_date_parse_order, m_century_window);
+            } else if (!m_src.layout.parse_date(begin, end, ymd)) {
+                ymd.set_from_str(begin, end, m_date_parse_order,
+                                 m_century_window, assign_error_fractional);
+                m_src.detect(begin, end);
             }
             *reinterpret_cast<int32_t *>(dst) = ymd.to_days();
         }
@@ -51,9 +52,8 @@ size_t dynd::make_string_to_date_assignment_kernel(
     }
 
     self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
-    self->m_src_string_tp = src_string_tp;
-    self->m_src_arrmeta = src_arrmeta;
-    self->m_errmode = ectx->errmode;
+    self->m_src.init(src_string_tp, src_arrmeta, ectx->errmode,
+                     datetime_string_source::date_kind);
     self->m_date_parse_order = ectx->date_parse_order;
     self->m_century_window = ectx->century_window;
     return ckb_offset;
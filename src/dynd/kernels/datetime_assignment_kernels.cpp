@@ -7,6 +7,7 @@
 #include <dynd/kernels/assignment_kernels.hpp>
 #include <dynd/types/cstruct_type.hpp>
 #include <dynd/types/datetime_type.hpp>
+#include <dynd/types/datetime_layout.hpp>
 #include <datetime_strings.h>
 
 using namespace std;
@@ -18,22 +19,24 @@ using namespace dynd;
 namespace {
     struct string_to_datetime_ck : public kernels::unary_ck<string_to_datetime_ck> {
         ndt::type m_dst_datetime_tp;
-        ndt::type m_src_string_tp;
-        const char *m_src_arrmeta;
-        assign_error_mode m_errmode;
+        datetime_string_source m_src;
         date_parse_order_t m_date_parse_order;
         int m_century_window;
 
         inline void single(char *dst, const char *src)
         {
-            const base_string_type *bst = static_cast<const base_string_type *>(m_src_string_tp.extended());
-            const string& s = bst->get_utf8_string(m_src_arrmeta, src, m_errmode);
+            const char *begin, *end;
+            string s;
             datetime_struct dts;
-            // TODO: properly distinguish "date" and "option[date]" with respect to NA support
-            if (s == "NA") {
+            if (m_src.get_range(src, begin, end, s)) {
+                // TODO: properly distinguish "date" and "option[date]" with respect to NA support
                 dts.set_to_na();
-            } else {
-                dts.set_from_str(s, m_date_parse_order, m_century_window);
+            } else if (!m_src.layout.parse_datetime(begin, end, dts)) {
+                const char *tz_begin = NULL, *tz_end = NULL;
+                dts.set_from_str(begin, end, m_date_parse_order,
+                                 m_century_window, assign_error_fractional,
+                                 tz_begin, tz_end);
+                m_src.detect(begin, end);
             }
             *reinterpret_cast<int64_t *>(dst) = dts.to_ticks();
         }
@@ -56,9 +59,8 @@ size_t dynd::make_string_to_datetime_assignment_kernel(
 
     self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
     self->m_dst_datetime_tp = dst_datetime_tp;
-    self->m_src_string_tp = src_string_tp;
-    self->m_src_arrmeta = src_arrmeta;
-    self->m_errmode = ectx->errmode;
+    self->m_src.init(src_string_tp, src_arrmeta, ectx->errmode,
+                     datetime_string_source::datetime_kind);
     self->m_date_parse_order = ectx->date_parse_order;
     self->m_century_window = ectx->century_window;
     return ckb_offset;
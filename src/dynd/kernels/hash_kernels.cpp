@@ -0,0 +1,339 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstring>
+#include <vector>
+
+#include <dynd/type.hpp>
+#include <dynd/kernels/hash_kernels.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/base_tuple_type.hpp>
+#include <dynd/types/bytes_type.hpp>
+#include <dynd/types/option_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+uint64_t dynd::hash_bytes(const char *data, size_t size)
+{
+  uint64_t h = hash_mix(size ^ 0x9e3779b97f4a7c15ULL);
+  uint64_t word;
+  for (; size >= 8; data += 8, size -= 8) {
+    memcpy(&word, data, 8);
+    h = (h ^ hash_mix(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  if (size > 0) {
+    word = 0;
+    memcpy(&word, data, size);
+    h = (h ^ hash_mix(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  return hash_mix(h);
+}
+
+namespace {
+
+// The hash of a missing value in an option type
+const uint64_t hash_of_na = 0x4e412d4e412d4e41ULL;
+
+template <typename T>
+inline uint64_t hash_value(T v)
+{
+  return hash_mix(static_cast<uint64_t>(v));
+}
+
+inline uint64_t hash_value(dynd_bool v)
+{
+  return hash_mix(v ? 1 : 0);
+}
+
+// -0.0 and 0.0 compare equal, as do all NaNs, so they have to hash equal
+inline uint64_t hash_value(float v)
+{
+  uint32_t bits;
+  if (v != v) {
+    bits = 0x7fc00000u;
+  } else if (v == 0) {
+    bits = 0;
+  } else {
+    memcpy(&bits, &v, sizeof(bits));
+  }
+  return hash_mix(bits);
+}
+
+inline uint64_t hash_value(double v)
+{
+  uint64_t bits;
+  if (v != v) {
+    bits = 0x7ff8000000000000ULL;
+  } else if (v == 0) {
+    bits = 0;
+  } else {
+    memcpy(&bits, &v, sizeof(bits));
+  }
+  return hash_mix(bits);
+}
+
+inline uint64_t hash_value(dynd_float16 v)
+{
+  return hash_value(static_cast<float>(v));
+}
+
+template <typename T>
+inline uint64_t hash_value(dynd_complex<T> v)
+{
+  return hash_combine(hash_value(v.real()), hash_value(v.imag()));
+}
+
+/**
+ * Hashes builtin values. The contiguous case is a tight loop with
+ * no calls, so the compiler can vectorize it.
+ */
+template <typename T>
+struct builtin_hash_ck
+    : public kernels::expr_ck<builtin_hash_ck<T>, kernel_request_host, 1> {
+  inline void single(char *dst, char *const *src)
+  {
+    *reinterpret_cast<uint64_t *>(dst) =
+        hash_value(*reinterpret_cast<const T *>(src[0]));
+  }
+
+  inline void strided(char *dst, intptr_t dst_stride, char *const *src,
+                      const intptr_t *src_stride, size_t count)
+  {
+    const char *s = src[0];
+    intptr_t ss = src_stride[0];
+    if (dst_stride == sizeof(uint64_t) && ss == sizeof(T)) {
+      uint64_t *d = reinterpret_cast<uint64_t *>(dst);
+      const T *sv = reinterpret_cast<const T *>(s);
+      for (size_t i = 0; i != count; ++i) {
+        d[i] = hash_value(sv[i]);
+      }
+    } else {
+      for (size_t i = 0; i != count; ++i, dst += dst_stride, s += ss) {
+        *reinterpret_cast<uint64_t *>(dst) =
+            hash_value(*reinterpret_cast<const T *>(s));
+      }
+    }
+  }
+};
+
+/**
+ * Hashes values whose equality is equality of their bytes, such as
+ * fixedstring, 128-bit integers, or the storage of a categorical.
+ */
+struct fixed_bytes_hash_ck
+    : public kernels::expr_ck<fixed_bytes_hash_ck, kernel_request_host, 1> {
+  size_t m_data_size;
+
+  inline void single(char *dst, char *const *src)
+  {
+    *reinterpret_cast<uint64_t *>(dst) = hash_bytes(src[0], m_data_size);
+  }
+};
+
+/**
+ * Hashes string or bytes values, which are both a begin/end pair
+ * pointing into a memory block.
+ */
+struct blockref_bytes_hash_ck
+    : public kernels::expr_ck<blockref_bytes_hash_ck, kernel_request_host, 1> {
+  inline void single(char *dst, char *const *src)
+  {
+    const bytes_type_data *d =
+        reinterpret_cast<const bytes_type_data *>(src[0]);
+    *reinterpret_cast<uint64_t *>(dst) =
+        hash_bytes(d->begin, d->end - d->begin);
+  }
+};
+
+/**
+ * Hashes a struct or tuple by combining the hashes of its fields
+ * in order.
+ */
+struct tuple_hash_ck
+    : public kernels::expr_ck<tuple_hash_ck, kernel_request_host, 1> {
+  const uintptr_t *m_data_offsets;
+  // Offsets of the field hash child ckernels
+  std::vector<intptr_t> m_field_offsets;
+
+  inline void single(char *dst, char *const *src)
+  {
+    size_t field_count = m_field_offsets.size();
+    uint64_t h = hash_mix(field_count);
+    for (size_t i = 0; i != field_count; ++i) {
+      ckernel_prefix *child = get_child_ckernel(m_field_offsets[i]);
+      expr_single_t child_fn = child->get_function<expr_single_t>();
+      char *field_src = src[0] + m_data_offsets[i];
+      uint64_t fh;
+      child_fn(reinterpret_cast<char *>(&fh), &field_src, child);
+      h = hash_combine(h, fh);
+    }
+    *reinterpret_cast<uint64_t *>(dst) = h;
+  }
+
+  inline void destruct_children()
+  {
+    for (size_t i = 0; i != m_field_offsets.size(); ++i) {
+      base.destroy_child_ckernel(m_field_offsets[i]);
+    }
+  }
+};
+
+/**
+ * Hashes an option value, using the value hash if it is available.
+ */
+struct option_hash_ck
+    : public kernels::expr_ck<option_hash_ck, kernel_request_host, 1> {
+  // The default child is the src is_avail ckernel
+  // This child is the value hash ckernel
+  intptr_t m_value_hash_offset;
+
+  inline void single(char *dst, char *const *src)
+  {
+    ckernel_prefix *is_avail = get_child_ckernel();
+    expr_single_t is_avail_fn = is_avail->get_function<expr_single_t>();
+    dynd_bool avail = false;
+    is_avail_fn(reinterpret_cast<char *>(&avail), src, is_avail);
+    if (avail) {
+      ckernel_prefix *value_hash = get_child_ckernel(m_value_hash_offset);
+      expr_single_t value_hash_fn =
+          value_hash->get_function<expr_single_t>();
+      value_hash_fn(dst, src, value_hash);
+    } else {
+      *reinterpret_cast<uint64_t *>(dst) = hash_of_na;
+    }
+  }
+
+  inline void destruct_children()
+  {
+    // is_avail
+    get_child_ckernel()->destroy();
+    // value_hash
+    base.destroy_child_ckernel(m_value_hash_offset);
+  }
+};
+
+template <typename T>
+intptr_t make_builtin_hash_kernel(void *ckb, intptr_t ckb_offset,
+                                  kernel_request_t kernreq)
+{
+  builtin_hash_ck<T>::create_leaf(ckb, kernreq, ckb_offset);
+  return ckb_offset;
+}
+
+} // anonymous namespace
+
+intptr_t dynd::make_hash_kernel(void *ckb, intptr_t ckb_offset,
+                                const ndt::type &src_tp,
+                                const char *src_arrmeta,
+                                kernel_request_t kernreq,
+                                const eval::eval_context *ectx)
+{
+  switch (src_tp.get_type_id()) {
+  case bool_type_id:
+    return make_builtin_hash_kernel<dynd_bool>(ckb, ckb_offset, kernreq);
+  case int8_type_id:
+    return make_builtin_hash_kernel<int8_t>(ckb, ckb_offset, kernreq);
+  case int16_type_id:
+    return make_builtin_hash_kernel<int16_t>(ckb, ckb_offset, kernreq);
+  case int32_type_id:
+    return make_builtin_hash_kernel<int32_t>(ckb, ckb_offset, kernreq);
+  case int64_type_id:
+    return make_builtin_hash_kernel<int64_t>(ckb, ckb_offset, kernreq);
+  case uint8_type_id:
+    return make_builtin_hash_kernel<uint8_t>(ckb, ckb_offset, kernreq);
+  case uint16_type_id:
+    return make_builtin_hash_kernel<uint16_t>(ckb, ckb_offset, kernreq);
+  case uint32_type_id:
+    return make_builtin_hash_kernel<uint32_t>(ckb, ckb_offset, kernreq);
+  case uint64_type_id:
+    return make_builtin_hash_kernel<uint64_t>(ckb, ckb_offset, kernreq);
+  case float16_type_id:
+    return make_builtin_hash_kernel<dynd_float16>(ckb, ckb_offset, kernreq);
+  case float32_type_id:
+    return make_builtin_hash_kernel<float>(ckb, ckb_offset, kernreq);
+  case float64_type_id:
+    return make_builtin_hash_kernel<double>(ckb, ckb_offset, kernreq);
+  case complex_float32_type_id:
+    return make_builtin_hash_kernel<dynd_complex<float> >(ckb, ckb_offset,
+                                                          kernreq);
+  case complex_float64_type_id:
+    return make_builtin_hash_kernel<dynd_complex<double> >(ckb, ckb_offset,
+                                                           kernreq);
+  // float128 is hashed by its bytes too, so -0.0 and NaN payloads
+  // are not normalized for it
+  case int128_type_id:
+  case uint128_type_id:
+  case float128_type_id:
+  case fixedbytes_type_id:
+  case fixedstring_type_id:
+  case categorical_type_id:
+  case date_type_id:
+  case time_type_id:
+  case datetime_type_id: {
+    fixed_bytes_hash_ck *self =
+        fixed_bytes_hash_ck::create_leaf(ckb, kernreq, ckb_offset);
+    self->m_data_size = src_tp.get_data_size();
+    return ckb_offset;
+  }
+  case string_type_id:
+  case bytes_type_id:
+    blockref_bytes_hash_ck::create_leaf(ckb, kernreq, ckb_offset);
+    return ckb_offset;
+  case struct_type_id:
+  case cstruct_type_id:
+  case tuple_type_id:
+  case ctuple_type_id: {
+    typedef tuple_hash_ck self_type;
+    intptr_t root_ckb_offset = ckb_offset;
+    const base_tuple_type *bsd = src_tp.extended<base_tuple_type>();
+    intptr_t field_count = bsd->get_field_count();
+    self_type *self = self_type::create(ckb, kernreq, ckb_offset);
+    self->m_data_offsets = bsd->get_data_offsets(src_arrmeta);
+    self->m_field_offsets.resize(field_count);
+    const uintptr_t *arrmeta_offsets = bsd->get_arrmeta_offsets_raw();
+    for (intptr_t i = 0; i != field_count; ++i) {
+      // Reserve space for the child, and re-get the self pointer,
+      // because creating a field kernel may move the memory
+      reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+          ->ensure_capacity(ckb_offset);
+      self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+                 ->get_at<self_type>(root_ckb_offset);
+      self->m_field_offsets[i] = ckb_offset - root_ckb_offset;
+      ckb_offset = make_hash_kernel(ckb, ckb_offset, bsd->get_field_type(i),
+                                    src_arrmeta + arrmeta_offsets[i],
+                                    kernel_request_single, ectx);
+    }
+    return ckb_offset;
+  }
+  case option_type_id: {
+    typedef option_hash_ck self_type;
+    intptr_t root_ckb_offset = ckb_offset;
+    const option_type *ot = src_tp.extended<option_type>();
+    self_type::create(ckb, kernreq, ckb_offset);
+    // instantiate is_avail
+    const arrfunc_type_data *af = ot->get_is_avail_arrfunc();
+    const arrfunc_type *af_tp = ot->get_is_avail_arrfunc_type();
+    ckb_offset = af->instantiate(af, af_tp, ckb, ckb_offset,
+                                 ndt::make_type<dynd_bool>(), NULL, &src_tp,
+                                 &src_arrmeta, kernel_request_single, ectx,
+                                 nd::array());
+    // instantiate value_hash
+    reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+        ->ensure_capacity(ckb_offset);
+    self_type *self =
+        reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+            ->get_at<self_type>(root_ckb_offset);
+    self->m_value_hash_offset = ckb_offset - root_ckb_offset;
+    return make_hash_kernel(ckb, ckb_offset, ot->get_value_type(), src_arrmeta,
+                            kernel_request_single, ectx);
+  }
+  default: {
+    stringstream ss;
+    ss << "make_hash_kernel: cannot hash values of type " << src_tp;
+    throw type_error(ss.str());
+  }
+  }
+}
@@ -18,6 +18,24 @@ using namespace dynd;
 ////////////////////////////////////////////////////////////////////
 // make_elwise_strided_dimension_expr_kernel
 
+/**
+ * Returns the number of elements of a strided dimension to process as one
+ * chunk in parallel evaluation, so that each chunk touches roughly
+ * DYND_PARALLEL_CHUNK_BYTES of the operands.
+ */
+template <int N>
+static intptr_t get_parallel_chunk_size(intptr_t dst_stride,
+                                        const intptr_t *src_stride)
+{
+  intptr_t element_bytes = dst_stride >= 0 ? dst_stride : -dst_stride;
+  for (int i = 0; i < N; ++i) {
+    element_bytes += src_stride[i] >= 0 ? src_stride[i] : -src_stride[i];
+  }
+  return std::max<intptr_t>(DYND_PARALLEL_CHUNK_BYTES /
+                                std::max<intptr_t>(element_bytes, 1),
+                            1);
+}
+
 template <int N>
 static size_t make_elwise_strided_dimension_expr_kernel_for_N(
     void *ckb, intptr_t ckb_offset, intptr_t dst_ndim, const ndt::type &dst_tp,
@@ -86,6 +104,43 @@ static size_t make_elwise_strided_dimension_expr_kernel_for_N(
     ckb_offset = 0;
   }
 #endif
+
+  // Evaluate the outermost dimension in parallel if requested. This is
+  // only done when the output has no blockref memory, as allocating
+  // from a dst memory block is not thread-safe.
+  if (ectx->nthreads > 1 && kernreq == kernel_request_single &&
+      (dst_tp.get_flags() & type_flag_blockref) == 0) {
+    intptr_t chunk_size = get_parallel_chunk_size<N>(dst_stride, src_stride);
+    intptr_t nchunks = (size + chunk_size - 1) / chunk_size;
+    if (nchunks > 1) {
+      typedef kernels::parallel_elwise_ck<N> parallel_self_type;
+      parallel_self_type *self = parallel_self_type::create_leaf(
+          ckb, kernreq, ckb_offset, size, chunk_size,
+          std::min<intptr_t>(ectx->nthreads, nchunks), dst_stride,
+          src_stride);
+      // Each thread gets its own instance of the child ckernel, which
+      // itself runs serially
+      eval::eval_context child_ectx(*ectx);
+      child_ectx.nthreads = 1;
+      for (intptr_t i = 0; i < self->nthreads; ++i) {
+        if (!finished) {
+          make_lifted_expr_ckernel(elwise_handler, elwise_handler_tp,
+                                   &self->children[i], 0, dst_ndim - 1,
+                                   child_dst_tp, child_dst_arrmeta,
+                                   child_src_ndim, child_src_tp,
+                                   child_src_arrmeta, kernel_request_strided,
+                                   &child_ectx);
+        } else {
+          elwise_handler->instantiate(
+              elwise_handler, elwise_handler_tp, &self->children[i], 0,
+              child_dst_tp, child_dst_arrmeta, child_src_tp, child_src_arrmeta,
+              kernel_request_strided, &child_ectx, nd::array());
+        }
+      }
+      return ckb_offset;
+    }
+  }
+
   self_type::create(ckb, kernreq, ckb_offset, size, dst_stride,
                     kernels::array_wrapper<intptr_t, N>(src_stride));
 
@@ -10,6 +10,8 @@
 #include <dynd/types/var_dim_type.hpp>
 #include <dynd/kernels/expr_kernel_generator.hpp>
 #include <dynd/kernels/ckernel_common_functions.hpp>
+#include <dynd/eval/thread_pool.hpp>
+#include <dynd/shortvector.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -49,6 +51,18 @@ struct ckernel_reduction_prefix {
 
 };
 
+/**
+ * The members shared by the ckernels for a strided dimension being
+ * reduced. The parallel reduction relies on this to point one of these
+ * ckernels at a different number of elements for each chunk.
+ */
+struct strided_reduction_dimension_prefix {
+    ckernel_reduction_prefix ckpbase;
+    // The code assumes that size >= 1
+    intptr_t size;
+    intptr_t src_stride;
+};
+
 /**
  * STRIDED INITIAL REDUCTION DIMENSION
  * This ckernel handles one dimension of the reduction processing,
@@ -63,14 +77,10 @@ struct ckernel_reduction_prefix {
  *  - The child followup_call function must be *strided*.
  * 
  */
-struct strided_initial_reduction_kernel_extra {
+struct strided_initial_reduction_kernel_extra
+    : strided_reduction_dimension_prefix {
     typedef strided_initial_reduction_kernel_extra extra_type;
 
-    ckernel_reduction_prefix ckpbase;
-    // The code assumes that size >= 1
-    intptr_t size;
-    intptr_t src_stride;
-
     inline ckernel_prefix& base() {
         return ckpbase.base();
     }
@@ -288,13 +298,10 @@ struct strided_initial_broadcast_kernel_extra {
  *  - The child reduction kernel must be *strided*.
  * 
  */
-struct strided_inner_reduction_kernel_extra {
+struct strided_inner_reduction_kernel_extra
+    : strided_reduction_dimension_prefix {
     typedef strided_inner_reduction_kernel_extra extra_type;
 
-    ckernel_reduction_prefix ckpbase;
-    // The code assumes that size >= 1
-    intptr_t size;
-    intptr_t src_stride;
     size_t dst_init_kernel_offset;
     // For the case with a reduction identity
     const char *ident_data;
@@ -640,6 +647,99 @@ struct strided_inner_broadcast_kernel_extra {
     }
 };
 
+/**
+ * PARALLEL REDUCTION
+ * This ckernel reduces the outermost dimension using several threads.
+ * The dimension is partitioned into chunks, each chunk is reduced
+ * into its own partial result, and the partial results are combined
+ * pairwise in a tree before the last one is copied into the destination.
+ *
+ * The child ckernels live in their own ckernel_builders, so every thread
+ * has a private copy whose size can be changed for each chunk:
+ *  - children[i], for i < nthreads, reduce a chunk into a partial result.
+ *  - children[nthreads + i] accumulate one partial result into another.
+ *  - children[2 * nthreads] initializes the destination from the combined
+ *    partial result.
+ */
+struct parallel_reduction_kernel_extra {
+    typedef parallel_reduction_kernel_extra extra_type;
+
+    ckernel_prefix base;
+    intptr_t size, chunk_size, nchunks, nthreads;
+    intptr_t src_stride;
+    // Storage for one partial result per chunk
+    char *partial_data;
+    intptr_t partial_stride;
+    memory_block_data *partial_ref;
+    ckernel_builder<kernel_request_host> *children;
+
+    struct job_data {
+        extra_type *e;
+        char *src;
+        // The distance, in chunks, between two partial results being combined
+        intptr_t step;
+    };
+
+    static void reduce_chunk(intptr_t thread_index, intptr_t chunk_index,
+                             void *data)
+    {
+        job_data *job = reinterpret_cast<job_data *>(data);
+        extra_type *e = job->e;
+        strided_reduction_dimension_prefix *echild =
+            e->children[thread_index]
+                .get_at<strided_reduction_dimension_prefix>(0);
+        intptr_t i = chunk_index * e->chunk_size;
+        echild->size = std::min(e->chunk_size, e->size - i);
+        char *src_chunk = job->src + i * e->src_stride;
+        expr_single_t opchild_first_call =
+            echild->ckpbase.get_first_call_function<expr_single_t>();
+        opchild_first_call(e->partial_data + chunk_index * e->partial_stride,
+                           &src_chunk, &echild->ckpbase.base());
+    }
+
+    static void combine_pair(intptr_t thread_index, intptr_t pair_index,
+                             void *data)
+    {
+        job_data *job = reinterpret_cast<job_data *>(data);
+        extra_type *e = job->e;
+        ckernel_reduction_prefix *echild =
+            e->children[e->nthreads + thread_index]
+                .get_at<ckernel_reduction_prefix>(0);
+        intptr_t k = pair_index * 2 * job->step;
+        char *src_partial = e->partial_data + (k + job->step) * e->partial_stride;
+        intptr_t zero_stride = 0;
+        echild->get_followup_call_function()(
+            e->partial_data + k * e->partial_stride, 0, &src_partial,
+            &zero_stride, 1, &echild->base());
+    }
+
+    static void single(char *dst, char *const *src, ckernel_prefix *extra)
+    {
+        extra_type *e = reinterpret_cast<extra_type *>(extra);
+        job_data job = {e, src[0], 0};
+        eval::parallel_for(e->nthreads, e->nchunks, &reduce_chunk, &job);
+        for (job.step = 1; job.step < e->nchunks; job.step *= 2) {
+            intptr_t npairs =
+                (e->nchunks - job.step + 2 * job.step - 1) / (2 * job.step);
+            eval::parallel_for(e->nthreads, npairs, &combine_pair, &job);
+        }
+        ckernel_reduction_prefix *echild =
+            e->children[2 * e->nthreads].get_at<ckernel_reduction_prefix>(0);
+        char *src_partial = e->partial_data;
+        echild->get_first_call_function<expr_single_t>()(dst, &src_partial,
+                                                         &echild->base());
+    }
+
+    static void destruct(ckernel_prefix *self)
+    {
+        extra_type *e = reinterpret_cast<extra_type *>(self);
+        delete[] e->children;
+        if (e->partial_ref != NULL) {
+            memory_block_decref(e->partial_ref);
+        }
+    }
+};
+
 } // anonymous namespace
 
 /**
@@ -1008,94 +1108,21 @@ static size_t make_strided_inner_broadcast_dimension_kernel(
   return ckb_offset;
 }
 
-size_t dynd::make_lifted_reduction_ckernel(
+/**
+ * Adds the ckernel layers for processing the dimensions of the reduction,
+ * one layer per dimension, from the outermost to the innermost.
+ */
+static size_t make_lifted_reduction_dims(
     const arrfunc_type_data *elwise_reduction,
     const arrfunc_type *elwise_reduction_tp,
     const arrfunc_type_data *dst_initialization,
     const arrfunc_type *dst_initialization_tp, void *ckb,
-    intptr_t ckb_offset, const ndt::type &dst_tp, const char *dst_arrmeta,
-    const ndt::type &src_tp, const char *src_arrmeta, intptr_t reduction_ndim,
-    const bool *reduction_dimflags, bool associative, bool commutative,
-    bool right_associative, const nd::array &reduction_identity,
-    dynd::kernel_request_t kernreq, const eval::eval_context *ectx)
+    intptr_t ckb_offset, ndt::type dst_i_tp, const char *dst_arrmeta,
+    ndt::type src_i_tp, const char *src_arrmeta, intptr_t reduction_ndim,
+    const bool *reduction_dimflags, bool keep_dims, bool right_associative,
+    const nd::array &reduction_identity, kernel_request_t kernreq,
+    const eval::eval_context *ectx)
 {
-  // Count the number of dimensions being reduced
-  intptr_t reducedim_count = 0;
-  for (intptr_t i = 0; i < reduction_ndim; ++i) {
-    reducedim_count += reduction_dimflags[i];
-  }
-  if (reducedim_count == 0) {
-    if (reduction_ndim == 0) {
-      // If there are no dimensions to reduce, it's
-      // just a dst_initialization operation, so create
-      // that ckernel directly
-      if (dst_initialization != NULL) {
-        return dst_initialization->instantiate(
-            dst_initialization, dst_initialization_tp, ckb, ckb_offset, dst_tp,
-            dst_arrmeta, &src_tp, &src_arrmeta, kernreq, ectx, 
-            nd::array());
-      }
-      else if (reduction_identity.is_null()) {
-        return make_assignment_kernel(NULL, NULL, ckb, ckb_offset, dst_tp, dst_arrmeta,
-                                      src_tp, src_arrmeta, kernreq, ectx, nd::array());
-      }
-      else {
-        // Create the kernel which copies the identity and then
-        // does one reduction
-        return make_strided_inner_reduction_dimension_kernel(
-            elwise_reduction, elwise_reduction_tp, dst_initialization,
-            dst_initialization_tp, ckb, ckb_offset, 0, 1, dst_tp, dst_arrmeta,
-            src_tp, src_arrmeta, right_associative, reduction_identity, kernreq,
-            ectx);
-      }
-    }
-    throw runtime_error("make_lifted_reduction_ckernel: no dimensions were "
-                        "flagged for reduction");
-  }
-
-  if (!(reducedim_count == 1 || (associative && commutative))) {
-    throw runtime_error(
-        "make_lifted_reduction_ckernel: for reducing along multiple dimensions,"
-        " the reduction function must be both associative and commutative");
-  }
-  if (right_associative) {
-    throw runtime_error("make_lifted_reduction_ckernel: right_associative is "
-                        "not yet supported");
-  }
-
-  ndt::type dst_el_tp = elwise_reduction_tp->get_return_type();
-  ndt::type src_el_tp = elwise_reduction_tp->get_arg_type(0);
-
-  // This is the number of dimensions being processed by the reduction
-  if (reduction_ndim != src_tp.get_ndim() - src_el_tp.get_ndim()) {
-    stringstream ss;
-    ss << "make_lifted_reduction_ckernel: wrong number of reduction "
-          "dimensions, ";
-    ss << "requested " << reduction_ndim << ", but types have ";
-    ss << (src_tp.get_ndim() - src_el_tp.get_ndim());
-    ss << " lifting from " << src_el_tp << " to " << src_tp;
-    throw runtime_error(ss.str());
-  }
-  // Determine whether reduced dimensions are being kept or not
-  bool keep_dims;
-  if (reduction_ndim == dst_tp.get_ndim() - dst_el_tp.get_ndim()) {
-    keep_dims = true;
-  }
-  else if (reduction_ndim - reducedim_count ==
-           dst_tp.get_ndim() - dst_el_tp.get_ndim()) {
-    keep_dims = false;
-  }
-  else {
-    stringstream ss;
-    ss << "make_lifted_reduction_ckernel: The number of dimensions flagged for "
-          "reduction, ";
-    ss << reducedim_count << ", is not consistent with the destination type ";
-    ss << "reducing " << dst_tp << " with element " << dst_el_tp;
-    throw runtime_error(ss.str());
-  }
-
-  ndt::type dst_i_tp = dst_tp, src_i_tp = src_tp;
-
   for (intptr_t i = 0; i < reduction_ndim; ++i) {
     intptr_t dst_stride, dst_size, src_stride, src_size;
     // Get the striding parameters for the source dimension
@@ -1195,3 +1222,250 @@ size_t dynd::make_lifted_reduction_ckernel(
   throw runtime_error("make_lifted_reduction_ckernel: internal error, "
                       "should have returned in the loop");
 }
+
+/**
+ * Adds the ckernel layers for reducing a strided run of ``src_size``
+ * elements into a single destination value. The outermost layer is always a
+ * reduction dimension ckernel, so its size can be changed between calls.
+ * The remaining dimensions of the source are described by ``rest_ndim``
+ * and ``rest_dimflags``.
+ */
+static size_t make_strided_reduction_run_kernel(
+    const arrfunc_type_data *elwise_reduction,
+    const arrfunc_type *elwise_reduction_tp, void *ckb, intptr_t ckb_offset,
+    intptr_t src_stride, intptr_t src_size, const ndt::type &dst_tp,
+    const char *dst_arrmeta, const ndt::type &src_tp, const char *src_arrmeta,
+    intptr_t rest_ndim, const bool *rest_dimflags, bool keep_dims,
+    const nd::array &reduction_identity, const eval::eval_context *ectx)
+{
+  if (rest_ndim == 0) {
+    return make_strided_inner_reduction_dimension_kernel(
+        elwise_reduction, elwise_reduction_tp, NULL, NULL, ckb, ckb_offset,
+        src_stride, src_size, dst_tp, dst_arrmeta, src_tp, src_arrmeta, false,
+        reduction_identity, kernel_request_single, ectx);
+  }
+  ckb_offset = make_strided_initial_reduction_dimension_kernel(
+      ckb, ckb_offset, src_stride, src_size, kernel_request_single);
+  return make_lifted_reduction_dims(
+      elwise_reduction, elwise_reduction_tp, NULL, NULL, ckb, ckb_offset,
+      dst_tp, dst_arrmeta, src_tp, src_arrmeta, rest_ndim, rest_dimflags,
+      keep_dims, false, reduction_identity, kernel_request_single, ectx);
+}
+
+/**
+ * Adds the parallel reduction ckernel for the outermost dimension, if the
+ * reduction is big enough to be split into multiple chunks. Returns -1
+ * without modifying the ckernel_builder otherwise.
+ */
+static intptr_t make_parallel_reduction_kernel(
+    const arrfunc_type_data *elwise_reduction,
+    const arrfunc_type *elwise_reduction_tp, void *ckb, intptr_t ckb_offset,
+    const ndt::type &dst_tp, const char *dst_arrmeta, const ndt::type &src_tp,
+    const char *src_arrmeta, intptr_t reduction_ndim,
+    const bool *reduction_dimflags, bool keep_dims,
+    const nd::array &reduction_identity, const eval::eval_context *ectx)
+{
+  intptr_t src_size, src_stride;
+  ndt::type src_rest_tp;
+  const char *src_rest_arrmeta;
+  if (!src_tp.get_as_strided(src_arrmeta, &src_size, &src_stride, &src_rest_tp,
+                             &src_rest_arrmeta)) {
+    return -1;
+  }
+  // With the dimensions kept, the destination has a size one dimension
+  // for the one being reduced
+  ndt::type dst_rest_tp = dst_tp;
+  const char *dst_rest_arrmeta = dst_arrmeta;
+  if (keep_dims) {
+    intptr_t dst_size, dst_stride;
+    if (!dst_tp.get_as_strided(dst_arrmeta, &dst_size, &dst_stride,
+                               &dst_rest_tp, &dst_rest_arrmeta) ||
+        dst_size != 1) {
+      return -1;
+    }
+  }
+
+  // Split the dimension so each chunk reads about DYND_PARALLEL_CHUNK_BYTES,
+  // but limit the number of partial results to a few per thread
+  intptr_t element_bytes = std::max<intptr_t>(
+      src_stride >= 0 ? src_stride : -src_stride, 1);
+  intptr_t chunk_size =
+      std::max<intptr_t>(DYND_PARALLEL_CHUNK_BYTES / element_bytes, 1);
+  intptr_t max_nchunks = 4 * ectx->nthreads;
+  if ((src_size + chunk_size - 1) / chunk_size > max_nchunks) {
+    chunk_size = (src_size + max_nchunks - 1) / max_nchunks;
+  }
+  intptr_t nchunks = (src_size + chunk_size - 1) / chunk_size;
+  if (nchunks < 2) {
+    return -1;
+  }
+  intptr_t nthreads = std::min(ectx->nthreads, nchunks);
+
+  parallel_reduction_kernel_extra *e =
+      reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+          ->alloc_ck_leaf<parallel_reduction_kernel_extra>(ckb_offset);
+  e->base.set_function<expr_single_t>(&parallel_reduction_kernel_extra::single);
+  e->base.destructor = &parallel_reduction_kernel_extra::destruct;
+  e->partial_ref = NULL;
+  e->children = NULL;
+  e->size = src_size;
+  e->chunk_size = chunk_size;
+  e->nchunks = nchunks;
+  e->nthreads = nthreads;
+  e->src_stride = src_stride;
+  e->children = new ckernel_builder<kernel_request_host>[2 * nthreads + 1];
+
+  nd::array partials = nd::empty(ndt::make_fixed_dim(nchunks, dst_rest_tp));
+  e->partial_data = partials.get_readwrite_originptr();
+  e->partial_stride =
+      reinterpret_cast<const fixed_dim_type_arrmeta *>(partials.get_arrmeta())
+          ->stride;
+  e->partial_ref = partials.get_memblock().release();
+  const char *partial_arrmeta =
+      partials.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
+
+  // The partial results are combined as a reduction over a size one
+  // dimension with every remaining dimension broadcast
+  intptr_t partial_ndim =
+      dst_rest_tp.get_ndim() - elwise_reduction_tp->get_return_type().get_ndim();
+  shortvector<bool> partial_dimflags(partial_ndim);
+  for (intptr_t i = 0; i < partial_ndim; ++i) {
+    partial_dimflags[i] = false;
+  }
+
+  // The child ckernels run serially on their own thread
+  eval::eval_context child_ectx(*ectx);
+  child_ectx.nthreads = 1;
+  for (intptr_t i = 0; i < nthreads; ++i) {
+    make_strided_reduction_run_kernel(
+        elwise_reduction, elwise_reduction_tp, &e->children[i], 0, src_stride,
+        chunk_size, dst_rest_tp, partial_arrmeta, src_rest_tp,
+        src_rest_arrmeta, reduction_ndim - 1, reduction_dimflags + 1,
+        keep_dims, reduction_identity, &child_ectx);
+  }
+  for (intptr_t i = 0; i < nthreads; ++i) {
+    make_strided_reduction_run_kernel(
+        elwise_reduction, elwise_reduction_tp, &e->children[nthreads + i], 0,
+        0, 1, dst_rest_tp, partial_arrmeta, dst_rest_tp, partial_arrmeta,
+        partial_ndim, partial_dimflags.get(), false, nd::array(),
+        &child_ectx);
+  }
+  // Every partial result already starts from the reduction identity, so
+  // the destination is initialized by copying the combined result
+  make_strided_reduction_run_kernel(
+      elwise_reduction, elwise_reduction_tp, &e->children[2 * nthreads], 0, 0,
+      1, dst_rest_tp, dst_rest_arrmeta, dst_rest_tp, partial_arrmeta,
+      partial_ndim, partial_dimflags.get(), false, nd::array(), &child_ectx);
+
+  return ckb_offset;
+}
+
+size_t dynd::make_lifted_reduction_ckernel(
+    const arrfunc_type_data *elwise_reduction,
+    const arrfunc_type *elwise_reduction_tp,
+    const arrfunc_type_data *dst_initialization,
+    const arrfunc_type *dst_initialization_tp, void *ckb,
+    intptr_t ckb_offset, const ndt::type &dst_tp, const char *dst_arrmeta,
+    const ndt::type &src_tp, const char *src_arrmeta, intptr_t reduction_ndim,
+    const bool *reduction_dimflags, bool associative, bool commutative,
+    bool right_associative, const nd::array &reduction_identity,
+    dynd::kernel_request_t kernreq, const eval::eval_context *ectx)
+{
+  // Count the number of dimensions being reduced
+  intptr_t reducedim_count = 0;
+  for (intptr_t i = 0; i < reduction_ndim; ++i) {
+    reducedim_count += reduction_dimflags[i];
+  }
+  if (reducedim_count == 0) {
+    if (reduction_ndim == 0) {
+      // If there are no dimensions to reduce, it's
+      // just a dst_initialization operation, so create
+      // that ckernel directly
+      if (dst_initialization != NULL) {
+        return dst_initialization->instantiate(
+            dst_initialization, dst_initialization_tp, ckb, ckb_offset, dst_tp,
+            dst_arrmeta, &src_tp, &src_arrmeta, kernreq, ectx, 
+            nd::array());
+      }
+      else if (reduction_identity.is_null()) {
+        return make_assignment_kernel(NULL, NULL, ckb, ckb_offset, dst_tp, dst_arrmeta,
+                                      src_tp, src_arrmeta, kernreq, ectx, nd::array());
+      }
+      else {
+        // Create the kernel which copies the identity and then
+        // does one reduction
+        return make_strided_inner_reduction_dimension_kernel(
+            elwise_reduction, elwise_reduction_tp, dst_initialization,
+            dst_initialization_tp, ckb, ckb_offset, 0, 1, dst_tp, dst_arrmeta,
+            src_tp, src_arrmeta, right_associative, reduction_identity, kernreq,
+            ectx);
+      }
+    }
+    throw runtime_error("make_lifted_reduction_ckernel: no dimensions were "
+                        "flagged for reduction");
+  }
+
+  if (!(reducedim_count == 1 || (associative && commutative))) {
+    throw runtime_error(
+        "make_lifted_reduction_ckernel: for reducing along multiple dimensions,"
+        " the reduction function must be both associative and commutative");
+  }
+  if (right_associative) {
+    throw runtime_error("make_lifted_reduction_ckernel: right_associative is "
+                        "not yet supported");
+  }
+
+  ndt::type dst_el_tp = elwise_reduction_tp->get_return_type();
+  ndt::type src_el_tp = elwise_reduction_tp->get_arg_type(0);
+
+  // This is the number of dimensions being processed by the reduction
+  if (reduction_ndim != src_tp.get_ndim() - src_el_tp.get_ndim()) {
+    stringstream ss;
+    ss << "make_lifted_reduction_ckernel: wrong number of reduction "
+          "dimensions, ";
+    ss << "requested " << reduction_ndim << ", but types have ";
+    ss << (src_tp.get_ndim() - src_el_tp.get_ndim());
+    ss << " lifting from " << src_el_tp << " to " << src_tp;
+    throw runtime_error(ss.str());
+  }
+  // Determine whether reduced dimensions are being kept or not
+  bool keep_dims;
+  if (reduction_ndim == dst_tp.get_ndim() - dst_el_tp.get_ndim()) {
+    keep_dims = true;
+  }
+  else if (reduction_ndim - reducedim_count ==
+           dst_tp.get_ndim() - dst_el_tp.get_ndim()) {
+    keep_dims = false;
+  }
+  else {
+    stringstream ss;
+    ss << "make_lifted_reduction_ckernel: The number of dimensions flagged for "
+          "reduction, ";
+    ss << reducedim_count << ", is not consistent with the destination type ";
+    ss << "reducing " << dst_tp << " with element " << dst_el_tp;
+    throw runtime_error(ss.str());
+  }
+
+  // Reduce the outermost dimension in parallel if requested. Combining the
+  // partial results reuses the reduction kernel with partial results as the
+  // source, so the reduction must be associative, must have matching source
+  // and destination types, and cannot use a separate dst_initialization.
+  if (ectx->nthreads > 1 && kernreq == kernel_request_single &&
+      reduction_dimflags[0] && associative && dst_initialization == NULL &&
+      dst_el_tp == src_el_tp &&
+      (dst_tp.get_flags() & type_flag_blockref) == 0) {
+    intptr_t parallel_ckb_offset = make_parallel_reduction_kernel(
+        elwise_reduction, elwise_reduction_tp, ckb, ckb_offset, dst_tp,
+        dst_arrmeta, src_tp, src_arrmeta, reduction_ndim, reduction_dimflags,
+        keep_dims, reduction_identity, ectx);
+    if (parallel_ckb_offset >= 0) {
+      return parallel_ckb_offset;
+    }
+  }
+
+  return make_lifted_reduction_dims(
+      elwise_reduction, elwise_reduction_tp, dst_initialization,
+      dst_initialization_tp, ckb, ckb_offset, dst_tp, dst_arrmeta, src_tp,
+      src_arrmeta, reduction_ndim, reduction_dimflags, keep_dims,
+      right_associative, reduction_identity, kernreq, ectx);
+}
@@ -379,6 +379,12 @@ static intptr_t instantiate_string_to_option_assignment_kernel(
     return ckb_offset;
   }
   case string_type_id: {
+    if (src_tp[0].get_type_id() == option_type_id) {
+      // An option[string] source may hold NA values, which carry over
+      return instantiate_option_to_option_assignment_kernel(
+          NULL, NULL, ckb, ckb_offset, dst_tp, dst_arrmeta, src_tp,
+          src_arrmeta, kernreq, ectx, kwds);
+    }
     // Just a string to string assignment
     return ::make_assignment_kernel(NULL, NULL,
         ckb, ckb_offset, dst_tp.extended<option_type>()->get_value_type(),
@@ -502,7 +508,7 @@ size_t kernels::make_option_assignment_kernel(
   const arrfunc_type_data *af = afl.get();
   const arrfunc_type *const *af_tp =
       reinterpret_cast<const arrfunc_type *const *>(afl.get_type());
-  map<nd::string, ndt::type> typevars;
+  ndt::typevar_table typevars;
   for (intptr_t i = 0; i < size; ++i, ++af_tp, ++af) {
     typevars.clear();
     if (ndt::pattern_match(src_tp, (*af_tp)->get_arg_type(0), typevars) &&
@@ -125,13 +125,72 @@ nd::arrfunc kernels::make_builtin_sum_reduction_arrfunc(type_id_t tid)
   return af;
 }
 
+namespace {
+/**
+ * The sum1d arrfunc forwards to a lifted sum reduction, and
+ * exists so get_builtin_reduction1d_info can recognize it.
+ */
+struct sum1d_arrfunc_data {
+  type_id_t tid;
+  nd::arrfunc lifted;
+
+  static void free(arrfunc_type_data *self_af)
+  {
+    delete *self_af->get_data_as<sum1d_arrfunc_data *>();
+  }
+
+  static int resolve_dst_type(const arrfunc_type_data *af_self,
+                              const arrfunc_type *DYND_UNUSED(af_tp),
+                              intptr_t nsrc, const ndt::type *src_tp,
+                              int throw_on_error, ndt::type &out_dst_tp,
+                              const nd::array &kwds)
+  {
+    const nd::arrfunc &lifted =
+        (*af_self->get_data_as<sum1d_arrfunc_data *>())->lifted;
+    return lifted.get()->resolve_dst_type(lifted.get(), lifted.get_type(),
+                                          nsrc, src_tp, throw_on_error,
+                                          out_dst_tp, kwds);
+  }
+
+  static intptr_t
+  instantiate(const arrfunc_type_data *af_self,
+              const arrfunc_type *DYND_UNUSED(af_tp), void *ckb,
+              intptr_t ckb_offset, const ndt::type &dst_tp,
+              const char *dst_arrmeta, const ndt::type *src_tp,
+              const char *const *src_arrmeta, kernel_request_t kernreq,
+              const eval::eval_context *ectx, const nd::array &kwds)
+  {
+    const nd::arrfunc &lifted =
+        (*af_self->get_data_as<sum1d_arrfunc_data *>())->lifted;
+    return lifted.get()->instantiate(lifted.get(), lifted.get_type(), ckb,
+                                     ckb_offset, dst_tp, dst_arrmeta, src_tp,
+                                     src_arrmeta, kernreq, ectx, kwds);
+  }
+};
+} // anonymous namespace
+
 nd::arrfunc kernels::make_builtin_sum1d_arrfunc(type_id_t tid)
 {
   nd::arrfunc sum_ew = kernels::make_builtin_sum_reduction_arrfunc(tid);
   bool reduction_dimflags[1] = {true};
-  return lift_reduction_arrfunc(sum_ew, ndt::make_fixed_dimsym(ndt::type(tid)),
-                                nd::array(), false, 1, reduction_dimflags, true,
-                                true, false, 0);
+  nd::arrfunc lifted = lift_reduction_arrfunc(
+      sum_ew, ndt::make_fixed_dimsym(ndt::type(tid)), nd::array(), false, 1,
+      reduction_dimflags, true, true, false, 0);
+
+  nd::array sum1d = nd::empty(lifted.get_array_type());
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(sum1d.get_readwrite_originptr());
+  sum1d_arrfunc_data *data = new sum1d_arrfunc_data;
+  data->tid = tid;
+  data->lifted = lifted;
+  *out_af->get_data_as<sum1d_arrfunc_data *>() = data;
+  out_af->instantiate = &sum1d_arrfunc_data::instantiate;
+  if (lifted.get()->resolve_dst_type != NULL) {
+    out_af->resolve_dst_type = &sum1d_arrfunc_data::resolve_dst_type;
+  }
+  out_af->free = &sum1d_arrfunc_data::free;
+  sum1d.flag_as_immutable();
+  return sum1d;
 }
 
 namespace {
@@ -161,14 +220,84 @@ struct double_mean1d_ck : public kernels::unary_ck<double_mean1d_ck> {
   }
 };
 
-struct mean1d_arrfunc_data {
+struct double_var1d_ck : public kernels::unary_ck<double_var1d_ck> {
+  intptr_t m_minp;
+  intptr_t m_src_dim_size, m_src_stride;
+
+  inline void single(char *dst, char *src)
+  {
+    intptr_t minp = m_minp, countp = 0;
+    intptr_t src_dim_size = m_src_dim_size, src_stride = m_src_stride;
+    // Two passes, first for the mean and then the squared deviations
+    double mean = 0;
+    char *src0 = src;
+    for (intptr_t i = 0; i < src_dim_size; ++i) {
+      double v = *reinterpret_cast<double *>(src0);
+      if (!DYND_ISNAN(v)) {
+        mean += v;
+        ++countp;
+      }
+      src0 += src_stride;
+    }
+    if (countp < minp || countp < 2) {
+      *reinterpret_cast<double *>(dst) = numeric_limits<double>::quiet_NaN();
+      return;
+    }
+    mean /= countp;
+    double result = 0;
+    for (intptr_t i = 0; i < src_dim_size; ++i) {
+      double v = *reinterpret_cast<double *>(src);
+      if (!DYND_ISNAN(v)) {
+        result += (v - mean) * (v - mean);
+      }
+      src += src_stride;
+    }
+    *reinterpret_cast<double *>(dst) = result / (countp - 1);
+  }
+};
+
+template <bool Max>
+struct double_minmax1d_ck : public kernels::unary_ck<double_minmax1d_ck<Max> > {
+  intptr_t m_minp;
+  intptr_t m_src_dim_size, m_src_stride;
+
+  inline void single(char *dst, char *src)
+  {
+    intptr_t minp = m_minp, countp = 0;
+    intptr_t src_dim_size = m_src_dim_size, src_stride = m_src_stride;
+    double result = 0;
+    for (intptr_t i = 0; i < src_dim_size; ++i) {
+      double v = *reinterpret_cast<double *>(src);
+      if (!DYND_ISNAN(v)) {
+        if (countp == 0 || (Max ? (v > result) : (v < result))) {
+          result = v;
+        }
+        ++countp;
+      }
+      src += src_stride;
+    }
+    if (countp >= minp && countp > 0) {
+      *reinterpret_cast<double *>(dst) = result;
+    }
+    else {
+      *reinterpret_cast<double *>(dst) = numeric_limits<double>::quiet_NaN();
+    }
+  }
+};
+
+/**
+ * The data shared by the float64 mean, var, min and max arrfuncs.
+ */
+struct reduction1d_arrfunc_data {
+  kernels::builtin_reduction1d_t kind;
   intptr_t minp;
 
   static void free(arrfunc_type_data *self_af)
   {
-    delete *self_af->get_data_as<mean1d_arrfunc_data *>();
+    delete *self_af->get_data_as<reduction1d_arrfunc_data *>();
   }
 
+  template <class CKT>
   static intptr_t instantiate(
       const arrfunc_type_data *af_self, const arrfunc_type *DYND_UNUSED(af_tp),
       void *ckb, intptr_t ckb_offset, const ndt::type &dst_tp,
@@ -177,8 +306,9 @@ struct mean1d_arrfunc_data {
       const eval::eval_context *DYND_UNUSED(ectx),
       const nd::array &DYND_UNUSED(kwds))
   {
-    typedef double_mean1d_ck self_type;
-    mean1d_arrfunc_data *data = *af_self->get_data_as<mean1d_arrfunc_data *>();
+    typedef CKT self_type;
+    reduction1d_arrfunc_data *data =
+        *af_self->get_data_as<reduction1d_arrfunc_data *>();
     self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
     intptr_t src_dim_size, src_stride;
     ndt::type src_el_tp;
@@ -186,15 +316,15 @@ struct mean1d_arrfunc_data {
     if (!src_tp[0].get_as_strided(src_arrmeta[0], &src_dim_size, &src_stride,
                                   &src_el_tp, &src_el_arrmeta)) {
       stringstream ss;
-      ss << "mean1d: could not process type " << src_tp[0];
+      ss << get_name(data->kind) << ": could not process type " << src_tp[0];
       ss << " as a strided dimension";
       throw type_error(ss.str());
     }
     if (src_el_tp.get_type_id() != float64_type_id ||
         dst_tp.get_type_id() != float64_type_id) {
       stringstream ss;
-      ss << "mean1d: input element type and output type must be "
-            "float64, got " << src_el_tp << " and " << dst_tp;
+      ss << get_name(data->kind) << ": input element type and output type "
+            "must be float64, got " << src_el_tp << " and " << dst_tp;
       throw invalid_argument(ss.str());
     }
     self->m_minp = data->minp;
@@ -209,27 +339,112 @@ struct mean1d_arrfunc_data {
     self->m_src_stride = src_stride;
     return ckb_offset;
   }
+
+  static const char *get_name(kernels::builtin_reduction1d_t kind)
+  {
+    switch (kind) {
+    case kernels::builtin_reduction1d_var:
+      return "var1d";
+    case kernels::builtin_reduction1d_min:
+      return "min1d";
+    case kernels::builtin_reduction1d_max:
+      return "max1d";
+    default:
+      return "mean1d";
+    }
+  }
 };
 } // anonymous namespace
 
-nd::arrfunc kernels::make_builtin_mean1d_arrfunc(type_id_t tid, intptr_t minp)
+static nd::arrfunc
+make_builtin_reduction1d_arrfunc(kernels::builtin_reduction1d_t kind,
+                                 type_id_t tid, intptr_t minp)
 {
   if (tid != float64_type_id) {
     stringstream ss;
-    ss << "make_builtin_mean1d_arrfunc: data type ";
+    ss << "make_builtin_" << reduction1d_arrfunc_data::get_name(kind)
+       << "_arrfunc: data type ";
     ss << ndt::type(tid) << " is not supported";
     throw type_error(ss.str());
   }
-  nd::array mean1d = nd::empty(
+  nd::array af = nd::empty(
       ndt::make_funcproto(ndt::make_fixed_dimsym(ndt::make_type<double>()),
                           ndt::make_type<double>()));
   arrfunc_type_data *out_af =
-      reinterpret_cast<arrfunc_type_data *>(mean1d.get_readwrite_originptr());
-  mean1d_arrfunc_data *data = new mean1d_arrfunc_data;
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  reduction1d_arrfunc_data *data = new reduction1d_arrfunc_data;
+  data->kind = kind;
   data->minp = minp;
-  *out_af->get_data_as<mean1d_arrfunc_data *>() = data;
-  out_af->instantiate = &mean1d_arrfunc_data::instantiate;
-  out_af->free = &mean1d_arrfunc_data::free;
-  mean1d.flag_as_immutable();
-  return mean1d;
+  *out_af->get_data_as<reduction1d_arrfunc_data *>() = data;
+  switch (kind) {
+  case kernels::builtin_reduction1d_var:
+    out_af->instantiate =
+        &reduction1d_arrfunc_data::instantiate<double_var1d_ck>;
+    break;
+  case kernels::builtin_reduction1d_min:
+    out_af->instantiate =
+        &reduction1d_arrfunc_data::instantiate<double_minmax1d_ck<false> >;
+    break;
+  case kernels::builtin_reduction1d_max:
+    out_af->instantiate =
+        &reduction1d_arrfunc_data::instantiate<double_minmax1d_ck<true> >;
+    break;
+  default:
+    out_af->instantiate =
+        &reduction1d_arrfunc_data::instantiate<double_mean1d_ck>;
+    break;
+  }
+  out_af->free = &reduction1d_arrfunc_data::free;
+  af.flag_as_immutable();
+  return af;
+}
+
+nd::arrfunc kernels::make_builtin_mean1d_arrfunc(type_id_t tid, intptr_t minp)
+{
+  return make_builtin_reduction1d_arrfunc(kernels::builtin_reduction1d_mean,
+                                          tid, minp);
+}
+
+nd::arrfunc kernels::make_builtin_var1d_arrfunc(type_id_t tid, intptr_t minp)
+{
+  return make_builtin_reduction1d_arrfunc(kernels::builtin_reduction1d_var,
+                                          tid, minp);
+}
+
+nd::arrfunc kernels::make_builtin_min1d_arrfunc(type_id_t tid, intptr_t minp)
+{
+  return make_builtin_reduction1d_arrfunc(kernels::builtin_reduction1d_min,
+                                          tid, minp);
+}
+
+nd::arrfunc kernels::make_builtin_max1d_arrfunc(type_id_t tid, intptr_t minp)
+{
+  return make_builtin_reduction1d_arrfunc(kernels::builtin_reduction1d_max,
+                                          tid, minp);
+}
+
+bool kernels::get_builtin_reduction1d_info(const nd::arrfunc &af,
+                                           builtin_reduction1d_info &out_info)
+{
+  const arrfunc_type_data *af_data = af.get();
+  if (af_data == NULL) {
+    return false;
+  }
+  else if (af_data->free == &sum1d_arrfunc_data::free) {
+    const sum1d_arrfunc_data *data =
+        *af_data->get_data_as<sum1d_arrfunc_data *>();
+    out_info.kind = kernels::builtin_reduction1d_sum;
+    out_info.tid = data->tid;
+    out_info.minp = 0;
+    return true;
+  }
+  else if (af_data->free == &reduction1d_arrfunc_data::free) {
+    const reduction1d_arrfunc_data *data =
+        *af_data->get_data_as<reduction1d_arrfunc_data *>();
+    out_info.kind = data->kind;
+    out_info.tid = float64_type_id;
+    out_info.minp = data->minp;
+    return true;
+  }
+  return false;
 }
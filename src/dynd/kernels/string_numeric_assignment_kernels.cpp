@@ -129,16 +129,12 @@ static void raise_string_cast_overflow_error(const ndt::type &dst_tp,
     throw overflow_error(ss.str());
 }
 
-static void string_to_bool_single(char *dst, char *const *src,
-                                  ckernel_prefix *extra)
+static void string_to_bool_convert(char *dst, const char *begin,
+                                   const char *end,
+                                   const string_to_builtin_kernel_extra *e,
+                                   const char *DYND_UNUSED(src))
 {
-    string_to_builtin_kernel_extra *e =
-        reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    // Get the string from the source
-    string s =
-        e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-    trim(s);
-    parse::string_to_bool(dst, s.data(), s.data() + s.size(), false, e->errmode);
+    parse::string_to_bool(dst, begin, end, false, e->errmode);
 }
 
 template <class T> struct overflow_check;
@@ -173,36 +169,33 @@ template <> struct overflow_check<uint64_t> { inline static bool is_overflow(uin
 }};
 
 namespace { template<typename T> struct string_to_int {
-    static void single(char *dst, char *const *src, 
-                        ckernel_prefix *extra)
+    static void convert(char *dst, const char *begin, const char *end,
+                        const string_to_builtin_kernel_extra *e,
+                        const char *src)
     {
-        string_to_builtin_kernel_extra *e = reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-        string s = e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-        trim(s);
         bool negative = false;
-        if (!s.empty() && s[0] == '-') {
-            s.erase(0, 1);
+        if (begin < end && *begin == '-') {
+            ++begin;
             negative = true;
         }
         T result;
         if (e->errmode == assign_error_nocheck) {
-            uint64_t value = parse::unchecked_string_to_uint64(
-                s.data(), s.data() + s.size());
+            uint64_t value = parse::unchecked_string_to_uint64(begin, end);
             result = negative ? static_cast<T>(-static_cast<int64_t>(value))
                               : static_cast<T>(value);
         } else {
             bool overflow = false, badparse = false;
             uint64_t value = parse::checked_string_to_uint64(
-                s.data(), s.data() + s.size(), overflow, badparse);
+                begin, end, overflow, badparse);
             if (badparse) {
                 raise_string_cast_error(ndt::make_type<T>(),
                                         ndt::type(e->src_string_tp, true),
-                                        e->src_arrmeta, src[0]);
+                                        e->src_arrmeta, src);
             } else if (overflow ||
                        overflow_check<T>::is_overflow(value, negative)) {
                 raise_string_cast_overflow_error(
                     ndt::make_type<T>(), ndt::type(e->src_string_tp, true),
-                    e->src_arrmeta, src[0]);
+                    e->src_arrmeta, src);
             }
             result = negative ? static_cast<T>(-static_cast<int64_t>(value))
                               : static_cast<T>(value);
@@ -212,35 +205,32 @@ namespace { template<typename T> struct string_to_int {
 };}
 
 namespace { template<typename T> struct string_to_uint {
-    static void single(char *dst, char *const *src, 
-                        ckernel_prefix *extra)
+    static void convert(char *dst, const char *begin, const char *end,
+                        const string_to_builtin_kernel_extra *e,
+                        const char *src)
     {
-        string_to_builtin_kernel_extra *e = reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-        string s = e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-        trim(s);
         bool negative = false;
-        if (!s.empty() && s[0] == '-') {
-            s.erase(0, 1);
+        if (begin < end && *begin == '-') {
+            ++begin;
             negative = true;
         }
         T result;
         if (e->errmode == assign_error_nocheck) {
-            uint64_t value = parse::unchecked_string_to_uint64(
-                s.data(), s.data() + s.size());
+            uint64_t value = parse::unchecked_string_to_uint64(begin, end);
             result = negative ? static_cast<T>(0) : static_cast<T>(value);
         } else {
             bool overflow = false, badparse = false;
             uint64_t value = parse::checked_string_to_uint64(
-                s.data(), s.data() + s.size(), overflow, badparse);
+                begin, end, overflow, badparse);
             if (badparse) {
                 raise_string_cast_error(ndt::make_type<T>(),
                                         ndt::type(e->src_string_tp, true),
-                                        e->src_arrmeta, src[0]);
+                                        e->src_arrmeta, src);
             } else if (overflow || (negative && value != 0) ||
                        overflow_check<T>::is_overflow(value)) {
                 raise_string_cast_overflow_error(
                     ndt::make_type<T>(), ndt::type(e->src_string_tp, true),
-                    e->src_arrmeta, src[0]);
+                    e->src_arrmeta, src);
             }
             result = static_cast<T>(value);
         }
@@ -248,37 +238,33 @@ namespace { template<typename T> struct string_to_uint {
     }
 };}
 
-static void string_to_int128_single(char *dst, char *const *src,
-                                    ckernel_prefix *extra)
+static void string_to_int128_convert(char *dst, const char *begin,
+                                     const char *end,
+                                     const string_to_builtin_kernel_extra *e,
+                                     const char *src)
 {
-    string_to_builtin_kernel_extra *e =
-        reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    string s =
-        e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-    trim(s);
     bool negative = false;
-    if (!s.empty() && s[0] == '-') {
-        s.erase(0, 1);
+    if (begin < end && *begin == '-') {
+        ++begin;
         negative = true;
     }
     dynd_int128 result;
     if (e->errmode == assign_error_nocheck) {
-        dynd_uint128 value =
-            parse::unchecked_string_to_uint128(s.data(), s.data() + s.size());
+        dynd_uint128 value = parse::unchecked_string_to_uint128(begin, end);
         result = negative ? static_cast<dynd_int128>(0) : static_cast<dynd_int128>(value);
     } else {
         bool overflow = false, badparse = false;
         dynd_uint128 value = parse::checked_string_to_uint128(
-            s.data(), s.data() + s.size(), overflow, badparse);
+            begin, end, overflow, badparse);
         if (badparse) {
             raise_string_cast_error(ndt::make_type<dynd_int128>(),
                                     ndt::type(e->src_string_tp, true),
-                                    e->src_arrmeta, src[0]);
+                                    e->src_arrmeta, src);
         } else if (overflow ||
                    overflow_check<dynd_int128>::is_overflow(value, negative)) {
             raise_string_cast_overflow_error(ndt::make_type<dynd_int128>(),
                                              ndt::type(e->src_string_tp, true),
-                                             e->src_arrmeta, src[0]);
+                                             e->src_arrmeta, src);
         }
         result = negative ? -static_cast<dynd_int128>(value)
                           : static_cast<dynd_int128>(value);
@@ -286,51 +272,42 @@ static void string_to_int128_single(char *dst, char *const *src,
     *reinterpret_cast<dynd_int128 *>(dst) = result;
 }
 
-static void string_to_uint128_single(char *dst, char *const *src,
-                                     ckernel_prefix *extra)
+static void string_to_uint128_convert(char *dst, const char *begin,
+                                      const char *end,
+                                      const string_to_builtin_kernel_extra *e,
+                                      const char *src)
 {
-    string_to_builtin_kernel_extra *e =
-        reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    string s =
-        e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-    trim(s);
     bool negative = false;
-    if (!s.empty() && s[0] == '-') {
-        s.erase(0, 1);
+    if (begin < end && *begin == '-') {
+        ++begin;
         negative = true;
     }
     dynd_int128 result;
     if (e->errmode == assign_error_nocheck) {
-        result =
-            parse::unchecked_string_to_uint128(s.data(), s.data() + s.size());
+        result = parse::unchecked_string_to_uint128(begin, end);
     } else {
         bool overflow = false, badparse = false;
         result = parse::checked_string_to_uint128(
-            s.data(), s.data() + s.size(), overflow, badparse);
+            begin, end, overflow, badparse);
         if (badparse) {
             raise_string_cast_error(ndt::make_type<dynd_int128>(),
                                     ndt::type(e->src_string_tp, true),
-                                    e->src_arrmeta, src[0]);
+                                    e->src_arrmeta, src);
         } else if (overflow || (negative && result != 0)) {
             raise_string_cast_overflow_error(ndt::make_type<dynd_uint128>(),
                                              ndt::type(e->src_string_tp, true),
-                                             e->src_arrmeta, src[0]);
+                                             e->src_arrmeta, src);
         }
     }
     *reinterpret_cast<dynd_uint128 *>(dst) = result;
 }
 
-static void string_to_float32_single(char *dst, char *const *src,
-                                     ckernel_prefix *extra)
+static void string_to_float32_convert(char *dst, const char *begin,
+                                      const char *end,
+                                      const string_to_builtin_kernel_extra *e,
+                                      const char *DYND_UNUSED(src))
 {
-    string_to_builtin_kernel_extra *e =
-        reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    // Get the string from the source
-    string s =
-        e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-    trim(s);
-    double value = parse::checked_string_to_float64(
-        s.data(), s.data() + s.size(), e->errmode);
+    double value = parse::checked_string_to_float64(begin, end, e->errmode);
     // Assign double -> float according to the error mode
     switch (e->errmode) {
         case assign_error_nocheck:
@@ -356,72 +333,144 @@ static void string_to_float32_single(char *dst, char *const *src,
     }
 }
 
-static void string_to_float64_single(char *dst, char *const *src,
-                        ckernel_prefix *extra)
+static void string_to_float64_convert(char *dst, const char *begin,
+                                      const char *end,
+                                      const string_to_builtin_kernel_extra *e,
+                                      const char *DYND_UNUSED(src))
 {
-    string_to_builtin_kernel_extra *e = reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    // Get the string from the source
-    string s =
-        e->src_string_tp->get_utf8_string(e->src_arrmeta, src[0], e->errmode);
-    trim(s);
-    double value = parse::checked_string_to_float64(
-        s.data(), s.data() + s.size(), e->errmode);
+    double value = parse::checked_string_to_float64(begin, end, e->errmode);
     *reinterpret_cast<double *>(dst) = value;
 }
 
-static void string_to_float16_single(char *dst, char *const *src,
-                        ckernel_prefix *extra)
+static void string_to_float16_convert(char *dst, const char *begin,
+                                      const char *end,
+                                      const string_to_builtin_kernel_extra *e,
+                                      const char *DYND_UNUSED(src))
 {
-    string_to_builtin_kernel_extra *e =
-        reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
-    double tmp;
-    string_to_float64_single(reinterpret_cast<char *>(&tmp), src, extra);
-    *reinterpret_cast<dynd_float16 *>(dst) = dynd_float16(tmp, e->errmode);
+    double value = parse::checked_string_to_float64(begin, end, e->errmode);
+    *reinterpret_cast<dynd_float16 *>(dst) = dynd_float16(value, e->errmode);
 }
 
-static void string_to_float128_single(char *DYND_UNUSED(dst),
-                                      char *const *DYND_UNUSED(src),
-                                      ckernel_prefix *DYND_UNUSED(self))
+static void string_to_float128_convert(char *DYND_UNUSED(dst),
+                        const char *DYND_UNUSED(begin),
+                        const char *DYND_UNUSED(end),
+                        const string_to_builtin_kernel_extra *DYND_UNUSED(e),
+                        const char *DYND_UNUSED(src))
 {
     throw std::runtime_error("TODO: implement string_to_float128_single");
 }
 
-static void
-string_to_complex_float32_single(char *DYND_UNUSED(dst),
-                                 char *const *DYND_UNUSED(src),
-                                 ckernel_prefix *DYND_UNUSED(self))
+static void string_to_complex_float32_convert(char *DYND_UNUSED(dst),
+                        const char *DYND_UNUSED(begin),
+                        const char *DYND_UNUSED(end),
+                        const string_to_builtin_kernel_extra *DYND_UNUSED(e),
+                        const char *DYND_UNUSED(src))
 {
     throw std::runtime_error("TODO: implement string_to_complex_float32_single");
 }
 
-static void
-string_to_complex_float64_single(char *DYND_UNUSED(dst),
-                                 char *const *DYND_UNUSED(src),
-                                 ckernel_prefix *DYND_UNUSED(self))
+static void string_to_complex_float64_convert(char *DYND_UNUSED(dst),
+                        const char *DYND_UNUSED(begin),
+                        const char *DYND_UNUSED(end),
+                        const string_to_builtin_kernel_extra *DYND_UNUSED(e),
+                        const char *DYND_UNUSED(src))
 {
     throw std::runtime_error("TODO: implement string_to_complex_float64_single");
 }
 
-static expr_single_t static_string_to_builtin_kernels[builtin_type_id_count-2] = {
-        &string_to_bool_single,
-        &string_to_int<int8_t>::single,
-        &string_to_int<int16_t>::single,
-        &string_to_int<int32_t>::single,
-        &string_to_int<int64_t>::single,
-        &string_to_int128_single,
-        &string_to_uint<uint8_t>::single,
-        &string_to_uint<uint16_t>::single,
-        &string_to_uint<uint32_t>::single,
-        &string_to_uint<uint64_t>::single,
-        &string_to_uint128_single,
-        &string_to_float16_single,
-        &string_to_float32_single,
-        &string_to_float64_single,
-        &string_to_float128_single,
-        &string_to_complex_float32_single,
-        &string_to_complex_float64_single
+namespace {
+    typedef void (*string_convert_t)(char *dst, const char *begin,
+                                     const char *end,
+                                     const string_to_builtin_kernel_extra *e,
+                                     const char *src);
+
+    /**
+     * Kernels for any string type, which go through a trimmed
+     * UTF-8 copy of the string.
+     */
+    template <string_convert_t Convert>
+    struct string_to_builtin_ck {
+        static void single(char *dst, char *const *src, ckernel_prefix *extra)
+        {
+            string_to_builtin_kernel_extra *e =
+                reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
+            // Get the string from the source
+            string s = e->src_string_tp->get_utf8_string(e->src_arrmeta,
+                                                         src[0], e->errmode);
+            trim(s);
+            Convert(dst, s.data(), s.data() + s.size(), e, src[0]);
+        }
     };
 
+    /**
+     * Kernels for the UTF-8 or ASCII string type, which parse the string
+     * data in place. The strided version lets a whole column of strings be
+     * converted in one call, without a copy per element.
+     */
+    template <string_convert_t Convert>
+    struct utf8_string_to_builtin_ck {
+        static inline void convert(char *dst, const char *src,
+                                   const string_to_builtin_kernel_extra *e)
+        {
+            const string_type_data *sd =
+                reinterpret_cast<const string_type_data *>(src);
+            const char *begin = trim_begin<const char *>(sd->begin, sd->end);
+            const char *end = trim_end<const char *>(begin, sd->end);
+            Convert(dst, begin, end, e, src);
+        }
+
+        static void single(char *dst, char *const *src, ckernel_prefix *extra)
+        {
+            convert(dst, src[0],
+                    reinterpret_cast<string_to_builtin_kernel_extra *>(extra));
+        }
+
+        static void strided(char *dst, intptr_t dst_stride, char *const *src,
+                            const intptr_t *src_stride, size_t count,
+                            ckernel_prefix *extra)
+        {
+            const string_to_builtin_kernel_extra *e =
+                reinterpret_cast<string_to_builtin_kernel_extra *>(extra);
+            const char *src0 = src[0];
+            intptr_t src0_stride = src_stride[0];
+            for (size_t i = 0; i != count; ++i) {
+                convert(dst, src0, e);
+                dst += dst_stride;
+                src0 += src0_stride;
+            }
+        }
+    };
+} // anonymous namespace
+
+#define DYND_STRING_TO_BUILTIN_KERNELS(CK, MEMBER) { \
+        &CK<&string_to_bool_convert>::MEMBER, \
+        &CK<&string_to_int<int8_t>::convert>::MEMBER, \
+        &CK<&string_to_int<int16_t>::convert>::MEMBER, \
+        &CK<&string_to_int<int32_t>::convert>::MEMBER, \
+        &CK<&string_to_int<int64_t>::convert>::MEMBER, \
+        &CK<&string_to_int128_convert>::MEMBER, \
+        &CK<&string_to_uint<uint8_t>::convert>::MEMBER, \
+        &CK<&string_to_uint<uint16_t>::convert>::MEMBER, \
+        &CK<&string_to_uint<uint32_t>::convert>::MEMBER, \
+        &CK<&string_to_uint<uint64_t>::convert>::MEMBER, \
+        &CK<&string_to_uint128_convert>::MEMBER, \
+        &CK<&string_to_float16_convert>::MEMBER, \
+        &CK<&string_to_float32_convert>::MEMBER, \
+        &CK<&string_to_float64_convert>::MEMBER, \
+        &CK<&string_to_float128_convert>::MEMBER, \
+        &CK<&string_to_complex_float32_convert>::MEMBER, \
+        &CK<&string_to_complex_float64_convert>::MEMBER \
+    }
+
+static expr_single_t static_string_to_builtin_kernels[builtin_type_id_count-2] =
+    DYND_STRING_TO_BUILTIN_KERNELS(string_to_builtin_ck, single);
+static expr_single_t static_utf8_string_to_builtin_single_kernels[builtin_type_id_count-2] =
+    DYND_STRING_TO_BUILTIN_KERNELS(utf8_string_to_builtin_ck, single);
+static expr_strided_t static_utf8_string_to_builtin_strided_kernels[builtin_type_id_count-2] =
+    DYND_STRING_TO_BUILTIN_KERNELS(utf8_string_to_builtin_ck, strided);
+
+#undef DYND_STRING_TO_BUILTIN_KERNELS
+
 size_t dynd::make_string_to_builtin_assignment_kernel(
     void *ckb, intptr_t ckb_offset, type_id_t dst_type_id,
     const ndt::type &src_string_tp, const char *src_arrmeta,
@@ -435,12 +484,30 @@ size_t dynd::make_string_to_builtin_assignment_kernel(
     }
 
     if (dst_type_id >= bool_type_id && dst_type_id <= complex_float64_type_id) {
-        ckb_offset =
-            make_kernreq_to_single_kernel_adapter(ckb, ckb_offset, 1, kernreq);
+        // The UTF-8 string type can be parsed in place, with a
+        // strided kernel, other string types are converted first
+        string_encoding_t encoding =
+            src_string_tp.extended<base_string_type>()->get_encoding();
+        bool in_place = src_string_tp.get_type_id() == string_type_id &&
+                        (encoding == string_encoding_utf_8 ||
+                         encoding == string_encoding_ascii);
+        if (!in_place) {
+            ckb_offset = make_kernreq_to_single_kernel_adapter(ckb, ckb_offset,
+                                                               1, kernreq);
+            kernreq = kernel_request_single;
+        }
         string_to_builtin_kernel_extra *e =
             reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->alloc_ck<string_to_builtin_kernel_extra>(ckb_offset);
-        e->base.set_function<expr_single_t>(
-            static_string_to_builtin_kernels[dst_type_id - bool_type_id]);
+        if (in_place) {
+            e->base.set_expr_function(
+                kernreq, static_utf8_string_to_builtin_single_kernels
+                             [dst_type_id - bool_type_id],
+                static_utf8_string_to_builtin_strided_kernels
+                    [dst_type_id - bool_type_id]);
+        } else {
+            e->base.set_function<expr_single_t>(
+                static_string_to_builtin_kernels[dst_type_id - bool_type_id]);
+        }
         e->base.destructor = &string_to_builtin_kernel_extra::destruct;
         // The kernel data owns this reference
         e->src_string_tp = static_cast<const base_string_type *>(
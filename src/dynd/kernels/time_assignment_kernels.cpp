@@ -6,6 +6,7 @@
 #include <dynd/kernels/time_assignment_kernels.hpp>
 #include <dynd/kernels/assignment_kernels.hpp>
 #include <dynd/types/cstruct_type.hpp>
+#include <dynd/types/datetime_layout.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -15,20 +16,20 @@ using namespace dynd;
 
 namespace {
     struct string_to_time_ck : public kernels::unary_ck<string_to_time_ck> {
-        ndt::type m_src_string_tp;
-        const char *m_src_arrmeta;
-        assign_error_mode m_errmode;
+        datetime_string_source m_src;
 
         inline void single(char *dst, const char *src)
         {
-            const base_string_type *bst = static_cast<const base_string_type *>(m_src_string_tp.extended());
-            const string& s = bst->get_utf8_string(m_src_arrmeta, src, m_errmode);
+            const char *begin, *end;
+            string s;
             time_hmst hmst;
-            // TODO: properly distinguish "time" and "option[time]" with respect to NA support
-            if (s == "NA") {
+            if (m_src.get_range(src, begin, end, s)) {
+                // TODO: properly distinguish "time" and "option[time]" with respect to NA support
                 hmst.set_to_na();
-            } else {
-                hmst.set_from_str(s);
+            } else if (!m_src.layout.parse_time(begin, end, hmst)) {
+                const char *tz_begin = NULL, *tz_end = NULL;
+                hmst.set_from_str(begin, end, tz_begin, tz_end);
+                m_src.detect(begin, end);
             }
             *reinterpret_cast<int64_t *>(dst) = hmst.to_ticks();
         }
@@ -50,9 +51,8 @@ size_t dynd::make_string_to_time_assignment_kernel(
     }
 
     self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
-    self->m_src_string_tp = src_string_tp;
-    self->m_src_arrmeta = src_arrmeta;
-    self->m_errmode = ectx->errmode;
+    self->m_src.init(src_string_tp, src_arrmeta, ectx->errmode,
+                     datetime_string_source::time_kind);
     return ckb_offset;
 }
 
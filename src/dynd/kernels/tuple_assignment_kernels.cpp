@@ -25,12 +25,25 @@ struct tuple_unary_op_item {
 };
 
 struct tuple_unary_op_ck : public kernels::unary_ck<tuple_unary_op_ck> {
-  vector<tuple_unary_op_item> m_fields;
+  intptr_t m_field_count;
+  // After this are m_field_count tuple_unary_op_item, one per field
+
+  tuple_unary_op_ck(intptr_t field_count) : m_field_count(field_count) {}
+
+  inline const tuple_unary_op_item *get_fields() const
+  {
+    return reinterpret_cast<const tuple_unary_op_item *>(this + 1);
+  }
+
+  inline tuple_unary_op_item *get_fields()
+  {
+    return reinterpret_cast<tuple_unary_op_item *>(this + 1);
+  }
 
   inline void single(char *dst, char *src)
   {
-    const tuple_unary_op_item *fi = &m_fields[0];
-    intptr_t field_count = m_fields.size();
+    const tuple_unary_op_item *fi = get_fields();
+    intptr_t field_count = m_field_count;
     ckernel_prefix *child;
     expr_single_t child_fn;
 
@@ -43,12 +56,51 @@ struct tuple_unary_op_ck : public kernels::unary_ck<tuple_unary_op_ck> {
     }
   }
 
+  inline void strided(char *dst, intptr_t dst_stride, char *src,
+                      intptr_t src_stride, size_t count)
+  {
+    // The child ckernels are strided, so each field is assigned as a
+    // column, a chunk of elements at a time to keep them in cache
+    const tuple_unary_op_item *fi = get_fields();
+    intptr_t field_count = m_field_count;
+    while (count > 0) {
+      size_t chunk_size = min(count, (size_t)DYND_BUFFER_CHUNK_SIZE);
+      for (intptr_t i = 0; i < field_count; ++i) {
+        const tuple_unary_op_item &item = fi[i];
+        ckernel_prefix *child = get_child_ckernel(item.child_kernel_offset);
+        expr_strided_t child_fn = child->get_function<expr_strided_t>();
+        char *child_src = src + item.src_data_offset;
+        child_fn(dst + item.dst_data_offset, dst_stride, &child_src,
+                 &src_stride, chunk_size, child);
+      }
+      dst += chunk_size * dst_stride;
+      src += chunk_size * src_stride;
+      count -= chunk_size;
+    }
+  }
+
   inline void destruct_children()
   {
-    for (size_t i = 0; i < m_fields.size(); ++i) {
-      base.destroy_child_ckernel(m_fields[i].child_kernel_offset);
+    const tuple_unary_op_item *fi = get_fields();
+    for (intptr_t i = 0; i < m_field_count; ++i) {
+      base.destroy_child_ckernel(fi[i].child_kernel_offset);
     }
   }
+
+  /**
+   * Creates the ckernel with room after it for the fields, and
+   * increments ``inout_ckb_offset`` to the position after them.
+   */
+  static void create_with_fields(void *ckb, kernel_request_t kernreq,
+                                 intptr_t &inout_ckb_offset,
+                                 intptr_t field_count)
+  {
+    create(ckb, kernreq, inout_ckb_offset, field_count);
+    kernels::inc_ckb_offset(inout_ckb_offset,
+                            field_count * sizeof(tuple_unary_op_item));
+    reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+        ->ensure_capacity(inout_ckb_offset);
+  }
 };
 } // anonymous namespace
 
@@ -61,18 +113,18 @@ intptr_t dynd::make_tuple_unary_op_ckernel(
     kernel_request_t kernreq, const eval::eval_context *ectx)
 {
   intptr_t root_ckb_offset = ckb_offset;
-  tuple_unary_op_ck *self = tuple_unary_op_ck::create(ckb, kernreq, ckb_offset);
-  self->m_fields.resize(field_count);
+  tuple_unary_op_ck::create_with_fields(ckb, kernreq, ckb_offset, field_count);
   for (intptr_t i = 0; i < field_count; ++i) {
     reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->ensure_capacity(ckb_offset);
-    self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->get_at<tuple_unary_op_ck>(root_ckb_offset);
-    tuple_unary_op_item &field = self->m_fields[i];
+    tuple_unary_op_ck *self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->get_at<tuple_unary_op_ck>(root_ckb_offset);
+    tuple_unary_op_item &field = self->get_fields()[i];
     field.child_kernel_offset = ckb_offset - root_ckb_offset;
     field.dst_data_offset = dst_offsets[i];
     field.src_data_offset = src_offsets[i];
+    // The children are single or strided to match this ckernel
     ckb_offset = af->instantiate(
         af, af_tp, ckb, ckb_offset, dst_tp[i], dst_arrmeta[i], &src_tp[i],
-        &src_arrmeta[i], kernel_request_single, ectx, nd::array());
+        &src_arrmeta[i], kernreq, ectx, nd::array());
   }
   return ckb_offset;
 }
@@ -86,18 +138,17 @@ intptr_t dynd::make_tuple_unary_op_ckernel(
     kernel_request_t kernreq, const eval::eval_context *ectx)
 {
   intptr_t root_ckb_offset = ckb_offset;
-  tuple_unary_op_ck *self = tuple_unary_op_ck::create(ckb, kernreq, ckb_offset);
-  self->m_fields.resize(field_count);
+  tuple_unary_op_ck::create_with_fields(ckb, kernreq, ckb_offset, field_count);
   for (intptr_t i = 0; i < field_count; ++i) {
     reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->ensure_capacity(ckb_offset);
-    self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->get_at<tuple_unary_op_ck>(root_ckb_offset);
-    tuple_unary_op_item &field = self->m_fields[i];
+    tuple_unary_op_ck *self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)->get_at<tuple_unary_op_ck>(root_ckb_offset);
+    tuple_unary_op_item &field = self->get_fields()[i];
     field.child_kernel_offset = ckb_offset - root_ckb_offset;
     field.dst_data_offset = dst_offsets[i];
     field.src_data_offset = src_offsets[i];
     ckb_offset = af[i]->instantiate(
         af[i], af_tp[i], ckb, ckb_offset, dst_tp[i], dst_arrmeta[i], &src_tp[i],
-        &src_arrmeta[i], kernel_request_single, ectx, nd::array());
+        &src_arrmeta[i], kernreq, ectx, nd::array());
   }
   return ckb_offset;
 }
@@ -8,6 +8,10 @@
 #include <cstdlib>
 #include <algorithm>
 #include <limits>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #ifdef WIN32
 # define NOMINMAX
@@ -63,13 +67,65 @@ static void clip_begin_end(intptr_t size, intptr_t& begin, intptr_t& end)
     }
 }
 
+static void validate_hints(uint32_t hints)
+{
+    if ((hints & ~(uint32_t)(memmap_hint_sequential | memmap_hint_random |
+                             memmap_hint_willneed | memmap_hint_populate |
+                             memmap_hint_hugepages)) != 0) {
+        stringstream ss;
+        ss << "invalid memmap hint flags 0x" << hex << hints;
+        throw runtime_error(ss.str());
+    }
+    if ((hints & memmap_hint_sequential) && (hints & memmap_hint_random)) {
+        throw runtime_error("memmap hints sequential and random cannot be combined");
+    }
+}
+
+static intptr_t get_page_size()
+{
+#ifdef WIN32
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return sysInfo.dwPageSize;
+#else
+    static const intptr_t page_size = sysconf(_SC_PAGE_SIZE);
+    return page_size;
+#endif
+}
+
+#ifndef WIN32
+/**
+ * Passes the hints to madvise for a page aligned range. The advice
+ * is only advice, so failures (e.g. huge pages disabled) are ignored.
+ */
+static void advise_pages(char *begin, intptr_t size, uint32_t hints)
+{
+    if (size <= 0) {
+        return;
+    }
+    if (hints & memmap_hint_sequential) {
+        (void)madvise(begin, size, MADV_SEQUENTIAL);
+    } else if (hints & memmap_hint_random) {
+        (void)madvise(begin, size, MADV_RANDOM);
+    }
+#ifdef MADV_HUGEPAGE
+    if (hints & memmap_hint_hugepages) {
+        (void)madvise(begin, size, MADV_HUGEPAGE);
+    }
+#endif
+    if (hints & memmap_hint_willneed) {
+        (void)madvise(begin, size, MADV_WILLNEED);
+    }
+}
+#endif
+
 namespace {
     struct memmap_memory_block {
         /** Every memory block object needs this at the front */
         memory_block_data m_mbd;
         // Parameters used to construct the memory block
         string m_filename;
-        uint32_t m_access;
+        uint32_t m_access, m_hints;
         intptr_t m_begin, m_end;
         // Handle to the mapped memory
 #ifdef WIN32
@@ -85,9 +141,9 @@ namespace {
 
         memmap_memory_block(const std::string& filename,
                     uint32_t access, char **out_pointer, intptr_t *out_size,
-                    intptr_t begin, intptr_t end)
+                    intptr_t begin, intptr_t end, uint32_t hints)
             : m_mbd(1, memmap_memory_block_type), m_filename(filename),
-                m_access(access), m_begin(begin), m_end(end)
+                m_access(access), m_hints(hints), m_begin(begin), m_end(end)
         {
             bool readwrite = ((access & nd::write_access_flag) ==
                               nd::write_access_flag);
@@ -194,14 +250,26 @@ namespace {
             m_begin = begin;
             m_end = end;
 
-            intptr_t pageSize = sysconf(_SC_PAGE_SIZE);
+            intptr_t pageSize = get_page_size();
             intptr_t mapbegin = (begin / pageSize) * pageSize;
             m_mapOffset = begin - mapbegin;
             intptr_t mapsize = end - mapbegin;
 
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (hints & memmap_hint_populate) {
+                flags |= MAP_POPULATE;
+                hints &= ~memmap_hint_populate;
+            }
+#endif
+            // Without MAP_POPULATE, fall back to asking for the pages
+            // to be read in
+            if (hints & memmap_hint_populate) {
+                hints |= memmap_hint_willneed;
+            }
             m_mapPointer = (char *)mmap(NULL, mapsize,
                 PROT_READ|(readwrite ? PROT_WRITE : 0),
-                MAP_SHARED, m_fd, mapbegin);
+                flags, m_fd, mapbegin);
             if (m_mapPointer == (char *)MAP_FAILED) {
                 close(m_fd);
                 stringstream ss;
@@ -209,6 +277,7 @@ namespace {
                    << "\" for memory mapping";
                 throw runtime_error(ss.str());
             }
+            advise_pages(m_mapPointer, mapsize, hints);
 
             *out_pointer = m_mapPointer + m_mapOffset;
             *out_size = end - begin;
@@ -232,13 +301,169 @@ namespace {
 
 memory_block_ptr dynd::make_memmap_memory_block(const std::string& filename,
     uint32_t access, char **out_pointer, intptr_t *out_size,
-    intptr_t begin, intptr_t end)
+    intptr_t begin, intptr_t end, uint32_t hints)
 {
+    validate_hints(hints);
     memmap_memory_block *pmb = new memmap_memory_block(
-        filename, access, out_pointer, out_size, begin, end);
+        filename, access, out_pointer, out_size, begin, end, hints);
     return memory_block_ptr(reinterpret_cast<memory_block_data *>(pmb), false);
 }
 
+void dynd::memmap_advise(const char *begin, const char *end, uint32_t hints)
+{
+    validate_hints(hints);
+#ifndef WIN32
+    if (end <= begin) {
+        return;
+    }
+    intptr_t pageSize = get_page_size();
+    char *pagebegin = (char *)((uintptr_t)begin & ~(uintptr_t)(pageSize - 1));
+    // MAP_POPULATE only exists at mmap time, the nearest advice is willneed
+    if (hints & memmap_hint_populate) {
+        hints |= memmap_hint_willneed;
+    }
+    advise_pages(pagebegin, end - pagebegin, hints);
+#else
+    (void)begin;
+    (void)end;
+#endif
+}
+
+struct dynd::memmap_prefetcher::state {
+    const char *m_origin;
+    intptr_t m_stride, m_count, m_element_size, m_lookahead;
+    intptr_t m_page_size;
+    // The element the scan has reached, as of the last notification
+    atomic<intptr_t> m_position;
+    // Elements [0, m_prefetched) have been touched
+    intptr_t m_prefetched;
+    bool m_shutdown;
+    // Lets the thread stop in the middle of a window
+    atomic<bool> m_shutdown_requested;
+    mutex m_mutex;
+    condition_variable m_cv;
+    thread m_thread;
+
+    state(const char *origin, intptr_t stride, intptr_t count,
+          intptr_t element_size, intptr_t lookahead)
+        : m_origin(origin), m_stride(stride), m_count(count),
+          m_element_size(element_size), m_lookahead(lookahead),
+          m_page_size(get_page_size()), m_position(0), m_prefetched(0),
+          m_shutdown(false), m_shutdown_requested(false)
+    {
+    }
+
+    /** Reads one byte from every page in [begin, end) */
+    void touch_pages(const char *begin, const char *end, const char *&last_page)
+    {
+        const char *page = (const char *)((uintptr_t)begin &
+                                          ~(uintptr_t)(m_page_size - 1));
+        unsigned char sum = 0;
+        for (; page < end; page += m_page_size) {
+            if (page != last_page) {
+                sum += *(const volatile unsigned char *)page;
+                last_page = page;
+            }
+        }
+        m_sink = sum;
+    }
+
+    void prefetch(intptr_t i0, intptr_t i1)
+    {
+        const char *last_page = NULL;
+        intptr_t abs_stride = m_stride < 0 ? -m_stride : m_stride;
+        if (abs_stride < m_page_size) {
+            // The elements cover every page of their span
+            const char *first = m_origin + i0 * m_stride;
+            const char *last = m_origin + (i1 - 1) * m_stride;
+            if (first > last) {
+                swap(first, last);
+            }
+            memmap_advise(first, last + m_element_size, memmap_hint_willneed);
+            touch_pages(first, last + m_element_size, last_page);
+        } else {
+            for (intptr_t i = i0; i < i1; ++i) {
+                const char *ptr = m_origin + i * m_stride;
+                touch_pages(ptr, ptr + m_element_size, last_page);
+            }
+        }
+    }
+
+    void run()
+    {
+        // Prefetch in pieces of a quarter of the lookahead, so the scan
+        // is not held up waiting for a whole window
+        intptr_t piece = max<intptr_t>(m_lookahead / 4, 1);
+        for (;;) {
+            intptr_t target;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_cv.wait(lock, [&] {
+                    return m_shutdown ||
+                           m_prefetched < min(m_position.load() + m_lookahead,
+                                              m_count);
+                });
+                if (m_shutdown) {
+                    return;
+                }
+                target = min(m_position.load() + m_lookahead, m_count);
+            }
+            intptr_t i0 = m_prefetched;
+            while (i0 < target && !m_shutdown_requested.load()) {
+                // Skip anything the scan has already passed
+                i0 = max(i0, m_position.load());
+                intptr_t i1 = min(i0 + piece, target);
+                if (i0 < i1) {
+                    prefetch(i0, i1);
+                }
+                i0 = i1;
+            }
+            lock_guard<mutex> lock(m_mutex);
+            m_prefetched = target;
+        }
+    }
+
+    volatile unsigned char m_sink;
+};
+
+dynd::memmap_prefetcher::memmap_prefetcher(const char *origin, intptr_t stride,
+                                     intptr_t count, intptr_t element_size,
+                                     intptr_t lookahead)
+    : m_state(new state(origin, stride, count, element_size,
+                        max<intptr_t>(lookahead, 1))),
+      m_next_notify(max<intptr_t>(lookahead / 4, 1))
+{
+    if (count > 0 && element_size > 0) {
+        m_state->m_thread = thread(&state::run, m_state);
+    }
+}
+
+dynd::memmap_prefetcher::~memmap_prefetcher()
+{
+    if (m_state->m_thread.joinable()) {
+        m_state->m_shutdown_requested.store(true);
+        {
+            lock_guard<mutex> lock(m_state->m_mutex);
+            m_state->m_shutdown = true;
+        }
+        m_state->m_cv.notify_one();
+        m_state->m_thread.join();
+    }
+    delete m_state;
+}
+
+void dynd::memmap_prefetcher::notify(intptr_t i)
+{
+    // The thread is only woken once the scan has used up a quarter of
+    // the lookahead, so most calls to advance are a single compare
+    m_next_notify = i + max<intptr_t>(m_state->m_lookahead / 4, 1);
+    m_state->m_position.store(i);
+    {
+        lock_guard<mutex> lock(m_state->m_mutex);
+    }
+    m_state->m_cv.notify_one();
+}
+
 namespace dynd { namespace detail {
 
 void free_memmap_memory_block(memory_block_data *memblock)
@@ -255,4 +480,7 @@ void dynd::memmap_memory_block_debug_print(const memory_block_data *memblock, st
     o << indent << " filename: " << emb->m_filename << "\n";
     o << indent << " begin: " << emb->m_begin << "\n";
     o << indent << " end: " << emb->m_end << "\n";
+    if (emb->m_hints != 0) {
+        o << indent << " hints: 0x" << hex << emb->m_hints << dec << "\n";
+    }
 }
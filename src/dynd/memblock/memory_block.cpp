@@ -3,6 +3,10 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 #include <dynd/memblock/memory_block.hpp>
 #include <dynd/memblock/pod_memory_block.hpp>
 #include <dynd/memblock/zeroinit_memory_block.hpp>
@@ -76,6 +80,141 @@ extern memory_block_objectarray_allocator_api objectarray_memory_block_allocator
 
 }} // namespace dynd::detail
 
+namespace {
+    // Chunks are pooled in power of two size classes from 256 bytes
+    // to 1 MB, bigger chunks always come from malloc
+    const int chunk_pool_min_shift = 8;
+    const int chunk_pool_size_class_count = 13;
+    const int chunk_pool_max_free_chunks = 16;
+    // The most memory one thread's pool keeps for reuse
+    const intptr_t chunk_pool_max_free_bytes = 8 * 1024 * 1024;
+
+    atomic<intptr_t> chunk_bytes_in_flight(0);
+    atomic<intptr_t> chunk_pool_hits(0);
+    atomic<intptr_t> chunk_pool_misses(0);
+
+    // Returns the size class for a chunk of ``size_bytes``,
+    // or -1 if it is too big to be pooled
+    inline int get_chunk_size_class(intptr_t size_bytes)
+    {
+        intptr_t chunk_size = (intptr_t)1 << chunk_pool_min_shift;
+        for (int i = 0; i < chunk_pool_size_class_count; ++i) {
+            if (size_bytes <= chunk_size) {
+                return i;
+            }
+            chunk_size *= 2;
+        }
+        return -1;
+    }
+
+    inline intptr_t get_chunk_size(int size_class)
+    {
+        return (intptr_t)1 << (chunk_pool_min_shift + size_class);
+    }
+
+    struct memory_chunk_pool {
+        char *free_chunks[chunk_pool_size_class_count][chunk_pool_max_free_chunks];
+        int free_count[chunk_pool_size_class_count];
+        intptr_t free_bytes;
+
+        memory_chunk_pool()
+            : free_bytes(0)
+        {
+            for (int i = 0; i < chunk_pool_size_class_count; ++i) {
+                free_count[i] = 0;
+            }
+        }
+
+        ~memory_chunk_pool()
+        {
+            for (int i = 0; i < chunk_pool_size_class_count; ++i) {
+                for (int j = 0; j < free_count[i]; ++j) {
+                    free(free_chunks[i][j]);
+                }
+            }
+        }
+    };
+
+    // The pool is reached through a trivially destructible pointer, so
+    // memory blocks freed while the thread is exiting (e.g. from atexit
+    // handlers, after the pool is gone) can still check for it
+    thread_local memory_chunk_pool *tls_chunk_pool = NULL;
+    thread_local bool tls_chunk_pool_destroyed = false;
+
+    struct memory_chunk_pool_owner {
+        ~memory_chunk_pool_owner()
+        {
+            delete tls_chunk_pool;
+            tls_chunk_pool = NULL;
+            tls_chunk_pool_destroyed = true;
+        }
+    };
+
+    thread_local memory_chunk_pool_owner tls_chunk_pool_owner;
+
+    // Returns the calling thread's pool, or NULL once it has been destroyed
+    memory_chunk_pool *get_chunk_pool()
+    {
+        if (tls_chunk_pool == NULL && !tls_chunk_pool_destroyed) {
+            // Touching the owner registers its destructor for this thread
+            (void)&tls_chunk_pool_owner;
+            tls_chunk_pool = new memory_chunk_pool;
+        }
+        return tls_chunk_pool;
+    }
+} // anonymous namespace
+
+intptr_t dynd::detail::memory_chunk_capacity(intptr_t size_bytes)
+{
+    int size_class = get_chunk_size_class(size_bytes);
+    return size_class < 0 ? size_bytes : get_chunk_size(size_class);
+}
+
+char *dynd::detail::memory_chunk_alloc(intptr_t size_bytes, intptr_t *out_capacity_bytes)
+{
+    int size_class = get_chunk_size_class(size_bytes);
+    intptr_t capacity_bytes = size_class < 0 ? size_bytes : get_chunk_size(size_class);
+    char *chunk = NULL;
+    memory_chunk_pool *pool = size_class < 0 ? NULL : get_chunk_pool();
+    if (pool != NULL && pool->free_count[size_class] > 0) {
+        chunk = pool->free_chunks[size_class][--pool->free_count[size_class]];
+        pool->free_bytes -= capacity_bytes;
+        chunk_pool_hits.fetch_add(1, memory_order_relaxed);
+    } else {
+        chunk = reinterpret_cast<char *>(malloc(capacity_bytes));
+        if (chunk == NULL) {
+            throw bad_alloc();
+        }
+        chunk_pool_misses.fetch_add(1, memory_order_relaxed);
+    }
+    chunk_bytes_in_flight.fetch_add(capacity_bytes, memory_order_relaxed);
+    *out_capacity_bytes = capacity_bytes;
+    return chunk;
+}
+
+void dynd::detail::memory_chunk_free(char *chunk, intptr_t capacity_bytes)
+{
+    chunk_bytes_in_flight.fetch_sub(capacity_bytes, memory_order_relaxed);
+    int size_class = get_chunk_size_class(capacity_bytes);
+    memory_chunk_pool *pool = size_class < 0 ? NULL : get_chunk_pool();
+    if (pool != NULL && pool->free_count[size_class] < chunk_pool_max_free_chunks &&
+                    pool->free_bytes + capacity_bytes <= chunk_pool_max_free_bytes) {
+        pool->free_chunks[size_class][pool->free_count[size_class]++] = chunk;
+        pool->free_bytes += capacity_bytes;
+    } else {
+        free(chunk);
+    }
+}
+
+memory_chunk_pool_stats dynd::get_memory_chunk_pool_stats()
+{
+    memory_chunk_pool_stats stats;
+    stats.bytes_in_flight = chunk_bytes_in_flight.load(memory_order_relaxed);
+    stats.hits = chunk_pool_hits.load(memory_order_relaxed);
+    stats.misses = chunk_pool_misses.load(memory_order_relaxed);
+    return stats;
+}
+
 
 void dynd::detail::memory_block_free(memory_block_data *memblock)
 {
@@ -17,6 +17,7 @@ namespace {
     struct memory_chunk {
         char *memory;
         size_t used_count, capacity_count;
+        intptr_t capacity_bytes;
     };
 
     struct objectarray_memory_block {
@@ -27,7 +28,7 @@ namespace {
         intptr_t m_stride;
         size_t m_total_allocated_count;
         bool m_finalized;
-        /** The malloc'd memory */
+        /** The pooled memory chunks */
         vector<memory_chunk> m_memory_handles;
 
         /**
@@ -36,17 +37,14 @@ namespace {
          */
         void append_memory(intptr_t count)
         {
-            m_memory_handles.push_back(memory_chunk());
-            memory_chunk& mc = m_memory_handles.back();
+            memory_chunk mc;
+            m_memory_handles.reserve(m_memory_handles.size() + 1);
+            mc.memory = detail::memory_chunk_alloc(m_stride * count, &mc.capacity_bytes);
             mc.used_count = 0;
-            mc.capacity_count = count;
-            char *memory = reinterpret_cast<char *>(malloc(m_stride * count));
-            mc.memory = memory;
-            if (memory == NULL) {
-                m_memory_handles.pop_back();
-                throw bad_alloc();
-            }
-            m_total_allocated_count += count;
+            // The chunk may be bigger than requested, use all of it
+            mc.capacity_count = mc.capacity_bytes / m_stride;
+            m_memory_handles.push_back(mc);
+            m_total_allocated_count += mc.capacity_count;
         }
 
         objectarray_memory_block(const ndt::type& dt, const char *arrmeta, intptr_t stride, intptr_t initial_count)
@@ -68,7 +66,7 @@ namespace {
             for (size_t i = 0, i_end = m_memory_handles.size(); i != i_end; ++i) {
                 memory_chunk& mc = m_memory_handles[i];
                 m_dt.extended()->data_destruct_strided(m_arrmeta, mc.memory, m_stride, mc.used_count);
-                free(mc.memory);
+                detail::memory_chunk_free(mc.memory, mc.capacity_bytes);
             }
         }
     };
@@ -125,16 +123,18 @@ static char *resize(memory_block_data *self, char *previous_allocated, size_t co
 
     if (mc->capacity_count - previous_index < count) {
         emb->append_memory(max(emb->m_total_allocated_count, count));
+        // Appending may have moved the chunk records
+        mc = &emb->m_memory_handles[emb->m_memory_handles.size() - 2];
         memory_chunk *new_mc = &emb->m_memory_handles.back();
         // Move the old memory to the newly allocated block
         if (previous_count > 0) {
             // Subtract the previously used memory from the old chunk's count
             mc->used_count -= previous_count;
-            memcpy(new_mc->memory, previous_allocated, previous_count);
+            memcpy(new_mc->memory, previous_allocated, emb->m_stride * previous_count);
             // If the old memory only had the memory being resized,
             // free it completely.
             if (previous_allocated == mc->memory) {
-                free(mc->memory);
+                detail::memory_chunk_free(mc->memory, mc->capacity_bytes);
                 // Remove the second-last element of the vector
                 emb->m_memory_handles.erase(
                             emb->m_memory_handles.begin() +
@@ -158,8 +158,10 @@ static char *resize(memory_block_data *self, char *previous_allocated, size_t co
 
     if ((emb->m_dt.get_flags()&type_flag_zeroinit) != 0) {
         // Zero-init the new memory
-        intptr_t new_count = count - (intptr_t)previous_count;
-        memset(mc->memory + emb->m_stride * previous_count, 0, emb->m_stride * new_count);
+        if (count > previous_count) {
+            memset(result + emb->m_stride * previous_count, 0,
+                   emb->m_stride * (count - previous_count));
+        }
     } else {
         // TODO: Add a default data constructor to base_type
         //       as well, with a flag for it
@@ -190,7 +192,7 @@ static void reset(memory_block_data *self)
             memory_chunk& mc = emb->m_memory_handles[i];
             emb->m_dt.extended()->data_destruct_strided(
                 emb->m_arrmeta, mc.memory, emb->m_stride, mc.used_count);
-            free(mc.memory);
+            detail::memory_chunk_free(mc.memory, mc.capacity_bytes);
         }
         emb->m_memory_handles.front() = emb->m_memory_handles.back();
         emb->m_memory_handles.resize(1);
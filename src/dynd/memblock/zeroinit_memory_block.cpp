@@ -18,9 +18,9 @@ namespace {
         /** Every memory block object needs this at the front */
         memory_block_data m_mbd;
         intptr_t m_total_allocated_capacity;
-        /** The malloc'd memory */
-        vector<char *> m_memory_handles;
-        /** The current malloc'd memory being doled out */
+        /** The pooled memory chunks, with their capacities */
+        vector<pair<char *, intptr_t> > m_memory_handles;
+        /** The current memory chunk being doled out */
         char *m_memory_begin, *m_memory_current, *m_memory_end;
 
         /**
@@ -29,13 +29,9 @@ namespace {
          */
         void append_memory(intptr_t capacity_bytes)
         {
-            m_memory_handles.push_back(NULL);
-            m_memory_begin = reinterpret_cast<char *>(malloc(capacity_bytes));
-            m_memory_handles.back() = m_memory_begin;
-            if (m_memory_begin == NULL) {
-                m_memory_handles.pop_back();
-                throw bad_alloc();
-            }
+            m_memory_handles.reserve(m_memory_handles.size() + 1);
+            m_memory_begin = detail::memory_chunk_alloc(capacity_bytes, &capacity_bytes);
+            m_memory_handles.push_back(make_pair(m_memory_begin, capacity_bytes));
             m_memory_current = m_memory_begin;
             m_memory_end = m_memory_current + capacity_bytes;
             m_total_allocated_capacity += capacity_bytes;
@@ -51,7 +47,7 @@ namespace {
         ~zeroinit_memory_block()
         {
             for (size_t i = 0, i_end = m_memory_handles.size(); i != i_end; ++i) {
-                free(m_memory_handles[i]);
+                detail::memory_chunk_free(m_memory_handles[i].first, m_memory_handles[i].second);
             }
         }
     };
@@ -82,7 +78,7 @@ static void allocate(memory_block_data *self, intptr_t size_bytes, intptr_t alig
     if (end > emb->m_memory_end) {
         emb->m_total_allocated_capacity -= emb->m_memory_end - emb->m_memory_current;
         // Allocate memory to double the amount used so far, or the requested size, whichever is larger
-        // NOTE: We're assuming malloc produces memory which has good enough alignment for anything
+        // NOTE: We're assuming the chunks from malloc have good enough alignment for anything
         emb->append_memory(max(emb->m_total_allocated_capacity, size_bytes));
         begin = emb->m_memory_begin;
         end = begin + size_bytes;
@@ -120,11 +116,11 @@ static void resize(memory_block_data *self, intptr_t size_bytes, char **inout_be
         }
         *inout_end = end;
     } else {
-        // If it doesn't fit, need to copy to newly malloc'd memory
+        // If it doesn't fit, need to copy to a new chunk
 		char *old_current = *inout_begin, *old_end = *inout_end;
         intptr_t old_size_bytes = *inout_end - *inout_begin;
         // Allocate memory to double the amount used so far, or the requested size, whichever is larger
-        // NOTE: We're assuming malloc produces memory which has good enough alignment for anything
+        // NOTE: We're assuming the chunks from malloc have good enough alignment for anything
         emb->append_memory(max(emb->m_total_allocated_capacity, size_bytes));
         memcpy(emb->m_memory_begin, *inout_begin, old_size_bytes);
         end = emb->m_memory_begin + size_bytes;
@@ -161,7 +157,7 @@ static void reset(memory_block_data *self)
         // If there are more than one allocated memory chunks,
         // throw them all away except the last
         for (size_t i = 0, i_end = emb->m_memory_handles.size() - 1; i != i_end; ++i) {
-            free(emb->m_memory_handles[i]);
+            detail::memory_chunk_free(emb->m_memory_handles[i].first, emb->m_memory_handles[i].second);
         }
         emb->m_memory_handles.front() = emb->m_memory_handles.back();
         emb->m_memory_handles.resize(1);
@@ -0,0 +1,399 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <type_traits>
+
+#include <dynd/option_bitmap.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// The number of elements option_from_bitmap copies with each value
+// assignment, a multiple of 64 small enough to stay in cache
+const intptr_t option_bitmap_block_size = 1024;
+
+// Returns the index of the lowest set bit in a nonzero word
+inline int lowest_set_bit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return (int)index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanForward(&index, (unsigned long)word)) {
+    return (int)index;
+  }
+  _BitScanForward(&index, (unsigned long)(word >> 32));
+  return (int)index + 32;
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+inline intptr_t count_set_bits(uint64_t word)
+{
+#ifdef _MSC_VER
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (intptr_t)((word * 0x0101010101010101ULL) >> 56);
+#else
+  return __builtin_popcountll(word);
+#endif
+}
+
+// The bits of a word which belong to elements, for the word holding
+// elements [begin, begin + 64) of an array of ``size`` elements
+inline uint64_t word_valid_mask(intptr_t begin, intptr_t size)
+{
+  intptr_t n = size - begin;
+  return n >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1);
+}
+
+/**
+ * Returns the index of the first bit in [begin, end) which equals
+ * ``value``, or ``end`` if there is none.
+ */
+intptr_t find_bit(const uint64_t *bits, intptr_t begin, intptr_t end,
+                  bool value)
+{
+  if (begin >= end) {
+    return end;
+  }
+  uint64_t flip = value ? 0 : ~(uint64_t)0;
+  intptr_t w = begin / 64;
+  uint64_t word = ((bits[w] ^ flip) >> (begin % 64)) << (begin % 64);
+  while (word == 0) {
+    if (++w * 64 >= end) {
+      return end;
+    }
+    word = bits[w] ^ flip;
+  }
+  return min<intptr_t>(w * 64 + lowest_set_bit(word), end);
+}
+
+nd::array get_strided_column(const char *func_name, const nd::array &a,
+                             intptr_t &out_size, intptr_t &out_stride,
+                             ndt::type &out_el_tp,
+                             const char *&out_el_arrmeta)
+{
+  nd::array values = a.get_dtype().is_expression() ? a.eval() : a;
+  if (values.get_ndim() != 1 ||
+      !values.get_type().get_as_strided(values.get_arrmeta(), &out_size,
+                                        &out_stride, &out_el_tp,
+                                        &out_el_arrmeta)) {
+    stringstream ss;
+    ss << "dynd " << func_name
+       << ": expected a one-dimensional strided array, but received "
+       << a.get_type();
+    throw type_error(ss.str());
+  }
+  return values;
+}
+
+/**
+ * Returns the words of ``bitmap`` as a contiguous "W * uint64" array,
+ * checking that there are enough of them for ``size`` elements.
+ */
+nd::array get_bitmap_words(const char *func_name, const nd::array &bitmap,
+                           intptr_t size)
+{
+  intptr_t word_count, stride;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  nd::array b = get_strided_column(func_name, bitmap, word_count, stride,
+                                   el_tp, el_arrmeta);
+  if (el_tp.get_type_id() != uint64_type_id) {
+    stringstream ss;
+    ss << "dynd " << func_name << ": expected a uint64 bitmap, but received "
+       << bitmap.get_type();
+    throw type_error(ss.str());
+  }
+  if (word_count < validity_bitmap_word_count(size)) {
+    stringstream ss;
+    ss << "dynd " << func_name << ": a bitmap of " << word_count
+       << " words is too small for " << size << " elements";
+    throw runtime_error(ss.str());
+  }
+  if (stride != (intptr_t)sizeof(uint64_t)) {
+    nd::array c = nd::empty(word_count, ndt::make_type<uint64_t>());
+    c.vals() = b;
+    return c;
+  }
+  return b;
+}
+
+template <class T, class A>
+A masked_sum_contig(const T *values, const uint64_t *bits, intptr_t size)
+{
+  A sum = 0;
+  for (intptr_t begin = 0; begin < size; begin += 64) {
+    uint64_t mask = word_valid_mask(begin, size);
+    uint64_t word = bits[begin / 64] & mask;
+    const T *v = values + begin;
+    intptr_t n = min<intptr_t>(64, size - begin);
+    if (word == mask) {
+      // All available, sum without looking at the bits
+      for (intptr_t i = 0; i < n; ++i) {
+        sum += static_cast<A>(v[i]);
+      }
+    } else if (is_integral<A>::value && count_set_bits(word) > n / 2) {
+      // Mostly available, so for integers sum all the values and take
+      // back the missing ones, which wraps around exactly
+      typedef typename conditional<is_integral<A>::value, uint64_t, A>::type
+          word_sum_type;
+      uint64_t missing = ~word & mask;
+      word_sum_type word_sum = 0;
+      for (intptr_t i = 0; i < n; ++i) {
+        word_sum += static_cast<word_sum_type>(static_cast<A>(v[i]));
+      }
+      while (missing != 0) {
+        word_sum -= static_cast<word_sum_type>(
+            static_cast<A>(v[lowest_set_bit(missing)]));
+        missing &= missing - 1;
+      }
+      sum += static_cast<A>(word_sum);
+    } else {
+      while (word != 0) {
+        sum += static_cast<A>(v[lowest_set_bit(word)]);
+        word &= word - 1;
+      }
+    }
+  }
+  return sum;
+}
+
+template <class T, class A>
+A masked_sum(const char *data, intptr_t stride, const uint64_t *bits,
+             intptr_t size)
+{
+  if (stride == (intptr_t)sizeof(T) &&
+      (reinterpret_cast<uintptr_t>(data) & (sizeof(T) - 1)) == 0) {
+    return masked_sum_contig<T, A>(reinterpret_cast<const T *>(data), bits,
+                                   size);
+  }
+  A sum = 0;
+  for (intptr_t begin = 0; begin < size; begin += 64) {
+    uint64_t word = bits[begin / 64] & word_valid_mask(begin, size);
+    while (word != 0) {
+      T v;
+      memcpy(&v, data + (begin + lowest_set_bit(word)) * stride, sizeof(T));
+      sum += static_cast<A>(v);
+      word &= word - 1;
+    }
+  }
+  return sum;
+}
+
+template <class T, class A>
+nd::array masked_sum_array(const char *data, intptr_t stride,
+                           const uint64_t *bits, intptr_t size)
+{
+  return nd::array(masked_sum<T, A>(data, stride, bits, size));
+}
+
+} // anonymous namespace
+
+intptr_t dynd::validity_bitmap_count(const uint64_t *bits, intptr_t size)
+{
+  intptr_t count = 0;
+  for (intptr_t begin = 0; begin < size; begin += 64) {
+    count += count_set_bits(bits[begin / 64] & word_valid_mask(begin, size));
+  }
+  return count;
+}
+
+nd::array nd::validity_bitmap(const nd::array &a)
+{
+  intptr_t size, stride;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  nd::array v =
+      get_strided_column("validity_bitmap", a, size, stride, el_tp, el_arrmeta);
+  if (el_tp.get_type_id() != option_type_id) {
+    stringstream ss;
+    ss << "dynd validity_bitmap: expected an option array, but received "
+       << a.get_type();
+    throw type_error(ss.str());
+  }
+
+  intptr_t word_count = validity_bitmap_word_count(size);
+  nd::array result = nd::empty(word_count, ndt::make_type<uint64_t>());
+  uint64_t *bits = reinterpret_cast<uint64_t *>(result.get_readwrite_originptr());
+  if (size == 0) {
+    return result;
+  }
+
+  // Classify the elements a word at a time with the strided is_avail
+  // ckernel of the option type, then pack them into bits
+  const option_type *ot = el_tp.extended<option_type>();
+  ckernel_builder<kernel_request_host> ckb;
+  const arrfunc_type_data *af = ot->get_is_avail_arrfunc();
+  af->instantiate(af, ot->get_is_avail_arrfunc_type(), &ckb, 0,
+                  ndt::make_type<dynd_bool>(), NULL, &el_tp, &el_arrmeta,
+                  kernel_request_strided, &eval::default_eval_context,
+                  nd::array());
+  ckernel_prefix *ckp = ckb.get();
+  expr_strided_t is_avail_fn = ckp->get_function<expr_strided_t>();
+
+  dynd_bool avail[64];
+  char *src = const_cast<char *>(v.get_readonly_originptr());
+  for (intptr_t w = 0; w < word_count; ++w) {
+    intptr_t n = min<intptr_t>(64, size - w * 64);
+    is_avail_fn(reinterpret_cast<char *>(avail), 1, &src, &stride, n, ckp);
+    uint64_t word = 0;
+    for (intptr_t i = 0; i < n; ++i) {
+      word |= (uint64_t)(avail[i] != 0) << i;
+    }
+    bits[w] = word;
+    src += n * stride;
+  }
+  return result;
+}
+
+nd::array nd::option_from_bitmap(const nd::array &values,
+                                 const nd::array &bitmap)
+{
+  intptr_t size, src_stride;
+  ndt::type src_tp;
+  const char *src_arrmeta;
+  nd::array v = get_strided_column("option_from_bitmap", values, size,
+                                   src_stride, src_tp, src_arrmeta);
+  nd::array b = get_bitmap_words("option_from_bitmap", bitmap, size);
+  const uint64_t *bits =
+      reinterpret_cast<const uint64_t *>(b.get_readonly_originptr());
+
+  // Values which are already options are copied as options, so an NA
+  // under a set bit stays NA
+  bool src_is_option = src_tp.get_type_id() == option_type_id;
+  ndt::type value_tp = src_is_option
+                           ? src_tp.extended<option_type>()->get_value_type()
+                           : src_tp;
+  ndt::type dst_tp = ndt::make_option(value_tp);
+  const option_type *ot = dst_tp.extended<option_type>();
+  nd::array result = nd::empty(size, dst_tp);
+  const char *dst_arrmeta = result.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
+  intptr_t dst_stride =
+      reinterpret_cast<const fixed_dim_type_arrmeta *>(result.get_arrmeta())
+          ->stride;
+  if (size == 0) {
+    return result;
+  }
+
+  const eval::eval_context *ectx = &eval::default_eval_context;
+  ckernel_builder<kernel_request_host> value_assign;
+  make_assignment_kernel(NULL, NULL, &value_assign, 0,
+                         src_is_option ? dst_tp : value_tp, dst_arrmeta,
+                         src_tp, src_arrmeta, kernel_request_strided, ectx,
+                         nd::array());
+  ckernel_prefix *value_assign_ckp = value_assign.get();
+  expr_strided_t value_assign_fn =
+      value_assign_ckp->get_function<expr_strided_t>();
+  ckernel_builder<kernel_request_host> assign_na;
+  const arrfunc_type_data *af = ot->get_assign_na_arrfunc();
+  af->instantiate(af, ot->get_assign_na_arrfunc_type(), &assign_na, 0, dst_tp,
+                  dst_arrmeta, NULL, NULL, kernel_request_strided, ectx,
+                  nd::array());
+  ckernel_prefix *assign_na_ckp = assign_na.get();
+  expr_strided_t assign_na_fn = assign_na_ckp->get_function<expr_strided_t>();
+
+  // Copy a block of POD values with one strided value assignment, then
+  // overwrite the runs of clear bits with NA. Other values, like strings,
+  // can't be assigned NA after they're assigned, so they are copied a
+  // run of set bits at a time. A block with no set bits is only
+  // assigned NA.
+  bool pod = dst_tp.is_pod();
+  char *dst = result.get_readwrite_originptr();
+  char *src = const_cast<char *>(v.get_readonly_originptr());
+  for (intptr_t begin = 0; begin < size; begin += option_bitmap_block_size) {
+    intptr_t end = min(begin + option_bitmap_block_size, size);
+    intptr_t i = find_bit(bits, begin, end, true);
+    if (i == end) {
+      assign_na_fn(dst + begin * dst_stride, dst_stride, NULL, NULL,
+                   end - begin, assign_na_ckp);
+      continue;
+    }
+    if (pod) {
+      char *block_src = src + begin * src_stride;
+      value_assign_fn(dst + begin * dst_stride, dst_stride, &block_src,
+                      &src_stride, end - begin, value_assign_ckp);
+    }
+    i = begin;
+    while (i < end) {
+      intptr_t run_end = find_bit(bits, i, end, false);
+      if (!pod && run_end > i) {
+        char *run_src = src + i * src_stride;
+        value_assign_fn(dst + i * dst_stride, dst_stride, &run_src,
+                        &src_stride, run_end - i, value_assign_ckp);
+      }
+      i = find_bit(bits, run_end, end, true);
+      if (i > run_end) {
+        assign_na_fn(dst + run_end * dst_stride, dst_stride, NULL, NULL,
+                     i - run_end, assign_na_ckp);
+      }
+    }
+  }
+  return result;
+}
+
+nd::array nd::masked_sum(const nd::array &values, const nd::array &bitmap)
+{
+  intptr_t size, stride;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  nd::array v = get_strided_column("masked_sum", values, size, stride, el_tp,
+                                   el_arrmeta);
+  nd::array b = get_bitmap_words("masked_sum", bitmap, size);
+  const uint64_t *bits =
+      reinterpret_cast<const uint64_t *>(b.get_readonly_originptr());
+  const char *data = v.get_readonly_originptr();
+
+  // Elements under a clear bit are never read, so the sentinels of an
+  // option type don't need to be checked
+  ndt::type value_tp = el_tp.get_type_id() == option_type_id
+                           ? el_tp.extended<option_type>()->get_value_type()
+                           : el_tp;
+  switch (value_tp.get_type_id()) {
+  case bool_type_id:
+    return masked_sum_array<uint8_t, int64_t>(data, stride, bits, size);
+  case int8_type_id:
+    return masked_sum_array<int8_t, int64_t>(data, stride, bits, size);
+  case int16_type_id:
+    return masked_sum_array<int16_t, int64_t>(data, stride, bits, size);
+  case int32_type_id:
+    return masked_sum_array<int32_t, int64_t>(data, stride, bits, size);
+  case int64_type_id:
+    return masked_sum_array<int64_t, int64_t>(data, stride, bits, size);
+  case uint8_type_id:
+    return masked_sum_array<uint8_t, uint64_t>(data, stride, bits, size);
+  case uint16_type_id:
+    return masked_sum_array<uint16_t, uint64_t>(data, stride, bits, size);
+  case uint32_type_id:
+    return masked_sum_array<uint32_t, uint64_t>(data, stride, bits, size);
+  case uint64_type_id:
+    return masked_sum_array<uint64_t, uint64_t>(data, stride, bits, size);
+  case float32_type_id:
+    return masked_sum_array<float, double>(data, stride, bits, size);
+  case float64_type_id:
+    return masked_sum_array<double, double>(data, stride, bits, size);
+  default: {
+    stringstream ss;
+    ss << "dynd masked_sum: cannot sum values of type " << el_tp;
+    throw type_error(ss.str());
+  }
+  }
+}
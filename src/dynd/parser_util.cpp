@@ -5,6 +5,7 @@
 
 #include <string>
 #include <climits>
+#include <cfloat>
 
 #include <dynd/parser_util.hpp>
 #include <dynd/string_encodings.hpp>
@@ -12,9 +13,131 @@
 #include <dynd/kernels/single_assigner_builtin.hpp>
 
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DYND_PARSE_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 using namespace std;
 using namespace dynd;
 
+#ifdef DYND_PARSE_USE_SSE2
+// Returns the index of the lowest set bit in a nonzero mask
+static inline int lowest_set_bit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define DYND_PARSE_USE_SWAR_DIGITS
+#endif
+
+#ifdef DYND_PARSE_USE_SWAR_DIGITS
+// Loads 8 bytes for SWAR digit processing, the first byte lowest
+static inline uint64_t load_eight_bytes(const char *p)
+{
+  uint64_t val;
+  memcpy(&val, p, sizeof(val));
+  return val;
+}
+
+// Returns true if all 8 bytes of ``val`` are ASCII digits
+static inline bool is_eight_digits(uint64_t val)
+{
+  return (((val & 0xF0F0F0F0F0F0F0F0ULL) |
+           (((val + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+          0x3333333333333333ULL);
+}
+
+// Converts 8 ASCII digits to their value with three multiplications
+static inline uint32_t parse_eight_digits(uint64_t val)
+{
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+  val -= 0x3030303030303030ULL;
+  val = (val * 10) + (val >> 8);
+  val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+  return static_cast<uint32_t>(val);
+}
+#endif
+
+// Accumulates a run of decimal digits into ``value``, which must stay
+// below 10^19 to not overflow, returning the end of the run
+static inline const char *accumulate_digits(const char *begin, const char *end,
+                                            uint64_t &value)
+{
+#ifdef DYND_PARSE_USE_SWAR_DIGITS
+  while (end - begin >= 8 && is_eight_digits(load_eight_bytes(begin))) {
+    value = value * 100000000ULL + parse_eight_digits(load_eight_bytes(begin));
+    begin += 8;
+  }
+#endif
+  while (begin < end && '0' <= *begin && *begin <= '9') {
+    value = value * 10 + (uint32_t)(*begin - '0');
+    ++begin;
+  }
+  return begin;
+}
+
+const char *parse::skip_whitespace_run(const char *begin, const char *end)
+{
+#ifdef DYND_PARSE_USE_SSE2
+  // Whitespace is ' ', or '\t' through '\r'
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i before_tab = _mm_set1_epi8('\t' - 1);
+  const __m128i after_cr = _mm_set1_epi8('\r' + 1);
+  while (end - begin >= 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    __m128i ws = _mm_or_si128(
+        _mm_cmpeq_epi8(block, space),
+        _mm_and_si128(_mm_cmpgt_epi8(block, before_tab),
+                      _mm_cmplt_epi8(block, after_cr)));
+    unsigned int mask = _mm_movemask_epi8(ws);
+    if (mask != 0xffff) {
+      return begin + lowest_set_bit(~mask);
+    }
+    begin += 16;
+  }
+#endif
+  while (begin < end && (*begin == ' ' || ('\t' <= *begin && *begin <= '\r'))) {
+    ++begin;
+  }
+  return begin;
+}
+
+const char *parse::find_quote_or_backslash(const char *begin, const char *end)
+{
+#ifdef DYND_PARSE_USE_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (end - begin >= 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    unsigned int mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+    if (mask != 0) {
+      return begin + lowest_set_bit(mask);
+    }
+    begin += 16;
+  }
+#endif
+  while (begin < end && *begin != '"' && *begin != '\\') {
+    ++begin;
+  }
+  return begin;
+}
+
 // [a-zA-Z_][a-zA-Z0-9_]*
 bool parse::parse_name_no_ws(const char *&rbegin, const char *end,
                              const char *&out_strbegin, const char *&out_strend)
@@ -75,6 +198,8 @@ bool parse::parse_doublequote_string_no_ws(const char *&rbegin, const char *end,
     return false;
   }
   for (;;) {
+    // Skip the plain characters up to the next quote or escape
+    begin = find_quote_or_backslash(begin, end);
     if (begin == end) {
       throw parse::parse_error(rbegin, "string has no ending quote");
     }
@@ -488,6 +613,14 @@ inline static T unchecked_string_to_uint(const char *begin, const char *end)
 uint64_t parse::checked_string_to_uint64(const char *begin, const char *end,
                                          bool &out_overflow, bool &out_badparse)
 {
+  // A plain run of at most 19 digits can't overflow, and is by far
+  // the most common input
+  if (begin < end && end - begin <= 19) {
+    uint64_t result = 0;
+    if (accumulate_digits(begin, end, result) == end) {
+      return result;
+    }
+  }
   return checked_string_to_uint<uint64_t>(begin, end, out_overflow,
                                           out_badparse);
 }
@@ -548,9 +681,198 @@ inline static double make_double_nan(bool negative)
   return nan.d;
 }
 
+namespace dynd { namespace parse { namespace detail {
+extern const uint64_t power_of_five_128[];
+}}} // namespace dynd::parse::detail
+
+namespace {
+struct uint128_parts {
+  uint64_t low, high;
+};
+
+inline uint128_parts full_multiplication(uint64_t a, uint64_t b)
+{
+  uint128_parts result;
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 r = (unsigned __int128)a * b;
+  result.low = (uint64_t)r;
+  result.high = (uint64_t)(r >> 64);
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+  result.high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+  result.low = (cross << 32) | (uint32_t)lo_lo;
+#endif
+  return result;
+}
+
+inline int leading_zeros(uint64_t value)
+{
+  int count = 0;
+  while ((value & 0x8000000000000000ULL) == 0) {
+    value <<= 1;
+    ++count;
+  }
+  return count;
+}
+
+/**
+ * Computes the float64 nearest to ``w * 10^q`` with the Eisel-Lemire
+ * algorithm, for nonzero ``w``. Returns false in the rare cases it can't
+ * decide the rounding, or if the result is subnormal or out of range,
+ * which are left to strtod.
+ */
+bool eisel_lemire_float64(uint64_t w, int64_t q, double &out)
+{
+  if (q < -342 || q > 308) {
+    return false;
+  }
+  int lz = leading_zeros(w);
+  w <<= lz;
+  // Multiply by the 128-bit approximation of 5^q, using the low word
+  // only when the high word leaves the result in doubt
+  const uint64_t *pow5 = parse::detail::power_of_five_128 + 2 * (q + 342);
+  uint128_parts product = full_multiplication(w, pow5[0]);
+  const uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFULL >> 55;
+  if ((product.high & precision_mask) == precision_mask) {
+    uint128_parts second = full_multiplication(w, pow5[1]);
+    product.low += second.high;
+    if (second.high > product.low) {
+      ++product.high;
+    }
+  }
+  if (product.low == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55)) {
+    return false;
+  }
+  int upperbit = (int)(product.high >> 63);
+  int shift = upperbit + 64 - 52 - 3;
+  uint64_t mantissa = product.high >> shift;
+  // floor(log2(10^q)) + 63, plus the normalization, plus the exponent bias
+  int64_t power2 =
+      (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+  if (power2 <= 0) {
+    return false;
+  }
+  // Exactly halfway between two floats rounds to even
+  if (product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+      (mantissa << shift) == product.high) {
+    mantissa &= ~(uint64_t)1;
+  }
+  mantissa += (mantissa & 1);
+  mantissa >>= 1;
+  if (mantissa >= ((uint64_t)2 << 52)) {
+    mantissa = (uint64_t)1 << 52;
+    ++power2;
+  }
+  mantissa &= ~((uint64_t)1 << 52);
+  if (power2 >= 0x7FF) {
+    return false;
+  }
+  uint64_t bits = ((uint64_t)power2 << 52) | mantissa;
+  memcpy(&out, &bits, sizeof(out));
+  return true;
+}
+
+/**
+ * Converts a plain decimal number, ``-?digits[.digits][(e|E)[+-]digits]``,
+ * exactly. Returns false for anything else, or if the number needs more
+ * than 19 significant digits, so the caller can fall back to strtod.
+ */
+bool fast_string_to_float64(const char *begin, const char *end, double &out)
+{
+  bool negative = false;
+  if (begin < end && *begin == '-') {
+    negative = true;
+    ++begin;
+  }
+  const char *digits_begin = begin;
+  uint64_t w = 0;
+  begin = accumulate_digits(begin, end, w);
+  const char *int_end = begin;
+  int64_t q = 0;
+  intptr_t digit_count = int_end - digits_begin;
+  if (begin < end && *begin == '.') {
+    const char *frac_begin = ++begin;
+    begin = accumulate_digits(begin, end, w);
+    q = frac_begin - begin;
+    digit_count += begin - frac_begin;
+  }
+  if (digit_count == 0) {
+    return false;
+  }
+  if (begin < end && (*begin == 'e' || *begin == 'E')) {
+    bool negative_exponent = false;
+    if (++begin < end && (*begin == '+' || *begin == '-')) {
+      negative_exponent = (*begin == '-');
+      ++begin;
+    }
+    if (begin == end || *begin < '0' || *begin > '9') {
+      return false;
+    }
+    int64_t exponent = 0;
+    while (begin < end && '0' <= *begin && *begin <= '9') {
+      if (exponent < 100000) {
+        exponent = exponent * 10 + (*begin - '0');
+      }
+      ++begin;
+    }
+    q += negative_exponent ? -exponent : exponent;
+  }
+  if (begin != end) {
+    return false;
+  }
+  if (digit_count > 19) {
+    // Leading zeros don't count, but any more digits could have
+    // overflowed the mantissa
+    const char *p = digits_begin;
+    while (p < end && (*p == '0' || *p == '.')) {
+      if (*p++ == '0') {
+        --digit_count;
+      }
+    }
+    if (digit_count > 19) {
+      return false;
+    }
+  }
+
+  double value;
+  if (w == 0) {
+    value = 0;
+  }
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  // Clinger's fast path, where w and 10^|q| are exact doubles
+  // and a single correctly rounded operation gives the result
+  else if (w <= ((uint64_t)1 << 53) && q >= -22 && q <= 22) {
+    static const double powers_of_ten[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    value = (double)w;
+    if (q < 0) {
+      value /= powers_of_ten[-q];
+    } else {
+      value *= powers_of_ten[q];
+    }
+  }
+#endif
+  else if (!eisel_lemire_float64(w, q, value)) {
+    return false;
+  }
+  out = negative ? -value : value;
+  return true;
+}
+} // anonymous namespace
+
 double parse::checked_string_to_float64(const char *begin, const char *end,
                                         assign_error_mode errmode)
 {
+  double result;
+  if (fast_string_to_float64(begin, end, result)) {
+    return result;
+  }
+
   bool negative = false;
   const char *pos = begin;
   if (pos < end && *pos == '-') {
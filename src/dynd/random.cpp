@@ -3,79 +3,745 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <vector>
+
 #include <dynd/random.hpp>
+#include <dynd/eval/thread_pool.hpp>
+#include <dynd/func/call_callable.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/base_struct_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/pointer_type.hpp>
+#include <dynd/shortvector.hpp>
 
 using namespace std;
 using namespace dynd;
 
-// Currently using c stdlib rand(), which is known to
-// be a terrible thing to do, this function needs to
-// be replaced before it's reasonable for serious
-// applications
-inline void bad_quality_random(float *out)
+void detail::philox4x32_10(const uint32_t *counter, const uint32_t *key,
+                           uint32_t *out)
 {
-  *out = ::rand() / ((float)RAND_MAX);
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int r = 0; r < 10; ++r) {
+    uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+    uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t)p1;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t)p0;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
 }
 
-inline void bad_quality_random(double *out)
+namespace {
+
+// Number of Philox counters generated together. The rounds are applied
+// across the whole batch one at a time, in a loop the compiler can
+// vectorize.
+const intptr_t philox_batch_size = 64;
+
+// Number of array elements per parallel chunk. This must be a multiple
+// of every sampler's values_per_counter, so that chunks begin on a
+// counter boundary.
+const intptr_t random_chunk_size = 16384;
+
+/**
+ * Generates the Philox4x32-10 outputs for the ``count`` counters starting
+ * at ``first``, with the stream in the high half of the counter, into
+ * ``out`` as four words per counter.
+ */
+void philox4x32_10_batch(uint64_t seed, uint64_t stream, uint64_t first,
+                         intptr_t count, uint32_t *out)
 {
-  *out = ::rand() / ((double)RAND_MAX);
+  uint32_t c0[philox_batch_size], c1[philox_batch_size],
+      c2[philox_batch_size], c3[philox_batch_size];
+  for (intptr_t i = 0; i < count; ++i) {
+    c0[i] = (uint32_t)(first + i);
+    c1[i] = (uint32_t)((first + i) >> 32);
+    c2[i] = (uint32_t)stream;
+    c3[i] = (uint32_t)(stream >> 32);
+  }
+  uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+  for (int r = 0; r < 10; ++r) {
+    for (intptr_t i = 0; i < count; ++i) {
+      uint64_t p0 = (uint64_t)0xD2511F53u * c0[i];
+      uint64_t p1 = (uint64_t)0xCD9E8D57u * c2[i];
+      c0[i] = (uint32_t)(p1 >> 32) ^ c1[i] ^ k0;
+      c1[i] = (uint32_t)p1;
+      c2[i] = (uint32_t)(p0 >> 32) ^ c3[i] ^ k1;
+      c3[i] = (uint32_t)p0;
+    }
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  for (intptr_t i = 0; i < count; ++i) {
+    out[4 * i] = c0[i];
+    out[4 * i + 1] = c1[i];
+    out[4 * i + 2] = c2[i];
+    out[4 * i + 3] = c3[i];
+  }
 }
 
-inline void bad_quality_random(dynd_complex<float> *out)
+inline uint64_t make_uint64(uint32_t lo, uint32_t hi)
 {
-  *out = dynd_complex<float>(::rand() / ((float)RAND_MAX),
-                             ::rand() / ((float)RAND_MAX));
+  return (uint64_t)lo | ((uint64_t)hi << 32);
 }
 
-inline void bad_quality_random(dynd_complex<double> *out)
+// A double in [0, 1) from the top 53 bits
+inline double to_unit_double(uint64_t u)
 {
-  *out = dynd_complex<double>(::rand() / ((double)RAND_MAX),
-                              ::rand() / ((double)RAND_MAX));
+  return (u >> 11) * (1.0 / 9007199254740992.0);
 }
 
-template<class T>
-static void fill_random(const nd::array &a, intptr_t count)
+// A float in [0, 1) from the top 24 bits
+inline float to_unit_float(uint32_t u)
 {
-  T *v = reinterpret_cast<T *>(a.get_readwrite_originptr());
-  for (intptr_t i = 0; i < count; ++i) {
-    bad_quality_random(&v[i]);
-  }
+  return (u >> 8) * (1.0f / 16777216.0f);
 }
 
-nd::array nd::rand(const ndt::type &tp) {
-  intptr_t strided_ndim = tp.get_strided_ndim();
-  ndt::type dtp = tp.get_type_at_dimension(NULL, strided_ndim);
+inline uint64_t mulhi64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+  return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+  return hi_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
 
-  nd::array res = nd::empty(tp);
+/**
+ * The samplers turn the four words of one Philox output into
+ * ``values_per_counter`` values of the distribution.
+ */
+/**
+ * Scales a value in [0, 1) to [low, high). As ``low + span * u`` can
+ * round to ``high`` when u is close to 1, it is clamped to the last
+ * value before ``high``.
+ */
+template <class T>
+struct uniform_scale {
+  T low, span, last;
 
-  // Get the total number of elements to fill in randomly
-  intptr_t total_size = 1;
-  const size_stride_t *arrmeta =
-      reinterpret_cast<const size_stride_t *>(res.get_arrmeta());
-  for (intptr_t i = 0; i < strided_ndim; ++i) {
-    total_size *= arrmeta[i].dim_size;
+  inline T operator()(T u) const
+  {
+    T v = low + span * u;
+    return (span > 0 ? v > last : v < last) ? last : v;
   }
+};
 
-  switch (dtp.get_type_id()) {
+template <class T>
+struct uniform_real_sampler {
+  typedef T value_type;
+  static const int values_per_counter = sizeof(T) == 4 ? 4 : 2;
+  uniform_scale<T> scale;
+
+  inline void operator()(const uint32_t *w, T *out) const
+  {
+    if (sizeof(T) == 4) {
+      for (int i = 0; i < 4; ++i) {
+        out[i] = scale((T)to_unit_float(w[i]));
+      }
+    } else {
+      out[0] = scale((T)to_unit_double(make_uint64(w[0], w[1])));
+      out[1] = scale((T)to_unit_double(make_uint64(w[2], w[3])));
+    }
+  }
+};
+
+template <class T>
+struct uniform_complex_sampler {
+  typedef dynd_complex<T> value_type;
+  static const int values_per_counter = sizeof(T) == 4 ? 2 : 1;
+  uniform_scale<T> scale;
+
+  inline void operator()(const uint32_t *w, dynd_complex<T> *out) const
+  {
+    if (sizeof(T) == 4) {
+      out[0] = dynd_complex<T>(scale((T)to_unit_float(w[0])),
+                               scale((T)to_unit_float(w[1])));
+      out[1] = dynd_complex<T>(scale((T)to_unit_float(w[2])),
+                               scale((T)to_unit_float(w[3])));
+    } else {
+      out[0] = dynd_complex<T>(
+          scale((T)to_unit_double(make_uint64(w[0], w[1]))),
+          scale((T)to_unit_double(make_uint64(w[2], w[3]))));
+    }
+  }
+};
+
+/** Normal values by the Box-Muller transform, two per counter */
+template <class T>
+struct normal_sampler {
+  typedef T value_type;
+  static const int values_per_counter = 2;
+  double mean, stddev;
+
+  inline void operator()(const uint32_t *w, T *out) const
+  {
+    // u1 is in (0, 1], so the log is finite
+    double u1 = ((make_uint64(w[0], w[1]) >> 11) + 1) *
+                (1.0 / 9007199254740992.0);
+    double u2 = to_unit_double(make_uint64(w[2], w[3]));
+    double r = stddev * sqrt(-2.0 * log(u1));
+    double theta = 6.283185307179586476925 * u2;
+    out[0] = static_cast<T>(mean + r * cos(theta));
+    out[1] = static_cast<T>(mean + r * sin(theta));
+  }
+};
+
+/**
+ * Integers in [low, high], scaling 64 random bits to the range by
+ * a multiply-high, whose bias is below range / 2^64.
+ */
+template <class T>
+struct randint_sampler {
+  typedef T value_type;
+  static const int values_per_counter = 2;
+  uint64_t low;
+  // The size of the range, or 0 for all 2^64 values
+  uint64_t range;
+
+  inline T scale(uint64_t u) const
+  {
+    return static_cast<T>(low + (range == 0 ? u : mulhi64(u, range)));
+  }
+
+  inline void operator()(const uint32_t *w, T *out) const
+  {
+    out[0] = scale(make_uint64(w[0], w[1]));
+    out[1] = scale(make_uint64(w[2], w[3]));
+  }
+};
+
+/**
+ * Walks the elements of a strided array in C order.
+ */
+struct strided_position {
+  intptr_t ndim;
+  const size_stride_t *shape;
+  shortvector<intptr_t> index;
+  char *ptr;
+
+  strided_position(intptr_t ndim, const size_stride_t *shape, char *data,
+                   intptr_t flat_index)
+      : ndim(ndim), shape(shape), index(ndim), ptr(data)
+  {
+    for (intptr_t i = ndim - 1; i >= 0; --i) {
+      index[i] = flat_index % shape[i].dim_size;
+      flat_index /= shape[i].dim_size;
+      ptr += index[i] * shape[i].stride;
+    }
+  }
+
+  inline void next()
+  {
+    for (intptr_t i = ndim - 1; i >= 0; --i) {
+      if (++index[i] < shape[i].dim_size) {
+        ptr += shape[i].stride;
+        return;
+      }
+      ptr -= (shape[i].dim_size - 1) * shape[i].stride;
+      index[i] = 0;
+    }
+  }
+};
+
+template <class Sampler>
+struct random_fill_job {
+  Sampler sampler;
+  uint64_t seed, stream;
+  intptr_t ndim;
+  const size_stride_t *shape;
+  char *data;
+  intptr_t size;
+};
+
+template <class Sampler>
+void random_fill_chunk(intptr_t DYND_UNUSED(thread_index),
+                       intptr_t chunk_index, void *data)
+{
+  typedef typename Sampler::value_type T;
+  const int per_counter = Sampler::values_per_counter;
+  const random_fill_job<Sampler> *job =
+      reinterpret_cast<const random_fill_job<Sampler> *>(data);
+  intptr_t i = chunk_index * random_chunk_size;
+  intptr_t end = min(i + random_chunk_size, job->size);
+  strided_position pos(job->ndim, job->shape, job->data, i);
+
+  uint32_t words[4 * philox_batch_size];
+  T values[per_counter * philox_batch_size];
+  while (i < end) {
+    intptr_t ncounters =
+        min(philox_batch_size, (end - i + per_counter - 1) / per_counter);
+    philox4x32_10_batch(job->seed, job->stream, (uint64_t)(i / per_counter),
+                        ncounters, words);
+    for (intptr_t j = 0; j < ncounters; ++j) {
+      job->sampler(words + 4 * j, values + per_counter * j);
+    }
+    intptr_t nvalues = min(ncounters * per_counter, end - i);
+    for (intptr_t j = 0; j < nvalues; ++j) {
+      *reinterpret_cast<T *>(pos.ptr) = values[j];
+      pos.next();
+    }
+    i += nvalues;
+  }
+}
+
+/**
+ * Fills the strided array with values from the sampler, in chunks
+ * of a fixed size so the result is independent of ``nthreads``.
+ */
+template <class Sampler>
+void random_fill(const Sampler &sampler, uint64_t seed, uint64_t stream,
+                 intptr_t ndim, const size_stride_t *shape, char *data,
+                 intptr_t nthreads)
+{
+  random_fill_job<Sampler> job;
+  job.sampler = sampler;
+  job.seed = seed;
+  job.stream = stream;
+  job.ndim = ndim;
+  job.shape = shape;
+  job.data = data;
+  job.size = 1;
+  for (intptr_t i = 0; i < ndim; ++i) {
+    job.size *= shape[i].dim_size;
+  }
+  if (job.size > 0) {
+    intptr_t nchunks = (job.size + random_chunk_size - 1) / random_chunk_size;
+    eval::parallel_for(nthreads, nchunks, &random_fill_chunk<Sampler>, &job);
+  }
+}
+
+template <class T>
+uniform_scale<T> make_uniform_scale(double low, double high)
+{
+  uniform_scale<T> scale;
+  scale.low = static_cast<T>(low);
+  scale.span = static_cast<T>(high - low);
+  scale.last = nextafter(static_cast<T>(high), static_cast<T>(low));
+  return scale;
+}
+
+template <class T>
+uniform_real_sampler<T> make_uniform_real_sampler(double low, double high)
+{
+  uniform_real_sampler<T> sampler;
+  sampler.scale = make_uniform_scale<T>(low, high);
+  return sampler;
+}
+
+template <class T>
+uniform_complex_sampler<T> make_uniform_complex_sampler(double low,
+                                                        double high)
+{
+  uniform_complex_sampler<T> sampler;
+  sampler.scale = make_uniform_scale<T>(low, high);
+  return sampler;
+}
+
+void random_fill_uniform(type_id_t tid, double low, double high,
+                         uint64_t seed, uint64_t stream, intptr_t ndim,
+                         const size_stride_t *shape, char *data,
+                         intptr_t nthreads)
+{
+  switch (tid) {
   case float32_type_id:
-    fill_random<float>(res, total_size);
+    random_fill(make_uniform_real_sampler<float>(low, high), seed, stream,
+                ndim, shape, data, nthreads);
     break;
   case float64_type_id:
-    fill_random<double>(res, total_size);
+    random_fill(make_uniform_real_sampler<double>(low, high), seed, stream,
+                ndim, shape, data, nthreads);
     break;
   case complex_float32_type_id:
-    fill_random<dynd_complex<float> >(res, total_size);
+    random_fill(make_uniform_complex_sampler<float>(low, high), seed, stream,
+                ndim, shape, data, nthreads);
     break;
   case complex_float64_type_id:
-    fill_random<dynd_complex<double> >(res, total_size);
+    random_fill(make_uniform_complex_sampler<double>(low, high), seed, stream,
+                ndim, shape, data, nthreads);
     break;
   default: {
     stringstream ss;
-    ss << "dynd rand: unsupported dtype " << dtp;
+    ss << "dynd rand: unsupported dtype " << ndt::type(tid);
     throw std::runtime_error(ss.str());
   }
   }
+}
+
+/**
+ * Returns a seed for nd::rand calls without one, different on every call.
+ */
+uint64_t next_auto_seed()
+{
+  static atomic<uint64_t> counter(0);
+  static const uint64_t base = ((uint64_t)random_device()() << 32) ^
+                               (uint64_t)random_device()();
+  // SplitMix64 finalizer, so consecutive calls get unrelated seeds
+  uint64_t z = base + 0x9E3779B97F4A7C15ULL * ++counter;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+} // anonymous namespace
 
+nd::array nd::rand(const ndt::type &tp, uint64_t seed, uint64_t stream)
+{
+  intptr_t strided_ndim = tp.get_strided_ndim();
+  ndt::type dtp = tp.get_type_at_dimension(NULL, strided_ndim);
+
+  nd::array res = nd::empty(tp);
+  const size_stride_t *shape =
+      reinterpret_cast<const size_stride_t *>(res.get_arrmeta());
+  random_fill_uniform(dtp.get_type_id(), 0, 1, seed, stream, strided_ndim,
+                      shape, res.get_readwrite_originptr(),
+                      eval::default_eval_context.nthreads);
   return res;
 }
+
+nd::array nd::rand(const ndt::type &tp)
+{
+  return nd::rand(tp, next_auto_seed());
+}
+
+namespace {
+
+enum random_distribution_t {
+  random_uniform,
+  random_normal,
+  random_randint
+};
+
+struct random_arrfunc_data {
+  random_distribution_t distribution;
+  type_id_t tid;
+};
+
+const char *get_name(random_distribution_t distribution)
+{
+  switch (distribution) {
+  case random_uniform:
+    return "uniform";
+  case random_normal:
+    return "normal";
+  default:
+    return "randint";
+  }
+}
+
+/**
+ * Gets the keyword argument ``name``, returning false if it was not
+ * passed. Array values are passed by pointer, and get dereferenced.
+ */
+bool get_kwd(const nd::array &kwds, const char *name, nd::array &out)
+{
+  if (kwds.is_null()) {
+    return false;
+  }
+  intptr_t i = kwds.get_type().extended<base_struct_type>()->get_field_index(
+      name);
+  if (i < 0) {
+    return false;
+  }
+  out = kwds.p(name);
+  if (out.get_type().get_type_id() == pointer_type_id) {
+    out = out.f("dereference");
+  }
+  return true;
+}
+
+void validate_kwds(random_distribution_t distribution, const nd::array &kwds)
+{
+  if (kwds.is_null()) {
+    return;
+  }
+  const base_struct_type *kwds_tp =
+      kwds.get_type().extended<base_struct_type>();
+  for (intptr_t i = 0; i < kwds_tp->get_field_count(); ++i) {
+    std::string name = kwds_tp->get_field_name(i);
+    if (name == "shape" || name == "seed" || name == "stream") {
+      continue;
+    }
+    if (distribution == random_normal ? (name == "mean" || name == "stddev")
+                                      : (name == "low" || name == "high")) {
+      continue;
+    }
+    stringstream ss;
+    ss << "dynd " << get_name(distribution)
+       << ": unexpected keyword \"" << name << "\"";
+    throw invalid_argument(ss.str());
+  }
+}
+
+template <class T>
+T get_kwd_value(const nd::array &kwds, const char *name, T default_value)
+{
+  nd::array value;
+  return get_kwd(kwds, name, value) ? value.as<T>() : default_value;
+}
+
+template <class Sampler>
+struct random_fill_ck
+    : public kernels::expr_ck<random_fill_ck<Sampler>, kernel_request_host, 0> {
+  Sampler m_sampler;
+  uint64_t m_seed, m_stream;
+  intptr_t m_nthreads;
+  std::vector<size_stride_t> m_shape;
+
+  inline void single(char *dst, char *const *DYND_UNUSED(src))
+  {
+    random_fill(m_sampler, m_seed, m_stream, (intptr_t)m_shape.size(),
+                m_shape.empty() ? NULL : &m_shape[0], dst, m_nthreads);
+  }
+};
+
+template <class Sampler>
+intptr_t make_random_fill_ck(void *ckb, intptr_t ckb_offset,
+                             kernel_request_t kernreq,
+                             const Sampler &sampler, uint64_t seed,
+                             uint64_t stream, intptr_t ndim,
+                             const size_stride_t *shape,
+                             const eval::eval_context *ectx)
+{
+  typedef random_fill_ck<Sampler> self_type;
+  self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
+  self->m_sampler = sampler;
+  self->m_seed = seed;
+  self->m_stream = stream;
+  self->m_nthreads = ectx->nthreads;
+  self->m_shape.assign(shape, shape + ndim);
+  return ckb_offset;
+}
+
+template <class T>
+intptr_t make_randint_ck(void *ckb, intptr_t ckb_offset,
+                         kernel_request_t kernreq, const nd::array &kwds,
+                         uint64_t seed, uint64_t stream, intptr_t ndim,
+                         const size_stride_t *shape,
+                         const eval::eval_context *ectx)
+{
+  T low = get_kwd_value<T>(kwds, "low", 0);
+  T high = get_kwd_value<T>(kwds, "high", numeric_limits<T>::max());
+  if (high < low) {
+    stringstream ss;
+    ss << "dynd randint: \"high\" (" << high << ") is less than \"low\" ("
+       << low << ")";
+    throw invalid_argument(ss.str());
+  }
+  randint_sampler<T> sampler;
+  sampler.low = (uint64_t)low;
+  sampler.range = (uint64_t)high - (uint64_t)low + 1;
+  return make_random_fill_ck(ckb, ckb_offset, kernreq, sampler, seed, stream,
+                             ndim, shape, ectx);
+}
+
+intptr_t instantiate_random(const arrfunc_type_data *af_self,
+                            const arrfunc_type *DYND_UNUSED(af_tp), void *ckb,
+                            intptr_t ckb_offset, const ndt::type &dst_tp,
+                            const char *dst_arrmeta,
+                            const ndt::type *DYND_UNUSED(src_tp),
+                            const char *const *DYND_UNUSED(src_arrmeta),
+                            kernel_request_t kernreq,
+                            const eval::eval_context *ectx,
+                            const nd::array &kwds)
+{
+  const random_arrfunc_data *data =
+      af_self->get_data_as<random_arrfunc_data>();
+  validate_kwds(data->distribution, kwds);
+
+  intptr_t ndim = dst_tp.get_strided_ndim();
+  const size_stride_t *shape;
+  ndt::type el_tp;
+  const char *el_arrmeta;
+  if (!dst_tp.get_as_strided(dst_arrmeta, ndim, &shape, &el_tp,
+                             &el_arrmeta) ||
+      el_tp.get_type_id() != data->tid) {
+    stringstream ss;
+    ss << "dynd " << get_name(data->distribution) << ": cannot fill "
+       << dst_tp << ", expected a strided array of " << ndt::type(data->tid);
+    throw type_error(ss.str());
+  }
+
+  uint64_t seed = get_kwd_value<uint64_t>(kwds, "seed", 0);
+  uint64_t stream = get_kwd_value<uint64_t>(kwds, "stream", 0);
+  switch (data->distribution) {
+  case random_uniform: {
+    double low = get_kwd_value<double>(kwds, "low", 0);
+    double high = get_kwd_value<double>(kwds, "high", 1);
+    switch (data->tid) {
+    case float32_type_id:
+      return make_random_fill_ck(ckb, ckb_offset, kernreq,
+                                 make_uniform_real_sampler<float>(low, high),
+                                 seed, stream, ndim, shape, ectx);
+    case float64_type_id:
+      return make_random_fill_ck(ckb, ckb_offset, kernreq,
+                                 make_uniform_real_sampler<double>(low, high),
+                                 seed, stream, ndim, shape, ectx);
+    case complex_float32_type_id:
+      return make_random_fill_ck(
+          ckb, ckb_offset, kernreq,
+          make_uniform_complex_sampler<float>(low, high), seed, stream, ndim,
+          shape, ectx);
+    default:
+      return make_random_fill_ck(
+          ckb, ckb_offset, kernreq,
+          make_uniform_complex_sampler<double>(low, high), seed, stream, ndim,
+          shape, ectx);
+    }
+  }
+  case random_normal: {
+    double mean = get_kwd_value<double>(kwds, "mean", 0);
+    double stddev = get_kwd_value<double>(kwds, "stddev", 1);
+    if (data->tid == float32_type_id) {
+      normal_sampler<float> sampler;
+      sampler.mean = mean;
+      sampler.stddev = stddev;
+      return make_random_fill_ck(ckb, ckb_offset, kernreq, sampler, seed,
+                                 stream, ndim, shape, ectx);
+    } else {
+      normal_sampler<double> sampler;
+      sampler.mean = mean;
+      sampler.stddev = stddev;
+      return make_random_fill_ck(ckb, ckb_offset, kernreq, sampler, seed,
+                                 stream, ndim, shape, ectx);
+    }
+  }
+  default:
+    switch (data->tid) {
+    case int8_type_id:
+      return make_randint_ck<int8_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                     stream, ndim, shape, ectx);
+    case int16_type_id:
+      return make_randint_ck<int16_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                      stream, ndim, shape, ectx);
+    case int32_type_id:
+      return make_randint_ck<int32_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                      stream, ndim, shape, ectx);
+    case int64_type_id:
+      return make_randint_ck<int64_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                      stream, ndim, shape, ectx);
+    case uint8_type_id:
+      return make_randint_ck<uint8_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                      stream, ndim, shape, ectx);
+    case uint16_type_id:
+      return make_randint_ck<uint16_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                       stream, ndim, shape, ectx);
+    case uint32_type_id:
+      return make_randint_ck<uint32_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                       stream, ndim, shape, ectx);
+    default:
+      return make_randint_ck<uint64_t>(ckb, ckb_offset, kernreq, kwds, seed,
+                                       stream, ndim, shape, ectx);
+    }
+  }
+}
+
+int resolve_random_dst_type(const arrfunc_type_data *af_self,
+                            const arrfunc_type *DYND_UNUSED(af_tp),
+                            intptr_t nsrc,
+                            const ndt::type *DYND_UNUSED(src_tp),
+                            int throw_on_error, ndt::type &out_dst_tp,
+                            const nd::array &kwds)
+{
+  const random_arrfunc_data *data =
+      af_self->get_data_as<random_arrfunc_data>();
+  if (nsrc != 0) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "dynd " << get_name(data->distribution)
+         << ": expected no positional arguments, but received " << nsrc;
+      throw invalid_argument(ss.str());
+    }
+    return 0;
+  }
+  validate_kwds(data->distribution, kwds);
+
+  out_dst_tp = ndt::type(data->tid);
+  nd::array shape;
+  if (get_kwd(kwds, "shape", shape)) {
+    if (shape.get_ndim() == 0) {
+      out_dst_tp = ndt::make_fixed_dim(shape.as<intptr_t>(), out_dst_tp);
+    } else {
+      for (intptr_t i = shape.get_dim_size() - 1; i >= 0; --i) {
+        out_dst_tp = ndt::make_fixed_dim(shape(i).as<intptr_t>(), out_dst_tp);
+      }
+    }
+  }
+  return 1;
+}
+
+nd::arrfunc make_random_arrfunc(random_distribution_t distribution,
+                                type_id_t tid)
+{
+  nd::array af = nd::empty(ndt::make_funcproto(0, NULL, ndt::type(tid)));
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  random_arrfunc_data *data = out_af->get_data_as<random_arrfunc_data>();
+  data->distribution = distribution;
+  data->tid = tid;
+  out_af->instantiate = &instantiate_random;
+  out_af->resolve_dst_type = &resolve_random_dst_type;
+  out_af->free = NULL;
+  af.flag_as_immutable();
+  return af;
+}
+
+} // anonymous namespace
+
+nd::arrfunc dynd::make_uniform_arrfunc(type_id_t tid)
+{
+  if (tid != float32_type_id && tid != float64_type_id &&
+      tid != complex_float32_type_id && tid != complex_float64_type_id) {
+    stringstream ss;
+    ss << "make_uniform_arrfunc: data type " << ndt::type(tid)
+       << " is not supported";
+    throw type_error(ss.str());
+  }
+  return make_random_arrfunc(random_uniform, tid);
+}
+
+nd::arrfunc dynd::make_normal_arrfunc(type_id_t tid)
+{
+  if (tid != float32_type_id && tid != float64_type_id) {
+    stringstream ss;
+    ss << "make_normal_arrfunc: data type " << ndt::type(tid)
+       << " is not supported";
+    throw type_error(ss.str());
+  }
+  return make_random_arrfunc(random_normal, tid);
+}
+
+nd::arrfunc dynd::make_randint_arrfunc(type_id_t tid)
+{
+  switch (tid) {
+  case int8_type_id:
+  case int16_type_id:
+  case int32_type_id:
+  case int64_type_id:
+  case uint8_type_id:
+  case uint16_type_id:
+  case uint32_type_id:
+  case uint64_type_id:
+    return make_random_arrfunc(random_randint, tid);
+  default: {
+    stringstream ss;
+    ss << "make_randint_arrfunc: data type " << ndt::type(tid)
+       << " is not supported";
+    throw type_error(ss.str());
+  }
+  }
+}
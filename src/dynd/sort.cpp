@@ -0,0 +1,763 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <dynd/sort.hpp>
+#include <dynd/eval/thread_pool.hpp>
+#include <dynd/func/lift_arrfunc.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/kernels/comparison_kernels.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/cfixed_dim_type.hpp>
+#include <dynd/types/string_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// Dimensions at least this long are sorted in parallel when the eval
+// context allows more than one thread
+const intptr_t parallel_sort_threshold = 1 << 20;
+
+// Dimensions shorter than this are insertion sorted, since the radix
+// sort histograms cost more than the sort itself
+const intptr_t radix_sort_threshold = 64;
+
+/**
+ * Maps the values of a builtin type to unsigned keys which order the
+ * same way, so they can be radix sorted, and back again.
+ */
+template <typename T>
+struct unsigned_radix_traits {
+  typedef T key_type;
+  static const bool has_signed_zero = false;
+  static inline key_type to_key(T v) { return v; }
+  static inline T from_key(key_type k) { return k; }
+};
+
+template <typename T, typename U>
+struct signed_radix_traits {
+  typedef U key_type;
+  static const bool has_signed_zero = false;
+  static const U sign_bit = (U)1 << (sizeof(U) * 8 - 1);
+  static inline key_type to_key(T v) { return (U)v ^ sign_bit; }
+  static inline T from_key(key_type k) { return (T)(k ^ sign_bit); }
+};
+
+/**
+ * Negative floats have all their bits flipped and positive floats just
+ * the sign bit, which orders the bit patterns like the values. Every NaN
+ * maps to the largest key, so they all go last, and -0.0 gets the key of
+ * +0.0, since the two compare equal.
+ */
+template <typename T, typename U>
+struct float_radix_traits {
+  typedef U key_type;
+  static const bool has_signed_zero = true;
+  static const U sign_bit = (U)1 << (sizeof(U) * 8 - 1);
+  static inline key_type to_key(T v)
+  {
+    if (v != v) {
+      return ~(U)0;
+    } else if (v == 0) {
+      return sign_bit;
+    }
+    U bits;
+    memcpy(&bits, &v, sizeof(U));
+    return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+  }
+  static inline T from_key(key_type k)
+  {
+    U bits = (k & sign_bit) ? (k ^ sign_bit) : ~k;
+    T v;
+    memcpy(&v, &bits, sizeof(T));
+    return v;
+  }
+};
+
+template <typename T>
+struct radix_traits;
+
+template <>
+struct radix_traits<uint8_t> : unsigned_radix_traits<uint8_t> {
+};
+template <>
+struct radix_traits<uint16_t> : unsigned_radix_traits<uint16_t> {
+};
+template <>
+struct radix_traits<uint32_t> : unsigned_radix_traits<uint32_t> {
+};
+template <>
+struct radix_traits<uint64_t> : unsigned_radix_traits<uint64_t> {
+};
+template <>
+struct radix_traits<int8_t> : signed_radix_traits<int8_t, uint8_t> {
+};
+template <>
+struct radix_traits<int16_t> : signed_radix_traits<int16_t, uint16_t> {
+};
+template <>
+struct radix_traits<int32_t> : signed_radix_traits<int32_t, uint32_t> {
+};
+template <>
+struct radix_traits<int64_t> : signed_radix_traits<int64_t, uint64_t> {
+};
+template <>
+struct radix_traits<float> : float_radix_traits<float, uint32_t> {
+};
+template <>
+struct radix_traits<double> : float_radix_traits<double, uint64_t> {
+};
+
+/**
+ * Stable insertion sort of keys, carrying the indices along if ``idx``
+ * is not NULL.
+ */
+template <typename K>
+void insertion_sort(K *keys, intptr_t *idx, intptr_t n)
+{
+  for (intptr_t i = 1; i < n; ++i) {
+    K k = keys[i];
+    intptr_t j = i;
+    if (idx != NULL) {
+      intptr_t x = idx[i];
+      for (; j > 0 && k < keys[j - 1]; --j) {
+        keys[j] = keys[j - 1];
+        idx[j] = idx[j - 1];
+      }
+      idx[j] = x;
+    } else {
+      for (; j > 0 && k < keys[j - 1]; --j) {
+        keys[j] = keys[j - 1];
+      }
+    }
+    keys[j] = k;
+  }
+}
+
+/**
+ * LSD radix sort of ``n`` keys, one byte per pass, using ``keys_tmp``
+ * (and ``idx_tmp``) as scratch space of the same size. The indices in
+ * ``idx`` are permuted along with the keys unless it is NULL. Passes over
+ * a byte which is the same in every key are skipped.
+ */
+template <typename K>
+void radix_sort(K *keys, K *keys_tmp, intptr_t *idx, intptr_t *idx_tmp,
+                intptr_t n)
+{
+  if (n < radix_sort_threshold) {
+    insertion_sort(keys, idx, n);
+    return;
+  }
+
+  // Histogram every byte position in one pass over the data
+  intptr_t counts[sizeof(K)][256];
+  memset(counts, 0, sizeof(counts));
+  for (intptr_t i = 0; i < n; ++i) {
+    K k = keys[i];
+    for (size_t d = 0; d < sizeof(K); ++d) {
+      ++counts[d][(k >> (8 * d)) & 0xff];
+    }
+  }
+
+  K *src_k = keys, *dst_k = keys_tmp;
+  intptr_t *src_i = idx, *dst_i = idx_tmp;
+  for (size_t d = 0; d < sizeof(K); ++d) {
+    const intptr_t *c = counts[d];
+    if (c[(keys[0] >> (8 * d)) & 0xff] == n) {
+      continue;
+    }
+    intptr_t offsets[256];
+    intptr_t sum = 0;
+    for (int b = 0; b < 256; ++b) {
+      offsets[b] = sum;
+      sum += c[b];
+    }
+    if (src_i != NULL) {
+      for (intptr_t i = 0; i < n; ++i) {
+        intptr_t pos = offsets[(src_k[i] >> (8 * d)) & 0xff]++;
+        dst_k[pos] = src_k[i];
+        dst_i[pos] = src_i[i];
+      }
+    } else {
+      for (intptr_t i = 0; i < n; ++i) {
+        dst_k[offsets[(src_k[i] >> (8 * d)) & 0xff]++] = src_k[i];
+      }
+    }
+    swap(src_k, dst_k);
+    swap(src_i, dst_i);
+  }
+
+  if (src_k != keys) {
+    memcpy(keys, src_k, n * sizeof(K));
+    if (idx != NULL) {
+      memcpy(idx, src_i, n * sizeof(intptr_t));
+    }
+  }
+}
+
+/**
+ * Stable merge of the sorted ranges [begin, mid) and [mid, end) of the
+ * source buffers into the same range of the destination buffers.
+ */
+template <typename K>
+void merge_runs(const K *src_k, const intptr_t *src_i, K *dst_k,
+                intptr_t *dst_i, intptr_t begin, intptr_t mid, intptr_t end)
+{
+  intptr_t i = begin, j = mid, out = begin;
+  while (i < mid && j < end) {
+    if (src_k[j] < src_k[i]) {
+      dst_k[out] = src_k[j];
+      if (src_i != NULL) {
+        dst_i[out] = src_i[j];
+      }
+      ++j;
+    } else {
+      dst_k[out] = src_k[i];
+      if (src_i != NULL) {
+        dst_i[out] = src_i[i];
+      }
+      ++i;
+    }
+    ++out;
+  }
+  if (i < mid) {
+    memcpy(dst_k + out, src_k + i, (mid - i) * sizeof(K));
+    if (src_i != NULL) {
+      memcpy(dst_i + out, src_i + i, (mid - i) * sizeof(intptr_t));
+    }
+  } else if (j < end) {
+    memcpy(dst_k + out, src_k + j, (end - j) * sizeof(K));
+    if (src_i != NULL) {
+      memcpy(dst_i + out, src_i + j, (end - j) * sizeof(intptr_t));
+    }
+  }
+}
+
+template <typename K>
+struct parallel_sort_job {
+  K *keys, *keys_tmp;
+  intptr_t *idx, *idx_tmp;
+  intptr_t n, nruns;
+  // The buffers and run width of the current merge round
+  K *src_k, *dst_k;
+  intptr_t *src_i, *dst_i;
+  intptr_t width;
+
+  intptr_t run_begin(intptr_t r) const
+  {
+    return r >= nruns ? n : n / nruns * r;
+  }
+};
+
+template <typename K>
+void parallel_sort_chunk(intptr_t DYND_UNUSED(thread_index),
+                         intptr_t chunk_index, void *data)
+{
+  parallel_sort_job<K> *job = reinterpret_cast<parallel_sort_job<K> *>(data);
+  intptr_t begin = job->run_begin(chunk_index);
+  intptr_t end = job->run_begin(chunk_index + 1);
+  radix_sort(job->keys + begin, job->keys_tmp + begin,
+             job->idx != NULL ? job->idx + begin : NULL,
+             job->idx != NULL ? job->idx_tmp + begin : NULL, end - begin);
+}
+
+template <typename K>
+void parallel_merge_chunk(intptr_t DYND_UNUSED(thread_index),
+                          intptr_t chunk_index, void *data)
+{
+  parallel_sort_job<K> *job = reinterpret_cast<parallel_sort_job<K> *>(data);
+  intptr_t first_run = chunk_index * 2 * job->width;
+  intptr_t begin = job->run_begin(first_run);
+  intptr_t mid = job->run_begin(first_run + job->width);
+  intptr_t end = job->run_begin(first_run + 2 * job->width);
+  merge_runs(job->src_k, job->src_i, job->dst_k, job->dst_i, begin, mid, end);
+}
+
+/**
+ * Sorts the keys as radix_sort does, splitting large arrays into one run
+ * per thread which are radix sorted in parallel and then merged pairwise.
+ */
+template <typename K>
+void sort_keys(K *keys, K *keys_tmp, intptr_t *idx, intptr_t *idx_tmp,
+               intptr_t n, intptr_t nthreads)
+{
+  if (n < parallel_sort_threshold || nthreads <= 1) {
+    radix_sort(keys, keys_tmp, idx, idx_tmp, n);
+    return;
+  }
+
+  parallel_sort_job<K> job;
+  job.keys = keys;
+  job.keys_tmp = keys_tmp;
+  job.idx = idx;
+  job.idx_tmp = idx_tmp;
+  job.n = n;
+  job.nruns = nthreads;
+  eval::parallel_for(nthreads, job.nruns, &parallel_sort_chunk<K>, &job);
+
+  job.src_k = keys;
+  job.dst_k = keys_tmp;
+  job.src_i = idx;
+  job.dst_i = idx_tmp;
+  for (job.width = 1; job.width < job.nruns; job.width *= 2) {
+    intptr_t npairs = (job.nruns + 2 * job.width - 1) / (2 * job.width);
+    eval::parallel_for(nthreads, npairs, &parallel_merge_chunk<K>, &job);
+    swap(job.src_k, job.dst_k);
+    swap(job.src_i, job.dst_i);
+  }
+  if (job.src_k != keys) {
+    memcpy(keys, job.src_k, n * sizeof(K));
+    if (idx != NULL) {
+      memcpy(idx, job.src_i, n * sizeof(intptr_t));
+    }
+  }
+}
+
+/**
+ * Sorts a strided dimension of a builtin type by radix sorting keys made
+ * from its values, writing either the sorted values or their indices.
+ */
+template <typename T>
+struct radix_sort_ck
+    : public kernels::expr_ck<radix_sort_ck<T>, kernel_request_host, 1> {
+  typedef radix_traits<T> traits;
+  typedef typename traits::key_type key_type;
+
+  intptr_t m_size, m_dst_stride, m_src_stride, m_nthreads;
+  bool m_argsort;
+  // Scratch space, kept for the next call
+  std::vector<key_type> m_keys;
+  std::vector<intptr_t> m_idx;
+
+  inline void single(char *dst, char *const *src)
+  {
+    intptr_t n = m_size;
+    if (n == 0) {
+      return;
+    }
+    m_keys.resize(2 * n);
+    key_type *keys = &m_keys[0];
+    intptr_t *idx = NULL;
+    if (m_argsort) {
+      m_idx.resize(2 * n);
+      idx = &m_idx[0];
+      for (intptr_t i = 0; i < n; ++i) {
+        idx[i] = i;
+      }
+    }
+    const char *s = src[0];
+    for (intptr_t i = 0; i < n; ++i, s += m_src_stride) {
+      keys[i] = traits::to_key(*reinterpret_cast<const T *>(s));
+    }
+
+    sort_keys(keys, keys + n, idx, idx != NULL ? idx + n : NULL, n,
+              m_nthreads);
+
+    if (m_argsort) {
+      for (intptr_t i = 0; i < n; ++i, dst += m_dst_stride) {
+        *reinterpret_cast<intptr_t *>(dst) = idx[i];
+      }
+    } else {
+      char *d = dst;
+      for (intptr_t i = 0; i < n; ++i, d += m_dst_stride) {
+        *reinterpret_cast<T *>(d) = traits::from_key(keys[i]);
+      }
+      if (traits::has_signed_zero) {
+        copy_zeros(dst, src[0], keys, n);
+      }
+    }
+  }
+
+  // All zeros share one key, so the sorted keys only give back +0.0. This
+  // copies the zeros over from the source in their original order, which
+  // keeps the signs of any -0.0 values.
+  void copy_zeros(char *dst, const char *src, const key_type *keys,
+                  intptr_t n) const
+  {
+    const key_type zero_key = traits::to_key(T(0));
+    intptr_t pos = lower_bound(keys, keys + n, zero_key) - keys;
+    if (pos == n || keys[pos] != zero_key) {
+      return;
+    }
+    dst += pos * m_dst_stride;
+    for (intptr_t i = 0; i < n; ++i, src += m_src_stride) {
+      T v = *reinterpret_cast<const T *>(src);
+      if (v == 0) {
+        *reinterpret_cast<T *>(dst) = v;
+        dst += m_dst_stride;
+      }
+    }
+  }
+};
+
+/**
+ * The first 8 bytes of a string as a big-endian integer, zero padded,
+ * which orders like the strings themselves except for ties.
+ */
+inline uint64_t string_prefix_key(const char *begin, const char *end)
+{
+  uint64_t key = 0;
+  intptr_t len = min<intptr_t>(8, end - begin);
+  for (intptr_t i = 0; i < len; ++i) {
+    key |= (uint64_t) static_cast<unsigned char>(begin[i]) << (56 - 8 * i);
+  }
+  return key;
+}
+
+struct string_index_less {
+  const char *m_origin;
+  intptr_t m_stride;
+
+  string_index_less(const char *origin, intptr_t stride)
+      : m_origin(origin), m_stride(stride)
+  {
+  }
+
+  bool operator()(intptr_t i, intptr_t j) const
+  {
+    const string_type_data *a =
+        reinterpret_cast<const string_type_data *>(m_origin + i * m_stride);
+    const string_type_data *b =
+        reinterpret_cast<const string_type_data *>(m_origin + j * m_stride);
+    size_t alen = a->end - a->begin, blen = b->end - b->begin;
+    int cmp = memcmp(a->begin, b->begin, min(alen, blen));
+    return cmp < 0 || (cmp == 0 && alen < blen);
+  }
+};
+
+struct ckernel_index_less {
+  const char *m_origin;
+  intptr_t m_stride;
+  expr_predicate_t m_less;
+  ckernel_prefix *m_less_self;
+
+  ckernel_index_less(const char *origin, intptr_t stride,
+                     ckernel_prefix *less_self)
+      : m_origin(origin), m_stride(stride),
+        m_less(less_self->get_function<expr_predicate_t>()),
+        m_less_self(less_self)
+  {
+  }
+
+  bool operator()(intptr_t i, intptr_t j) const
+  {
+    const char *src[2] = {m_origin + i * m_stride, m_origin + j * m_stride};
+    return m_less(src, m_less_self) != 0;
+  }
+};
+
+/**
+ * Sorts a strided dimension of any type by computing the sorting
+ * permutation, then writing either it or the values it selects. ascii and
+ * utf8 strings radix sort a prefix of each string first, everything else
+ * uses a comparison merge sort.
+ */
+struct permutation_sort_ck
+    : public kernels::expr_ck<permutation_sort_ck, kernel_request_host, 1> {
+  intptr_t m_size, m_dst_stride, m_src_stride, m_nthreads;
+  bool m_argsort, m_string_prefix;
+  // Offsets of the sorting_less and the element assignment child
+  // ckernels, or 0 if there is none
+  intptr_t m_less_offset, m_assign_offset;
+  // Scratch space, kept for the next call
+  std::vector<uint64_t> m_keys;
+  std::vector<intptr_t> m_idx;
+
+  permutation_sort_ck() : m_less_offset(0), m_assign_offset(0) {}
+
+  inline void single(char *dst, char *const *src)
+  {
+    intptr_t n = m_size;
+    if (n == 0) {
+      return;
+    }
+    const char *origin = src[0];
+    m_idx.resize(2 * n);
+    intptr_t *idx = &m_idx[0];
+    for (intptr_t i = 0; i < n; ++i) {
+      idx[i] = i;
+    }
+
+    if (m_string_prefix) {
+      m_keys.resize(2 * n);
+      uint64_t *keys = &m_keys[0];
+      const char *s = origin;
+      for (intptr_t i = 0; i < n; ++i, s += m_src_stride) {
+        const string_type_data *sd =
+            reinterpret_cast<const string_type_data *>(s);
+        keys[i] = string_prefix_key(sd->begin, sd->end);
+      }
+      sort_keys(keys, keys + n, idx, idx + n, n, m_nthreads);
+      // Only the strings sharing a prefix still need ordering
+      string_index_less less(origin, m_src_stride);
+      for (intptr_t i = 0; i < n;) {
+        intptr_t j = i + 1;
+        while (j < n && keys[j] == keys[i]) {
+          ++j;
+        }
+        if (j - i > 1) {
+          stable_sort(idx + i, idx + j, less);
+        }
+        i = j;
+      }
+    } else {
+      stable_sort(idx, idx + n,
+                  ckernel_index_less(origin, m_src_stride,
+                                     get_child_ckernel(m_less_offset)));
+    }
+
+    if (m_argsort) {
+      for (intptr_t i = 0; i < n; ++i, dst += m_dst_stride) {
+        *reinterpret_cast<intptr_t *>(dst) = idx[i];
+      }
+    } else {
+      ckernel_prefix *assign = get_child_ckernel(m_assign_offset);
+      expr_single_t assign_fn = assign->get_function<expr_single_t>();
+      for (intptr_t i = 0; i < n; ++i, dst += m_dst_stride) {
+        char *s = const_cast<char *>(origin) + idx[i] * m_src_stride;
+        assign_fn(dst, &s, assign);
+      }
+    }
+  }
+
+  inline void destruct_children()
+  {
+    base.destroy_child_ckernel(m_less_offset);
+    base.destroy_child_ckernel(m_assign_offset);
+  }
+};
+
+template <typename T>
+intptr_t make_radix_sort_ck(void *ckb, intptr_t ckb_offset,
+                            kernel_request_t kernreq, intptr_t size,
+                            intptr_t dst_stride, intptr_t src_stride,
+                            bool argsort, const eval::eval_context *ectx)
+{
+  typedef radix_sort_ck<T> self_type;
+  self_type *self = self_type::create_leaf(ckb, kernreq, ckb_offset);
+  self->m_size = size;
+  self->m_dst_stride = dst_stride;
+  self->m_src_stride = src_stride;
+  self->m_nthreads = ectx->nthreads;
+  self->m_argsort = argsort;
+  return ckb_offset;
+}
+
+intptr_t instantiate_sort(const arrfunc_type_data *af_self,
+                          const arrfunc_type *DYND_UNUSED(af_tp), void *ckb,
+                          intptr_t ckb_offset, const ndt::type &dst_tp,
+                          const char *dst_arrmeta, const ndt::type *src_tp,
+                          const char *const *src_arrmeta,
+                          kernel_request_t kernreq,
+                          const eval::eval_context *ectx,
+                          const nd::array &DYND_UNUSED(kwds))
+{
+  bool argsort = *af_self->get_data_as<bool>();
+  const char *name = argsort ? "argsort" : "sort";
+
+  intptr_t size, dst_stride, src_size, src_stride;
+  ndt::type dst_el_tp, src_el_tp;
+  const char *dst_el_arrmeta, *src_el_arrmeta;
+  if (!dst_tp.get_as_strided(dst_arrmeta, &size, &dst_stride, &dst_el_tp,
+                             &dst_el_arrmeta)) {
+    stringstream ss;
+    ss << "dynd " << name << ": could not process type " << dst_tp
+       << " as a strided dimension";
+    throw type_error(ss.str());
+  }
+  if (!src_tp[0].get_as_strided(src_arrmeta[0], &src_size, &src_stride,
+                                &src_el_tp, &src_el_arrmeta)) {
+    stringstream ss;
+    ss << "dynd " << name << ": could not process type " << src_tp[0]
+       << " as a strided dimension";
+    throw type_error(ss.str());
+  }
+  if (src_size != size) {
+    stringstream ss;
+    ss << "dynd " << name << ": source dimension size " << src_size
+       << " does not match destination dimension size " << size;
+    throw type_error(ss.str());
+  }
+  if (argsort && dst_el_tp.get_type_id() != (type_id_t)type_id_of<intptr_t>::value) {
+    stringstream ss;
+    ss << "dynd argsort: destination type " << dst_tp
+       << " does not have intptr elements";
+    throw type_error(ss.str());
+  }
+
+  if (argsort || dst_el_tp == src_el_tp) {
+    switch (src_el_tp.get_type_id()) {
+    case bool_type_id:
+    case uint8_type_id:
+      return make_radix_sort_ck<uint8_t>(ckb, ckb_offset, kernreq, size,
+                                         dst_stride, src_stride, argsort, ectx);
+    case uint16_type_id:
+      return make_radix_sort_ck<uint16_t>(ckb, ckb_offset, kernreq, size,
+                                          dst_stride, src_stride, argsort,
+                                          ectx);
+    case uint32_type_id:
+      return make_radix_sort_ck<uint32_t>(ckb, ckb_offset, kernreq, size,
+                                          dst_stride, src_stride, argsort,
+                                          ectx);
+    case uint64_type_id:
+      return make_radix_sort_ck<uint64_t>(ckb, ckb_offset, kernreq, size,
+                                          dst_stride, src_stride, argsort,
+                                          ectx);
+    case int8_type_id:
+      return make_radix_sort_ck<int8_t>(ckb, ckb_offset, kernreq, size,
+                                        dst_stride, src_stride, argsort, ectx);
+    case int16_type_id:
+      return make_radix_sort_ck<int16_t>(ckb, ckb_offset, kernreq, size,
+                                         dst_stride, src_stride, argsort, ectx);
+    case int32_type_id:
+      return make_radix_sort_ck<int32_t>(ckb, ckb_offset, kernreq, size,
+                                         dst_stride, src_stride, argsort, ectx);
+    case int64_type_id:
+      return make_radix_sort_ck<int64_t>(ckb, ckb_offset, kernreq, size,
+                                         dst_stride, src_stride, argsort, ectx);
+    case float32_type_id:
+      return make_radix_sort_ck<float>(ckb, ckb_offset, kernreq, size,
+                                       dst_stride, src_stride, argsort, ectx);
+    case float64_type_id:
+      return make_radix_sort_ck<double>(ckb, ckb_offset, kernreq, size,
+                                        dst_stride, src_stride, argsort, ectx);
+    default:
+      break;
+    }
+  }
+
+  typedef permutation_sort_ck self_type;
+  intptr_t root_ckb_offset = ckb_offset;
+  self_type *self = self_type::create(ckb, kernreq, ckb_offset);
+  self->m_size = size;
+  self->m_dst_stride = dst_stride;
+  self->m_src_stride = src_stride;
+  self->m_nthreads = ectx->nthreads;
+  self->m_argsort = argsort;
+  string_encoding_t encoding =
+      src_el_tp.get_type_id() == string_type_id
+          ? src_el_tp.extended<string_type>()->get_encoding()
+          : string_encoding_invalid;
+  self->m_string_prefix =
+      encoding == string_encoding_ascii || encoding == string_encoding_utf_8;
+  if (!self->m_string_prefix) {
+    self->m_less_offset = ckb_offset - root_ckb_offset;
+    ckb_offset = make_comparison_kernel(ckb, ckb_offset, src_el_tp,
+                                        src_el_arrmeta, src_el_tp,
+                                        src_el_arrmeta,
+                                        comparison_type_sorting_less, ectx);
+  }
+  if (!argsort) {
+    // Reserve space for the child, and re-retrieve the self pointer,
+    // because it may be at a new memory location now
+    reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+        ->ensure_capacity(ckb_offset);
+    self = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+               ->get_at<self_type>(root_ckb_offset);
+    self->m_assign_offset = ckb_offset - root_ckb_offset;
+    ckb_offset = make_assignment_kernel(
+        NULL, NULL, ckb, ckb_offset, dst_el_tp, dst_el_arrmeta, src_el_tp,
+        src_el_arrmeta, kernel_request_single, ectx, nd::array());
+  }
+  return ckb_offset;
+}
+
+int resolve_sort_dst_type(const arrfunc_type_data *af_self,
+                          const arrfunc_type *DYND_UNUSED(af_tp), intptr_t nsrc,
+                          const ndt::type *src_tp, int throw_on_error,
+                          ndt::type &out_dst_tp,
+                          const nd::array &DYND_UNUSED(kwds))
+{
+  bool argsort = *af_self->get_data_as<bool>();
+  const char *name = argsort ? "argsort" : "sort";
+  if (nsrc != 1) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "dynd " << name << ": expected 1 argument, but received " << nsrc;
+      throw invalid_argument(ss.str());
+    }
+    return 0;
+  }
+
+  ndt::type tp = src_tp[0].value_type();
+  intptr_t size;
+  switch (tp.get_type_id()) {
+  case fixed_dim_type_id:
+    size = tp.extended<fixed_dim_type>()->get_fixed_dim_size();
+    break;
+  case cfixed_dim_type_id:
+    size = tp.extended<cfixed_dim_type>()->get_fixed_dim_size();
+    break;
+  default:
+    size = -1;
+    break;
+  }
+  if (size < 0 || tp.get_ndim() != 1) {
+    if (throw_on_error) {
+      stringstream ss;
+      ss << "dynd " << name << ": expected a strided dimension of scalars, "
+         << "but received " << src_tp[0];
+      throw type_error(ss.str());
+    }
+    return 0;
+  }
+
+  if (argsort) {
+    out_dst_tp = ndt::make_fixed_dim(size, ndt::make_type<intptr_t>());
+  } else {
+    out_dst_tp = tp;
+  }
+  return 1;
+}
+
+nd::arrfunc make_sort_or_argsort_arrfunc(bool argsort)
+{
+  nd::array af = nd::empty(ndt::type(argsort ? "(N * T) -> N * intptr"
+                                             : "(N * T) -> N * T"));
+  arrfunc_type_data *out_af =
+      reinterpret_cast<arrfunc_type_data *>(af.get_readwrite_originptr());
+  *out_af->get_data_as<bool>() = argsort;
+  out_af->instantiate = &instantiate_sort;
+  out_af->resolve_dst_type = &resolve_sort_dst_type;
+  out_af->free = NULL;
+  af.flag_as_immutable();
+  return af;
+}
+
+nd::array call_sort(const nd::arrfunc &af, const nd::array &a)
+{
+  if (a.get_ndim() == 0) {
+    throw invalid_argument("dynd sort: cannot sort a scalar");
+  } else if (a.get_ndim() == 1) {
+    return af(a);
+  } else {
+    return lift_arrfunc(af)(a);
+  }
+}
+
+} // anonymous namespace
+
+nd::arrfunc dynd::make_sort_arrfunc() { return make_sort_or_argsort_arrfunc(false); }
+
+nd::arrfunc dynd::make_argsort_arrfunc()
+{
+  return make_sort_or_argsort_arrfunc(true);
+}
+
+nd::array nd::sort(const nd::array &a)
+{
+  return call_sort(make_sort_arrfunc(), a);
+}
+
+nd::array nd::argsort(const nd::array &a)
+{
+  return call_sort(make_argsort_arrfunc(), a);
+}
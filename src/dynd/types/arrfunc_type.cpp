@@ -64,6 +64,10 @@ arrfunc_type::arrfunc_type(const ndt::type &return_type,
     }
   }
 
+  m_pos_signature = ndt::pattern_signature(
+      get_npos(), m_arg_types.is_null() ? NULL : get_arg_types_raw(),
+      m_return_type);
+
   // Note that we don't base the flags of this type on that of its arguments
   // and return types, because it is something the can be instantiated, even
   // for arguments that are symbolic.
@@ -3,9 +3,9 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <algorithm>
 #include <cstring>
-#include <map>
-#include <set>
+#include <vector>
 
 #include <dynd/auxiliary_data.hpp>
 #include <dynd/types/categorical_type.hpp>
@@ -13,49 +13,17 @@
 #include <dynd/kernels/comparison_kernels.hpp>
 #include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/convert_type.hpp>
+#include <dynd/types/option_type.hpp>
 #include <dynd/func/make_callable.hpp>
 #include <dynd/array_range.hpp>
+#include <dynd/sort.hpp>
+#include <dynd/hash.hpp>
 
 using namespace dynd;
 using namespace std;
 
 namespace {
 
-    class sorter {
-        const char *m_originptr;
-        intptr_t m_stride;
-        const expr_predicate_t m_less;
-        ckernel_prefix *m_less_self;
-    public:
-      sorter(const char *originptr, intptr_t stride,
-             const expr_predicate_t less, ckernel_prefix *less_self)
-          : m_originptr(originptr), m_stride(stride), m_less(less),
-            m_less_self(less_self)
-      {
-      }
-        bool operator()(intptr_t i, intptr_t j) const {
-            const char *s[2] = {m_originptr + i * m_stride,
-                                m_originptr + j * m_stride};
-            return m_less(s, m_less_self) != 0;
-        }
-    };
-
-    class cmp {
-        const expr_predicate_t m_less;
-        ckernel_prefix *m_less_self;
-    public:
-        cmp(const expr_predicate_t less, ckernel_prefix *less_self)
-          : m_less(less), m_less_self(less_self)
-        {
-        }
-        bool operator()(const char *a, const char *b) const
-        {
-            const char *s[2] = {a, b};
-            bool result = m_less(s, m_less_self) != 0;
-            return result;
-        }
-    };
-
     // Assign from a categorical type to some other type
     struct categorical_to_other_kernel_extra {
         typedef categorical_to_other_kernel_extra extra_type;
@@ -76,6 +44,27 @@ namespace {
           opchild(dst, &src_val, echild);
         }
 
+        template<typename UIntType>
+        static void strided(char *dst, intptr_t dst_stride, char *const *src,
+                            const intptr_t *src_stride, size_t count,
+                            ckernel_prefix *extra)
+        {
+          extra_type *e = reinterpret_cast<extra_type *>(extra);
+          ckernel_prefix *echild = extra->get_child_ckernel(sizeof(extra_type));
+          expr_single_t opchild = echild->get_function<expr_single_t>();
+          const categorical_type *cat_tp = e->src_cat_tp;
+          const char *src0 = src[0];
+          intptr_t src0_stride = src_stride[0];
+          for (size_t i = 0; i != count; ++i) {
+            uint32_t value = *reinterpret_cast<const UIntType *>(src0);
+            char *src_val =
+                const_cast<char *>(cat_tp->get_category_data_from_value(value));
+            opchild(dst, &src_val, echild);
+            dst += dst_stride;
+            src0 += src0_stride;
+          }
+        }
+
         // Some compilers are finicky about getting single<T> as a function pointer, so this...
         static void single_uint8(char *dst, char *const *src,
                                  ckernel_prefix *extra)
@@ -103,6 +92,73 @@ namespace {
         }
     };
 
+    // Assign from a categorical type to its POD category type, by
+    // gathering directly from the categories
+    template <typename UIntType, typename T>
+    struct categorical_gather_kernel_extra {
+        typedef categorical_gather_kernel_extra self_type;
+
+        ckernel_prefix base;
+        const categorical_type *src_cat_tp;
+        const char *categories;
+        intptr_t category_count;
+
+        inline const T *get(const char *src) const
+        {
+            uint32_t value = *reinterpret_cast<const UIntType *>(src);
+            if (value >= (uint32_t)category_count) {
+                throw std::runtime_error("category value is out of bounds");
+            }
+            return reinterpret_cast<const T *>(categories) + value;
+        }
+
+        static void single(char *dst, char *const *src, ckernel_prefix *self)
+        {
+            self_type *e = reinterpret_cast<self_type *>(self);
+            memcpy(dst, e->get(src[0]), sizeof(T));
+        }
+
+        static void strided(char *dst, intptr_t dst_stride, char *const *src,
+                            const intptr_t *src_stride, size_t count,
+                            ckernel_prefix *self)
+        {
+            self_type *e = reinterpret_cast<self_type *>(self);
+            const char *src0 = src[0];
+            intptr_t src0_stride = src_stride[0];
+            if (dst_stride == sizeof(T) && src0_stride == sizeof(UIntType)) {
+                // Check the whole block first, so the gather loop is
+                // free of branches
+                const UIntType *values = reinterpret_cast<const UIntType *>(src0);
+                UIntType max_value = 0;
+                for (size_t i = 0; i != count; ++i) {
+                    max_value = max(max_value, values[i]);
+                }
+                if (count > 0) {
+                    e->get(reinterpret_cast<const char *>(&max_value));
+                }
+                const T *categories = reinterpret_cast<const T *>(e->categories);
+                T *dst_values = reinterpret_cast<T *>(dst);
+                for (size_t i = 0; i != count; ++i) {
+                    dst_values[i] = categories[values[i]];
+                }
+            } else {
+                for (size_t i = 0; i != count; ++i) {
+                    memcpy(dst, e->get(src0), sizeof(T));
+                    dst += dst_stride;
+                    src0 += src0_stride;
+                }
+            }
+        }
+
+        static void destruct(ckernel_prefix *self)
+        {
+            self_type *e = reinterpret_cast<self_type *>(self);
+            if (e->src_cat_tp != NULL) {
+                base_type_decref(e->src_cat_tp);
+            }
+        }
+    };
+
     struct category_to_categorical_kernel_extra {
         typedef category_to_categorical_kernel_extra self_type;
 
@@ -121,6 +177,32 @@ namespace {
             *reinterpret_cast<UIntType *>(dst) = src_val;
         }
 
+        // Looks up a block of categories in the hash table at a time
+        template <typename UIntType>
+        static void strided(char *dst, intptr_t dst_stride, char *const *src,
+                            const intptr_t *src_stride, size_t count,
+                            ckernel_prefix *self)
+        {
+            self_type *e = reinterpret_cast<self_type *>(self);
+            const categorical_type *cat_tp = e->dst_cat_tp;
+            const char *src0 = src[0];
+            intptr_t src0_stride = src_stride[0];
+            intptr_t values[DYND_BUFFER_CHUNK_SIZE];
+            while (count > 0) {
+                intptr_t chunk_size =
+                    min((intptr_t)count, (intptr_t)DYND_BUFFER_CHUNK_SIZE);
+                cat_tp->get_values_from_categories(e->src_arrmeta, src0,
+                                                   src0_stride, chunk_size,
+                                                   values);
+                for (intptr_t i = 0; i < chunk_size; ++i) {
+                    *reinterpret_cast<UIntType *>(dst) = (UIntType)values[i];
+                    dst += dst_stride;
+                }
+                src0 += chunk_size * src0_stride;
+                count -= chunk_size;
+            }
+        }
+
         // Some compilers are finicky about getting single<T> as a function pointer, so this...
         static void single_uint8(char *dst, char *const *src,
                                  ckernel_prefix *self)
@@ -190,114 +272,217 @@ namespace {
 
 } // anoymous namespace
 
-/** This function converts the set of char* pointers into a strided immutable nd::array of the categories */
-static nd::array make_sorted_categories(const set<const char *, cmp> &uniques,
-                                        const ndt::type &element_tp,
-                                        const char *arrmeta)
+template <typename UIntType, typename T>
+static intptr_t alloc_categorical_gather_kernel(const categorical_type *cat_tp,
+                                                void *ckb, intptr_t ckb_offset,
+                                                kernel_request_t kernreq)
 {
-    nd::array categories = nd::empty(uniques.size(), element_tp);
+    typedef categorical_gather_kernel_extra<UIntType, T> self_type;
+    self_type *e = reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
+                       ->alloc_ck_leaf<self_type>(ckb_offset);
+    if (kernreq == kernel_request_single) {
+        e->base.template set_function<expr_single_t>(&self_type::single);
+    } else {
+        e->base.template set_function<expr_strided_t>(&self_type::strided);
+    }
+    e->base.destructor = &self_type::destruct;
+    // The kernel type owns a reference to this type
+    e->src_cat_tp = cat_tp;
+    base_type_incref(cat_tp);
+    e->categories = cat_tp->get_categories().get_readonly_originptr();
+    e->category_count = cat_tp->get_category_count();
+    return ckb_offset;
+}
+
+/**
+ * Makes a kernel which assigns from ``cat_tp`` to its category type,
+ * which must be POD with size ``sizeof(T)``, and be stored contiguously.
+ */
+template <typename T>
+static intptr_t make_categorical_gather_kernel(const categorical_type *cat_tp,
+                                               void *ckb, intptr_t ckb_offset,
+                                               kernel_request_t kernreq)
+{
+    switch (cat_tp->get_storage_type().get_type_id()) {
+    case uint8_type_id:
+        return alloc_categorical_gather_kernel<uint8_t, T>(cat_tp, ckb,
+                                                           ckb_offset, kernreq);
+    case uint16_type_id:
+        return alloc_categorical_gather_kernel<uint16_t, T>(cat_tp, ckb,
+                                                            ckb_offset, kernreq);
+    case uint32_type_id:
+        return alloc_categorical_gather_kernel<uint32_t, T>(cat_tp, ckb,
+                                                            ckb_offset, kernreq);
+    default:
+        throw runtime_error(
+            "internal error in categorical_type::make_assignment_kernel");
+    }
+}
+
+/**
+ * Copies ``values`` into a new immutable array in sorted order. Equal
+ * values are dropped if ``drop_duplicates`` is true, and raise an error
+ * otherwise. If ``out_order`` is not NULL, it receives the index in
+ * ``values`` of each sorted value.
+ */
+static nd::array make_sorted_categories(const nd::array &values,
+                                        bool drop_duplicates,
+                                        nd::array *out_order)
+{
+    intptr_t dim_size, stride;
+    ndt::type el_tp;
+    const char *el_arrmeta;
+    values.get_type().get_as_strided(values.get_arrmeta(), &dim_size, &stride,
+                                     &el_tp, &el_arrmeta);
+    nd::array order = nd::argsort(values);
+
+    comparison_ckernel_builder less;
+    ::make_comparison_kernel(&less, 0, el_tp, el_arrmeta, el_tp, el_arrmeta,
+                             comparison_type_sorting_less,
+                             &eval::default_eval_context);
+
+    // Collect the first of each run of equal values
+    vector<const char *> uniques;
+    uniques.reserve(dim_size);
+    for (intptr_t i = 0; i < dim_size; ++i) {
+        const char *data = values.get_readonly_originptr() +
+                           unchecked_fixed_dim_get<intptr_t>(order, i) * stride;
+        if (!uniques.empty() && !less(uniques.back(), data)) {
+            if (drop_duplicates) {
+                continue;
+            }
+            stringstream ss;
+            ss << "categories must be unique: category value ";
+            el_tp.print_data(ss, el_arrmeta, data);
+            ss << " appears more than once";
+            throw std::runtime_error(ss.str());
+        }
+        uniques.push_back(data);
+    }
+
+    nd::array categories = nd::empty(uniques.size(), el_tp);
     unary_ckernel_builder k;
     make_assignment_kernel(
-        NULL, NULL, &k, 0, element_tp,
-        categories.get_arrmeta() + sizeof(fixed_dim_type_arrmeta), element_tp,
-        arrmeta, kernel_request_single, &eval::default_eval_context, nd::array());
+        NULL, NULL, &k, 0, el_tp,
+        categories.get_arrmeta() + sizeof(fixed_dim_type_arrmeta), el_tp,
+        el_arrmeta, kernel_request_single, &eval::default_eval_context, nd::array());
 
-    intptr_t stride = reinterpret_cast<const fixed_dim_type_arrmeta *>(categories.get_arrmeta())->stride;
+    intptr_t dst_stride = reinterpret_cast<const fixed_dim_type_arrmeta *>(categories.get_arrmeta())->stride;
     char *dst_ptr = categories.get_readwrite_originptr();
-    for (set<const char *, cmp>::const_iterator it = uniques.begin(); it != uniques.end(); ++it) {
-        k(dst_ptr, const_cast<char *>(*it));
-        dst_ptr += stride;
+    for (size_t i = 0; i != uniques.size(); ++i) {
+        k(dst_ptr, const_cast<char *>(uniques[i]));
+        dst_ptr += dst_stride;
     }
     categories.get_type().extended()->arrmeta_finalize_buffers(categories.get_arrmeta());
     categories.flag_as_immutable();
 
+    if (out_order != NULL) {
+        *out_order = order;
+    }
     return categories;
 }
 
+/**
+ * Whether values of ``tp`` with different arrmeta can be compared, as
+ * they are when looking up categories in a hash table.
+ */
+static bool is_arrmeta_independent(const ndt::type &tp)
+{
+    switch (tp.get_type_id()) {
+    case string_type_id:
+    case bytes_type_id:
+        // The arrmeta only holds the blockref of the data
+        return true;
+    case option_type_id:
+        return is_arrmeta_independent(
+            tp.extended<option_type>()->get_value_type());
+    default:
+        return tp.get_arrmeta_size() == 0;
+    }
+}
+
+/**
+ * Returns a hash table of the values in the immutable one-dimensional
+ * array ``categories``, or NULL if the type can't be hashed, or if its
+ * values can't be compared without their own arrmeta. Values assigned
+ * into the categorical are looked up with the arrmeta of the categories.
+ */
+static value_hash_index *make_value_index(const nd::array &categories)
+{
+    intptr_t dim_size, stride;
+    ndt::type el_tp;
+    const char *el_arrmeta;
+    categories.get_type().get_as_strided(categories.get_arrmeta(), &dim_size,
+                                         &stride, &el_tp, &el_arrmeta);
+    if (!is_arrmeta_independent(el_tp)) {
+        return NULL;
+    }
+
+    value_hash_index *index;
+    try {
+        index = new value_hash_index(el_tp, el_arrmeta,
+                                     &eval::default_eval_context);
+    } catch (const dynd::type_error &) {
+        return NULL;
+    }
+    vector<intptr_t> ids(dim_size);
+    index->insert(categories.get_readonly_originptr(), stride, dim_size,
+                  dim_size > 0 ? &ids[0] : NULL);
+    for (intptr_t i = 0; i < dim_size; ++i) {
+        if (ids[i] != i) {
+            delete index;
+            stringstream ss;
+            ss << "categories must be unique: category value ";
+            el_tp.print_data(ss, el_arrmeta,
+                             categories.get_readonly_originptr() + i * stride);
+            ss << " appears more than once";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    return index;
+}
+
 categorical_type::categorical_type(const nd::array& categories, bool presorted)
-    : base_type(categorical_type_id, custom_kind, 4, 4, type_flag_scalar, 0, 0, 0)
+    : base_type(categorical_type_id, custom_kind, 4, 4, type_flag_scalar, 0, 0, 0),
+      m_value_index(NULL)
 {
-    intptr_t category_count;
     if (presorted) {
         // This is construction shortcut, for the case when the categories are already
         // sorted. No validation of this is done, the caller should have ensured it
         // was correct already, typically by construction.
-        m_categories = categories.eval_immutable();
-        m_category_tp = m_categories.get_type().at(0);
-
-        category_count = categories.get_dim_size();
-        m_value_to_category_index = nd::range(category_count);
-        m_value_to_category_index.flag_as_immutable();
-        m_category_index_to_value = m_value_to_category_index;
+        m_categories_by_value = categories.eval_immutable();
+        m_category_tp = m_categories_by_value.get_type().at(0);
+        m_value_index = make_value_index(m_categories_by_value);
+        if (m_value_index == NULL) {
+            m_categories = m_categories_by_value;
+            m_category_index_to_value = nd::range(get_category_count());
+            m_category_index_to_value.flag_as_immutable();
+        }
     } else {
         // Process the categories array to make sure it's valid
         const ndt::type& cdt = categories.get_type();
         if (cdt.get_type_id() != fixed_dim_type_id) {
             throw dynd::type_error("categorical_type only supports construction from a fixed-dim array of categories");
         }
-        m_category_tp = categories.get_type().at(0);
-        if (!m_category_tp.is_scalar()) {
+        if (!cdt.at(0).is_scalar()) {
             throw dynd::type_error("categorical_type only supports construction from a 1-dimensional strided array of categories");
         }
-
-        category_count = categories.get_dim_size();
-        intptr_t categories_stride =
-            reinterpret_cast<const fixed_dim_type_arrmeta *>(
-                categories.get_arrmeta())->stride;
-
-        const char *categories_element_arrmeta =
-            categories.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
-        comparison_ckernel_builder k;
-        ::make_comparison_kernel(&k, 0,
-                        m_category_tp, categories_element_arrmeta,
-                        m_category_tp, categories_element_arrmeta,
-                        comparison_type_sorting_less, &eval::default_eval_context);
-
-        cmp less(k.get_function(), k.get());
-        set<const char *, cmp> uniques(less);
-
-        m_value_to_category_index =
-            nd::empty(category_count, ndt::make_type<intptr_t>());
-        m_category_index_to_value =
-            nd::empty(category_count, ndt::make_type<intptr_t>());
-
-        // create the mapping from indices of (to be lexicographically sorted) categories to values
-        for (size_t i = 0; i != (size_t)category_count; ++i) {
-            unchecked_fixed_dim_get_rw<intptr_t>(m_category_index_to_value, i) = i;
-            const char *category_value = categories.get_readonly_originptr() +
-                            i * categories_stride;
-
-            if (uniques.find(category_value) == uniques.end()) {
-                uniques.insert(category_value);
-            } else {
-                stringstream ss;
-                ss << "categories must be unique: category value ";
-                m_category_tp.print_data(ss, categories_element_arrmeta, category_value);
-                ss << " appears more than once";
-                throw std::runtime_error(ss.str());
-            }
+        m_categories_by_value = categories.eval_immutable();
+        m_category_tp = m_categories_by_value.get_type().at(0);
+
+        // Categories which hash are looked up in a hash table built from
+        // them in value order, which also checks they are unique. Other
+        // categories are kept sorted, and looked up by binary search.
+        m_value_index = make_value_index(m_categories_by_value);
+        if (m_value_index == NULL) {
+            // create the mapping from indices of (lexicographically sorted)
+            // categories to values
+            m_categories = make_sorted_categories(m_categories_by_value, false,
+                                                  &m_category_index_to_value);
         }
-        // TODO: Putting everything in a set already caused a sort operation to occur,
-        //       there's no reason we should need a second sort.
-        std::sort(
-            &unchecked_fixed_dim_get_rw<intptr_t>(m_category_index_to_value, 0),
-            &unchecked_fixed_dim_get_rw<intptr_t>(m_category_index_to_value,
-                                                  category_count),
-            sorter(categories.get_readonly_originptr(), categories_stride,
-                   k.get_function(), k.get()));
-
-        // invert the m_category_index_to_value permutation
-        for (intptr_t i = 0; i < category_count; ++i) {
-          unchecked_fixed_dim_get_rw<intptr_t>(
-              m_value_to_category_index,
-              unchecked_fixed_dim_get<intptr_t>(m_category_index_to_value, i)) =
-              i;
-        }
-
-        m_categories = make_sorted_categories(uniques, m_category_tp,
-                                              categories_element_arrmeta);
     }
 
+    size_t category_count = get_category_count();
     // Use the number of categories to set which underlying integer storage to use
     if (category_count <= 256) {
         m_storage_type = ndt::make_type<uint8_t>();
@@ -310,9 +495,14 @@ categorical_type::categorical_type(const nd::array& categories, bool presorted)
     m_members.data_alignment = (uint8_t)m_storage_type.get_data_alignment();
 }
 
+categorical_type::~categorical_type()
+{
+    delete m_value_index;
+}
+
 void categorical_type::print_data(std::ostream& o, const char *DYND_UNUSED(arrmeta), const char *data) const
 {
-  intptr_t category_count = m_categories.get_dim_size();
+  intptr_t category_count = get_category_count();
   uint32_t value;
   switch (m_storage_type.get_type_id()) {
   case uint8_type_id:
@@ -338,7 +528,7 @@ void categorical_type::print_data(std::ostream& o, const char *DYND_UNUSED(arrme
 void categorical_type::print_type(std::ostream& o) const
 {
     size_t category_count = get_category_count();
-    const char *arrmeta = m_categories.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
+    const char *arrmeta = get_category_arrmeta();
 
     o << "categorical[" << m_category_tp;
     o << ", [";
@@ -365,16 +555,43 @@ void dynd::categorical_type::get_shape(intptr_t ndim, intptr_t i, intptr_t *out_
 
 uint32_t categorical_type::get_value_from_category(const char *category_arrmeta, const char *category_data) const
 {
-    intptr_t i = nd::binary_search(m_categories, category_arrmeta, category_data);
-    if (i < 0) {
+    intptr_t value;
+    if (m_value_index != NULL) {
+        m_value_index->find(category_data, 0, 1, &value);
+    } else {
+        intptr_t i = nd::binary_search(m_categories, category_arrmeta, category_data);
+        value = i < 0 ? -1 : unchecked_fixed_dim_get<intptr_t>(
+                                 m_category_index_to_value, i);
+    }
+    if (value < 0) {
         stringstream ss;
         ss << "Unrecognized category value ";
         m_category_tp.print_data(ss, category_arrmeta, category_data);
         ss << " assigning to dynd type " << ndt::type(this, true);
         throw std::runtime_error(ss.str());
+    }
+    return (uint32_t)value;
+}
+
+void categorical_type::get_values_from_categories(const char *category_arrmeta,
+                                                  const char *category_data,
+                                                  intptr_t stride, intptr_t count,
+                                                  intptr_t *out_values) const
+{
+    if (m_value_index != NULL) {
+        m_value_index->find(category_data, stride, count, out_values);
+        for (intptr_t i = 0; i < count; ++i) {
+            if (out_values[i] < 0) {
+                // Raises the error for the unrecognized category
+                get_value_from_category(category_arrmeta,
+                                        category_data + i * stride);
+            }
+        }
     } else {
-      return (uint32_t)unchecked_fixed_dim_get<intptr_t>(
-          m_category_index_to_value, i);
+        for (intptr_t i = 0; i < count; ++i, category_data += stride) {
+            out_values[i] =
+                get_value_from_category(category_arrmeta, category_data);
+        }
     }
 }
 
@@ -393,30 +610,12 @@ uint32_t categorical_type::get_value_from_category(const nd::array& category) co
 
 const char *categorical_type::get_category_arrmeta() const
 {
-    const char *arrmeta = m_categories.get_arrmeta();
-    m_categories.get_type().extended()->at_single(0, &arrmeta, NULL);
-    return arrmeta;
+    return m_categories_by_value.get_arrmeta() + sizeof(fixed_dim_type_arrmeta);
 }
 
 nd::array categorical_type::get_categories() const
 {
-    // TODO: store categories in their original order
-    //       so this is simply "return m_categories".
-    nd::array categories = nd::empty(get_category_count(), m_category_tp);
-    intptr_t dim_size, stride;
-    ndt::type el_tp;
-    const char *el_arrmeta;
-    categories.get_type().get_as_strided(categories.get_arrmeta(), &dim_size,
-                                         &stride, &el_tp, &el_arrmeta);
-    unary_ckernel_builder k;
-    ::make_assignment_kernel(NULL, NULL, &k, 0, m_category_tp, el_arrmeta, el_tp,
-                             get_category_arrmeta(), kernel_request_single,
-                             &eval::default_eval_context, nd::array());
-    for (intptr_t i = 0; i < dim_size; ++i) {
-      k(categories.get_readwrite_originptr() + i * stride,
-        const_cast<char *>(get_category_data_from_value((uint32_t)i)));
-    }
-    return categories;
+    return m_categories_by_value;
 }
 
 
@@ -457,23 +656,42 @@ intptr_t categorical_type::make_assignment_kernel(
     }
     // assign from the same category value type
     else if (src_tp == m_category_tp) {
-      ckb_offset =
-          make_kernreq_to_single_kernel_adapter(ckb, ckb_offset, 1, kernreq);
+      if (kernreq != kernel_request_single &&
+          kernreq != kernel_request_strided) {
+        ckb_offset =
+            make_kernreq_to_single_kernel_adapter(ckb, ckb_offset, 1, kernreq);
+        kernreq = kernel_request_single;
+      }
       category_to_categorical_kernel_extra *e =
           reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
               ->alloc_ck_leaf<category_to_categorical_kernel_extra>(ckb_offset);
       switch (m_storage_type.get_type_id()) {
       case uint8_type_id:
-        e->base.set_function<expr_single_t>(
-            &category_to_categorical_kernel_extra::single_uint8);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &category_to_categorical_kernel_extra::single_uint8);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &category_to_categorical_kernel_extra::strided<uint8_t>);
+        }
         break;
       case uint16_type_id:
-        e->base.set_function<expr_single_t>(
-            &category_to_categorical_kernel_extra::single_uint16);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &category_to_categorical_kernel_extra::single_uint16);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &category_to_categorical_kernel_extra::strided<uint16_t>);
+        }
         break;
       case uint32_type_id:
-        e->base.set_function<expr_single_t>(
-            &category_to_categorical_kernel_extra::single_uint32);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &category_to_categorical_kernel_extra::single_uint32);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &category_to_categorical_kernel_extra::strided<uint32_t>);
+        }
         break;
       default:
         throw runtime_error(
@@ -500,23 +718,59 @@ intptr_t categorical_type::make_assignment_kernel(
     }
   } else {
     if (dst_tp.value_type().get_type_id() != categorical_type_id) {
-      ckb_offset =
-          make_kernreq_to_single_kernel_adapter(ckb, ckb_offset, 1, kernreq);
+      if (kernreq != kernel_request_single &&
+          kernreq != kernel_request_strided) {
+        ckb_offset =
+            make_kernreq_to_single_kernel_adapter(ckb, ckb_offset, 1, kernreq);
+        kernreq = kernel_request_single;
+      }
+      if (dst_tp == m_category_tp && m_category_tp.is_pod() &&
+          reinterpret_cast<const fixed_dim_type_arrmeta *>(
+              m_categories_by_value.get_arrmeta())->stride ==
+              (intptr_t)m_category_tp.get_data_size()) {
+        switch (m_category_tp.get_data_size()) {
+        case 1:
+          return make_categorical_gather_kernel<uint8_t>(this, ckb, ckb_offset, kernreq);
+        case 2:
+          return make_categorical_gather_kernel<uint16_t>(this, ckb, ckb_offset, kernreq);
+        case 4:
+          return make_categorical_gather_kernel<uint32_t>(this, ckb, ckb_offset, kernreq);
+        case 8:
+          return make_categorical_gather_kernel<uint64_t>(this, ckb, ckb_offset, kernreq);
+        default:
+          break;
+        }
+      }
       categorical_to_other_kernel_extra *e =
           reinterpret_cast<ckernel_builder<kernel_request_host> *>(ckb)
               ->alloc_ck<categorical_to_other_kernel_extra>(ckb_offset);
       switch (m_storage_type.get_type_id()) {
       case uint8_type_id:
-        e->base.set_function<expr_single_t>(
-            &categorical_to_other_kernel_extra::single_uint8);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &categorical_to_other_kernel_extra::single_uint8);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &categorical_to_other_kernel_extra::strided<uint8_t>);
+        }
         break;
       case uint16_type_id:
-        e->base.set_function<expr_single_t>(
-            &categorical_to_other_kernel_extra::single_uint16);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &categorical_to_other_kernel_extra::single_uint16);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &categorical_to_other_kernel_extra::strided<uint16_t>);
+        }
         break;
       case uint32_type_id:
-        e->base.set_function<expr_single_t>(
-            &categorical_to_other_kernel_extra::single_uint32);
+        if (kernreq == kernel_request_single) {
+          e->base.set_function<expr_single_t>(
+              &categorical_to_other_kernel_extra::single_uint32);
+        } else {
+          e->base.set_function<expr_strided_t>(
+              &categorical_to_other_kernel_extra::strided<uint32_t>);
+        }
         break;
       default:
         throw runtime_error(
@@ -543,20 +797,9 @@ bool categorical_type::operator==(const base_type& rhs) const
         return true;
     if (rhs.get_type_id() != categorical_type_id)
         return false;
-    if (!m_categories.equals_exact(
-            static_cast<const categorical_type &>(rhs).m_categories))
-        return false;
-    if (!m_category_index_to_value.equals_exact(
-            static_cast<const categorical_type &>(rhs)
-                .m_category_index_to_value))
-        return false;
-    if (!m_value_to_category_index.equals_exact(
-            static_cast<const categorical_type &>(rhs)
-                .m_value_to_category_index))
-        return false;
-
-    return true;
-
+    // The other members all follow from the categories in value order
+    return m_categories_by_value.equals_exact(
+        static_cast<const categorical_type &>(rhs).m_categories_by_value);
 }
 
 void categorical_type::arrmeta_default_construct(
@@ -589,29 +832,17 @@ ndt::type dynd::ndt::factor_categorical(const nd::array& values)
     // TODO: Some cases where we don't want to do this?
     nd::array values_eval = values.eval();
 
-    intptr_t dim_size, stride;
-    ndt::type el_tp;
-    const char *el_arrmeta;
-    values_eval.get_type().get_as_strided(values_eval.get_arrmeta(), &dim_size,
-                                          &stride, &el_tp, &el_arrmeta);
-
-    comparison_ckernel_builder k;
-    ::make_comparison_kernel(&k, 0, el_tp, el_arrmeta, el_tp, el_arrmeta,
-                             comparison_type_sorting_less,
-                             &eval::default_eval_context);
-
-    cmp less(k.get_function(), k.get());
-    set<const char *, cmp> uniques(less);
-
-    for (intptr_t i = 0; i < dim_size; ++i) {
-      const char *data = values_eval.get_readonly_originptr() + i * stride;
-      if (uniques.find(data) == uniques.end()) {
-        uniques.insert(data);
-      }
+    // Reduce the values to the distinct ones with a hash table first if
+    // possible, so only those need sorting
+    nd::array uniques;
+    try {
+        uniques = nd::unique(values_eval);
+    } catch (const dynd::type_error &) {
+        uniques = values_eval;
     }
 
     // Copy the values (now sorted and unique) into a new nd::array
-    nd::array categories = make_sorted_categories(uniques, el_tp, el_arrmeta);
+    nd::array categories = make_sorted_categories(uniques, true, NULL);
 
     return ndt::type(new categorical_type(categories, true), false);
 }
@@ -3,8 +3,11 @@
 // BSD 2-Clause License, see LICENSE.txt
 //
 
+#include <list>
 #include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 
 #include <dynd/types/datashape_parser.hpp>
 #include <dynd/parser_util.hpp>
@@ -40,6 +43,7 @@
 #include <dynd/types/ellipsis_dim_type.hpp>
 #include <dynd/types/option_type.hpp>
 #include <dynd/types/adapt_type.hpp>
+#include <dynd/types/type_intern.hpp>
 #include <dynd/func/callable.hpp>
 
 using namespace std;
@@ -69,6 +73,108 @@ static ndt::type parse_datashape(const char *&begin, const char *end,
 
 static const map<string, ndt::type> *builtin_types;
 
+namespace {
+
+// The maximum number of datashapes held by the parse cache
+const size_t datashape_cache_capacity = 1024;
+
+struct datashape_cache_entry {
+  size_t hash;
+  string text;
+  ndt::type tp;
+};
+
+/**
+ * An LRU cache from datashape text to the interned type it parses to.
+ * Entries are found by a hash of the text, so a lookup doesn't need to
+ * copy the text, and a hash collision just evicts the older entry.
+ */
+class datashape_cache {
+  typedef list<datashape_cache_entry> list_type;
+
+  mutex m_mutex;
+  // Most recently used first
+  list_type m_entries;
+  unordered_map<size_t, list_type::iterator> m_index;
+  intptr_t m_hits, m_misses;
+
+public:
+  datashape_cache() : m_hits(0), m_misses(0) {}
+
+  static size_t hash_text(const char *begin, const char *end)
+  {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (; begin != end; ++begin) {
+      hash = (hash ^ static_cast<unsigned char>(*begin)) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+  }
+
+  bool lookup(size_t hash, const char *begin, const char *end,
+              ndt::type &out_tp)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    unordered_map<size_t, list_type::iterator>::iterator it =
+        m_index.find(hash);
+    if (it != m_index.end() &&
+        it->second->text.size() == static_cast<size_t>(end - begin) &&
+        memcmp(it->second->text.data(), begin, end - begin) == 0) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      out_tp = it->second->tp;
+      ++m_hits;
+      return true;
+    }
+    ++m_misses;
+    return false;
+  }
+
+  void insert(size_t hash, const char *begin, const char *end,
+              const ndt::type &tp)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    unordered_map<size_t, list_type::iterator>::iterator it =
+        m_index.find(hash);
+    if (it != m_index.end()) {
+      // Another thread parsed it first, or the hash collided
+      m_entries.erase(it->second);
+      m_index.erase(it);
+    } else if (m_entries.size() >= datashape_cache_capacity) {
+      m_index.erase(m_entries.back().hash);
+      m_entries.pop_back();
+    }
+    datashape_cache_entry e;
+    e.hash = hash;
+    e.text.assign(begin, end);
+    e.tp = tp;
+    m_entries.push_front(e);
+    m_index[hash] = m_entries.begin();
+  }
+
+  void clear()
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  datashape_cache_stats get_stats()
+  {
+    lock_guard<mutex> lock(m_mutex);
+    datashape_cache_stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.size = m_entries.size();
+    return stats;
+  }
+};
+
+datashape_cache *ds_cache = NULL;
+
+} // anonymous namespace
+
 void init::datashape_parser_init()
 {
   // Fill in the types in a stack-allocated map
@@ -108,10 +214,13 @@ void init::datashape_parser_init()
   map<string, ndt::type> *bit_ptr = new map<string, ndt::type>();
   bit_ptr->swap(bit);
   builtin_types = bit_ptr;
+  ds_cache = new datashape_cache;
 }
 
 void init::datashape_parser_cleanup()
 {
+  delete ds_cache;
+  ds_cache = NULL;
   delete builtin_types;
   builtin_types = NULL;
 }
@@ -1366,8 +1475,8 @@ static void get_error_line_column(const char *begin, const char *end,
       "Cannot get line number of error, its position is out of range");
 }
 
-ndt::type dynd::type_from_datashape(const char *datashape_begin,
-                                    const char *datashape_end)
+static ndt::type parse_datashape_text(const char *datashape_begin,
+                                      const char *datashape_end)
 {
   try {
     // Symbol table for intermediate types declared in the datashape
@@ -1396,3 +1505,37 @@ ndt::type dynd::type_from_datashape(const char *datashape_begin,
     throw runtime_error(ss.str());
   }
 }
+
+ndt::type dynd::type_from_datashape(const char *datashape_begin,
+                                    const char *datashape_end)
+{
+  if (ds_cache == NULL) {
+    return parse_datashape_text(datashape_begin, datashape_end);
+  }
+
+  size_t hash = datashape_cache::hash_text(datashape_begin, datashape_end);
+  ndt::type result;
+  if (!ds_cache->lookup(hash, datashape_begin, datashape_end, result)) {
+    result =
+        ndt::intern(parse_datashape_text(datashape_begin, datashape_end));
+    ds_cache->insert(hash, datashape_begin, datashape_end, result);
+  }
+  return result;
+}
+
+datashape_cache_stats dynd::get_datashape_cache_stats()
+{
+  if (ds_cache != NULL) {
+    return ds_cache->get_stats();
+  } else {
+    datashape_cache_stats stats = {0, 0, 0};
+    return stats;
+  }
+}
+
+void dynd::clear_datashape_cache()
+{
+  if (ds_cache != NULL) {
+    ds_cache->clear();
+  }
+}
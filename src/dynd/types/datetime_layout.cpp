@@ -0,0 +1,296 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstring>
+
+#include <dynd/types/datetime_layout.hpp>
+#include <dynd/types/base_string_type.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DYND_DATETIME_LAYOUT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace dynd;
+
+static inline bool is_digit(char c) { return '0' <= c && c <= '9'; }
+
+// Advances past exactly ``n`` digits, returning false if they aren't there
+static inline bool skip_digits(const char *&p, const char *end, int n)
+{
+  for (int i = 0; i < n; ++i, ++p) {
+    if (p == end || !is_digit(*p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline bool skip_char(const char *&p, const char *end, char c)
+{
+  if (p != end && *p == c) {
+    ++p;
+    return true;
+  }
+  return false;
+}
+
+static inline int two_digits(const char *p)
+{
+  return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+bool datetime_layout::detect(const char *begin, const char *end, bool date,
+                             bool time)
+{
+  length = 0;
+  if (end - begin > max_length) {
+    return false;
+  }
+
+  const char *p = begin;
+  time_offset = -1;
+  second_offset = -1;
+  fraction_offset = 0;
+  fraction_digits = 0;
+  if (date) {
+    // YYYY-MM-DD
+    if (!skip_digits(p, end, 4) || !skip_char(p, end, '-') ||
+        !skip_digits(p, end, 2) || !skip_char(p, end, '-') ||
+        !skip_digits(p, end, 2)) {
+      return false;
+    }
+    if (time) {
+      // A datetime may be just the date, or have a "T" or " " before
+      // the time
+      if (p == end) {
+        time = false;
+      } else if (!skip_char(p, end, 'T') && !skip_char(p, end, ' ')) {
+        return false;
+      }
+    }
+  }
+  if (time) {
+    // HH:MM, HH:MM:SS, or HH:MM:SS.f...
+    time_offset = static_cast<int>(p - begin);
+    if (!skip_digits(p, end, 2) || !skip_char(p, end, ':') ||
+        !skip_digits(p, end, 2)) {
+      return false;
+    }
+    if (skip_char(p, end, ':')) {
+      second_offset = static_cast<int>(p - begin);
+      if (!skip_digits(p, end, 2)) {
+        return false;
+      }
+      if (skip_char(p, end, '.')) {
+        fraction_offset = static_cast<int>(p - begin);
+        while (p != end && is_digit(*p)) {
+          ++p;
+        }
+        fraction_digits = static_cast<int>(p - begin) - fraction_offset;
+        if (fraction_digits == 0) {
+          return false;
+        }
+      }
+    }
+    skip_char(p, end, 'Z');
+  }
+  if (p != end) {
+    return false;
+  }
+
+  // The template the strings are compared against
+  memset(literal, 0, sizeof(literal));
+  memset(digit, 0, sizeof(digit));
+  for (intptr_t i = 0; i < end - begin; ++i) {
+    if (is_digit(begin[i])) {
+      digit[i] = 0xff;
+    } else {
+      literal[i] = begin[i];
+    }
+  }
+  length = static_cast<int>(end - begin);
+  return true;
+}
+
+bool datetime_layout::detect_date(const char *begin, const char *end)
+{
+  return detect(begin, end, true, false);
+}
+
+bool datetime_layout::detect_time(const char *begin, const char *end)
+{
+  return detect(begin, end, false, true);
+}
+
+bool datetime_layout::detect_datetime(const char *begin, const char *end)
+{
+  return detect(begin, end, true, true);
+}
+
+// Copies the string into ``buf``, zero padded to max_length, and returns
+// whether it has a digit at each digit position of the layout and the
+// layout's char everywhere else
+bool datetime_layout::matches(const char *begin, const char *end,
+                              char *buf) const
+{
+  if (end - begin != length || length == 0) {
+    return false;
+  }
+  memcpy(buf, begin, length);
+  memset(buf + length, 0, max_length - length);
+#ifdef DYND_DATETIME_LAYOUT_USE_SSE2
+  const __m128i zero_char = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  for (int i = 0; i < length; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+    __m128i digit_pos =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(digit + i));
+    __m128i expected =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(literal + i));
+    // A byte is a digit if subtracting '0' leaves it at most 9, unsigned
+    __m128i d = _mm_sub_epi8(v, zero_char);
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+    __m128i ok = _mm_or_si128(_mm_and_si128(digit_pos, is_digit),
+                              _mm_andnot_si128(digit_pos,
+                                               _mm_cmpeq_epi8(v, expected)));
+    if (_mm_movemask_epi8(ok) != 0xffff) {
+      return false;
+    }
+  }
+  return true;
+#else
+  for (int i = 0; i < length; ++i) {
+    if (digit[i] ? !is_digit(buf[i]) : buf[i] != literal[i]) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+bool datetime_layout::parse_hmst(const char *buf, time_hmst &out_hmst) const
+{
+  const char *t = buf + time_offset;
+  int hour = two_digits(t), minute = two_digits(t + 3), second = 0, tick = 0;
+  if (second_offset >= 0) {
+    second = two_digits(buf + second_offset);
+    // The first 7 fractional digits are the ticks, the rest are truncated
+    const char *f = buf + fraction_offset;
+    for (int i = 0; i < 7; ++i) {
+      tick = tick * 10 + (i < fraction_digits ? f[i] - '0' : 0);
+    }
+  }
+  if (!time_hmst::is_valid(hour, minute, second, tick)) {
+    return false;
+  }
+  out_hmst.hour = hour;
+  out_hmst.minute = minute;
+  out_hmst.second = second;
+  out_hmst.tick = tick;
+  return true;
+}
+
+bool datetime_layout::parse_date(const char *begin, const char *end,
+                                 date_ymd &out_ymd) const
+{
+  char buf[max_length];
+  if (!matches(begin, end, buf)) {
+    return false;
+  }
+  int year = two_digits(buf) * 100 + two_digits(buf + 2);
+  int month = two_digits(buf + 5), day = two_digits(buf + 8);
+  if (!date_ymd::is_valid(year, month, day)) {
+    return false;
+  }
+  out_ymd.year = year;
+  out_ymd.month = month;
+  out_ymd.day = day;
+  return true;
+}
+
+bool datetime_layout::parse_time(const char *begin, const char *end,
+                                 time_hmst &out_hmst) const
+{
+  char buf[max_length];
+  return matches(begin, end, buf) && parse_hmst(buf, out_hmst);
+}
+
+bool datetime_layout::parse_datetime(const char *begin, const char *end,
+                                     datetime_struct &out_dt) const
+{
+  char buf[max_length];
+  if (!matches(begin, end, buf)) {
+    return false;
+  }
+  int year = two_digits(buf) * 100 + two_digits(buf + 2);
+  int month = two_digits(buf + 5), day = two_digits(buf + 8);
+  if (!date_ymd::is_valid(year, month, day)) {
+    return false;
+  }
+  if (time_offset < 0) {
+    out_dt.hmst.set_to_zero();
+  } else if (!parse_hmst(buf, out_dt.hmst)) {
+    return false;
+  }
+  out_dt.ymd.year = year;
+  out_dt.ymd.month = month;
+  out_dt.ymd.day = day;
+  return true;
+}
+
+void datetime_string_source::init(const ndt::type &src_string_tp,
+                                  const char *src_arrmeta,
+                                  assign_error_mode src_errmode,
+                                  kind_t src_kind)
+{
+  string_tp = src_string_tp;
+  arrmeta = src_arrmeta;
+  errmode = src_errmode;
+  kind = src_kind;
+  string_encoding_t encoding =
+      src_string_tp.extended<base_string_type>()->get_encoding();
+  utf8 = (encoding == string_encoding_utf_8 ||
+          encoding == string_encoding_ascii);
+  layout = datetime_layout();
+  detect_count = 0;
+}
+
+bool datetime_string_source::get_range(const char *src,
+                                       const char *&out_begin,
+                                       const char *&out_end,
+                                       std::string &buf) const
+{
+  const base_string_type *bst = string_tp.extended<base_string_type>();
+  if (utf8) {
+    bst->get_string_range(&out_begin, &out_end, arrmeta, src);
+  } else {
+    buf = bst->get_utf8_string(arrmeta, src, errmode);
+    out_begin = buf.data();
+    out_end = out_begin + buf.size();
+  }
+  return out_end - out_begin == 2 && out_begin[0] == 'N' && out_begin[1] == 'A';
+}
+
+void datetime_string_source::detect(const char *begin, const char *end)
+{
+  if (!layout.empty() || detect_count >= datetime_layout::max_detect_count) {
+    return;
+  }
+  ++detect_count;
+  switch (kind) {
+  case date_kind:
+    layout.detect_date(begin, end);
+    break;
+  case time_kind:
+    layout.detect_time(begin, end);
+    break;
+  case datetime_kind:
+    layout.detect_datetime(begin, end);
+    break;
+  }
+}
@@ -27,10 +27,10 @@ using namespace dynd;
 /**
  * Substitutes the field types for contiguous array of types
  */
-static nd::array
-substitute_type_array(const nd::array &type_array,
-                      const std::map<nd::string, ndt::type> &typevars,
-                      bool concrete)
+template <typename TypevarMap>
+static nd::array substitute_type_array(const nd::array &type_array,
+                                       const TypevarMap &typevars,
+                                       bool concrete)
 {
   intptr_t field_count = type_array.get_dim_size();
   const ndt::type *field_types =
@@ -45,9 +45,9 @@ substitute_type_array(const nd::array &type_array,
   return tmp_field_types;
 }
 
-ndt::type ndt::detail::internal_substitute(
-    const ndt::type &pattern, const std::map<nd::string, ndt::type> &typevars,
-    bool concrete)
+template <typename TypevarMap>
+static ndt::type substitute_impl(const ndt::type &pattern,
+                                 const TypevarMap &typevars, bool concrete)
 {
   // This function assumes that ``pattern`` is symbolic, so does not
   // have to check types that are always concrete
@@ -113,7 +113,7 @@ ndt::type ndt::detail::internal_substitute(
           substitute(pattern.extended<arrfunc_type>()->get_return_type(),
                      typevars, concrete));
     case typevar_type_id: {
-      map<nd::string, ndt::type>::const_iterator it =
+      typename TypevarMap::const_iterator it =
           typevars.find(pattern.extended<typevar_type>()->get_name());
       if (it != typevars.end()) {
         if (it->second.get_ndim() != 0) {
@@ -142,7 +142,7 @@ ndt::type ndt::detail::internal_substitute(
       }
     }
     case typevar_dim_type_id: {
-      map<nd::string, ndt::type>::const_iterator it =
+      typename TypevarMap::const_iterator it =
           typevars.find(pattern.extended<typevar_dim_type>()->get_name());
       if (it != typevars.end()) {
         if (it->second.get_ndim() == 0) {
@@ -159,13 +159,13 @@ ndt::type ndt::detail::internal_substitute(
                 concrete));
           case fixed_dim_type_id:
             return ndt::make_fixed_dim(
-                it->second.extended<fixed_dim_type>()->get_fixed_dim_size(),
+                it->second.template extended<fixed_dim_type>()->get_fixed_dim_size(),
                 ndt::substitute(
                     pattern.extended<typevar_dim_type>()->get_element_type(),
                     typevars, concrete));
           case cfixed_dim_type_id:
             return ndt::make_cfixed_dim(
-                it->second.extended<cfixed_dim_type>()->get_fixed_dim_size(),
+                it->second.template extended<cfixed_dim_type>()->get_fixed_dim_size(),
                 ndt::substitute(
                     pattern.extended<typevar_dim_type>()->get_element_type(),
                     typevars, concrete));
@@ -205,17 +205,17 @@ ndt::type ndt::detail::internal_substitute(
       // Look up to the exponent typevar
       nd::string exponent_name =
           pattern.extended<pow_dimsym_type>()->get_exponent();
-      map<nd::string, ndt::type>::const_iterator tv_type =
+      typename TypevarMap::const_iterator tv_type =
           typevars.find(exponent_name);
       intptr_t exponent = -1;
       if (tv_type != typevars.end()) {
         if (tv_type->second.get_type_id() == fixed_dim_type_id) {
           exponent =
-              tv_type->second.extended<fixed_dim_type>()->get_fixed_dim_size();
+              tv_type->second.template extended<fixed_dim_type>()->get_fixed_dim_size();
         }
         else if (tv_type->second.get_type_id() == typevar_dim_type_id) {
           // If it's a typevar, substitute the new name in
-          exponent_name = tv_type->second.extended<typevar_dim_type>()->get_name();
+          exponent_name = tv_type->second.template extended<typevar_dim_type>()->get_name();
           if (concrete) {
             stringstream ss;
             ss << "The substitution for dynd typevar " << exponent_name.str()
@@ -240,7 +240,7 @@ ndt::type ndt::detail::internal_substitute(
       // Get the base type
       ndt::type base_tp = pattern.extended<pow_dimsym_type>()->get_base_type();
       if (base_tp.get_type_id() == typevar_dim_type_id) {
-        map<nd::string, ndt::type>::const_iterator btv_type =
+        typename TypevarMap::const_iterator btv_type =
             typevars.find(base_tp.extended<typevar_dim_type>()->get_name());
         if (btv_type == typevars.end()) {
           // We haven't seen this typevar yet, check if concrete
@@ -319,11 +319,11 @@ ndt::type ndt::detail::internal_substitute(
     case ellipsis_dim_type_id: {
       const nd::string &name = pattern.extended<ellipsis_dim_type>()->get_name();
       if (!name.is_null()) {
-        map<nd::string, ndt::type>::const_iterator it =
+        typename TypevarMap::const_iterator it =
             typevars.find(pattern.extended<typevar_dim_type>()->get_name());
         if (it != typevars.end()) {
           if (it->second.get_type_id() == dim_fragment_type_id) {
-            return it->second.extended<dim_fragment_type>()->apply_to_dtype(
+            return it->second.template extended<dim_fragment_type>()->apply_to_dtype(
                 ndt::substitute(
                     pattern.extended<ellipsis_dim_type>()->get_element_type(),
                     typevars, concrete));
@@ -361,3 +361,17 @@ ndt::type ndt::detail::internal_substitute(
      << "\" encountered for substituting typevars";
   throw invalid_argument(ss.str());
 }
+
+ndt::type ndt::detail::internal_substitute(
+    const ndt::type &pattern, const std::map<nd::string, ndt::type> &typevars,
+    bool concrete)
+{
+  return substitute_impl(pattern, typevars, concrete);
+}
+
+ndt::type ndt::detail::internal_substitute(const ndt::type &pattern,
+                                           const typevar_table &typevars,
+                                           bool concrete)
+{
+  return substitute_impl(pattern, typevars, concrete);
+}
@@ -0,0 +1,121 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include <dynd/types/type_intern.hpp>
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// The table is swept for unused types when it grows past this many
+// entries, and at least twice the size it had after the previous sweep
+const size_t type_intern_min_sweep_size = 1024;
+
+class type_intern_table {
+  // Keyed by the datashape of the type. Types which print the same but
+  // compare unequal share a key, so each bucket is checked with operator==.
+  typedef unordered_multimap<string, const base_type *> map_type;
+
+  mutex m_mutex;
+  map_type m_types;
+  size_t m_sweep_size;
+  intptr_t m_hits, m_misses;
+
+  // Drops the types which are only referenced by the table
+  void sweep()
+  {
+    for (map_type::iterator it = m_types.begin(); it != m_types.end();) {
+      if (it->second->get_use_count() == 1) {
+        base_type_decref(it->second);
+        it = m_types.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    m_sweep_size = max(type_intern_min_sweep_size, 2 * m_types.size());
+  }
+
+public:
+  type_intern_table()
+      : m_sweep_size(type_intern_min_sweep_size), m_hits(0), m_misses(0)
+  {
+  }
+
+  ~type_intern_table()
+  {
+    for (map_type::iterator it = m_types.begin(); it != m_types.end(); ++it) {
+      base_type_decref(it->second);
+    }
+  }
+
+  ndt::type intern(const ndt::type &tp)
+  {
+    stringstream ss;
+    ss << tp;
+    string key = ss.str();
+
+    lock_guard<mutex> lock(m_mutex);
+    pair<map_type::iterator, map_type::iterator> range =
+        m_types.equal_range(key);
+    for (map_type::iterator it = range.first; it != range.second; ++it) {
+      if (it->second == tp.extended() || *it->second == *tp.extended()) {
+        ++m_hits;
+        return ndt::type(it->second, true);
+      }
+    }
+    ++m_misses;
+    if (m_types.size() >= m_sweep_size) {
+      sweep();
+    }
+    base_type_incref(tp.extended());
+    m_types.insert(make_pair(key, tp.extended()));
+    return tp;
+  }
+
+  type_intern_stats get_stats()
+  {
+    lock_guard<mutex> lock(m_mutex);
+    type_intern_stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.size = m_types.size();
+    return stats;
+  }
+};
+
+type_intern_table *intern_table = NULL;
+
+} // anonymous namespace
+
+ndt::type ndt::intern(const ndt::type &tp)
+{
+  if (tp.is_builtin() || intern_table == NULL) {
+    return tp;
+  }
+  return intern_table->intern(tp);
+}
+
+type_intern_stats dynd::get_type_intern_stats()
+{
+  if (intern_table != NULL) {
+    return intern_table->get_stats();
+  } else {
+    type_intern_stats stats = {0, 0, 0};
+    return stats;
+  }
+}
+
+void init::type_intern_init() { intern_table = new type_intern_table; }
+
+void init::type_intern_cleanup()
+{
+  delete intern_table;
+  intern_table = NULL;
+}
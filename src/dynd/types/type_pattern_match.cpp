@@ -19,8 +19,30 @@
 using namespace std;
 using namespace dynd;
 
+ndt::type &ndt::typevar_table::operator[](const nd::string &name)
+{
+  iterator it = find(name);
+  if (it != end()) {
+    return it->second;
+  } else if (m_size < capacity) {
+    value_type *e = new (entries() + m_size) value_type(name, ndt::type());
+    ++m_size;
+    return e->second;
+  } else {
+    stringstream ss;
+    ss << "Too many distinct typevars to match, the limit is " << capacity;
+    throw type_error(ss.str());
+  }
+}
+
+template <typename TypevarMap>
+static bool match_dims(const ndt::type &concrete, const ndt::type &pattern,
+                       TypevarMap &typevars, ndt::type &out_concrete_dtype,
+                       ndt::type &out_pattern_dtype);
+
+template <typename TypevarMap>
 static bool recursive_match(const ndt::type &concrete, const ndt::type &pattern,
-                            std::map<nd::string, ndt::type> &typevars)
+                            TypevarMap &typevars)
 {
   if (concrete.get_ndim() == 0 && pattern.get_ndim() == 0) {
     // Matching a scalar vs scalar
@@ -143,8 +165,8 @@ static bool recursive_match(const ndt::type &concrete, const ndt::type &pattern,
   } else {
     // First match the dimensions, then the dtype
     ndt::type concrete_dtype, pattern_dtype;
-    if (pattern_match_dims(concrete, pattern, typevars, concrete_dtype,
-                           pattern_dtype)) {
+    if (match_dims(concrete, pattern, typevars, concrete_dtype,
+                   pattern_dtype)) {
       return recursive_match(concrete_dtype, pattern_dtype, typevars);
     } else {
       return false;
@@ -152,11 +174,10 @@ static bool recursive_match(const ndt::type &concrete, const ndt::type &pattern,
   }
 }
 
-bool ndt::pattern_match_dims(const ndt::type &concrete,
-                             const ndt::type &pattern,
-                             std::map<nd::string, ndt::type> &typevars,
-                             ndt::type &out_concrete_dtype,
-                             ndt::type &out_pattern_dtype)
+template <typename TypevarMap>
+static bool match_dims(const ndt::type &concrete, const ndt::type &pattern,
+                       TypevarMap &typevars, ndt::type &out_concrete_dtype,
+                       ndt::type &out_pattern_dtype)
 {
   if (concrete.get_ndim() == 0) {
     if (pattern.get_ndim() == 0) {
@@ -189,7 +210,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
             }
           }
         }
-        return pattern_match_dims(
+        return match_dims(
             concrete, pattern.extended<ellipsis_dim_type>()->get_element_type(),
             typevars, out_concrete_dtype, out_pattern_dtype);
       }
@@ -214,7 +235,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
             // The exponent is always the dim_size inside a fixed_dim_type
             return false;
           }
-          return pattern_match_dims(
+          return match_dims(
               concrete, pattern.extended<pow_dimsym_type>()->get_element_type(),
               typevars, out_concrete_dtype, out_pattern_dtype);
         }
@@ -233,14 +254,14 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
       case fixed_dimsym_type_id:
       case offset_dim_type_id:
       case var_dim_type_id:
-        return pattern_match_dims(
+        return match_dims(
             concrete.extended<base_dim_type>()->get_element_type(),
             pattern.extended<base_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
       case fixed_dim_type_id:
         return concrete.extended<fixed_dim_type>()->get_fixed_dim_size() ==
                    pattern.extended<fixed_dim_type>()->get_fixed_dim_size() &&
-               pattern_match_dims(
+               match_dims(
                    concrete.extended<base_dim_type>()->get_element_type(),
                    pattern.extended<base_dim_type>()->get_element_type(), typevars,
                    out_concrete_dtype, out_pattern_dtype);
@@ -249,21 +270,21 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
                    pattern.extended<cfixed_dim_type>()->get_fixed_dim_size() &&
                concrete.extended<cfixed_dim_type>()->get_fixed_stride() ==
                    pattern.extended<cfixed_dim_type>()->get_fixed_stride() &&
-               pattern_match_dims(
+               match_dims(
                    concrete.extended<base_dim_type>()->get_element_type(),
                    pattern.extended<base_dim_type>()->get_element_type(), typevars,
                    out_concrete_dtype, out_pattern_dtype);
       case ellipsis_dim_type_id:
-        return pattern_match_dims(
+        return match_dims(
             concrete.extended<ellipsis_dim_type>()->get_element_type(),
             pattern.extended<ellipsis_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
       case pow_dimsym_type_id:
-        if (pattern_match_dims(
+        if (match_dims(
                 concrete.extended<pow_dimsym_type>()->get_base_type(),
                 pattern.extended<pow_dimsym_type>()->get_base_type(), typevars,
                 out_concrete_dtype, out_pattern_dtype) &&
-            pattern_match_dims(
+            match_dims(
                 concrete.extended<pow_dimsym_type>()->get_element_type(),
                 pattern.extended<pow_dimsym_type>()->get_element_type(), typevars,
                 out_concrete_dtype, out_pattern_dtype)) {
@@ -299,7 +320,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
       // fixed[N] and cfixed[M] matches against fixed (symbolic fixed)
       if (concrete.get_type_id() == fixed_dim_type_id ||
           concrete.get_type_id() == cfixed_dim_type_id) {
-        return pattern_match_dims(
+        return match_dims(
             concrete.extended<base_dim_type>()->get_element_type(),
             pattern.extended<base_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
@@ -311,7 +332,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
       if (concrete.get_type_id() == cfixed_dim_type_id &&
           pattern.extended<fixed_dim_type>()->get_fixed_dim_size() ==
               concrete.extended<cfixed_dim_type>()->get_fixed_dim_size()) {
-        return pattern_match_dims(
+        return match_dims(
             concrete.extended<base_dim_type>()->get_element_type(),
             pattern.extended<base_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
@@ -350,7 +371,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
             }
           }
         }
-        return pattern_match_dims(
+        return match_dims(
             concrete.get_type_at_dimension(NULL, matched_ndim),
             pattern.extended<ellipsis_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
@@ -365,7 +386,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
       if (tv_type.is_null()) {
         // This typevar hasn't been seen yet
         tv_type = concrete;
-        return pattern_match_dims(
+        return match_dims(
             concrete.get_type_at_dimension(NULL, 1),
             pattern.extended<typevar_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
@@ -391,7 +412,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
         default:
           break;
         }
-        return pattern_match_dims(
+        return match_dims(
             concrete.get_type_at_dimension(NULL, 1),
             pattern.extended<typevar_dim_type>()->get_element_type(), typevars,
             out_concrete_dtype, out_pattern_dtype);
@@ -425,7 +446,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
       }
       // If the exponent is zero, the base doesn't matter, just match the rest
       if (exponent == 0) {
-        return pattern_match_dims(
+        return match_dims(
             concrete, pattern.extended<pow_dimsym_type>()->get_element_type(),
             typevars, out_concrete_dtype, out_pattern_dtype);
       } else if (exponent < 0) {
@@ -496,7 +517,7 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
         default:
           return false;
       }
-      return pattern_match_dims(
+      return match_dims(
           concrete_subtype,
           pattern.extended<pow_dimsym_type>()->get_element_type(), typevars,
           out_concrete_dtype, out_pattern_dtype);
@@ -507,8 +528,65 @@ bool ndt::pattern_match_dims(const ndt::type &concrete,
   }
 }
 
+bool ndt::pattern_match_dims(const ndt::type &concrete,
+                             const ndt::type &pattern,
+                             std::map<nd::string, ndt::type> &typevars,
+                             ndt::type &out_concrete_dtype,
+                             ndt::type &out_pattern_dtype)
+{
+  return match_dims(concrete, pattern, typevars, out_concrete_dtype,
+                    out_pattern_dtype);
+}
+
+bool ndt::pattern_match_dims(const ndt::type &concrete,
+                             const ndt::type &pattern,
+                             ndt::typevar_table &typevars,
+                             ndt::type &out_concrete_dtype,
+                             ndt::type &out_pattern_dtype)
+{
+  return match_dims(concrete, pattern, typevars, out_concrete_dtype,
+                    out_pattern_dtype);
+}
+
 bool ndt::pattern_match(const ndt::type &concrete, const ndt::type &pattern,
                         std::map<nd::string, ndt::type> &typevars)
 {
   return recursive_match(concrete, pattern, typevars);
 }
+
+bool ndt::pattern_match(const ndt::type &concrete, const ndt::type &pattern,
+                        ndt::typevar_table &typevars)
+{
+  return recursive_match(concrete, pattern, typevars);
+}
+
+ndt::pattern_signature::pattern_signature(intptr_t nparam,
+                                          const ndt::type *param_tp,
+                                          const ndt::type &return_tp)
+    : m_nparam(nparam), m_param_tp(param_tp), m_symbolic_mask(0),
+      m_symbolic_return(return_tp.is_symbolic() ||
+                        return_tp.get_type_id() == arrfunc_type_id)
+{
+  for (intptr_t i = 0; i < nparam && i < 64; ++i) {
+    if (param_tp[i].is_symbolic()) {
+      m_symbolic_mask |= (uint64_t)1 << i;
+    }
+  }
+}
+
+intptr_t ndt::pattern_signature::match(const ndt::type *src_tp,
+                                       typevar_table &typevars) const
+{
+  for (intptr_t i = 0; i < m_nparam; ++i) {
+    const ndt::type &param_tp = m_param_tp[i];
+    if (i < 64 && (m_symbolic_mask & ((uint64_t)1 << i)) == 0 &&
+        src_tp[i].get_kind() != expr_kind && src_tp[i] == param_tp) {
+      // A concrete parameter usually gets exactly its own type
+      continue;
+    }
+    if (!recursive_match(src_tp[i].value_type(), param_tp, typevars)) {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
 
 #include "inc_gtest.hpp"
 #include "../test_memory.hpp"
@@ -650,6 +651,89 @@ TEST(ArrayAssign, ArrayValsAtType)
   }
 }
 
+TEST(ArrayAssign, CheckedContiguousBlocks)
+{
+  eval::eval_context ectx_overflow, ectx_fractional, ectx_inexact;
+  ectx_overflow.errmode = assign_error_overflow;
+  ectx_fractional.errmode = assign_error_fractional;
+  ectx_inexact.errmode = assign_error_inexact;
+
+  // Enough values for several blocks, plus a partial block
+  intptr_t n = 1000;
+  nd::array a = nd::empty(n, "int64"), b = nd::empty(n, "int32");
+  int64_t *a_data = reinterpret_cast<int64_t *>(a.get_readwrite_originptr());
+  const int32_t *b_data =
+      reinterpret_cast<const int32_t *>(b.get_readonly_originptr());
+  for (intptr_t i = 0; i < n; ++i) {
+    a_data[i] = (i % 2 == 0) ? -i * 1000000 : i * 1000000;
+  }
+  b.val_assign(a, &ectx_overflow);
+  EXPECT_EQ(-998000000, b_data[998]);
+  EXPECT_EQ(999000000, b_data[999]);
+
+  // The error reports the bad value, after assigning the ones before it
+  b.vals() = 0;
+  a_data[700] = 3000000000LL;
+  try {
+    b.val_assign(a, &ectx_overflow);
+    FAIL() << "expected an overflow_error";
+  }
+  catch (const overflow_error &e) {
+    EXPECT_NE(string::npos, string(e.what()).find("3000000000"));
+  }
+  EXPECT_EQ(699000000, b_data[699]);
+  EXPECT_EQ(0, b_data[700]);
+  // Strided data is checked too
+  EXPECT_THROW(b(irange(0, n / 2)).val_assign(a(irange().by(2)), &ectx_overflow),
+               overflow_error);
+
+  // Signed to unsigned
+  a.vals() = 5;
+  a_data[999] = -1;
+  EXPECT_THROW(nd::empty(n, "uint16").val_assign(a, &ectx_overflow),
+               overflow_error);
+
+  // double -> float, where inf and NaN are not an overflow
+  a = nd::empty(n, "float64");
+  double *d_data = reinterpret_cast<double *>(a.get_readwrite_originptr());
+  for (intptr_t i = 0; i < n; ++i) {
+    d_data[i] = i + 0.5;
+  }
+  d_data[3] = numeric_limits<double>::infinity();
+  d_data[4] = numeric_limits<double>::quiet_NaN();
+  b = nd::empty(n, "float32");
+  b.val_assign(a, &ectx_overflow);
+  EXPECT_EQ(999.5f, b(999).as<float>());
+  EXPECT_TRUE(DYND_ISNAN(b(4).as<float>()));
+  d_data[4] = 1.0;
+  b.val_assign(a, &ectx_inexact);
+  d_data[500] = 0.1;
+  b.val_assign(a, &ectx_fractional);
+  EXPECT_THROW(b.val_assign(a, &ectx_inexact), runtime_error);
+  d_data[500] = 1e300;
+  EXPECT_THROW(b.val_assign(a, &ectx_overflow), overflow_error);
+
+  // double -> int32
+  a.vals() = 2.0;
+  d_data[999] = 2.5;
+  b = nd::empty(n, "int32");
+  b.val_assign(a, &ectx_overflow);
+  EXPECT_EQ(2, b(999).as<int32_t>());
+  EXPECT_THROW(b.val_assign(a, &ectx_fractional), runtime_error);
+  d_data[999] = 1e10;
+  EXPECT_THROW(b.val_assign(a, &ectx_overflow), overflow_error);
+
+  // double -> uint8, where -0.0 is fine but -1.0 is not
+  a.vals() = 3.0;
+  d_data[10] = -0.0;
+  b = nd::empty(n, "uint8");
+  b.val_assign(a, &ectx_fractional);
+  EXPECT_EQ(0u, b(10).as<uint8_t>());
+  EXPECT_EQ(3u, b(11).as<uint8_t>());
+  d_data[10] = -1.0;
+  EXPECT_THROW(b.val_assign(a, &ectx_overflow), overflow_error);
+}
+
 #if !(                                                                         \
     defined(_WIN32) &&                                                         \
     !defined(_M_X64)) // TODO: How to mark as expected failures in googletest?
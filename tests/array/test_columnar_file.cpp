@@ -0,0 +1,147 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <iterator>
+#include <cstdio>
+
+#include "inc_gtest.hpp"
+
+#include <dynd/array.hpp>
+#include <dynd/array_range.hpp>
+#include <dynd/columnar_file.hpp>
+#include <dynd/json_parser.hpp>
+#include <dynd/json_formatter.hpp>
+
+using namespace std;
+using namespace dynd;
+
+static nd::array save_and_open(const nd::array &a)
+{
+    nd::save_columnar("test.dyndcol", a);
+    return nd::open_columnar("test.dyndcol");
+}
+
+TEST(ColumnarFile, Fixed) {
+    nd::array a = nd::range(1000).ucast<double>().eval();
+    nd::array b = save_and_open(a);
+    EXPECT_EQ(a.get_type(), b.get_type());
+    EXPECT_EQ(nd::read_access_flag | nd::immutable_access_flag,
+              b.get_access_flags());
+    EXPECT_EQ(999.0, b(999).as<double>());
+    EXPECT_TRUE(a.equals_exact(b));
+
+    // A strided view is written in the default layout
+    a = parse_json("3 * 4 * int16", "[[1, 2, 3, 4], [5, 6, 7, 8], [9, 10, 11, 12]]");
+    b = save_and_open(a(irange(), irange().by(2)));
+    EXPECT_EQ(ndt::type("3 * 2 * int16"), b.get_type());
+    EXPECT_EQ("[[1,3],[5,7],[9,11]]", string(format_json(b).as<string>()));
+
+    // A scalar
+    b = save_and_open(nd::array(3.5f));
+    EXPECT_EQ(ndt::make_type<float>(), b.get_type());
+    EXPECT_EQ(3.5f, b.as<float>());
+}
+
+TEST(ColumnarFile, Strings) {
+    nd::array a = parse_json("4 * string",
+                             "[\"one\", \"\", \"three\", \"a longer string\"]");
+    nd::array b = save_and_open(a);
+    EXPECT_EQ(a.get_type(), b.get_type());
+    EXPECT_EQ("one", b(0).as<string>());
+    EXPECT_EQ("", b(1).as<string>());
+    EXPECT_EQ("a longer string", b(3).as<string>());
+
+    a = parse_json("3 * ?string", "[\"x\", null, \"z\"]");
+    b = save_and_open(a);
+    EXPECT_EQ(a.get_type(), b.get_type());
+    EXPECT_EQ("[\"x\",null,\"z\"]", string(format_json(b).as<string>()));
+}
+
+TEST(ColumnarFile, VarStruct) {
+    const char *json = "[{\"id\": 1, \"name\": \"alpha\", \"xs\": [1.5, 2.5], "
+                       "\"tags\": [\"a\", \"b\", \"c\"]}, "
+                       "{\"id\": 2, \"name\": \"beta\", \"xs\": [], "
+                       "\"tags\": [\"d\"]}, "
+                       "{\"id\": 3, \"name\": \"gamma\", \"xs\": [3.5], "
+                       "\"tags\": []}]";
+    nd::array a = parse_json(ndt::type("var * {id: int32, name: string, "
+                                       "xs: var * float64, tags: var * string}"),
+                             json);
+    nd::array b = save_and_open(a);
+    EXPECT_EQ(a.get_type(), b.get_type());
+    EXPECT_EQ(string(format_json(a).as<string>()),
+              string(format_json(b).as<string>()));
+    EXPECT_EQ("c", b(0).p("tags")(2).as<string>());
+    EXPECT_EQ(3.5, b(2).p("xs")(0).as<double>());
+
+    // The result stays valid after the file is opened again and the
+    // first result is released
+    nd::array c = nd::open_columnar("test.dyndcol");
+    b = nd::array();
+    EXPECT_EQ("gamma", c(2).p("name").as<string>());
+}
+
+TEST(ColumnarFile, Errors) {
+    // Types which aren't supported
+    EXPECT_THROW(nd::save_columnar("test.dyndcol",
+                                   nd::empty(ndt::type("pointer[int32]"))),
+                 type_error);
+
+    // Files which aren't columnar files, or are truncated
+    {
+        ofstream fout("test.dyndcol", ios::binary);
+        fout << "not a dynd columnar file, but long enough for the header";
+    }
+    EXPECT_THROW(nd::open_columnar("test.dyndcol"), runtime_error);
+
+    nd::save_columnar("test.dyndcol", parse_json("2 * string", "[\"a\", \"b\"]"));
+    string data;
+    {
+        ifstream fin("test.dyndcol", ios::binary);
+        data.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+    }
+    {
+        ofstream fout("test.dyndcol", ios::binary);
+        fout.write(data.data(), data.size() - 1);
+    }
+    EXPECT_THROW(nd::open_columnar("test.dyndcol"), runtime_error);
+
+    // A section count whose table size wraps around to zero bytes
+    uint64_t section_count = 1ULL << 60;
+    data.replace(40, sizeof(section_count),
+                 reinterpret_cast<const char *>(&section_count),
+                 sizeof(section_count));
+    {
+        ofstream fout("test.dyndcol", ios::binary);
+        fout.write(data.data(), data.size());
+    }
+    EXPECT_THROW(nd::open_columnar("test.dyndcol"), runtime_error);
+
+    remove("test.dyndcol");
+}
+
+TEST(ColumnarFile, ManySections) {
+    // Enough string fields that the per-section flags are reallocated
+    // while the layout is being built
+    stringstream tp, json;
+    tp << "{";
+    json << "{";
+    for (int i = 0; i < 100; ++i) {
+        tp << (i == 0 ? "" : ", ") << "f" << i << ": string";
+        json << (i == 0 ? "" : ", ") << "\"f" << i << "\": \"v" << i << "\"";
+    }
+    tp << "}";
+    json << "}";
+    nd::array a = parse_json(ndt::type(tp.str()), json.str().c_str());
+    nd::array b = save_and_open(a);
+    EXPECT_EQ(a.get_type(), b.get_type());
+    EXPECT_EQ("v0", b.p("f0").as<string>());
+    EXPECT_EQ("v99", b.p("f99").as<string>());
+    remove("test.dyndcol");
+}
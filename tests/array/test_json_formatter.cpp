@@ -7,6 +7,8 @@
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <sstream>
 
 #include "inc_gtest.hpp"
 
@@ -49,16 +51,79 @@ TEST(JSONFormatter, Builtins) {
     EXPECT_EQ("3.125", format_json(a).as<string>());
     a = 3.125;
     EXPECT_EQ("3.125", format_json(a).as<string>());
+    a = std::numeric_limits<int64_t>::min();
+    EXPECT_EQ("-9223372036854775808", format_json(a).as<string>());
+    a = std::numeric_limits<uint64_t>::max();
+    EXPECT_EQ("18446744073709551615", format_json(a).as<string>());
     a = parse_json("?bool", "null");
     EXPECT_EQ("null", format_json(a).as<string>());
 }
 
+TEST(JSONFormatter, RoundTripReal) {
+    nd::array a;
+    a = 0.1;
+    EXPECT_EQ("0.1", format_json(a).as<string>());
+    a = 1.0 / 3.0;
+    EXPECT_EQ("0.3333333333333333", format_json(a).as<string>());
+    a = 123456789.0;
+    EXPECT_EQ("123456789", format_json(a).as<string>());
+    a = 1e20;
+    EXPECT_EQ("100000000000000000000", format_json(a).as<string>());
+    a = 1e21;
+    EXPECT_EQ("1e+21", format_json(a).as<string>());
+    a = 1.5e-6;
+    EXPECT_EQ("0.0000015", format_json(a).as<string>());
+    a = -1e-7;
+    EXPECT_EQ("-1e-7", format_json(a).as<string>());
+    a = 1.7976931348623157e308;
+    EXPECT_EQ("1.7976931348623157e+308", format_json(a).as<string>());
+    a = 5e-324;
+    EXPECT_EQ("5e-324", format_json(a).as<string>());
+    a = 0.0;
+    EXPECT_EQ("0", format_json(a).as<string>());
+    a = -0.0;
+    EXPECT_EQ("-0", format_json(a).as<string>());
+    a = 0.1f;
+    EXPECT_EQ("0.1", format_json(a).as<string>());
+    a = 16777216.0f;
+    EXPECT_EQ("16777216", format_json(a).as<string>());
+    a = 3.4028235e38f;
+    EXPECT_EQ("3.4028235e+38", format_json(a).as<string>());
+
+    // Formatted values read back exactly
+    uint64_t state = 12345;
+    for (int i = 0; i < 10000; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double d;
+        memcpy(&d, &state, sizeof(d));
+        if (DYND_ISNAN(d) || std::isinf(d)) {
+            continue;
+        }
+        a = d;
+        string s = format_json(a).as<string>();
+        EXPECT_EQ(d, strtod(s.c_str(), NULL)) << s;
+        float f;
+        uint32_t fbits = static_cast<uint32_t>(state >> 32);
+        memcpy(&f, &fbits, sizeof(f));
+        if (DYND_ISNAN(f) || std::isinf(f)) {
+            continue;
+        }
+        a = f;
+        s = format_json(a).as<string>();
+        EXPECT_EQ(f, strtof(s.c_str(), NULL)) << s;
+    }
+}
+
 TEST(JSONFormatter, String) {
     nd::array a;
     a = "testing string";
     EXPECT_EQ("\"testing string\"", format_json(a).as<string>());
     a = " \" \\ / \b \f \n \r \t ";
     EXPECT_EQ("\" \\\" \\\\ \\/ \\b \\f \\n \\r \\t \"", format_json(a).as<string>());
+    // Escapes past the first 16 bytes, and multibyte UTF-8 passed through
+    a = "0123456789abcdefghij\x01klmnopqrstuvwxyz\x7f/\"\xc3\xa9" "end";
+    EXPECT_EQ("\"0123456789abcdefghij\\u0001klmnopqrstuvwxyz\\u007f\\/\\\"\xc3\xa9" "end\"",
+              format_json(a).as<string>());
     a = nd::array("testing string").ucast(ndt::make_string(string_encoding_utf_16)).eval();
     EXPECT_EQ("\"testing string\"", format_json(a).as<string>());
     a = nd::array("testing string").ucast(ndt::make_string(string_encoding_utf_32)).eval();
@@ -115,3 +180,33 @@ TEST(JSONFormatter, UniformDim) {
     EXPECT_EQ("[1.5,null,3.125,9.25,null,null]", format_json(a).as<string>());
 }
 
+namespace {
+class pieces_sink : public json_output_sink {
+public:
+    vector<string> pieces;
+
+    void write(const char *begin, const char *end) {
+        pieces.push_back(string(begin, end));
+    }
+};
+} // anonymous namespace
+
+TEST(JSONFormatter, Sink) {
+    nd::array a = parse_json("var * {name: string, value: ?float64}",
+                             "[[\"one\", 1.5], [\"two\", null], "
+                             "[\"a string which is longer than the buffer of "
+                             "sixty four bytes used for this test\", 3.25]]");
+    string expected = format_json(a).as<string>();
+    pieces_sink sink;
+    format_json(sink, a, false, 64);
+    EXPECT_LT(1u, sink.pieces.size());
+    string joined;
+    for (size_t i = 0; i < sink.pieces.size(); ++i) {
+        joined += sink.pieces[i];
+    }
+    EXPECT_EQ(expected, joined);
+
+    stringstream ss;
+    format_json(ss, a, true);
+    EXPECT_EQ(format_json(a, true).as<string>(), ss.str());
+}
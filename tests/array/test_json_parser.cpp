@@ -12,6 +12,7 @@
 
 #include <dynd/view.hpp>
 #include <dynd/json_parser.hpp>
+#include <dynd/parser_util.hpp>
 #include <dynd/types/var_dim_type.hpp>
 #include <dynd/types/cfixed_dim_type.hpp>
 #include <dynd/types/cstruct_type.hpp>
@@ -479,3 +480,111 @@ TEST(JSONParser, JSONDType) {
     EXPECT_EQ(12, n(1).as<int>());
     EXPECT_EQ("testing string", n(2).as<string>());
 }
+
+TEST(JSONParser, StreamRowsAcrossChunks) {
+    json_stream_parser p(ndt::type("{id: int32, name: string}"), 2);
+    // The second line is split across chunks, and there is a blank line
+    p.feed("{\"id\": 1, \"name\": \"one\"}\n{\"id\": 2, \"na");
+    EXPECT_FALSE(p.has_batch());
+    p.feed("me\": \"two\"}\r\n\n{\"id\": 3, \"name\": \"three\"}\n");
+    ASSERT_TRUE(p.has_batch());
+    nd::array b = p.pop_batch();
+    EXPECT_EQ(ndt::type("var * {id: int32, name: string}"), b.get_type());
+    ASSERT_EQ(2, b.get_dim_size());
+    EXPECT_EQ(1, b(0, 0).as<int>());
+    EXPECT_EQ("one", b(0, 1).as<string>());
+    EXPECT_EQ(2, b(1, 0).as<int>());
+    EXPECT_EQ("two", b(1, 1).as<string>());
+    EXPECT_FALSE(p.has_batch());
+    // The last line has no newline
+    p.feed("{\"id\": 4, \"name\": \"four\"}");
+    p.finish();
+    ASSERT_TRUE(p.has_batch());
+    b = p.pop_batch();
+    ASSERT_EQ(2, b.get_dim_size());
+    EXPECT_EQ("three", b(0, 1).as<string>());
+    EXPECT_EQ(4, b(1, 0).as<int>());
+    EXPECT_EQ("four", b(1, 1).as<string>());
+    EXPECT_FALSE(p.has_batch());
+    EXPECT_THROW(p.pop_batch(), runtime_error);
+}
+
+TEST(JSONParser, StreamByteAtATime) {
+    string json;
+    for (int i = 0; i < 25; ++i) {
+        json += "[" + to_string(i) + ", " + to_string(i * i) + "]\n";
+    }
+    json_stream_parser p(ndt::type("2 * int64"), 10);
+    intptr_t count = 0;
+    for (size_t i = 0; i < json.size(); ++i) {
+        p.feed(json.data() + i, json.data() + i + 1);
+        while (p.has_batch()) {
+            nd::array b = p.pop_batch();
+            EXPECT_EQ(10, b.get_dim_size());
+            for (intptr_t j = 0; j < b.get_dim_size(); ++j, ++count) {
+                EXPECT_EQ(count, b(j, 0).as<int64_t>());
+                EXPECT_EQ(count * count, b(j, 1).as<int64_t>());
+            }
+        }
+    }
+    p.finish();
+    nd::array b = p.pop_batch();
+    EXPECT_EQ(5, b.get_dim_size());
+    EXPECT_EQ(24, b(4, 0).as<int64_t>());
+}
+
+TEST(JSONParser, StreamErrors) {
+    json_stream_parser p(ndt::make_type<int32_t>());
+    p.feed("1\n2\n");
+    try {
+        p.feed("3\n4x\n");
+        FAIL() << "expected a parse error";
+    } catch (const invalid_argument& e) {
+        EXPECT_NE(string::npos, string(e.what()).find("line 4"));
+    }
+    EXPECT_THROW(json_stream_parser(ndt::make_type<int32_t>(), 0), invalid_argument);
+}
+
+TEST(JSONParser, BlockScanning) {
+    // Check every position of the first interesting byte around
+    // the 16 byte blocks
+    for (int i = 0; i < 40; ++i) {
+        string ws(i, ' ');
+        for (int j = 0; j < i; ++j) {
+            ws[j] = " \t\n\r\v\f"[j % 6];
+        }
+        string s = ws + "x" + string(20, ' ');
+        EXPECT_EQ(s.data() + i, parse::skip_whitespace_run(s.data(), s.data() + s.size()));
+        EXPECT_EQ(s.data() + i, parse::skip_whitespace_run(s.data(), s.data() + i));
+        s = string(i, 'a') + "\\" + string(20, '"');
+        EXPECT_EQ(s.data() + i, parse::find_quote_or_backslash(s.data(), s.data() + s.size()));
+        s[i] = '"';
+        EXPECT_EQ(s.data() + i, parse::find_quote_or_backslash(s.data(), s.data() + s.size()));
+        EXPECT_EQ(s.data() + i, parse::find_quote_or_backslash(s.data(), s.data() + i));
+    }
+    // Bytes outside ASCII are neither whitespace nor quotes
+    const char utf8[] = "   \xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\"";
+    EXPECT_EQ(utf8 + 3, parse::skip_whitespace_run(utf8, utf8 + sizeof(utf8) - 1));
+    EXPECT_EQ(utf8 + sizeof(utf8) - 2,
+              parse::find_quote_or_backslash(utf8, utf8 + sizeof(utf8) - 1));
+}
+
+TEST(JSONParser, LongStringsAndWhitespace) {
+    nd::array a;
+    string text(100, 'x');
+    for (int i = 0; i < 40; ++i) {
+        // An escape at every offset within the blocks of a long string
+        string json = "\n" + string(i, ' ') + "[\"" + text.substr(0, i) + "\\n" +
+                      text + "\",\n" + string(i + 17, ' ') + "\"" + text + "\"]" +
+                      string(i, '\t');
+        a = parse_json(ndt::type("2 * string"), json, &eval::default_eval_context);
+        EXPECT_EQ(text.substr(0, i) + "\n" + text, a(0).as<string>());
+        EXPECT_EQ(text, a(1).as<string>());
+        validate_json(json.data(), json.data() + json.size());
+    }
+    // A long unterminated string
+    EXPECT_THROW(parse_json(ndt::make_string(), "\"" + text, &eval::default_eval_context),
+                 invalid_argument);
+    EXPECT_THROW(parse_json(ndt::make_string(), "\"" + text + "\\", &eval::default_eval_context),
+                 invalid_argument);
+}
@@ -8,12 +8,15 @@
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
+#include <vector>
+#include <limits>
 
 #include "inc_gtest.hpp"
 
 #include <dynd/array.hpp>
 #include <dynd/types/bytes_type.hpp>
 #include <dynd/types/string_type.hpp>
+#include <dynd/memblock/memmap_memory_block.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -57,3 +60,96 @@ TEST(ArrayMemMap, SimpleString) {
     unlink("test.txt");
 #endif
 }
+
+TEST(ArrayMemMap, Hints) {
+    vector<int32_t> values(100000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = (int32_t)i;
+    }
+    write_string_file("test.bin", reinterpret_cast<const char *>(&values[0]),
+                      values.size() * sizeof(int32_t));
+
+    // The hints don't change what is mapped
+    uint32_t hints[] = {memmap_hint_sequential,
+                        memmap_hint_random | memmap_hint_hugepages,
+                        memmap_hint_willneed | memmap_hint_populate};
+    for (size_t k = 0; k < sizeof(hints) / sizeof(hints[0]); ++k) {
+        nd::array a = nd::memmap("test.bin", 4, -4, nd::read_access_flag,
+                                 hints[k]);
+        const char *const *extents =
+            reinterpret_cast<const char *const *>(a.get_readonly_originptr());
+        ASSERT_EQ((intptr_t)(values.size() - 2) * 4, extents[1] - extents[0]);
+        const int32_t *b = reinterpret_cast<const int32_t *>(extents[0]);
+        EXPECT_EQ(1, b[0]);
+        EXPECT_EQ(99998, b[99997]);
+    }
+
+    // Advice on part of a mapping
+    nd::array a = nd::memmap("test.bin", 0,
+                             numeric_limits<intptr_t>::max(),
+                             nd::read_access_flag);
+    const char *begin = reinterpret_cast<const char *const *>(
+        a.get_readonly_originptr())[0];
+    memmap_advise(begin + 1000, begin + 200000, memmap_hint_random);
+    memmap_advise(begin + 1000, begin + 200000, memmap_hint_willneed);
+    EXPECT_EQ(12345, reinterpret_cast<const int32_t *>(begin)[12345]);
+
+    EXPECT_THROW(nd::memmap("test.bin", 0, numeric_limits<intptr_t>::max(),
+                            nd::read_access_flag,
+                            memmap_hint_sequential | memmap_hint_random),
+                 runtime_error);
+    EXPECT_THROW(memmap_advise(begin, begin + 10, 0x100), runtime_error);
+
+    a = nd::array();
+#ifdef WIN32
+    _unlink("test.bin");
+#else
+    unlink("test.bin");
+#endif
+}
+
+TEST(ArrayMemMap, Prefetcher) {
+    vector<int32_t> values(300000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = (int32_t)(i % 1000);
+    }
+    write_string_file("test.bin", reinterpret_cast<const char *>(&values[0]),
+                      values.size() * sizeof(int32_t));
+    nd::array a = nd::memmap("test.bin", 0, numeric_limits<intptr_t>::max(),
+                             nd::read_access_flag);
+    const char *begin = reinterpret_cast<const char *const *>(
+        a.get_readonly_originptr())[0];
+
+    // A contiguous scan, a scan striding over pages, and a backwards scan
+    intptr_t strides[] = {4, 8000, -4};
+    for (size_t k = 0; k < sizeof(strides) / sizeof(strides[0]); ++k) {
+        intptr_t stride = strides[k];
+        intptr_t count = (intptr_t)(values.size() * 4) / (stride < 0 ? -stride : stride);
+        const char *origin = stride < 0 ? begin + (count - 1) * 4 : begin;
+        int64_t sum = 0, expected = 0;
+        {
+            memmap_prefetcher pf(origin, stride, count, 4, 4096);
+            for (intptr_t i = 0; i < count; ++i) {
+                pf.advance(i);
+                sum += *reinterpret_cast<const int32_t *>(origin + i * stride);
+            }
+        }
+        for (intptr_t i = 0; i < count; ++i) {
+            expected += values[(origin - begin + i * stride) / 4];
+        }
+        EXPECT_EQ(expected, sum);
+    }
+
+    // Destroying a prefetcher before the scan finishes
+    {
+        memmap_prefetcher pf(begin, 4, values.size(), 4, 1000);
+        pf.advance(10);
+    }
+
+    a = nd::array();
+#ifdef WIN32
+    _unlink("test.bin");
+#else
+    unlink("test.bin");
+#endif
+}
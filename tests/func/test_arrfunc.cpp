@@ -20,7 +20,10 @@
 #include <dynd/func/lift_arrfunc.hpp>
 #include <dynd/func/take_arrfunc.hpp>
 #include <dynd/func/call_callable.hpp>
+#include <dynd/kernels/ckernel_cache.hpp>
 #include <dynd/array.hpp>
+#include <dynd/json_parser.hpp>
+#include "../dynd_assertions.hpp"
 
 using namespace std;
 using namespace dynd;
@@ -267,4 +270,68 @@ nd::array((int)0)).get_type();
     EXPECT_EQ(-208, ints_out[1]);
     EXPECT_EQ(1237, ints_out[2]);
 }
-*/
\ No newline at end of file
+*/
+TEST(ArrFunc, CachedCKernel)
+{
+  nd::arrfunc af = nd::apply::make(&func);
+  kernels::clear_ckernel_cache();
+
+  // The second call with the same types reuses the ckernel
+  EXPECT_EQ(4.5, af(1, 2.5).as<double>());
+  EXPECT_EQ(7.0, af(2, 3.0).as<double>());
+  kernels::ckernel_cache_stats stats = kernels::get_ckernel_cache_stats();
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.size);
+
+  // Different shapes get different ckernels
+  nd::arrfunc lifted = lift_arrfunc(af);
+  int a0[3] = {1, 2, 3};
+  double b0[3] = {0.5, 1.5, 2.5};
+  int a1[2] = {4, 5};
+  double b1[2] = {0.25, 0.75};
+  nd::array c = lifted(a0, b0);
+  EXPECT_JSON_EQ_ARR("[2.5, 5.5, 8.5]", c);
+  c = lifted(a1, b1);
+  EXPECT_JSON_EQ_ARR("[8.25, 10.75]", c);
+  c = lifted(a0, b0);
+  EXPECT_JSON_EQ_ARR("[2.5, 5.5, 8.5]", c);
+  stats = kernels::get_ckernel_cache_stats();
+  EXPECT_EQ(3, stats.misses);
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(3, stats.size);
+
+  // Calls with keyword arguments are not cached
+  nd::arrfunc af_kwd = nd::apply::make(&func, "y");
+  EXPECT_EQ(4.5, af_kwd(1, kwds("y", 2.5)).as<double>());
+  EXPECT_EQ(4.5, af_kwd(1, kwds("y", 2.5)).as<double>());
+  stats = kernels::get_ckernel_cache_stats();
+  EXPECT_EQ(3, stats.misses);
+  EXPECT_EQ(2, stats.hits);
+
+  kernels::clear_ckernel_cache();
+  stats = kernels::get_ckernel_cache_stats();
+  EXPECT_EQ(0, stats.size);
+}
+
+TEST(ArrFunc, CKernelBuilderGrowth)
+{
+  // Grow through several of the pooled size classes and past them,
+  // checking that the data is preserved at each step
+  ckernel_builder<kernel_request_host> ckb;
+  intptr_t capacity = 0;
+  for (intptr_t size = 64; size <= 16384; size *= 2) {
+    ASSERT_EQ(0, ckernel_builder_ensure_capacity_leaf(&ckb, size));
+    char *data = reinterpret_cast<char *>(ckb.get());
+    for (intptr_t i = 0; i < capacity; ++i) {
+      ASSERT_EQ((char)(i % 127), data[i]);
+    }
+    for (intptr_t i = capacity; i < size; ++i) {
+      ASSERT_EQ(0, data[i]);
+      data[i] = (char)(i % 127);
+    }
+    capacity = size;
+  }
+  // Leave an empty ckernel so destruction is a no-op
+  memset(ckb.get(), 0, sizeof(ckernel_prefix));
+}
@@ -20,6 +20,7 @@
 #include <dynd/func/take_arrfunc.hpp>
 #include <dynd/func/call_callable.hpp>
 #include <dynd/array.hpp>
+#include <dynd/array_range.hpp>
 #include <dynd/json_parser.hpp>
 #include "../dynd_assertions.hpp"
 
@@ -209,6 +210,60 @@ TEST(Elwise, BinaryExpr)
 */
 }
 
+TEST(Elwise, BinaryExprParallel)
+{
+  nd::arrfunc af =
+      lift_arrfunc(nd::apply::make<kernel_request_host, callable_to_lift>());
+  eval::eval_context ectx;
+  ectx.nthreads = 4;
+
+  // Large enough to be split into several chunks
+  intptr_t size = 100000;
+  nd::array args[2] = {nd::range<int>(size), nd::range<int>(size, 0, -1)};
+  nd::array c = af.call(2, args, &ectx);
+  ASSERT_EQ(ndt::make_fixed_dim(size, ndt::make_type<int>()), c.get_type());
+  const int *c_data = reinterpret_cast<const int *>(c.get_readonly_originptr());
+  for (intptr_t i = 0; i < size; ++i) {
+    ASSERT_EQ(size, c_data[i]);
+  }
+
+  // Broadcast a one-dimensional array against a two-dimensional one
+  intptr_t nrows = 5000, ncols = 37;
+  args[0] = nd::empty(nrows, ncols, ndt::make_type<int>());
+  int *a_data = reinterpret_cast<int *>(args[0].get_readwrite_originptr());
+  for (intptr_t i = 0; i < nrows * ncols; ++i) {
+    a_data[i] = static_cast<int>(i);
+  }
+  args[1] = nd::range<int>(static_cast<int>(ncols));
+  c = af.call(2, args, &ectx);
+  ASSERT_EQ(nrows, c.get_dim_size());
+  c_data = reinterpret_cast<const int *>(c.get_readonly_originptr());
+  for (intptr_t i = 0; i < nrows * ncols; ++i) {
+    ASSERT_EQ(i + i % ncols, c_data[i]);
+  }
+}
+
+TEST(LiftArrFunc, UnaryExprParallel_Error)
+{
+  nd::arrfunc af = lift_arrfunc(make_arrfunc_from_assignment(
+      ndt::make_type<int8_t>(), ndt::make_type<int>(), assign_error_overflow));
+  eval::eval_context ectx;
+  ectx.nthreads = 4;
+
+  intptr_t size = 100000;
+  nd::array a = nd::empty(size, ndt::make_type<int>());
+  int *a_data = reinterpret_cast<int *>(a.get_readwrite_originptr());
+  for (intptr_t i = 0; i < size; ++i) {
+    a_data[i] = static_cast<int>(i % 100);
+  }
+  nd::array b = af.call(1, &a, &ectx);
+  EXPECT_EQ(99, b(size - 1).as<int>());
+
+  // An overflow in one of the chunks is reported on the calling thread
+  a_data[size / 2] = 1000;
+  EXPECT_THROW(af.call(1, &a, &ectx), overflow_error);
+}
+
 /*
 // TODO Reenable once there's a convenient way to make the binary arrfunc
 TEST(LiftArrFunc, Expr_MultiDimVarToVarDim) {
@@ -135,3 +135,36 @@ TEST(MultiDispatchArrfunc, Dims)
   EXPECT_EQ(ndt::type("3 * float64"), c.get_type());
   EXPECT_JSON_EQ_ARR("[3, 8, 6]", c);
 }
+
+TEST(MultiDispatchArrfunc, RepeatedDispatch)
+{
+  vector<nd::arrfunc> funcs;
+  funcs.push_back(nd::apply::make(&manip0));
+  funcs.push_back(nd::apply::make(&manip1));
+  nd::arrfunc af =
+      lift_arrfunc(make_multidispatch_arrfunc(funcs.size(), &funcs[0]));
+
+  // Alternating between source types gets the same overloads from
+  // the dispatch cache as on the first call
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(3, af(1, 2).as<double>());
+    EXPECT_EQ(-1, af(1.0, 2.0).as<double>());
+    EXPECT_EQ(3, af((int16_t)1, (int8_t)2).as<double>());
+    EXPECT_EQ(-1, af((int16_t)1, dynd_float16(2.f)).as<double>());
+    EXPECT_THROW(af(dynd_complex<double>(1.0), 2), type_error);
+  }
+
+  // More distinct source types than the cache holds
+  funcs[0] = lift_arrfunc(funcs[0]);
+  funcs[1] = lift_arrfunc(funcs[1]);
+  af = make_multidispatch_arrfunc(funcs.size(), &funcs[0]);
+  for (int n = 1; n < 200; ++n) {
+    nd::array a = nd::empty(ndt::make_fixed_dim(n, ndt::make_type<double>()));
+    nd::array b = nd::empty(ndt::make_fixed_dim(n, ndt::make_type<double>()));
+    a.vals() = 2;
+    b.vals() = 0.5;
+    nd::array c = af(a, b);
+    ASSERT_EQ(ndt::make_fixed_dim(n, ndt::make_type<double>()), c.get_type());
+    ASSERT_EQ(1.5, c(n - 1).as<double>());
+  }
+}
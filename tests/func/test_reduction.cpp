@@ -636,3 +636,127 @@ TEST(Reduction, BuiltinSum_Lift3D_StridedStridedStrided_ReduceBroadcastReduce)
   EXPECT_EQ(2.f + 1.25f + 7.f, b(1).as<float>());
   EXPECT_EQ(7.f - 0.5f + 2.125f + 0.25f, b(2).as<float>());
 }
+
+TEST(Reduction, BuiltinSum_Lift1D_Parallel)
+{
+  // Start with a float64 reduction arrfunc
+  nd::arrfunc reduction_kernel =
+      kernels::make_builtin_sum_reduction_arrfunc(float64_type_id);
+
+  // Lift it to a one-dimensional strided float64 reduction arrfunc. Each
+  // chunk starts from the identity, so it must really be an identity here
+  bool reduction_dimflags[1] = {true};
+  nd::arrfunc af = lift_reduction_arrfunc(
+      reduction_kernel, ndt::type("fixed * float64"), nd::array(), false, 1,
+      reduction_dimflags, true, true, false, nd::array(0.));
+
+  // Set up enough data to be split into several chunks
+  intptr_t size = 100000;
+  nd::array a = nd::empty(size, "float64");
+  double *a_data = reinterpret_cast<double *>(a.get_readwrite_originptr());
+  for (intptr_t i = 0; i < size; ++i) {
+    a_data[i] = static_cast<double>(i % 1000);
+  }
+  nd::array b = nd::empty(ndt::make_type<double>());
+
+  // Instantiate the lifted ckernel with parallel evaluation enabled
+  eval::eval_context ectx;
+  ectx.nthreads = 4;
+  unary_ckernel_builder ckb;
+  ndt::type src_tp[1] = {a.get_type()};
+  const char *src_arrmeta[1] = {a.get_arrmeta()};
+  af.get()->instantiate(af.get(), af.get_type(), &ckb, 0, b.get_type(),
+                        b.get_arrmeta(), src_tp, src_arrmeta,
+                        kernel_request_single, &ectx, nd::array());
+
+  // Call it on the data, twice to confirm the partial results are reset
+  ckb(b.get_readwrite_originptr(),
+      const_cast<char *>(a.get_readonly_originptr()));
+  EXPECT_EQ(100. * 499500., b.as<double>());
+  ckb(b.get_readwrite_originptr(),
+      const_cast<char *>(a.get_readonly_originptr()));
+  EXPECT_EQ(100. * 499500., b.as<double>());
+}
+
+TEST(Reduction, BuiltinSum_Lift2D_StridedStrided_ReduceReduce_Parallel)
+{
+  // Start with an int32 reduction arrfunc
+  nd::arrfunc reduction_kernel =
+      kernels::make_builtin_sum_reduction_arrfunc(int32_type_id);
+
+  // Lift it to a two-dimensional strided int32 reduction arrfunc
+  bool reduction_dimflags[2] = {true, true};
+  nd::arrfunc af = lift_reduction_arrfunc(
+      reduction_kernel, ndt::type("fixed * fixed * int32"), nd::array(), false,
+      2, reduction_dimflags, true, true, false, nd::array());
+
+  // Set up enough data to be split into several chunks
+  intptr_t rows = 20000, cols = 3;
+  nd::array a = nd::empty(rows, cols, "int32");
+  int32_t *a_data = reinterpret_cast<int32_t *>(a.get_readwrite_originptr());
+  for (intptr_t i = 0; i < rows * cols; ++i) {
+    a_data[i] = static_cast<int32_t>(i % 7) - 3;
+  }
+  int32_t expected = 0;
+  for (intptr_t i = 0; i < rows * cols; ++i) {
+    expected += a_data[i];
+  }
+  nd::array b = nd::empty(ndt::make_type<int32_t>());
+
+  // Instantiate the lifted ckernel with parallel evaluation enabled
+  eval::eval_context ectx;
+  ectx.nthreads = 4;
+  unary_ckernel_builder ckb;
+  const ndt::type src_tp[1] = {a.get_type()};
+  const char *src_arrmeta[1] = {a.get_arrmeta()};
+  af.get()->instantiate(af.get(), af.get_type(), &ckb, 0, b.get_type(),
+                        b.get_arrmeta(), src_tp, src_arrmeta,
+                        kernel_request_single, &ectx, nd::array());
+
+  // Call it on the data
+  ckb(b.get_readwrite_originptr(),
+      const_cast<char *>(a.get_readonly_originptr()));
+  EXPECT_EQ(expected, b.as<int32_t>());
+}
+
+TEST(Reduction, BuiltinSum_Lift2D_StridedStrided_ReduceBroadcast_KeepDim_Parallel)
+{
+  // Start with a float64 reduction arrfunc
+  nd::arrfunc reduction_kernel =
+      kernels::make_builtin_sum_reduction_arrfunc(float64_type_id);
+
+  // Lift it to a two-dimensional strided float64 reduction arrfunc
+  bool reduction_dimflags[2] = {true, false};
+  nd::arrfunc af = lift_reduction_arrfunc(
+      reduction_kernel, ndt::type("fixed * fixed * float64"), nd::array(),
+      true, 2, reduction_dimflags, true, true, false, nd::array());
+
+  // Set up enough data to be split into several chunks
+  intptr_t rows = 5000, cols = 7;
+  nd::array a = nd::empty(rows, cols, "float64");
+  double *a_data = reinterpret_cast<double *>(a.get_readwrite_originptr());
+  for (intptr_t i = 0; i < rows; ++i) {
+    for (intptr_t j = 0; j < cols; ++j) {
+      a_data[i * cols + j] = static_cast<double>(j * (i % 10));
+    }
+  }
+  nd::array b = nd::empty(1, cols, "float64");
+
+  // Instantiate the lifted ckernel with parallel evaluation enabled
+  eval::eval_context ectx;
+  ectx.nthreads = 4;
+  unary_ckernel_builder ckb;
+  const ndt::type src_tp[1] = {a.get_type()};
+  const char *src_arrmeta[1] = {a.get_arrmeta()};
+  af.get()->instantiate(af.get(), af.get_type(), &ckb, 0, b.get_type(),
+                        b.get_arrmeta(), src_tp, src_arrmeta,
+                        kernel_request_single, &ectx, nd::array());
+
+  // Call it on the data
+  ckb(b.get_readwrite_originptr(),
+      const_cast<char *>(a.get_readonly_originptr()));
+  ASSERT_EQ(cols, b.get_shape()[1]);
+  for (intptr_t j = 0; j < cols; ++j) {
+    EXPECT_EQ(j * 45. * (rows / 10), b(0, j).as<double>());
+  }
+}
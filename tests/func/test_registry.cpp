@@ -7,11 +7,15 @@
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <thread>
+#include <vector>
 
 #include "inc_gtest.hpp"
 
 #include <dynd/array.hpp>
 #include <dynd/func/arrfunc_registry.hpp>
+#include <dynd/func/apply_arrfunc.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -91,3 +95,88 @@ TEST(ArrFuncRegistry, Trig) {
   EXPECT_FLOAT_EQ(powf(1.5f, 2.25f), af(1.5f, 2.25f).as<float>());
   EXPECT_DOUBLE_EQ(pow(1.5, 2.25), af(1.5, 2.25).as<double>());
 }
+
+TEST(ArrFuncRegistry, UnknownName) {
+  EXPECT_THROW(func::get_regfunction("not_a_registered_function"),
+               invalid_argument);
+  EXPECT_THROW(func::get_regfunction(nd::string("sin_")), invalid_argument);
+}
+
+TEST(ArrFuncRegistry, SetRegFunction) {
+  nd::arrfunc af;
+  func::set_regfunction("test_registry_alias", func::get_regfunction("cos"));
+  af = func::get_regfunction("test_registry_alias");
+  EXPECT_DOUBLE_EQ(cos(1.0), af(1.0).as<double>());
+  // Overwriting an existing name replaces its arrfunc
+  func::set_regfunction("test_registry_alias", func::get_regfunction("sin"));
+  af = func::get_regfunction("test_registry_alias");
+  EXPECT_DOUBLE_EQ(sin(1.0), af(1.0).as<double>());
+  EXPECT_EQ(1u, func::get_regfunctions().count("test_registry_alias"));
+}
+
+static double registry_test_square(double x) { return x * x; }
+
+TEST(ArrFuncRegistry, ReplacedTablesAreFreed) {
+  nd::arrfunc af = nd::apply::make(&registry_test_square);
+  memory_block_data *mb = nd::array(af).get_memblock().get();
+  int32_t initial = mb->m_use_count;
+  func::set_regfunction("test_registry_freed", af);
+  EXPECT_LT(initial, (int32_t)mb->m_use_count);
+  // Registering again copies the table, after which nothing may be left
+  // holding the arrfunc that was replaced
+  func::set_regfunction("test_registry_freed", func::get_regfunction("cos"));
+  EXPECT_EQ(initial, (int32_t)mb->m_use_count);
+}
+
+TEST(ArrFuncRegistry, GetRegFunctionsSnapshot) {
+  nd::arrfunc af = nd::apply::make(&registry_test_square);
+  func::set_regfunction("test_registry_snapshot", af);
+  map<nd::string, nd::arrfunc> snapshot = func::get_regfunctions();
+  ASSERT_EQ(1u, snapshot.count("test_registry_snapshot"));
+  EXPECT_EQ(nd::array(af).get_ndo(),
+            nd::array(snapshot["test_registry_snapshot"]).get_ndo());
+  EXPECT_EQ(1u, snapshot.count("sin"));
+  // Later registrations don't change a snapshot already taken
+  func::set_regfunction("test_registry_snapshot", func::get_regfunction("cos"));
+  func::set_regfunction("test_registry_snapshot_later", af);
+  EXPECT_EQ(nd::array(af).get_ndo(),
+            nd::array(snapshot["test_registry_snapshot"]).get_ndo());
+  EXPECT_EQ(0u, snapshot.count("test_registry_snapshot_later"));
+}
+
+static void lookup_repeatedly(int count, int *failures)
+{
+  for (int i = 0; i < count; ++i) {
+    try {
+      if (func::get_regfunction("sin").is_null() ||
+          func::get_regfunction("add").is_null()) {
+        ++*failures;
+      }
+    }
+    catch (const exception &) {
+      ++*failures;
+    }
+  }
+}
+
+TEST(ArrFuncRegistry, ConcurrentLookup) {
+  const int nthreads = 4, nregister = 200;
+  int failures[nthreads] = {0, 0, 0, 0};
+  vector<thread> threads;
+  for (int i = 0; i < nthreads; ++i) {
+    threads.push_back(thread(lookup_repeatedly, 2000, &failures[i]));
+  }
+  // Register new functions while the other threads are doing lookups
+  nd::arrfunc af = func::get_regfunction("sin");
+  for (int i = 0; i < nregister; ++i) {
+    func::set_regfunction("test_concurrent_" + to_string(i), af);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    threads[i].join();
+    EXPECT_EQ(0, failures[i]);
+  }
+  for (int i = 0; i < nregister; ++i) {
+    af = func::get_regfunction("test_concurrent_" + to_string(i));
+    EXPECT_DOUBLE_EQ(sin(1.0), af(1.0).as<double>());
+  }
+}
@@ -61,3 +61,110 @@ TEST(Rolling, BuiltinMean_Kernel) {
         EXPECT_EQ(s / 4, b(i).as<double>());
     }
 }
+
+// Checks a rolling arrfunc against its window op applied to each window
+static void check_rolling_matches_window_op(const nd::arrfunc &window_op,
+                                            intptr_t window_size,
+                                            const nd::array &a)
+{
+  nd::arrfunc rolling = make_rolling_arrfunc(window_op, window_size);
+  nd::array b = rolling(a);
+  intptr_t dim_size = a.get_dim_size();
+  ASSERT_EQ(dim_size, b.get_dim_size());
+  for (intptr_t i = 0; i < min(window_size - 1, dim_size); ++i) {
+    EXPECT_TRUE(DYND_ISNAN(b(i).as<double>()));
+  }
+  for (intptr_t i = window_size - 1; i < dim_size; ++i) {
+    double expected =
+        window_op(a(irange(i - window_size + 1, i + 1))).as<double>();
+    double actual = b(i).as<double>();
+    if (DYND_ISNAN(expected)) {
+      EXPECT_TRUE(DYND_ISNAN(actual)) << "at index " << i;
+    } else if (fabs(expected) == numeric_limits<double>::infinity()) {
+      EXPECT_EQ(expected, actual) << "at index " << i;
+    } else {
+      EXPECT_NEAR(expected, actual, 1e-9 * max(1.0, fabs(expected)))
+          << "at index " << i;
+    }
+  }
+}
+
+TEST(Rolling, BuiltinReductions_Incremental)
+{
+  const double nan = numeric_limits<double>::quiet_NaN();
+  const double inf = numeric_limits<double>::infinity();
+  double adata[] = {1, 3, 7, 2, 9, 4, -5, 100, 2, -20, 3, 9, 18, 0.5,
+                    -3.25, 11, 6, 6, 6, -1e-3, 2.5, 1e6, 7, -8};
+  double nandata[] = {1, nan, 7, 2, nan, nan, nan, 100, 2, -20, nan, 9, 18,
+                      nan, -3.25, 11};
+  double infdata[] = {1, 3, inf, 2, 9, -inf, -5, 100, 2, -20, 3, 9, nan, 8,
+                      1, 0};
+  nd::array arrays[] = {nd::array(adata), nd::array(nandata),
+                        nd::array(infdata)};
+  intptr_t window_sizes[] = {1, 2, 4, 7};
+  for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); ++k) {
+    for (size_t w = 0; w < sizeof(window_sizes) / sizeof(window_sizes[0]); ++w) {
+      intptr_t window_size = window_sizes[w];
+      check_rolling_matches_window_op(
+          kernels::make_builtin_sum1d_arrfunc(float64_type_id), window_size,
+          arrays[k]);
+      for (intptr_t minp = 0; minp < 3; ++minp) {
+        check_rolling_matches_window_op(
+            kernels::make_builtin_mean1d_arrfunc(float64_type_id, minp),
+            window_size, arrays[k]);
+        check_rolling_matches_window_op(
+            kernels::make_builtin_var1d_arrfunc(float64_type_id, minp),
+            window_size, arrays[k]);
+        check_rolling_matches_window_op(
+            kernels::make_builtin_min1d_arrfunc(float64_type_id, minp),
+            window_size, arrays[k]);
+        check_rolling_matches_window_op(
+            kernels::make_builtin_max1d_arrfunc(float64_type_id, minp),
+            window_size, arrays[k]);
+      }
+    }
+  }
+}
+
+TEST(Rolling, BuiltinReductions_LongWindow)
+{
+  // A large window over values with a wide range, where the running
+  // state has to stay accurate over many steps
+  intptr_t dim_size = 5000, window_size = 1000;
+  nd::array a = nd::empty(dim_size, ndt::make_type<double>());
+  double *adata = reinterpret_cast<double *>(a.get_readwrite_originptr());
+  uint32_t state = 12345;
+  for (intptr_t i = 0; i < dim_size; ++i) {
+    state = state * 1664525u + 1013904223u;
+    adata[i] = (state >> 8) * (i % 100 == 0 ? 1e6 : 1e-3);
+  }
+  nd::arrfunc rolling_max = make_rolling_arrfunc(
+      kernels::make_builtin_max1d_arrfunc(float64_type_id, 0), window_size);
+  nd::arrfunc rolling_mean = make_rolling_arrfunc(
+      kernels::make_builtin_mean1d_arrfunc(float64_type_id, 0), window_size);
+  nd::array bmax = rolling_max(a), bmean = rolling_mean(a);
+  for (intptr_t i = window_size - 1; i < dim_size; i += 97) {
+    double m = adata[i], s = 0;
+    for (intptr_t j = i - window_size + 1; j <= i; ++j) {
+      m = max(m, adata[j]);
+      s += adata[j];
+    }
+    EXPECT_EQ(m, bmax(i).as<double>());
+    EXPECT_NEAR(s / window_size, bmean(i).as<double>(), 1e-9 * s / window_size);
+  }
+}
+
+TEST(Rolling, BuiltinReductionInfo)
+{
+  kernels::builtin_reduction1d_info info;
+  EXPECT_TRUE(kernels::get_builtin_reduction1d_info(
+      kernels::make_builtin_sum1d_arrfunc(int32_type_id), info));
+  EXPECT_EQ(kernels::builtin_reduction1d_sum, info.kind);
+  EXPECT_EQ(int32_type_id, info.tid);
+  EXPECT_TRUE(kernels::get_builtin_reduction1d_info(
+      kernels::make_builtin_var1d_arrfunc(float64_type_id, 3), info));
+  EXPECT_EQ(kernels::builtin_reduction1d_var, info.kind);
+  EXPECT_EQ(3, info.minp);
+  EXPECT_FALSE(kernels::get_builtin_reduction1d_info(
+      kernels::make_builtin_sum_reduction_arrfunc(float64_type_id), info));
+}
@@ -0,0 +1,90 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+
+#include "inc_gtest.hpp"
+
+#include <dynd/array.hpp>
+#include <dynd/func/struct_layout_arrfunc.hpp>
+#include <dynd/json_parser.hpp>
+#include <dynd/json_formatter.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(ArrFunc, StructOfArrays) {
+    nd::arrfunc to_soa = kernels::make_struct_of_arrays_arrfunc();
+    nd::arrfunc to_aos = kernels::make_array_of_structs_arrfunc();
+
+    nd::array a = parse_json("3 * {x: int32, name: string, y: float64}",
+                             "[[1, \"one\", 1.5], [2, \"two\", 2.5], "
+                             "[3, \"three\", 3.5]]");
+    nd::array b = to_soa(a);
+    EXPECT_EQ(ndt::type("{x: 3 * int32, name: 3 * string, y: 3 * float64}"),
+              b.get_type());
+    EXPECT_EQ("[1,2,3]", string(format_json(b.p("x")).as<string>()));
+    EXPECT_EQ("[\"one\",\"two\",\"three\"]",
+              string(format_json(b.p("name")).as<string>()));
+    EXPECT_EQ(3.5, b.p("y")(2).as<double>());
+    // The columns are contiguous
+    EXPECT_EQ(4, reinterpret_cast<const fixed_dim_type_arrmeta *>(
+                     b.p("x").get_arrmeta())->stride);
+
+    nd::array c = to_aos(b);
+    EXPECT_EQ(a.get_type(), c.get_type());
+    EXPECT_EQ(string(format_json(a).as<string>()),
+              string(format_json(c).as<string>()));
+
+    // Tuples, from a strided view
+    a = parse_json("4 * (int16, float32)", "[[1, 0.5], [2, 1], [3, 1.5], [4, 2]]");
+    b = to_soa(a(irange().by(2)));
+    EXPECT_EQ(ndt::type("(2 * int16, 2 * float32)"), b.get_type());
+    EXPECT_EQ(3, b(0, 1).as<int16_t>());
+    EXPECT_EQ(0.5f, b(1, 0).as<float>());
+    EXPECT_EQ(1.5f, b(1, 1).as<float>());
+    c = to_aos(b);
+    EXPECT_EQ(ndt::type("2 * (int16, float32)"), c.get_type());
+    EXPECT_EQ(1, c(0, 0).as<int16_t>());
+    EXPECT_EQ(3, c(1, 0).as<int16_t>());
+    EXPECT_EQ(1.5f, c(1, 1).as<float>());
+}
+
+TEST(ArrFunc, StructOfArraysErrors) {
+    nd::arrfunc to_soa = kernels::make_struct_of_arrays_arrfunc();
+    nd::arrfunc to_aos = kernels::make_array_of_structs_arrfunc();
+
+    EXPECT_THROW(to_soa(parse_json("2 * int32", "[1, 2]")), type_error);
+    EXPECT_THROW(to_soa(parse_json("var * {x: int32}", "[[1]]")), type_error);
+    EXPECT_THROW(to_aos(parse_json("{x: 2 * int32, y: 3 * int32}",
+                                   "[[1, 2], [1, 2, 3]]")),
+                 type_error);
+    EXPECT_THROW(to_aos(parse_json("{x: int32}", "[1]")), type_error);
+}
+
+static int resolve_without_throwing(const nd::arrfunc &af,
+                                    const ndt::type &src_tp)
+{
+    ndt::type dst_tp;
+    return af.get()->resolve_dst_type(af.get(), af.get_type(), 1, &src_tp,
+                                      false, dst_tp, nd::array());
+}
+
+TEST(ArrFunc, StructOfArraysErrorsWithoutThrowing) {
+    nd::arrfunc to_soa = kernels::make_struct_of_arrays_arrfunc();
+    nd::arrfunc to_aos = kernels::make_array_of_structs_arrfunc();
+
+    EXPECT_EQ(0, resolve_without_throwing(to_soa, ndt::type("2 * int32")));
+    EXPECT_EQ(0, resolve_without_throwing(to_soa, ndt::type("{x: int32}")));
+    EXPECT_EQ(0, resolve_without_throwing(to_soa,
+                                          ndt::type("var * {x: int32}")));
+    EXPECT_EQ(0, resolve_without_throwing(
+                     to_aos, ndt::type("{x: 2 * int32, y: 3 * int32}")));
+    EXPECT_EQ(0, resolve_without_throwing(to_aos, ndt::type("{x: int32}")));
+    EXPECT_EQ(0, resolve_without_throwing(to_aos, ndt::type("2 * int32")));
+    EXPECT_EQ(1, resolve_without_throwing(to_soa,
+                                          ndt::type("2 * {x: int32}")));
+}
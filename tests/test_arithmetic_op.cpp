@@ -10,6 +10,8 @@
 
 #include <dynd/array.hpp>
 #include <dynd/json_parser.hpp>
+#include <dynd/array_range.hpp>
+#include <dynd/types/base_tuple_type.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -247,3 +249,69 @@ TEST(ArithmeticOp, ComplexScalar) {
     EXPECT_EQ(dynd_complex<float>(0,-2), c(1).as<dynd_complex<float> >());
     EXPECT_EQ(dynd_complex<float>(0,-3), c(2).as<dynd_complex<float> >());
 }
+
+TEST(ArithmeticOp, DeferredFusion) {
+    nd::array a, b, c, d, e, r;
+
+    // Long enough to take several chunks, and strided
+    a = nd::range(1000.0);
+    b = nd::range(2000.0)(irange().by(2));
+    c = 3.0;
+    d = nd::range(1000.0)(irange().by(-1));
+    e = 0.5;
+    {
+        nd::deferred_arithmetic deferred;
+        r = a * b + c * d - e;
+    }
+    // The whole chain is one unevaluated expression on the five operands
+    EXPECT_EQ(expr_type_id, r.get_type().get_type_id());
+    EXPECT_EQ(ndt::type("1000 * float64"), r.get_type().value_type());
+    r = r.eval();
+    EXPECT_EQ(ndt::type("1000 * float64"), r.get_type());
+    for (int i = 0; i < 1000; ++i) {
+        double x = a(i).as<double>(), y = b(i).as<double>();
+        double z = d(i).as<double>();
+        ASSERT_EQ(x * y + 3 * z - 0.5, r(i).as<double>());
+    }
+
+    // Operators outside the scope fuse with an unevaluated operand
+    {
+        nd::deferred_arithmetic deferred;
+        r = a + b;
+    }
+    r = r / c;
+    EXPECT_EQ(ndt::type("1000 * float64"), r.get_type());
+    EXPECT_EQ((a(7).as<double>() + b(7).as<double>()) / 3, r(7).as<double>());
+}
+
+TEST(ArithmeticOp, DeferredFusionBroadcast) {
+    nd::array a, b, r;
+    a = parse_json("3 * int32", "[1, 2, 3]");
+    b = parse_json("2 * 1 * int32", "[[10], [20]]");
+    {
+        nd::deferred_arithmetic deferred;
+        // More operands than fit in one fused expression
+        r = a + b + a + b + a + b + a + b;
+    }
+    r = r.eval();
+    EXPECT_EQ(ndt::type("2 * 3 * int32"), r.get_type());
+    EXPECT_EQ(4 * 10 + 4 * 1, r(0, 0).as<int>());
+    EXPECT_EQ(4 * 20 + 4 * 3, r(1, 2).as<int>());
+
+    // When the two sides don't fit together, the smaller one is
+    // evaluated, leaving the larger one fused
+    nd::array left, right;
+    {
+        nd::deferred_arithmetic deferred;
+        left = a + b;
+        right = a + b + a + b + a;
+        r = left + right;
+    }
+    EXPECT_EQ(expr_type_id, r.get_type().get_type_id());
+    EXPECT_EQ(6, r.get_type().operand_type().extended<base_tuple_type>()
+                     ->get_field_count());
+    r = r.eval();
+    EXPECT_EQ(ndt::type("2 * 3 * int32"), r.get_type());
+    EXPECT_EQ(3 * 10 + 4 * 1, r(0, 0).as<int>());
+    EXPECT_EQ(3 * 20 + 4 * 3, r(1, 2).as<int>());
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include "inc_gtest.hpp"
+
+#include <dynd/groupby.hpp>
+#include <dynd/random.hpp>
+#include <dynd/array.hpp>
+#include <dynd/json_parser.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(GroupByAggregate, StringKeys) {
+    nd::array keys = parse_json("6 * string",
+                                "[\"b\", \"a\", \"b\", \"c\", \"a\", \"b\"]");
+    nd::array values = parse_json("6 * int32", "[1, 2, 3, 4, 5, 6]");
+
+    nd::array r = nd::groupby_aggregate(keys, values, groupby_aggregate_sum);
+    EXPECT_EQ(ndt::type("3 * {key: string, value: int64}"), r.get_type());
+    EXPECT_EQ("b", r(0, 0).as<string>());
+    EXPECT_EQ(10, r(0, 1).as<int64_t>());
+    EXPECT_EQ("a", r(1, 0).as<string>());
+    EXPECT_EQ(7, r(1, 1).as<int64_t>());
+    EXPECT_EQ("c", r(2, 0).as<string>());
+    EXPECT_EQ(4, r(2, 1).as<int64_t>());
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_count);
+    EXPECT_EQ(ndt::type("3 * {key: string, value: int64}"), r.get_type());
+    EXPECT_EQ(3, r(0, 1).as<int64_t>());
+    EXPECT_EQ(2, r(1, 1).as<int64_t>());
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_mean);
+    EXPECT_EQ(ndt::type("3 * {key: string, value: float64}"), r.get_type());
+    EXPECT_DOUBLE_EQ(10.0 / 3, r(0, 1).as<double>());
+    EXPECT_DOUBLE_EQ(3.5, r(1, 1).as<double>());
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_min);
+    EXPECT_EQ(ndt::type("3 * {key: string, value: int32}"), r.get_type());
+    EXPECT_EQ(1, r(0, 1).as<int32_t>());
+    EXPECT_EQ(2, r(1, 1).as<int32_t>());
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_max);
+    EXPECT_EQ(6, r(0, 1).as<int32_t>());
+    EXPECT_EQ(5, r(1, 1).as<int32_t>());
+}
+
+TEST(GroupByAggregate, StructKeysAndValues) {
+    nd::array keys = parse_json("5 * {a: int32, b: string}",
+                                "[[1, \"x\"], [1, \"y\"], [1, \"x\"], "
+                                "[2, \"x\"], [1, \"y\"]]");
+    nd::array values = parse_json("5 * {u: uint8, f: float32}",
+                                  "[[1, 0.5], [2, 0], [3, 1.5], "
+                                  "[4, 2.0], [5, 0]]");
+    values(1, 1).vals() = numeric_limits<float>::quiet_NaN();
+    values(4, 1).vals() = numeric_limits<float>::quiet_NaN();
+    nd::array r = nd::groupby_aggregate(keys, values, groupby_aggregate_sum);
+    EXPECT_EQ(ndt::type("3 * {key: {a: int32, b: string}, u: uint64, "
+                        "f: float64}"), r.get_type());
+    EXPECT_EQ(1, r(0, 0, 0).as<int32_t>());
+    EXPECT_EQ("x", r(0, 0, 1).as<string>());
+    EXPECT_EQ(4u, r(0, 1).as<uint64_t>());
+    EXPECT_EQ(2.0, r(0, 2).as<double>());
+    EXPECT_EQ(7u, r(1, 1).as<uint64_t>());
+    // NaN values are skipped
+    EXPECT_EQ(0.0, r(1, 2).as<double>());
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_max);
+    EXPECT_EQ(ndt::type("3 * {key: {a: int32, b: string}, u: uint8, "
+                        "f: float32}"), r.get_type());
+    EXPECT_EQ(1.5f, r(0, 2).as<float>());
+    EXPECT_TRUE(DYND_ISNAN(r(1, 2).as<float>()));
+
+    r = nd::groupby_aggregate(keys, values, groupby_aggregate_count);
+    EXPECT_EQ(2, r(1, 1).as<int64_t>());
+    EXPECT_EQ(0, r(1, 2).as<int64_t>());
+}
+
+TEST(GroupByAggregate, Errors) {
+    nd::array keys = parse_json("3 * int32", "[1, 2, 1]");
+    EXPECT_THROW(nd::groupby_aggregate(keys, parse_json("2 * int32", "[1, 2]"),
+                                       groupby_aggregate_sum),
+                 runtime_error);
+    EXPECT_THROW(nd::groupby_aggregate(keys,
+                                       parse_json("3 * string", "[\"\", \"\", \"\"]"),
+                                       groupby_aggregate_sum),
+                 type_error);
+    EXPECT_THROW(nd::groupby_aggregate(parse_json("1 * 1 * int32", "[[1]]"),
+                                       parse_json("1 * int32", "[1]"),
+                                       groupby_aggregate_sum),
+                 type_error);
+
+    // No rows gives no groups
+    nd::array r = nd::groupby_aggregate(nd::empty(0, ndt::make_type<int32_t>()),
+                                        nd::empty(0, ndt::make_type<double>()),
+                                        groupby_aggregate_mean);
+    EXPECT_EQ(ndt::type("0 * {key: int32, value: float64}"), r.get_type());
+}
+
+TEST(GroupByAggregate, ParallelMatchesSerial) {
+    intptr_t nthreads = eval::default_eval_context.nthreads;
+    intptr_t n = 300000;
+    nd::array keys = make_randint_arrfunc(int32_type_id)(
+        kwds("shape", n, "low", 0, "high", 5000, "seed", 4));
+    nd::array values = make_randint_arrfunc(int64_type_id)(
+        kwds("shape", n, "low", -1000, "high", 1000, "seed", 5));
+    for (int agg = groupby_aggregate_count; agg <= groupby_aggregate_max; ++agg) {
+        eval::default_eval_context.nthreads = 1;
+        nd::array a = nd::groupby_aggregate(keys, values, (groupby_aggregate_t)agg);
+        eval::default_eval_context.nthreads = 4;
+        nd::array b = nd::groupby_aggregate(keys, values, (groupby_aggregate_t)agg);
+        eval::default_eval_context.nthreads = nthreads;
+        ASSERT_EQ(a.get_type(), b.get_type());
+        EXPECT_EQ(0, memcmp(a.get_readonly_originptr(), b.get_readonly_originptr(),
+                            a.get_dim_size() * a.get_type().at(0).get_data_size()));
+    }
+}
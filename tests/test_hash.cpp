@@ -0,0 +1,149 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include "inc_gtest.hpp"
+
+#include <dynd/hash.hpp>
+#include <dynd/array.hpp>
+#include <dynd/json_parser.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(Hash, Builtins) {
+    nd::array a = parse_json("5 * int32", "[1, 2, 1, -1, 2]");
+    nd::array h = nd::hash(a);
+    EXPECT_EQ(ndt::type("5 * uint64"), h.get_type());
+    EXPECT_EQ(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+    EXPECT_EQ(h(1).as<uint64_t>(), h(4).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(1).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(3).as<uint64_t>());
+
+    // Values which compare equal hash equal
+    nd::array f = nd::empty(4, ndt::make_type<double>());
+    f(0).vals() = 0.0;
+    f(1).vals() = -0.0;
+    f(2).vals() = numeric_limits<double>::quiet_NaN();
+    f(3).vals() = -numeric_limits<double>::quiet_NaN();
+    h = nd::hash(f);
+    EXPECT_EQ(h(0).as<uint64_t>(), h(1).as<uint64_t>());
+    EXPECT_EQ(h(2).as<uint64_t>(), h(3).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+
+    EXPECT_EQ(ndt::make_type<uint64_t>(), nd::hash(nd::array(3.5f)).get_type());
+}
+
+TEST(Hash, Strings) {
+    nd::array a = parse_json("4 * string",
+                             "[\"a fairly long string\", \"b\", "
+                             "\"a fairly long string\", \"a fairly long strinG\"]");
+    nd::array h = nd::hash(a);
+    EXPECT_EQ(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(1).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(3).as<uint64_t>());
+
+    nd::array fs = a.ucast(ndt::type("string[24]")).eval();
+    h = nd::hash(fs);
+    EXPECT_EQ(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(3).as<uint64_t>());
+}
+
+TEST(Hash, StructAndOption) {
+    nd::array a = parse_json("4 * {x: int32, y: string}",
+                             "[[1, \"a\"], [1, \"b\"], [1, \"a\"], [2, \"a\"]]");
+    nd::array h = nd::hash(a);
+    EXPECT_EQ(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(1).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(3).as<uint64_t>());
+
+    a = parse_json("4 * ?int32", "[1, null, 1, null]");
+    h = nd::hash(a);
+    EXPECT_EQ(h(0).as<uint64_t>(), h(2).as<uint64_t>());
+    EXPECT_EQ(h(1).as<uint64_t>(), h(3).as<uint64_t>());
+    EXPECT_NE(h(0).as<uint64_t>(), h(1).as<uint64_t>());
+
+    // Hashing is elementwise over any dimensions
+    h = nd::hash(parse_json("2 * var * int32", "[[1], [2, 1]]"));
+    EXPECT_EQ(ndt::type("2 * var * uint64"), h.get_type());
+    EXPECT_EQ(h(0, 0).as<uint64_t>(), h(1, 1).as<uint64_t>());
+}
+
+TEST(Hash, Unique) {
+    nd::array a = parse_json("8 * int64", "[5, 3, 5, 5, -2, 3, 0, -2]");
+    nd::array u = nd::unique(a);
+    EXPECT_EQ(ndt::type("4 * int64"), u.get_type());
+    EXPECT_EQ(5, u(0).as<int64_t>());
+    EXPECT_EQ(3, u(1).as<int64_t>());
+    EXPECT_EQ(-2, u(2).as<int64_t>());
+    EXPECT_EQ(0, u(3).as<int64_t>());
+
+    a = parse_json("5 * string", "[\"x\", \"y\", \"x\", \"\", \"y\"]");
+    u = nd::unique(a);
+    EXPECT_EQ(ndt::type("3 * string"), u.get_type());
+    EXPECT_EQ("x", u(0).as<string>());
+    EXPECT_EQ("y", u(1).as<string>());
+    EXPECT_EQ("", u(2).as<string>());
+
+    nd::array f = nd::empty(4, ndt::make_type<float>());
+    f(0).vals() = numeric_limits<float>::quiet_NaN();
+    f(1).vals() = 0.0f;
+    f(2).vals() = numeric_limits<float>::quiet_NaN();
+    f(3).vals() = -0.0f;
+    u = nd::unique(f);
+    EXPECT_EQ(2, u.get_dim_size());
+    EXPECT_TRUE(DYND_ISNAN(u(0).as<float>()));
+
+    // Enough values to grow the table many times
+    a = nd::empty(100000, ndt::make_type<int32_t>());
+    for (int i = 0; i < 100000; ++i) {
+        a(i).vals() = (i * 7919) % 1000;
+    }
+    u = nd::unique(a);
+    EXPECT_EQ(1000, u.get_dim_size());
+    EXPECT_EQ(0, u(0).as<int32_t>());
+    EXPECT_EQ(919, u(1).as<int32_t>());
+
+    EXPECT_THROW(nd::unique(parse_json("2 * 2 * int32", "[[1, 2], [3, 4]]")),
+                 type_error);
+}
+
+TEST(Hash, ValueCounts) {
+    nd::array a = parse_json("7 * ?string",
+                             "[\"b\", \"a\", null, \"b\", \"b\", null, \"c\"]");
+    nd::array vc = nd::value_counts(a);
+    EXPECT_EQ(ndt::type("4 * {value: ?string, count: int64}"), vc.get_type());
+    EXPECT_EQ("b", vc(0, 0).as<string>());
+    EXPECT_EQ(3, vc(0, 1).as<int64_t>());
+    EXPECT_EQ("a", vc(1, 0).as<string>());
+    EXPECT_EQ(1, vc(1, 1).as<int64_t>());
+    EXPECT_EQ(2, vc(2, 1).as<int64_t>());
+    EXPECT_EQ("c", vc(3, 0).as<string>());
+    EXPECT_EQ(1, vc(3, 1).as<int64_t>());
+}
+
+TEST(Hash, ValueHashIndex) {
+    nd::array a = parse_json("6 * int16", "[4, 8, 4, 15, 16, 8]");
+    value_hash_index index(ndt::make_type<int16_t>(), NULL,
+                           &eval::default_eval_context);
+    intptr_t ids[6];
+    index.insert(a.get_readonly_originptr(), sizeof(int16_t), 6, ids);
+    EXPECT_EQ(4, index.size());
+    EXPECT_EQ(0, ids[0]);
+    EXPECT_EQ(1, ids[1]);
+    EXPECT_EQ(0, ids[2]);
+    EXPECT_EQ(2, ids[3]);
+    EXPECT_EQ(3, ids[4]);
+    EXPECT_EQ(1, ids[5]);
+
+    nd::array b = parse_json("3 * int16", "[16, 23, 4]");
+    index.find(b.get_readonly_originptr(), sizeof(int16_t), 3, ids);
+    EXPECT_EQ(3, ids[0]);
+    EXPECT_EQ(-1, ids[1]);
+    EXPECT_EQ(0, ids[2]);
+    EXPECT_EQ(4, index.size());
+}
@@ -0,0 +1,96 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include "inc_gtest.hpp"
+
+#include <dynd/memblock/pod_memory_block.hpp>
+#include <dynd/memblock/zeroinit_memory_block.hpp>
+#include <dynd/memblock/objectarray_memory_block.hpp>
+#include <dynd/types/type_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(MemoryBlock, PodChunkReuse) {
+    memory_chunk_pool_stats before = get_memory_chunk_pool_stats();
+    char *begin, *end;
+    {
+        memory_block_ptr m = make_pod_memory_block(100000);
+        memory_block_pod_allocator_api *api = get_memory_block_pod_allocator_api(m.get());
+        api->allocate(m.get(), 50000, 8, &begin, &end);
+        memset(begin, 1, end - begin);
+        EXPECT_LE(100000, get_memory_chunk_pool_stats().bytes_in_flight -
+                        before.bytes_in_flight);
+    }
+    memory_chunk_pool_stats after_free = get_memory_chunk_pool_stats();
+    EXPECT_EQ(before.bytes_in_flight, after_free.bytes_in_flight);
+
+    // A block of the same size gets the freed chunk back from the pool
+    {
+        memory_block_ptr m = make_pod_memory_block(100000);
+        memory_block_pod_allocator_api *api = get_memory_block_pod_allocator_api(m.get());
+        api->allocate(m.get(), 50000, 8, &begin, &end);
+    }
+    memory_chunk_pool_stats after_reuse = get_memory_chunk_pool_stats();
+    EXPECT_EQ(after_free.hits + 1, after_reuse.hits);
+    EXPECT_EQ(after_free.misses, after_reuse.misses);
+    EXPECT_EQ(before.bytes_in_flight, after_reuse.bytes_in_flight);
+}
+
+TEST(MemoryBlock, PodResizeAcrossChunks) {
+    memory_block_ptr m = make_pod_memory_block(16);
+    memory_block_pod_allocator_api *api = get_memory_block_pod_allocator_api(m.get());
+    char *begin, *end;
+    api->allocate(m.get(), 10, 1, &begin, &end);
+    for (int i = 0; i < 10; ++i) {
+        begin[i] = (char)i;
+    }
+    // Growing past the first chunk moves the data to a new chunk
+    api->resize(m.get(), 100000, &begin, &end);
+    EXPECT_EQ(100000, end - begin);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ((char)i, begin[i]);
+    }
+    api->reset(m.get());
+    api->allocate(m.get(), 10, 1, &begin, &end);
+    EXPECT_EQ(10, end - begin);
+}
+
+TEST(MemoryBlock, ZeroinitResizeAcrossChunks) {
+    memory_block_ptr m = make_zeroinit_memory_block(16);
+    memory_block_pod_allocator_api *api = get_memory_block_pod_allocator_api(m.get());
+    char *begin, *end;
+    api->allocate(m.get(), 10, 1, &begin, &end);
+    memset(begin, 3, 10);
+    api->resize(m.get(), 5000, &begin, &end);
+    EXPECT_EQ(3, begin[9]);
+    for (int i = 10; i < 5000; ++i) {
+        ASSERT_EQ(0, begin[i]);
+    }
+}
+
+TEST(MemoryBlock, ObjectArrayResizeAcrossChunks) {
+    memory_chunk_pool_stats before = get_memory_chunk_pool_stats();
+    {
+        memory_block_ptr m = make_objectarray_memory_block(ndt::make_type(), NULL,
+                        sizeof(type_type_data), 1);
+        memory_block_objectarray_allocator_api *api =
+                        get_memory_block_objectarray_allocator_api(m.get());
+        type_type_data *data = reinterpret_cast<type_type_data *>(api->allocate(m.get(), 2));
+        data[0].tp = ndt::make_type<int32_t>().release();
+        data[1].tp = ndt::make_type<double>().release();
+        // Growing past the first chunk moves every element to a new chunk
+        data = reinterpret_cast<type_type_data *>(
+                        api->resize(m.get(), reinterpret_cast<char *>(data), 1000));
+        EXPECT_EQ(ndt::make_type<int32_t>().extended(), data[0].tp);
+        EXPECT_EQ(ndt::make_type<double>().extended(), data[1].tp);
+        for (int i = 2; i < 1000; ++i) {
+            ASSERT_EQ(NULL, data[i].tp);
+        }
+    }
+    EXPECT_EQ(before.bytes_in_flight, get_memory_chunk_pool_stats().bytes_in_flight);
+}
@@ -0,0 +1,152 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include "inc_gtest.hpp"
+
+#include <dynd/option_bitmap.hpp>
+#include <dynd/array.hpp>
+#include <dynd/array_range.hpp>
+#include <dynd/json_parser.hpp>
+#include <dynd/json_formatter.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(OptionBitmap, WordHelpers) {
+    uint64_t bits[3] = {0, 0, 0};
+    EXPECT_EQ(0, validity_bitmap_word_count(0));
+    EXPECT_EQ(1, validity_bitmap_word_count(64));
+    EXPECT_EQ(3, validity_bitmap_word_count(129));
+    validity_bitmap_set(bits, 0, true);
+    validity_bitmap_set(bits, 63, true);
+    validity_bitmap_set(bits, 64, true);
+    validity_bitmap_set(bits, 130, true);
+    EXPECT_TRUE(validity_bitmap_get(bits, 63));
+    EXPECT_FALSE(validity_bitmap_get(bits, 62));
+    EXPECT_EQ(4, validity_bitmap_count(bits, 192));
+    // Bits past the size aren't counted
+    EXPECT_EQ(3, validity_bitmap_count(bits, 130));
+    validity_bitmap_set(bits, 63, false);
+    EXPECT_EQ(2, validity_bitmap_count(bits, 130));
+}
+
+TEST(OptionBitmap, FromOption) {
+    nd::array a = parse_json("5 * ?int32", "[1, null, 3, null, 5]");
+    nd::array b = nd::validity_bitmap(a);
+    EXPECT_EQ(ndt::type("1 * uint64"), b.get_type());
+    EXPECT_EQ(0x15u, b(0).as<uint64_t>());
+
+    a = parse_json("3 * ?string", "[null, \"x\", \"\"]");
+    EXPECT_EQ(0x6u, nd::validity_bitmap(a)(0).as<uint64_t>());
+
+    // Across several words, and through a strided view
+    a = nd::empty(200, ndt::type("?float64"));
+    for (intptr_t i = 0; i < 200; ++i) {
+        if (i % 7 == 0) {
+            a(i).vals() = parse_json("?float64", "null");
+        } else {
+            a(i).vals() = (double)i;
+        }
+    }
+    b = nd::validity_bitmap(a);
+    ASSERT_EQ(4, b.get_dim_size());
+    const uint64_t *bits =
+        reinterpret_cast<const uint64_t *>(b.get_readonly_originptr());
+    for (intptr_t i = 0; i < 200; ++i) {
+        EXPECT_EQ(i % 7 != 0, validity_bitmap_get(bits, i));
+    }
+    EXPECT_EQ(0u, bits[3] >> 8);
+    EXPECT_EQ(200 - 29, validity_bitmap_count(bits, 200));
+    b = nd::validity_bitmap(a(irange().by(3)));
+    bits = reinterpret_cast<const uint64_t *>(b.get_readonly_originptr());
+    for (intptr_t i = 0; i < 67; ++i) {
+        EXPECT_EQ((3 * i) % 7 != 0, validity_bitmap_get(bits, i));
+    }
+}
+
+TEST(OptionBitmap, ToOption) {
+    nd::array values = nd::range(150).ucast<int32_t>().eval();
+    nd::array bitmap = nd::empty(3, ndt::make_type<uint64_t>());
+    bitmap(0).vals() = ~(uint64_t)0;
+    bitmap(1).vals() = 0u;
+    bitmap(2).vals() = 0xf0f0u;
+    nd::array a = nd::option_from_bitmap(values, bitmap);
+    EXPECT_EQ(ndt::type("150 * ?int32"), a.get_type());
+    for (intptr_t i = 0; i < 150; ++i) {
+        bool avail = i < 64 || (i >= 128 && ((0xf0f0u >> (i - 128)) & 1));
+        if (avail) {
+            EXPECT_EQ(i, a(i).as<int32_t>());
+        } else {
+            EXPECT_EQ("null", string(format_json(a(i)).as<string>()));
+        }
+    }
+    // The round trip gives back the same bitmap
+    nd::array b = nd::validity_bitmap(a);
+    EXPECT_EQ(~(uint64_t)0, b(0).as<uint64_t>());
+    EXPECT_EQ(0u, b(1).as<uint64_t>());
+    EXPECT_EQ(0xf0f0u, b(2).as<uint64_t>());
+
+    // Strings, from option values with an NA under a set bit
+    values = parse_json("4 * ?string", "[\"a\", \"b\", null, \"d\"]");
+    bitmap = parse_json("1 * uint64", "[13]");
+    a = nd::option_from_bitmap(values, bitmap);
+    EXPECT_EQ(ndt::type("4 * ?string"), a.get_type());
+    EXPECT_EQ("[\"a\",null,null,\"d\"]", string(format_json(a).as<string>()));
+}
+
+TEST(OptionBitmap, MaskedSum) {
+    nd::array a = parse_json("6 * ?int16", "[1, null, 3, -4, null, 10]");
+    nd::array s = nd::masked_sum(a, nd::validity_bitmap(a));
+    EXPECT_EQ(ndt::make_type<int64_t>(), s.get_type());
+    EXPECT_EQ(10, s.as<int64_t>());
+
+    a = parse_json("4 * ?float32", "[0.5, null, 1.5, 2]");
+    s = nd::masked_sum(a, nd::validity_bitmap(a));
+    EXPECT_EQ(ndt::make_type<double>(), s.get_type());
+    EXPECT_EQ(4.0, s.as<double>());
+
+    // Full, empty and mixed words, contiguous and strided
+    nd::array values = nd::range(300).ucast<uint32_t>().eval();
+    nd::array bitmap = nd::empty(5, ndt::make_type<uint64_t>());
+    bitmap(0).vals() = ~(uint64_t)0;
+    bitmap(1).vals() = 0u;
+    bitmap(2).vals() = 0x8000000000000001ULL;
+    bitmap(3).vals() = ~(uint64_t)0 ^ 4u;
+    bitmap(4).vals() = ~(uint64_t)0;
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < 300; ++i) {
+        if (i < 64 || i == 128 || i == 191 || (i >= 192 && i != 194)) {
+            expected += i;
+        }
+    }
+    s = nd::masked_sum(values, bitmap);
+    EXPECT_EQ(ndt::make_type<uint64_t>(), s.get_type());
+    EXPECT_EQ(expected, s.as<uint64_t>());
+    expected = 0;
+    for (uint64_t i = 0; i < 150; ++i) {
+        if (i < 64 || i == 128) {
+            expected += 2 * i;
+        }
+    }
+    EXPECT_EQ(expected, nd::masked_sum(values(irange().by(2)), bitmap)
+                            .as<uint64_t>());
+}
+
+TEST(OptionBitmap, Errors) {
+    EXPECT_THROW(nd::validity_bitmap(parse_json("2 * int32", "[1, 2]")),
+                 type_error);
+    EXPECT_THROW(nd::validity_bitmap(parse_json("1 * 1 * ?int32", "[[1]]")),
+                 type_error);
+    nd::array values = nd::range(65).ucast<int32_t>().eval();
+    EXPECT_THROW(nd::masked_sum(values, parse_json("1 * uint64", "[1]")),
+                 runtime_error);
+    EXPECT_THROW(nd::masked_sum(values, parse_json("2 * int64", "[1, 1]")),
+                 type_error);
+    EXPECT_THROW(nd::masked_sum(parse_json("1 * string", "[\"\"]"),
+                                parse_json("1 * uint64", "[1]")),
+                 type_error);
+}
@@ -0,0 +1,165 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include "inc_gtest.hpp"
+
+#include <dynd/random.hpp>
+#include <dynd/array.hpp>
+#include <dynd/json_parser.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(Random, PhiloxKnownAnswers) {
+    // Known answer vectors from the Random123 distribution
+    uint32_t out[4];
+    uint32_t ctr0[4] = {0, 0, 0, 0}, key0[2] = {0, 0};
+    detail::philox4x32_10(ctr0, key0, out);
+    EXPECT_EQ(0x6627e8d5u, out[0]);
+    EXPECT_EQ(0xe169c58du, out[1]);
+    EXPECT_EQ(0xbc57ac4cu, out[2]);
+    EXPECT_EQ(0x9b00dbd8u, out[3]);
+
+    uint32_t ctr1[4] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu};
+    uint32_t key1[2] = {0xffffffffu, 0xffffffffu};
+    detail::philox4x32_10(ctr1, key1, out);
+    EXPECT_EQ(0x408f276du, out[0]);
+    EXPECT_EQ(0x41c83b0eu, out[1]);
+    EXPECT_EQ(0xa20bc7c6u, out[2]);
+    EXPECT_EQ(0x6d5451fdu, out[3]);
+
+    uint32_t ctr2[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u};
+    uint32_t key2[2] = {0xa4093822u, 0x299f31d0u};
+    detail::philox4x32_10(ctr2, key2, out);
+    EXPECT_EQ(0xd16cfe09u, out[0]);
+    EXPECT_EQ(0x94fdccebu, out[1]);
+    EXPECT_EQ(0x5001e420u, out[2]);
+    EXPECT_EQ(0x24126ea1u, out[3]);
+}
+
+TEST(Random, RandSeeded) {
+    nd::array a = nd::rand(ndt::make_fixed_dim(1000, ndt::make_type<double>()), 7);
+    nd::array b = nd::rand(ndt::make_fixed_dim(1000, ndt::make_type<double>()), 7);
+    nd::array c = nd::rand(ndt::make_fixed_dim(1000, ndt::make_type<double>()), 7, 1);
+    int ndiff = 0;
+    for (int i = 0; i < 1000; ++i) {
+        double v = a(i).as<double>();
+        EXPECT_LE(0.0, v);
+        EXPECT_GT(1.0, v);
+        EXPECT_EQ(v, b(i).as<double>());
+        ndiff += v != c(i).as<double>();
+    }
+    EXPECT_EQ(1000, ndiff);
+
+    // Without a seed, every call gets different values
+    a = nd::rand(100, ndt::make_type<float>());
+    b = nd::rand(100, ndt::make_type<float>());
+    EXPECT_NE(a(0).as<float>(), b(0).as<float>());
+}
+
+TEST(Random, RandIndependentOfThreads) {
+    intptr_t nthreads = eval::default_eval_context.nthreads;
+    eval::default_eval_context.nthreads = 1;
+    nd::array a = nd::rand(ndt::type("300 * 301 * complex[float32]"), 3);
+    eval::default_eval_context.nthreads = 4;
+    nd::array b = nd::rand(ndt::type("300 * 301 * complex[float32]"), 3);
+    eval::default_eval_context.nthreads = nthreads;
+    EXPECT_EQ(0, memcmp(a.get_readonly_originptr(), b.get_readonly_originptr(),
+                    300 * 301 * sizeof(dynd_complex<float>)));
+}
+
+TEST(Random, UniformArrFunc) {
+    nd::arrfunc af = make_uniform_arrfunc(float64_type_id);
+    nd::array a = af(kwds("shape", 10000, "low", -2.0, "high", 3.0, "seed", 5));
+    EXPECT_EQ(ndt::type("10000 * float64"), a.get_type());
+    double sum = 0;
+    for (int i = 0; i < 10000; ++i) {
+        double v = a(i).as<double>();
+        EXPECT_LE(-2.0, v);
+        EXPECT_GT(3.0, v);
+        sum += v;
+    }
+    EXPECT_NEAR(0.5, sum / 10000, 0.05);
+
+    // Elements are numbered in C order, so the shape doesn't change them
+    nd::array shape = parse_json("2 * int", "[100, 100]");
+    nd::array b = af(kwds("shape", shape, "low", -2.0, "high", 3.0, "seed", 5));
+    EXPECT_EQ(ndt::type("100 * 100 * float64"), b.get_type());
+    EXPECT_EQ(a(257).as<double>(), b(2, 57).as<double>());
+
+    EXPECT_EQ(ndt::make_type<double>(), af().get_type());
+    EXPECT_THROW(af(kwds("mean", 1.0)), invalid_argument);
+    EXPECT_THROW(make_uniform_arrfunc(int32_type_id), type_error);
+}
+
+TEST(Random, UniformBelowHigh) {
+    // Across a single float spacing, half of low + (high - low) * u
+    // rounds to high, which is excluded from the range
+    nd::arrfunc af = make_uniform_arrfunc(float32_type_id);
+    nd::array a = af(kwds("shape", 1000, "low", 16777216.0,
+                          "high", 16777218.0, "seed", 5));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(16777216.0f, a(i).as<float>());
+    }
+    af = make_uniform_arrfunc(float64_type_id);
+    a = af(kwds("shape", 1000, "low", 9007199254740992.0,
+                "high", 9007199254740994.0, "seed", 5));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(9007199254740992.0, a(i).as<double>());
+    }
+}
+
+TEST(Random, NormalArrFunc) {
+    nd::arrfunc af = make_normal_arrfunc(float64_type_id);
+    nd::array a = af(kwds("shape", 100000, "mean", 3.0, "stddev", 2.0,
+                          "seed", 11, "stream", 2));
+    double sum = 0, sumsq = 0;
+    for (int i = 0; i < 100000; ++i) {
+        double v = a(i).as<double>();
+        sum += v;
+        sumsq += v * v;
+    }
+    double mean = sum / 100000;
+    EXPECT_NEAR(3.0, mean, 0.05);
+    EXPECT_NEAR(2.0, sqrt(sumsq / 100000 - mean * mean), 0.05);
+
+    nd::array b = make_normal_arrfunc(float32_type_id)(kwds("shape", 10));
+    EXPECT_EQ(ndt::type("10 * float32"), b.get_type());
+}
+
+TEST(Random, RandIntArrFunc) {
+    nd::arrfunc af = make_randint_arrfunc(int32_type_id);
+    nd::array a = af(kwds("shape", 1000, "low", -3, "high", 3));
+    int counts[7] = {0, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 1000; ++i) {
+        int v = a(i).as<int>();
+        ASSERT_LE(-3, v);
+        ASSERT_GE(3, v);
+        ++counts[v + 3];
+    }
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_LT(0, counts[i]);
+    }
+
+    // The full range of a 64-bit type
+    a = make_randint_arrfunc(uint64_type_id)(kwds("shape", 100));
+    EXPECT_NE(a(0).as<uint64_t>(), a(1).as<uint64_t>());
+
+    a = make_randint_arrfunc(int8_type_id)(kwds("shape", 1000, "low", -128));
+    int8_t lo = 127, hi = -128;
+    for (int i = 0; i < 1000; ++i) {
+        lo = min(lo, a(i).as<int8_t>());
+        hi = max(hi, a(i).as<int8_t>());
+    }
+    EXPECT_EQ(-128, lo);
+    EXPECT_EQ(127, hi);
+
+    EXPECT_THROW(af(kwds("low", 3, "high", 2)), invalid_argument);
+    EXPECT_THROW(make_randint_arrfunc(int8_type_id)(kwds("high", 300)),
+                 overflow_error);
+}
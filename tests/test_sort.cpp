@@ -0,0 +1,182 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include "inc_gtest.hpp"
+
+#include <dynd/sort.hpp>
+#include <dynd/random.hpp>
+#include <dynd/array.hpp>
+#include <dynd/json_parser.hpp>
+
+using namespace std;
+using namespace dynd;
+
+TEST(Sort, Ints) {
+    nd::array a = parse_json("7 * int32", "[3, -1, 7, -100000, 0, 3, 2]");
+    nd::array b = nd::sort(a);
+    EXPECT_EQ(ndt::type("7 * int32"), b.get_type());
+    int32_t expected[7] = {-100000, -1, 0, 2, 3, 3, 7};
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_EQ(expected[i], b(i).as<int32_t>());
+    }
+    // The input is unchanged
+    EXPECT_EQ(3, a(0).as<int32_t>());
+
+    a = parse_json("5 * uint64", "[18446744073709551615, 0, 5, 1, 5]");
+    b = nd::sort(a);
+    EXPECT_EQ(0u, b(0).as<uint64_t>());
+    EXPECT_EQ(18446744073709551615ULL, b(4).as<uint64_t>());
+
+    a = parse_json("4 * bool", "[true, false, true, false]");
+    b = nd::sort(a);
+    EXPECT_FALSE(b(1).as<bool>());
+    EXPECT_TRUE(b(2).as<bool>());
+}
+
+TEST(Sort, LongInts) {
+    // Long enough to take the radix sort path
+    nd::array a = make_randint_arrfunc(int64_type_id)(
+        kwds("shape", 10000, "low", -1000000, "high", 1000000, "seed", 3));
+    nd::array b = nd::sort(a);
+    nd::array idx = nd::argsort(a);
+    EXPECT_EQ(ndt::type("10000 * intptr"), idx.get_type());
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(a(idx(i).as<intptr_t>()).as<int64_t>(), b(i).as<int64_t>());
+        if (i > 0) {
+            ASSERT_LE(b(i - 1).as<int64_t>(), b(i).as<int64_t>());
+            if (b(i - 1).as<int64_t>() == b(i).as<int64_t>()) {
+                ASSERT_LT(idx(i - 1).as<intptr_t>(), idx(i).as<intptr_t>());
+            }
+        }
+    }
+}
+
+TEST(Sort, Floats) {
+    nd::array a = nd::empty(6, ndt::make_type<double>());
+    double vals[6] = {2.5, -0.0, numeric_limits<double>::quiet_NaN(), -3.0,
+                      numeric_limits<double>::infinity(), 1e-300};
+    for (int i = 0; i < 6; ++i) {
+        a(i).vals() = vals[i];
+    }
+    nd::array b = nd::sort(a);
+    EXPECT_EQ(-3.0, b(0).as<double>());
+    EXPECT_EQ(0.0, b(1).as<double>());
+    EXPECT_TRUE(signbit(b(1).as<double>()));
+    EXPECT_EQ(1e-300, b(2).as<double>());
+    EXPECT_EQ(2.5, b(3).as<double>());
+    EXPECT_EQ(numeric_limits<double>::infinity(), b(4).as<double>());
+    EXPECT_TRUE(DYND_ISNAN(b(5).as<double>()));
+
+    nd::array idx = nd::argsort(a.ucast<float>().eval());
+    EXPECT_EQ(3, idx(0).as<intptr_t>());
+    EXPECT_EQ(2, idx(5).as<intptr_t>());
+}
+
+TEST(Sort, SignedZeros) {
+    // -0.0 and +0.0 compare equal, so a stable argsort keeps them in
+    // their original order, both below and above the radix sort threshold
+    const int sizes[2] = {10, 1000};
+    for (int k = 0; k < 2; ++k) {
+        int n = sizes[k];
+        nd::array a = nd::empty(n, ndt::make_type<double>());
+        for (int i = 0; i < n; ++i) {
+            a(i).vals() = (i % 3 == 0) ? 1.0 : ((i % 3 == 1) ? -0.0 : 0.0);
+        }
+        nd::array idx = nd::argsort(a);
+        nd::array b = nd::sort(a);
+        int nzeros = n - (n + 2) / 3;
+        int j = 0;
+        for (int i = 0; i < n; ++i) {
+            if (i % 3 != 0) {
+                EXPECT_EQ(i, idx(j).as<intptr_t>());
+                // The sorted values keep their signs
+                EXPECT_EQ(i % 3 == 1, (bool)signbit(b(j).as<double>()));
+                ++j;
+            }
+        }
+        EXPECT_EQ(nzeros, j);
+        EXPECT_EQ(1.0, b(n - 1).as<double>());
+    }
+}
+
+TEST(Sort, Strings) {
+    nd::array a = parse_json("6 * string",
+        "[\"prefix_shared_b\", \"prefix_shared_a\", \"x\", \"\", "
+        "\"prefix_shared\", \"prefix_shared_a\"]");
+    nd::array b = nd::sort(a);
+    EXPECT_EQ("", b(0).as<string>());
+    EXPECT_EQ("prefix_shared", b(1).as<string>());
+    EXPECT_EQ("prefix_shared_a", b(2).as<string>());
+    EXPECT_EQ("prefix_shared_a", b(3).as<string>());
+    EXPECT_EQ("prefix_shared_b", b(4).as<string>());
+    EXPECT_EQ("x", b(5).as<string>());
+
+    nd::array idx = nd::argsort(a);
+    EXPECT_EQ(1, idx(2).as<intptr_t>());
+    EXPECT_EQ(5, idx(3).as<intptr_t>());
+
+    // Fixed-size strings use the comparison sort
+    b = nd::sort(a.ucast(ndt::type("string[16]")).eval());
+    EXPECT_EQ(ndt::type("6 * string[16]"), b.get_type());
+    EXPECT_EQ("prefix_shared", b(1).as<string>());
+    EXPECT_EQ("x", b(5).as<string>());
+}
+
+TEST(Sort, Struct) {
+    nd::array a = parse_json("4 * {x: int32, y: string}",
+        "[[2, \"a\"], [1, \"z\"], [2, \"A\"], [1, \"b\"]]");
+    nd::array idx = nd::argsort(a);
+    EXPECT_EQ(3, idx(0).as<intptr_t>());
+    EXPECT_EQ(1, idx(1).as<intptr_t>());
+    EXPECT_EQ(2, idx(2).as<intptr_t>());
+    EXPECT_EQ(0, idx(3).as<intptr_t>());
+    nd::array b = nd::sort(a);
+    EXPECT_EQ(ndt::type("4 * {x: int32, y: string}"), b.get_type());
+    EXPECT_EQ("b", b(0, 1).as<string>());
+    EXPECT_EQ("A", b(2, 1).as<string>());
+}
+
+TEST(Sort, MultiDim) {
+    nd::array a = parse_json("2 * 3 * int16", "[[3, 1, 2], [-1, -3, -2]]");
+    nd::array b = nd::sort(a);
+    EXPECT_EQ(ndt::type("2 * 3 * int16"), b.get_type());
+    EXPECT_EQ(1, b(0, 0).as<int16_t>());
+    EXPECT_EQ(3, b(0, 2).as<int16_t>());
+    EXPECT_EQ(-3, b(1, 0).as<int16_t>());
+    EXPECT_EQ(-1, b(1, 2).as<int16_t>());
+
+    nd::array idx = nd::argsort(a);
+    EXPECT_EQ(ndt::type("2 * 3 * intptr"), idx.get_type());
+    EXPECT_EQ(1, idx(0, 0).as<intptr_t>());
+    EXPECT_EQ(0, idx(1, 2).as<intptr_t>());
+
+    EXPECT_THROW(nd::sort(nd::array(1)), invalid_argument);
+}
+
+TEST(Sort, ParallelMatchesSerial) {
+    intptr_t nthreads = eval::default_eval_context.nthreads;
+    nd::array a = nd::rand(ndt::make_fixed_dim((1 << 20) + 77,
+                                               ndt::make_type<float>()), 9);
+    eval::default_eval_context.nthreads = 1;
+    nd::array b = nd::sort(a);
+    nd::array idx_b = nd::argsort(a);
+    eval::default_eval_context.nthreads = 3;
+    nd::array c = nd::sort(a);
+    nd::array idx_c = nd::argsort(a);
+    eval::default_eval_context.nthreads = nthreads;
+    EXPECT_EQ(0, memcmp(b.get_readonly_originptr(), c.get_readonly_originptr(),
+                        ((1 << 20) + 77) * sizeof(float)));
+    EXPECT_EQ(0, memcmp(idx_b.get_readonly_originptr(),
+                        idx_c.get_readonly_originptr(),
+                        ((1 << 20) + 77) * sizeof(intptr_t)));
+    const float *data = reinterpret_cast<const float *>(b.get_readonly_originptr());
+    for (int i = 1; i < (1 << 20) + 77; ++i) {
+        ASSERT_LE(data[i - 1], data[i]);
+    }
+}
+
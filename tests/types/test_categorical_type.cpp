@@ -14,6 +14,7 @@
 #include <dynd/types/string_type.hpp>
 #include <dynd/types/convert_type.hpp>
 #include <dynd/array_range.hpp>
+#include <dynd/json_parser.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -322,3 +323,52 @@ TEST(CategoricalDType, AssignFromOther) {
     EXPECT_EQ(3, a(5).as<int>());
 }
 
+
+TEST(CategoricalDType, AssignStrided) {
+    // Enough values that the strided kernels see several blocks
+    nd::array cats = (nd::range(300) * 7).eval();
+    ndt::type dt = ndt::make_categorical(cats);
+    EXPECT_EQ(ndt::make_type<uint16_t>(), dt.p("storage_type").as<ndt::type>());
+
+    nd::array vals = nd::empty(1000, ndt::make_type<int32_t>());
+    for (int i = 0; i < 1000; ++i) {
+        vals(i).vals() = ((i * 37) % 300) * 7;
+    }
+    nd::array a = nd::empty(1000, dt);
+    a.vals() = vals;
+    nd::array ints = a.p("ints");
+    nd::array back = nd::empty(1000, ndt::make_type<int32_t>());
+    back.vals() = a;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ((i * 37) % 300, ints(i).as<int>());
+        EXPECT_EQ(vals(i).as<int>(), back(i).as<int>());
+    }
+
+    // A non-contiguous gather
+    nd::array back2 = nd::empty(500, ndt::make_type<int32_t>());
+    back2.vals() = a(irange().by(2));
+    EXPECT_EQ(vals(998).as<int>(), back2(499).as<int>());
+
+    // An unrecognized value anywhere in the block raises an error
+    vals(700).vals() = 1;
+    EXPECT_THROW(a.vals() = vals, std::runtime_error);
+}
+
+TEST(CategoricalDType, OptionCategories) {
+    // Option categories are hashed, so they don't need to be sortable
+    nd::array cats = parse_json("3 * ?string", "[\"b\", null, \"a\"]");
+    ndt::type dt = ndt::make_categorical(cats);
+    EXPECT_EQ(ndt::type("3 * ?string"), dt.p("categories").get_type());
+
+    nd::array a = nd::empty(4, dt);
+    a.vals() = parse_json("4 * ?string", "[\"a\", \"b\", null, \"a\"]");
+    nd::array ints = a.p("ints");
+    EXPECT_EQ(2, ints(0).as<int>());
+    EXPECT_EQ(0, ints(1).as<int>());
+    EXPECT_EQ(1, ints(2).as<int>());
+    EXPECT_EQ(2, ints(3).as<int>());
+
+    EXPECT_THROW(ndt::make_categorical(
+                     parse_json("2 * ?string", "[\"b\", \"b\"]")),
+                 std::runtime_error);
+}
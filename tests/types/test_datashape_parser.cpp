@@ -24,6 +24,7 @@
 #include <dynd/types/json_type.hpp>
 #include <dynd/types/option_type.hpp>
 #include <dynd/types/type_alignment.hpp>
+#include <dynd/types/type_intern.hpp>
 #include <dynd/func/callable.hpp>
 
 using namespace std;
@@ -1101,3 +1102,34 @@ TEST(DataShapeParser, SpecialCharacterFields)
                 string::npos);
   }
 }
+
+TEST(DataShapeParser, ParseCache)
+{
+  datashape_cache_stats before = get_datashape_cache_stats();
+  ndt::type a("3 * {x: int32, y: var * string}");
+  ndt::type b("3 * {x: int32, y: var * string}");
+  datashape_cache_stats after = get_datashape_cache_stats();
+  EXPECT_EQ(before.hits + 1, after.hits);
+  // Parsing the same text again gives the same type object
+  EXPECT_EQ(a.extended(), b.extended());
+
+  // Different text for an equal type still gets the interned instance
+  ndt::type c("3 * {x: int, y: var * string}");
+  EXPECT_EQ(a.extended(), c.extended());
+  EXPECT_EQ(a.extended(),
+            ndt::intern(ndt::make_fixed_dim(
+                            3, ndt::make_struct(
+                                   ndt::make_type<int32_t>(), "x",
+                                   ndt::make_var_dim(ndt::make_string()), "y")))
+                .extended());
+  EXPECT_NE(a.extended(), ndt::type("3 * {x: int64, y: var * string}").extended());
+
+  // Errors are not cached
+  EXPECT_THROW(ndt::type("3 * {x: int32"), runtime_error);
+  EXPECT_THROW(ndt::type("3 * {x: int32"), runtime_error);
+
+  clear_datashape_cache();
+  EXPECT_EQ(0, get_datashape_cache_stats().size);
+  EXPECT_EQ(a.extended(),
+            ndt::type("3 * {x: int32, y: var * string}").extended());
+}
@@ -134,6 +134,23 @@ TEST(DateType, BadInputStrings) {
     EXPECT_THROW(nd::array("1980-02-03 q").ucast(d).eval(), invalid_argument);
 }
 
+TEST(DateType, StringColumn) {
+    ndt::type d = ndt::make_date(), di = ndt::make_type<int32_t>();
+
+    // The first value sets the layout, the others fall back to the
+    // general parser
+    const char *strs[] = {"1979-03-22", "NA", "1979-3-22", "March 22, 1979"};
+    nd::array b = nd::array(strs).ucast(d).eval().view_scalars(di);
+    EXPECT_EQ(3367, b(0).as<int32_t>());
+    EXPECT_EQ(DYND_DATE_NA, b(1).as<int32_t>());
+    EXPECT_EQ(3367, b(2).as<int32_t>());
+    EXPECT_EQ(3367, b(3).as<int32_t>());
+
+    // An invalid date in the layout of the column is an error
+    const char *invalid[] = {"1979-03-22", "1980-02-30"};
+    EXPECT_THROW(nd::array(invalid).ucast(d).eval(), invalid_argument);
+}
+
 TEST(DateType, DateProperties) {
     ndt::type d = ndt::make_date();
     nd::array a;
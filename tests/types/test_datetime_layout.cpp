@@ -0,0 +1,289 @@
+//
+// Copyright (C) 2011-14 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <string>
+
+#include "inc_gtest.hpp"
+
+#include <dynd/array.hpp>
+#include <dynd/types/datetime_layout.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/fixedstring_type.hpp>
+
+using namespace std;
+using namespace dynd;
+
+static bool detect_date(datetime_layout &layout, const char *s)
+{
+  return layout.detect_date(s, s + strlen(s));
+}
+
+static bool detect_time(datetime_layout &layout, const char *s)
+{
+  return layout.detect_time(s, s + strlen(s));
+}
+
+static bool detect_datetime(datetime_layout &layout, const char *s)
+{
+  return layout.detect_datetime(s, s + strlen(s));
+}
+
+TEST(DatetimeLayout, DetectDate)
+{
+  datetime_layout layout;
+  EXPECT_TRUE(layout.empty());
+  EXPECT_TRUE(detect_date(layout, "1979-03-22"));
+  EXPECT_EQ(10, layout.length);
+  EXPECT_EQ(-1, layout.time_offset);
+
+  // Anything other than YYYY-MM-DD has no fixed layout
+  const char *no_layout[] = {"1979-3-22", "+001979-03-22", " 1979-03-22",
+                             "1979/03/22", "1979-03-22T", "March 22, 1979",
+                             ""};
+  for (size_t i = 0; i < sizeof(no_layout) / sizeof(no_layout[0]); ++i) {
+    EXPECT_FALSE(detect_date(layout, no_layout[i])) << no_layout[i];
+    EXPECT_TRUE(layout.empty()) << no_layout[i];
+  }
+}
+
+TEST(DatetimeLayout, DetectTime)
+{
+  datetime_layout layout;
+  EXPECT_TRUE(detect_time(layout, "12:34"));
+  EXPECT_EQ(0, layout.time_offset);
+  EXPECT_EQ(-1, layout.second_offset);
+  EXPECT_EQ(0, layout.fraction_digits);
+
+  EXPECT_TRUE(detect_time(layout, "12:34:56"));
+  EXPECT_EQ(6, layout.second_offset);
+  EXPECT_EQ(0, layout.fraction_digits);
+
+  EXPECT_TRUE(detect_time(layout, "12:34:56.789Z"));
+  EXPECT_EQ(9, layout.fraction_offset);
+  EXPECT_EQ(3, layout.fraction_digits);
+  EXPECT_EQ(13, layout.length);
+
+  EXPECT_FALSE(detect_time(layout, "1:02:03"));
+  EXPECT_FALSE(detect_time(layout, "12:34:56."));
+  EXPECT_FALSE(detect_time(layout, "12:34:56.789 pm"));
+  EXPECT_TRUE(layout.empty());
+}
+
+TEST(DatetimeLayout, DetectDatetime)
+{
+  datetime_layout layout;
+  EXPECT_TRUE(detect_datetime(layout, "2014-03-22"));
+  EXPECT_EQ(-1, layout.time_offset);
+  EXPECT_TRUE(detect_datetime(layout, "2014-03-22T15:10"));
+  EXPECT_EQ(11, layout.time_offset);
+  EXPECT_TRUE(detect_datetime(layout, "2014-03-22 15:10:11.25Z"));
+  EXPECT_EQ(17, layout.second_offset);
+  EXPECT_EQ(2, layout.fraction_digits);
+
+  EXPECT_FALSE(detect_datetime(layout, "2014-03-22t15:10"));
+  EXPECT_FALSE(detect_datetime(layout, "2014-03-22T"));
+  EXPECT_TRUE(layout.empty());
+}
+
+TEST(DatetimeLayout, ParseDate)
+{
+  datetime_layout layout;
+  date_ymd ymd;
+  const char *s = "1979-03-22";
+  // An empty layout matches nothing
+  EXPECT_FALSE(layout.parse_date(s, s + 10, ymd));
+
+  ASSERT_TRUE(detect_date(layout, s));
+  s = "2000-02-29";
+  ASSERT_TRUE(layout.parse_date(s, s + 10, ymd));
+  EXPECT_EQ(2000, ymd.year);
+  EXPECT_EQ(2, ymd.month);
+  EXPECT_EQ(29, ymd.day);
+
+  // Strings which don't match the layout, or don't hold a valid date
+  const char *no_match[] = {"1980-02-30", "1979-13-01", "1979/03/22",
+                            "1979-03-2x", "1979-03-2/", "1979-03-2:",
+                            "1979-3-22", "1979-03-222"};
+  for (size_t i = 0; i < sizeof(no_match) / sizeof(no_match[0]); ++i) {
+    s = no_match[i];
+    EXPECT_FALSE(layout.parse_date(s, s + strlen(s), ymd)) << s;
+  }
+  // A byte with the high bit set isn't a digit
+  s = "1979-03-2\xb2";
+  EXPECT_FALSE(layout.parse_date(s, s + 10, ymd));
+}
+
+TEST(DatetimeLayout, ParseTime)
+{
+  datetime_layout layout;
+  time_hmst hmst;
+  ASSERT_TRUE(detect_time(layout, "12:34:56.789012345"));
+  const char *s = "23:59:59.123456789";
+  ASSERT_TRUE(layout.parse_time(s, s + 18, hmst));
+  EXPECT_EQ(23, hmst.hour);
+  EXPECT_EQ(59, hmst.minute);
+  EXPECT_EQ(59, hmst.second);
+  // Fractional digits past the 7 of a tick are truncated
+  EXPECT_EQ(1234567, hmst.tick);
+
+  s = "24:00:00.000000000";
+  EXPECT_FALSE(layout.parse_time(s, s + 18, hmst));
+  s = "12:60:00.000000000";
+  EXPECT_FALSE(layout.parse_time(s, s + 18, hmst));
+
+  ASSERT_TRUE(detect_time(layout, "12:34"));
+  s = "01:02";
+  ASSERT_TRUE(layout.parse_time(s, s + 5, hmst));
+  EXPECT_EQ(1, hmst.hour);
+  EXPECT_EQ(2, hmst.minute);
+  EXPECT_EQ(0, hmst.second);
+  EXPECT_EQ(0, hmst.tick);
+}
+
+TEST(DatetimeLayout, ParseDatetime)
+{
+  datetime_layout layout;
+  datetime_struct dt;
+  ASSERT_TRUE(detect_datetime(layout, "2014-03-22T15:10:11.250Z"));
+  const char *s = "1999-12-31T23:59:59.999Z";
+  ASSERT_TRUE(layout.parse_datetime(s, s + strlen(s), dt));
+  EXPECT_EQ(1999, dt.ymd.year);
+  EXPECT_EQ(12, dt.ymd.month);
+  EXPECT_EQ(31, dt.ymd.day);
+  EXPECT_EQ(23, dt.hmst.hour);
+  EXPECT_EQ(59, dt.hmst.minute);
+  EXPECT_EQ(59, dt.hmst.second);
+  EXPECT_EQ(9990000, dt.hmst.tick);
+
+  // The "Z" is part of the layout
+  s = "1999-12-31T23:59:59.9990";
+  EXPECT_FALSE(layout.parse_datetime(s, s + strlen(s), dt));
+  s = "1999-02-30T23:59:59.999Z";
+  EXPECT_FALSE(layout.parse_datetime(s, s + strlen(s), dt));
+  s = "1999-12-31T25:59:59.999Z";
+  EXPECT_FALSE(layout.parse_datetime(s, s + strlen(s), dt));
+
+  // A date-only layout gives midnight
+  ASSERT_TRUE(detect_datetime(layout, "2014-03-22"));
+  s = "2014-03-23";
+  ASSERT_TRUE(layout.parse_datetime(s, s + 10, dt));
+  EXPECT_EQ(23, dt.ymd.day);
+  EXPECT_EQ(0, dt.hmst.hour);
+  EXPECT_EQ(0, dt.hmst.tick);
+}
+
+TEST(DatetimeLayout, MaxLength)
+{
+  datetime_layout layout;
+  datetime_struct dt;
+  time_hmst hmst;
+
+  // 32 chars is the longest layout, and its last char is still checked
+  string s = "2014-03-22T15:10:11.";
+  s.append(32 - s.size(), '1');
+  ASSERT_EQ((size_t)datetime_layout::max_length, s.size());
+  ASSERT_TRUE(layout.detect_datetime(s.data(), s.data() + s.size()));
+  EXPECT_EQ(12, layout.fraction_digits);
+  EXPECT_TRUE(layout.parse_datetime(s.data(), s.data() + s.size(), dt));
+  EXPECT_EQ(1111111, dt.hmst.tick);
+  s[31] = 'x';
+  EXPECT_FALSE(layout.parse_datetime(s.data(), s.data() + s.size(), dt));
+  s[31] = '1';
+  s += '1';
+  EXPECT_FALSE(layout.parse_datetime(s.data(), s.data() + s.size(), dt));
+  EXPECT_FALSE(layout.detect_datetime(s.data(), s.data() + s.size()));
+  EXPECT_TRUE(layout.empty());
+
+  s = "12:34:56.";
+  s.append(32 - s.size(), '9');
+  ASSERT_TRUE(layout.detect_time(s.data(), s.data() + s.size()));
+  EXPECT_TRUE(layout.parse_time(s.data(), s.data() + s.size(), hmst));
+  EXPECT_EQ(9999999, hmst.tick);
+  s += '9';
+  EXPECT_FALSE(layout.detect_time(s.data(), s.data() + s.size()));
+}
+
+TEST(DatetimeStringSource, UTF8InPlace)
+{
+  nd::array a = nd::empty(ndt::make_string());
+  a.vals() = "2014-03-22";
+  datetime_string_source src;
+  src.init(a.get_type(), a.get_arrmeta(), assign_error_default,
+           datetime_string_source::date_kind);
+  EXPECT_TRUE(src.utf8);
+  EXPECT_TRUE(src.layout.empty());
+
+  const char *begin, *end;
+  string buf;
+  EXPECT_FALSE(src.get_range(a.get_readonly_originptr(), begin, end, buf));
+  EXPECT_EQ("2014-03-22", string(begin, end));
+  // The string was read in place
+  EXPECT_TRUE(buf.empty());
+
+  src.detect(begin, end);
+  EXPECT_FALSE(src.layout.empty());
+  date_ymd ymd;
+  EXPECT_TRUE(src.layout.parse_date(begin, end, ymd));
+  EXPECT_EQ(22, ymd.day);
+}
+
+TEST(DatetimeStringSource, ConvertedToUTF8)
+{
+  // A UTF-16 string is converted into the buffer before it's parsed
+  nd::array a = nd::empty(ndt::make_string(string_encoding_utf_16));
+  a.vals() = "2014-03-22";
+  datetime_string_source src;
+  src.init(a.get_type(), a.get_arrmeta(), assign_error_default,
+           datetime_string_source::date_kind);
+  EXPECT_FALSE(src.utf8);
+
+  const char *begin, *end;
+  string buf;
+  EXPECT_FALSE(src.get_range(a.get_readonly_originptr(), begin, end, buf));
+  EXPECT_EQ(buf.data(), begin);
+  EXPECT_EQ("2014-03-22", string(begin, end));
+  src.detect(begin, end);
+  date_ymd ymd;
+  EXPECT_TRUE(src.layout.parse_date(begin, end, ymd));
+
+  // A non-ASCII string comes out as UTF-8, and doesn't match the layout
+  a = nd::empty(ndt::make_string(string_encoding_utf_16));
+  a.vals() = "2014-03-2\xc3\xa9";
+  EXPECT_FALSE(src.get_range(a.get_readonly_originptr(), begin, end, buf));
+  EXPECT_EQ("2014-03-2\xc3\xa9", string(begin, end));
+  EXPECT_FALSE(src.layout.parse_date(begin, end, ymd));
+
+  a = nd::empty(ndt::make_fixedstring(2, string_encoding_utf_32));
+  a.vals() = "NA";
+  src.init(a.get_type(), a.get_arrmeta(), assign_error_default,
+           datetime_string_source::date_kind);
+  EXPECT_FALSE(src.utf8);
+  EXPECT_TRUE(src.get_range(a.get_readonly_originptr(), begin, end, buf));
+}
+
+TEST(DatetimeStringSource, DetectGivesUp)
+{
+  nd::array a = nd::empty(ndt::make_string());
+  datetime_string_source src;
+  src.init(a.get_type(), a.get_arrmeta(), assign_error_default,
+           datetime_string_source::time_kind);
+  const char *s = "12:34 pm";
+  for (int i = 0; i < datetime_layout::max_detect_count; ++i) {
+    src.detect(s, s + strlen(s));
+  }
+  EXPECT_TRUE(src.layout.empty());
+  // Once it has given up, a string with a layout isn't tried
+  s = "12:34";
+  src.detect(s, s + strlen(s));
+  EXPECT_TRUE(src.layout.empty());
+
+  src.init(a.get_type(), a.get_arrmeta(), assign_error_default,
+           datetime_string_source::time_kind);
+  src.detect(s, s + strlen(s));
+  EXPECT_FALSE(src.layout.empty());
+}
@@ -138,6 +138,25 @@ TEST(DatetimeType, ConvertToString) {
                     nd::array("2013-02-16T12:13:19.0123456Z").cast(ndt::type("datetime[tz='UTC']")).as<string>());
 }
 
+TEST(DatetimeType, StringColumn) {
+    ndt::type d = ndt::make_datetime(tz_abstract), di = ndt::make_type<int64_t>();
+
+    // The first value sets the layout, the others fall back to the
+    // general parser
+    const char *strs[] = {"2014-03-22T15:10:11.250", "NA",
+                          "2014-03-22 15:10:11.25Z", "2014-03-22"};
+    nd::array b = nd::array(strs).ucast(d).eval().view_scalars(di);
+    EXPECT_EQ(13955010112500000LL, b(0).as<int64_t>());
+    EXPECT_EQ(DYND_DATETIME_NA, b(1).as<int64_t>());
+    EXPECT_EQ(13955010112500000LL, b(2).as<int64_t>());
+    EXPECT_EQ(13954464000000000LL, b(3).as<int64_t>());
+
+    // An invalid time in the layout of the column is an error
+    const char *invalid[] = {"2014-03-22T15:10:11.250",
+                             "2014-03-22T25:10:11.250"};
+    EXPECT_THROW(nd::array(invalid).ucast(d).eval(), invalid_argument);
+}
+
 TEST(DatetimeType, AbstractTZToUTC) {
     // Assigning from an abstract/naive timezone to UTC is allowed, the datetime
     // value adopts the destination time zone.
@@ -189,3 +189,29 @@ TEST(OptionType, String) {
   a.vals_at(1) = "NA";
   EXPECT_EQ("NA", a(1).as<string>());
 }
+
+TEST(OptionType, AssignOptionStringToOptionString) {
+  // NA values carry over, instead of being parsed as strings
+  nd::array a = parse_json("3 * ?string", "[\"x\", null, \"y\"]");
+  nd::array b = nd::empty("3 * ?string");
+  b.vals() = a;
+  EXPECT_EQ("x", b(0).as<string>());
+  EXPECT_FALSE(nd::is_scalar_avail(b(1)));
+  EXPECT_EQ("y", b(2).as<string>());
+
+  // Scalars, both available and NA
+  nd::array c = nd::empty("?string");
+  c.vals() = a(0);
+  EXPECT_EQ("x", c.as<string>());
+  c = nd::empty("?string");
+  c.vals() = a(1);
+  EXPECT_FALSE(nd::is_scalar_avail(c));
+
+  // A string which looks like NA in the source stays a string
+  a = parse_json("2 * ?string", "[\"NA\", null]");
+  b = nd::empty("2 * ?string");
+  b.vals() = a;
+  EXPECT_TRUE(nd::is_scalar_avail(b(0)));
+  EXPECT_EQ("NA", b(0).as<string>());
+  EXPECT_FALSE(nd::is_scalar_avail(b(1)));
+}
@@ -430,6 +430,101 @@ TEST(StringType, StringToFloat64SpecialValues) {
     EXPECT_EQ(0xfff0000000000000ULL, nd::array("-1.#INF").ucast<double>().view_scalars<uint64_t>().as<uint64_t>());
 }
 
+static uint64_t string_to_float64_bits(const char *str)
+{
+    return nd::array(str).ucast<double>().view_scalars<uint64_t>().as<uint64_t>();
+}
+
+static uint64_t strtod_bits(const char *str)
+{
+    double value = strtod(str, NULL);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+TEST(StringType, StringToFloat64MatchesStrtod) {
+    const char *values[] = {
+        "0", "-0", "0.0", "1", "-1", "0.1", "0.3", "1.5", "123456789",
+        "3.141592653589793", "2.718281828459045", "1e22", "1e23", "9007199254740993",
+        "1.7976931348623157e308", "1.7976931348623159e308", "1e308", "1e-300",
+        "2.2250738585072014e-308", "2.2250738585072011e-308", "4.9e-324",
+        "5e-324", "2e-324", "1e-400", "1e400", "-1e400", "0e999",
+        // Halfway between two doubles
+        "9007199254740993.0", "9007199254740995", "1.00000000000000011102230246251565404236316680908203125",
+        "7.3177701707893310e+15", "2.47032822920623272e-324",
+        // 19 and 20 significant digits
+        "1234567890123456789", "12345678901234567890", "0.00001234567890123456789",
+        "18446744073709551615", "18446744073709551616", "1.0000000000000000000000001",
+        "1.", "00000000000000000000000000001.5", "123.456e-7", "8.41e+21", "5E-20"};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        EXPECT_EQ(strtod_bits(values[i]), string_to_float64_bits(values[i])) << values[i];
+    }
+
+    // Round trip pseudo-random doubles in shortest and full precision
+    uint64_t state = 88172645463325252ULL;
+    char buf[64];
+    for (int i = 0; i < 20000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double value;
+        memcpy(&value, &state, sizeof(value));
+        if (value != value || value - value != 0) {
+            continue;
+        }
+        sprintf(buf, "%.17g", value);
+        ASSERT_EQ(strtod_bits(buf), string_to_float64_bits(buf)) << buf;
+        sprintf(buf, "%.*g", (int)(state % 17) + 1, value);
+        ASSERT_EQ(strtod_bits(buf), string_to_float64_bits(buf)) << buf;
+        sprintf(buf, "%.*f", (int)(state % 9), (double)(int64_t)(state >> 20) / 1000);
+        ASSERT_EQ(strtod_bits(buf), string_to_float64_bits(buf)) << buf;
+    }
+
+    EXPECT_THROW(nd::array("1.5x").ucast<double>().eval(), invalid_argument);
+    EXPECT_THROW(nd::array("1e").ucast<double>().eval(), invalid_argument);
+    EXPECT_THROW(nd::array("1e+").ucast<double>().eval(), invalid_argument);
+    EXPECT_THROW(nd::array("--1").ucast<double>().eval(), invalid_argument);
+    EXPECT_THROW(nd::array("1.2.3").ucast<double>().eval(), invalid_argument);
+}
+
+TEST(StringType, StringToNumberStrided) {
+    nd::array a = parse_json("5 * string",
+                    "[\"1.25\", \" -7 \", \"1e3\", \"42\", \"-0.5e-1\"]");
+    nd::array b = a.ucast<double>().eval();
+    EXPECT_EQ(1.25, b(0).as<double>());
+    EXPECT_EQ(-7, b(1).as<double>());
+    EXPECT_EQ(1000, b(2).as<double>());
+    EXPECT_EQ(42, b(3).as<double>());
+    EXPECT_EQ(-0.05, b(4).as<double>());
+
+    // A non-contiguous source
+    b = a(irange().by(2)).ucast<double>().eval();
+    ASSERT_EQ(3, b.get_dim_size());
+    EXPECT_EQ(1.25, b(0).as<double>());
+    EXPECT_EQ(1000, b(1).as<double>());
+    EXPECT_EQ(-0.05, b(2).as<double>());
+
+    a = parse_json("4 * string", "[\"2147483647\", \"-2147483648\", \" 0\", \"17 \"]");
+    b = a.ucast<int32_t>().eval();
+    EXPECT_EQ(2147483647, b(0).as<int32_t>());
+    EXPECT_EQ(-2147483647 - 1, b(1).as<int32_t>());
+    EXPECT_EQ(0, b(2).as<int32_t>());
+    EXPECT_EQ(17, b(3).as<int32_t>());
+
+    a = parse_json("3 * string", "[\"1\", \"2\", \"2147483648\"]");
+    EXPECT_THROW(a.ucast<int32_t>().eval(), overflow_error);
+    a = parse_json("3 * string", "[\"1\", \"x\", \"3\"]");
+    EXPECT_THROW(a.ucast<int32_t>().eval(), invalid_argument);
+
+    // Other encodings go through the single kernel
+    a = parse_json("3 * string['utf16']", "[\"1.5\", \"-2\", \"3e2\"]");
+    b = a.ucast<double>().eval();
+    EXPECT_EQ(1.5, b(0).as<double>());
+    EXPECT_EQ(-2, b(1).as<double>());
+    EXPECT_EQ(300, b(2).as<double>());
+}
+
 TEST(StringType, StringEncodeError) {
     nd::array a = parse_json("string", "\"\\uc548\\ub155\""), b;
     EXPECT_THROW(a.ucast(ndt::make_string(string_encoding_ascii)).eval(),
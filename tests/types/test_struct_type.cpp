@@ -237,6 +237,28 @@ TEST(StructType, DifferentTypeAssign) {
     EXPECT_EQ(8,    b(1,1).as<short>());
 }
 
+TEST(StructType, StridedAssign) {
+    // Enough elements for several chunks of the strided struct kernel,
+    // with fields which need conversion and a string
+    intptr_t n = 300;
+    nd::array a = nd::empty(2 * n, "{x: int32, s: string, y: {a: int16, b: float64}}");
+    for (intptr_t i = 0; i < 2 * n; ++i) {
+        a(i, 0).vals() = (int)i;
+        a(i, 1).vals() = string(i % 3, 'a' + i % 26);
+        a(i, 2, 0).vals() = (int)(i % 100);
+        a(i, 2, 1).vals() = i + 0.5;
+    }
+
+    nd::array b = nd::empty(n, "{y: {a: int64, b: float32}, x: float64, s: string}");
+    b.val_assign(a(irange().by(2)));
+    for (intptr_t i = 0; i < n; ++i) {
+        EXPECT_EQ(2 * i, b(i, 1).as<double>());
+        EXPECT_EQ(string((2 * i) % 3, 'a' + (2 * i) % 26), b(i, 2).as<string>());
+        EXPECT_EQ((2 * i) % 100, b(i, 0, 0).as<int64_t>());
+        EXPECT_EQ(2 * i + 0.5f, b(i, 0, 1).as<float>());
+    }
+}
+
 TEST(StructType, FromCStructAssign) {
     ndt::type dt = ndt::make_cstruct(ndt::make_type<int>(), "x", ndt::make_type<double>(), "y", ndt::make_type<short>(), "z");
     nd::array a = nd::empty(2, dt);
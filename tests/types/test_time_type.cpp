@@ -80,6 +80,24 @@ TEST(TimeDType, ValueCreationAbstract) {
             nd::array("23:59:59.9999999").ucast(d).view_scalars(di).as<int64_t>());
 }
 
+TEST(TimeDType, StringColumn) {
+  ndt::type d = ndt::make_time(tz_abstract), di = ndt::make_type<int64_t>();
+
+  // The first value sets the layout, the others fall back to the general
+  // parser
+  const char *strs[] = {"12:34:56.789", "NA", "1:02:03.400",
+                        "12:34:56.789 pm"};
+  nd::array b = nd::array(strs).ucast(d).eval().view_scalars(di);
+  EXPECT_EQ(452967890000LL, b(0).as<int64_t>());
+  EXPECT_EQ(DYND_TIME_NA, b(1).as<int64_t>());
+  EXPECT_EQ(37234000000LL, b(2).as<int64_t>());
+  EXPECT_EQ(452967890000LL, b(3).as<int64_t>());
+
+  // An invalid time in the layout of the column is an error
+  const char *invalid[] = {"12:34:56.789", "24:00:00.000"};
+  EXPECT_THROW(nd::array(invalid).ucast(d).eval(), invalid_argument);
+}
+
 TEST(TimeDType, ConvertToString) {
   EXPECT_EQ("00:00",
             nd::array("00:00:00.000").cast(ndt::type("time")).as<string>());
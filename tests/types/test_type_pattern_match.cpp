@@ -9,6 +9,8 @@
 
 #include <dynd/types/type_pattern_match.hpp>
 #include <dynd/types/pow_dimsym_type.hpp>
+#include <dynd/types/arrfunc_type.hpp>
+#include <dynd/types/substitute_typevars.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -215,3 +217,68 @@ TEST(TypePatternMatchDims, Simple)
   EXPECT_EQ(ndt::type("int32"), cdt);
   EXPECT_EQ(ndt::type("{x: int}"), pdt);
 }
+
+TEST(TypePatternMatch, TypevarTable)
+{
+  ndt::typevar_table typevars;
+  EXPECT_TRUE(ndt::pattern_match(ndt::type("3 * 4 * int32"),
+                                 ndt::type("M * N * T"), typevars));
+  EXPECT_TRUE(ndt::pattern_match(ndt::type("4 * int32"), ndt::type("N * T"),
+                                 typevars));
+  EXPECT_FALSE(ndt::pattern_match(ndt::type("3 * int32"), ndt::type("N * T"),
+                                  typevars));
+  EXPECT_EQ(3, typevars.size());
+  EXPECT_EQ(ndt::type("int32"), typevars[nd::string("T")]);
+  EXPECT_EQ(3, typevars.size());
+  EXPECT_EQ(ndt::type("4 * 3 * int32"),
+            ndt::substitute(ndt::type("N * M * T"), typevars, true));
+
+  // The table binds the same things as a map does
+  std::map<nd::string, ndt::type> tvmap;
+  typevars.clear();
+  EXPECT_TRUE(ndt::pattern_match(ndt::type("2 * 3 * var * float64"),
+                                 ndt::type("Dims... * var * T"), typevars));
+  EXPECT_TRUE(ndt::pattern_match(ndt::type("2 * 3 * var * float64"),
+                                 ndt::type("Dims... * var * T"), tvmap));
+  EXPECT_EQ((intptr_t)tvmap.size(), typevars.size());
+  EXPECT_EQ(ndt::substitute(ndt::type("Dims... * T"), tvmap, true),
+            ndt::substitute(ndt::type("Dims... * T"), typevars, true));
+
+  // Running out of room is an error rather than a silent mismatch
+  typevars.clear();
+  ndt::type pattern("(A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P, Q)");
+  ndt::type concrete("(int8, int16, int32, int64, uint8, uint16, uint32, "
+                     "uint64, float32, float64, int8, int16, int32, int64, "
+                     "uint8, uint16, uint32)");
+  EXPECT_THROW(ndt::pattern_match(concrete, pattern, typevars), type_error);
+}
+
+TEST(TypePatternMatch, PatternSignature)
+{
+  ndt::type af_tp("(N * T, N * T, int32) -> N * T");
+  const ndt::pattern_signature &sig =
+      af_tp.extended<arrfunc_type>()->get_pos_signature();
+  EXPECT_EQ(3, sig.get_nparam());
+  EXPECT_TRUE(sig.has_symbolic_return());
+
+  ndt::type src_tp[3] = {ndt::type("10 * float64"), ndt::type("10 * float64"),
+                         ndt::type("int32")};
+  ndt::typevar_table typevars;
+  EXPECT_EQ(-1, sig.match(src_tp, typevars));
+  EXPECT_EQ(ndt::type("10 * float64"),
+            ndt::substitute(af_tp.extended<arrfunc_type>()->get_return_type(),
+                            typevars, true));
+
+  typevars.clear();
+  src_tp[1] = ndt::type("11 * float64");
+  EXPECT_EQ(1, sig.match(src_tp, typevars));
+  typevars.clear();
+  src_tp[1] = src_tp[0];
+  src_tp[2] = ndt::type("int64");
+  EXPECT_EQ(2, sig.match(src_tp, typevars));
+
+  EXPECT_FALSE(ndt::type("(int32) -> float64")
+                   .extended<arrfunc_type>()
+                   ->get_pos_signature()
+                   .has_symbolic_return());
+}
@@ -12,6 +12,7 @@
 #include <dynd/types/type_type.hpp>
 #include <dynd/types/cfixed_dim_type.hpp>
 #include <dynd/types/var_dim_type.hpp>
+#include <dynd/types/fixed_dimsym_type.hpp>
 
 using namespace std;
 using namespace dynd;
@@ -53,30 +54,44 @@ TEST(DTypeDType, ScalarRefCount) {
     nd::array a;
     ndt::type d, d2;
     d = ndt::type("fixed * 12 * int");
+    // Parsing interns the type, so other holders may share the instance.
+    // Only the change each operation makes to its count is checked
+    int32_t base = d.extended()->get_use_count();
+    // Parsing the same text again gives the same instance
+    EXPECT_EQ(d.extended(), ndt::type("fixed * 12 * int").extended());
+    EXPECT_EQ(base, d.extended()->get_use_count());
 
     a = nd::empty(ndt::make_type());
-    EXPECT_EQ(1, d.extended()->get_use_count());
     a.vals() = d;
-    EXPECT_EQ(2, d.extended()->get_use_count());
+    EXPECT_EQ(base + 1, d.extended()->get_use_count());
     d2 = a.as<ndt::type>();
-    EXPECT_EQ(3, d.extended()->get_use_count());
+    EXPECT_EQ(base + 2, d.extended()->get_use_count());
     d2 = ndt::type();
-    EXPECT_EQ(2, d.extended()->get_use_count());
+    EXPECT_EQ(base + 1, d.extended()->get_use_count());
     // Assigning a new value in the nd::array should free the reference in 'a'
     a.vals() = ndt::type();
-    EXPECT_EQ(1, d.extended()->get_use_count());
+    EXPECT_EQ(base, d.extended()->get_use_count());
     a.vals() = d;
-    EXPECT_EQ(2, d.extended()->get_use_count());
+    EXPECT_EQ(base + 1, d.extended()->get_use_count());
     // Assigning a new reference to 'a' should free the reference when
     // destructing the existing 'a'
     a = 1.0;
-    EXPECT_EQ(1, d.extended()->get_use_count());
+    EXPECT_EQ(base, d.extended()->get_use_count());
+}
+
+// The tests below build their type directly rather than parsing it, so it
+// isn't interned or cached, and the arrays hold the only references
+// besides 'd'
+static ndt::type make_refcount_type()
+{
+    return ndt::make_fixed_dimsym(
+        ndt::make_fixed_dim(12, ndt::make_type<int>()));
 }
 
 TEST(DTypeDType, StridedArrayRefCount) {
     nd::array a;
     ndt::type d;
-    d = ndt::type("fixed * 12 * int");
+    d = make_refcount_type();
 
     // 1D Strided Array
     a = nd::empty(10, ndt::make_type());
@@ -123,7 +138,7 @@ TEST(DTypeDType, StridedArrayRefCount) {
 TEST(DTypeDType, FixedArrayRefCount) {
     nd::array a;
     ndt::type d;
-    d = ndt::type("fixed * 12 * int");
+    d = make_refcount_type();
 
     // 1D Fixed Array
     a = nd::empty(ndt::make_cfixed_dim(10, ndt::make_type()));
@@ -169,7 +184,7 @@ TEST(DTypeDType, FixedArrayRefCount) {
 TEST(DTypeDType, VarArrayRefCount) {
     nd::array a;
     ndt::type d;
-    d = ndt::type("fixed * 12 * int");
+    d = make_refcount_type();
 
     // 1D Var Array
     a = nd::empty(ndt::make_var_dim(ndt::make_type()));
@@ -222,7 +237,7 @@ TEST(DTypeDType, VarArrayRefCount) {
 TEST(DTypeDType, CStructRefCount) {
     nd::array a;
     ndt::type d;
-    d = ndt::type("fixed * 12 * int");
+    d = make_refcount_type();
 
     // Single CStruct Instance
     a = nd::empty("{dt: type, more: {a: int32, b: type}, other: string}");
@@ -272,7 +287,7 @@ TEST(DTypeDType, CStructRefCount) {
 TEST(DTypeDType, StructRefCount) {
     nd::array a;
     ndt::type d;
-    d = ndt::type("fixed * 12 * int");
+    d = make_refcount_type();
 
     // Single CStruct Instance
     a = nd::empty("{dt: type, more: {a: int32, b: type}, other: string}")(0 <= irange() < 2);